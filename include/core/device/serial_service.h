@@ -0,0 +1,166 @@
+#pragma once
+#include "vex.h"
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <vector>
+
+#include "core/device/cobs_device.h"
+
+/**
+ * SerialService
+ *
+ * Owns every generic serial (UART) smart port that speaks 0-delimited COBS packets, and services all of them from one
+ * background task. Before this, every device ran its own polling loop (the VDB device had a task that slept 2ms when
+ * idle, OdometrySerial read its port from the odometry task), so each extra serial device cost another task spinning
+ * on the scheduler.
+ *
+ * Each registered port gets:
+ *   - a transmit ring buffer. send_frame() COBS encodes straight into it and returns without touching the port, the
+ *     service task drains it as the port frees up space. A frame is only queued if all of it fits, so a full buffer
+ *     drops whole frames instead of sending half of one.
+ *   - a receive buffer that collects bytes up to the next delimiter. Completed frames are decoded and handed to the
+ *     port's handler on the service task, right after they come off the wire.
+ *
+ * Handlers run on the service task, so they should be short and must lock anything they share with other tasks.
+ * All buffers are allocated when the port is added, nothing allocates while running.
+ *
+ * Ports are meant to be added once while the robot is starting up and are never removed.
+ */
+class SerialService {
+  public:
+    /**
+     * Called with every decoded packet received on a port.
+     * @param data the decoded bytes. Only valid until the handler returns
+     * @param len the number of decoded bytes
+     */
+    using FrameHandler = std::function<void(const uint8_t *data, size_t len)>;
+
+    /// Maximum number of ports that can be registered, one per smart port
+    static constexpr size_t MAX_PORTS = 21;
+    /// How long the service task sleeps after each pass over the ports (ms). At 921600 baud a port takes in about 92
+    /// bytes in this time, well inside the brain's receive buffer
+    static constexpr uint32_t PASS_DELAY_MS = 1;
+    /// Default size of each port's transmit ring buffer (bytes, encoded)
+    static constexpr size_t DEFAULT_TX_BUFFER_SIZE = 4096;
+    /// Default size of the largest packet a port will accept (bytes, decoded)
+    static constexpr size_t DEFAULT_MAX_FRAME_SIZE = 1024;
+
+    /**
+     * port_stats_t counts traffic on one port since it was added
+     */
+    typedef struct {
+        uint32_t bytes_in;      ///< bytes read off the wire, including delimiters
+        uint32_t bytes_out;     ///< bytes written to the wire, including delimiters
+        uint32_t frames_in;     ///< packets decoded and handed to the handler
+        uint32_t frames_out;    ///< packets queued by send_frame()
+        uint32_t rx_overflows;  ///< received packets thrown out for being longer than the max frame size
+        uint32_t tx_overflows;  ///< packets not queued because the transmit buffer was full
+        size_t tx_pending;      ///< encoded bytes waiting in the transmit buffer
+        size_t tx_high_water;   ///< most encoded bytes ever waiting in the transmit buffer
+    } port_stats_t;
+
+    /**
+     * Get the service shared by every serial device. The service task is started the first time a port is added.
+     * @return the serial service
+     */
+    static SerialService &instance();
+
+    /**
+     * Enable a smart port as generic serial and start servicing it.
+     *
+     * @param port the vex::PORTXX to use
+     * @param baud the baud rate to run the port at (i.e. 115200)
+     * @param handler called on the service task with every packet decoded from the port
+     * @param max_frame_size the largest decoded packet to accept, longer packets are counted and dropped
+     * @param tx_buffer_size the number of encoded bytes that can wait to be sent
+     * @return false if the port was already added or there is no room for another port
+     */
+    bool add_port(
+      int32_t port, int32_t baud, FrameHandler handler, size_t max_frame_size = DEFAULT_MAX_FRAME_SIZE,
+      size_t tx_buffer_size = DEFAULT_TX_BUFFER_SIZE
+    );
+
+    /**
+     * Queue a packet to be COBS encoded and sent. Never blocks on the port, the service task writes the bytes as the
+     * port has room for them.
+     *
+     * @param port the port to send on, must have been added with add_port()
+     * @param data the data to encode then write
+     * @param size the number of bytes of data
+     * @param leading_delimeter true to add a leading delimiter to the packet. This may help the packet deliver
+     * uncorrupted if the previous packet failed to send completely
+     * @return false if the port was never added or the transmit buffer does not have room for the packet
+     */
+    bool send_frame(int32_t port, const uint8_t *data, size_t size, bool leading_delimeter = false);
+
+    /**
+     * @param port the port to look up
+     * @param[out] out the traffic counts for the port. Untouched if the port was never added
+     * @return false if the port was never added
+     */
+    bool get_stats(int32_t port, port_stats_t &out);
+
+  private:
+    /**
+     * Everything the service keeps about one port
+     */
+    struct Endpoint {
+        int32_t port;
+        FrameHandler handler;
+        size_t max_wire_size; // longest encoded packet accepted, from the max frame size
+
+        // Transmit ring buffer of encoded bytes. Guarded by tx_mut, send_frame() is called from any task
+        vex::mutex tx_mut;
+        std::vector<uint8_t> tx_ring;
+        size_t tx_head = 0;  // index of the next byte to go out on the wire
+        size_t tx_count = 0; // number of bytes waiting
+
+        // Bytes of the packet currently being received, before COBS decoding. Only touched by the service task
+        COBSSerialDevice::WirePacket rx_wire;
+        COBSSerialDevice::Packet rx_decoded;
+        bool rx_overflow = false;
+
+        port_stats_t stats = {0, 0, 0, 0, 0, 0, 0, 0};
+    };
+
+    SerialService() = default;
+
+    /**
+     * @return the endpoint for a port, or nullptr if the port was never added
+     */
+    Endpoint *find(int32_t port);
+
+    /**
+     * Write as much of the port's transmit buffer as the port will take without blocking
+     * @return true if any bytes were written
+     */
+    bool write_pending(Endpoint &ep);
+
+    /**
+     * Read every byte the port has buffered, dispatching any packets completed along the way
+     * @return true if any bytes were read
+     */
+    bool read_available(Endpoint &ep);
+
+    /**
+     * Add one byte from the wire to the packet being received
+     */
+    void handle_incoming_byte(Endpoint &ep, uint8_t byte);
+
+    static int service_thread(void *vself);
+
+    // Endpoints are written before num_endpoints is incremented and never removed, so the service task can walk
+    // [0, num_endpoints) without locking
+    Endpoint *endpoints[MAX_PORTS] = {nullptr};
+    std::atomic<size_t> num_endpoints{0};
+    vex::mutex add_mut;
+
+    // Scratch space for pulling bytes off a port in bulk. Only touched by the service task
+    uint8_t read_buffer[256];
+
+    vex::task service_task;
+    bool started = false;
+};
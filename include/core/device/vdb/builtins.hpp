@@ -86,6 +86,44 @@ class OdometryDataRecord : public Record {
     std::shared_ptr<Float> ROT;
 };
 
+/**
+ * Defines a record that holds the odometry background task's timing statistics to be sent to the board
+ */
+class OdometryTimingRecord : public Record {
+  public:
+    /**
+     * Creates a record that contains a
+     * Uint32 of the scheduled period
+     * Uint32 of the number of updates
+     * Uint32 of the number of overruns
+     * Uint32 of the number of skipped deadlines
+     * Uint32 of the max jitter
+     * Float of the mean update() time
+     * Uint32 of the max update() time
+     * Record of the period histogram, one Uint32 per bin
+     * @param name the name of the record to create
+     * @param odom the odometry to get data from
+     */
+    OdometryTimingRecord(std::string name, OdometryBase &odom);
+    /**
+     * sets the data that the timing Parts hold
+     */
+    void fetch() override;
+
+  private:
+    OdometryBase &odom;
+
+    std::shared_ptr<Uint32> period;
+    std::shared_ptr<Uint32> updates;
+    std::shared_ptr<Uint32> overruns;
+    std::shared_ptr<Uint32> skipped;
+    std::shared_ptr<Uint32> max_jitter;
+    std::shared_ptr<Float> avg_update;
+    std::shared_ptr<Uint32> max_update;
+    std::shared_ptr<Record> histogram;
+    std::vector<std::shared_ptr<Uint32>> bins;
+};
+
 /**
  * Defines a record sets odometry values from the board
  */
@@ -1,18 +1,21 @@
 #pragma once
-#include "core/device/cobs_device.h"
+#include "core/device/serial_service.h"
 #include "core/device/vdb/protocol.hpp"
 #include "vex.h"
-#include <deque>
 
 /**
  * Defines a COBS Serial Device to transmit VDB data through
+ *
+ * Reading and writing the port is done by the SerialService task shared with every other serial device, this class
+ * just turns VDP packets into frames and back.
  */
 namespace VDB {
-class Device : public VDP::AbstractDevice, public COBSSerialDevice {
+class Device : public VDP::AbstractDevice {
   public:
-    static constexpr int32_t NO_ACTIVITY_DELAY = 2; // ms
-    static constexpr std::size_t MAX_OUT_QUEUE_SIZE = 50;
-    static constexpr std::size_t MAX_IN_QUEUE_SIZE = 50;
+    /// Encoded bytes that can wait to be sent before send_packet starts refusing packets
+    static constexpr std::size_t TX_BUFFER_SIZE = 8192;
+    /// Largest packet accepted from the debug board
+    static constexpr std::size_t MAX_PACKET_SIZE = 4096;
     /**
      * creates a COBS Serial device for VDB data at a specified port with a specified baud rate
      * @param port the port the debug board is connected to
@@ -20,9 +23,15 @@ class Device : public VDP::AbstractDevice, public COBSSerialDevice {
      */
     explicit Device(int32_t port, int32_t baud_rate);
 
-    bool send_packet(const VDP::Packet &packet);
+    /**
+     * Queues a packet to be sent to the debug board. Never blocks
+     * @param packet the packet to send
+     * @return false if there was no room left to queue the packet
+     */
+    bool send_packet(const VDP::Packet &packet) override;
     /**
      * defines a callback to a functions that calls when the register recieves data from the debug board
+     * The callback runs on the SerialService task
      * @param callback the callback function to call
      */
     void register_receive_callback(std::function<void(const VDP::Packet &packet)> callback
@@ -30,40 +39,14 @@ class Device : public VDP::AbstractDevice, public COBSSerialDevice {
 
   private:
     /**
-     * @brief Packets that have been encoded and are waiting for their turn
-     * to be sent out on the wire
-     */
-    std::deque<WirePacket> outbound_packets{};
-    vex::mutex outbound_mutex;
-    /**
-     * @brief Packets that have been read from the wire and split up but that are
-     * still COBS encoded
-     */
-    std::deque<WirePacket> inbound_packets;
-
-    vex::mutex inbound_mutex;
-    /**
-     * @brief Working buffer that the reading thread uses to assemble packets
-     * until it finds a full COBS packet
+     * Called by the SerialService with every packet decoded from the wire
      */
-    WirePacket inbound_buffer;
-    /**
-     * the thread for decoding data from the wire
-     */
-    static int decode_thread(void *self);
-
-    /**
-     * the thread for sending data to the wire
-     */
-    static int serial_thread(void *self);
-
-    bool write_packet_if_avail();
-    
-    // Task that deals with the low level writing and reading bytes from the wire
-    vex::task serial_task;
+    void handle_frame(const uint8_t *data, size_t len);
 
-    bool write_request();
+    int32_t port;
+    // Reused for every incoming packet so the callback can be handed a VDP::Packet without allocating each time
+    VDP::Packet inbound_packet;
     std::function<void(const VDP::Packet &packet)> callback;
 };
 
-} // namespace VDB
\ No newline at end of file
+} // namespace VDB
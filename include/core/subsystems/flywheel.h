@@ -5,6 +5,7 @@
 #include "core/utils/command_structure/auto_command.h"
 #include "core/utils/controls/feedforward.h"
 #include "core/utils/controls/pid.h"
+#include "core/utils/snapshot.h"
 #include "vex.h"
 #include <atomic>
 
@@ -36,7 +37,7 @@ public:
   double get_target() const;
 
   /**
-   * return the velocity of the flywheel
+   * return the velocity of the flywheel, as of the last time the runner thread measured it
    */
   double getRPM() const;
 
@@ -69,7 +70,7 @@ public:
    * @brief check if the feedback controller thinks the flywheel is on target
    * @return true if on target
    */
-  bool is_on_target() { return fb.is_on_target(); }
+  bool is_on_target() { return state.read().on_target; }
 
   /**
    *  @brief Creates a page displaying info about the flywheel
@@ -103,6 +104,15 @@ private:
   friend class FlywheelPage;
   friend int spinRPMTask(void *wheelPointer);
 
+  /**
+   * flywheel_state_t is what the runner thread publishes every loop, so readers never wait on fb_mut
+   */
+  typedef struct {
+    double rpm;     ///< smoothed measured velocity (rpm)
+    double output;  ///< the output last sent to the motors (-1 to 1)
+    bool on_target; ///< whether the feedback controller thinks we're on target
+  } flywheel_state_t;
+
   vex::motor_group &motors;       ///< motors that make up the flywheel
   bool task_running = false;      ///< is the task currently running?
   Feedback &fb;                   ///< Main Feeback controller
@@ -113,6 +123,8 @@ private:
   task rpm_task;                  ///< task that handles spinning the wheel at a given target_rpm
   Filter &avger;                  ///< Moving average to smooth out noise from
 
+  SeqLock<flywheel_state_t> state; ///< latest measurements from the runner thread, readable without fb_mut
+
   // Functions for internal use only
   /**
    * Sets the target rpm of the flywheel
@@ -0,0 +1,114 @@
+#pragma once
+
+#include "core/utils/math/estimator/kalman_filter.h"
+#include "core/utils/math/geometry/pose2d.h"
+#include "core/utils/math/geometry/translation2d.h"
+
+/**
+ * KinematicEstimator
+ *
+ * Estimates the velocity and acceleration of the robot from the stream of poses odometry produces. Each of x, y and
+ * heading is tracked by its own constant acceleration Kalman filter (state [position, velocity, acceleration], the
+ * position is measured) which is stepped with every pose, using the real time between poses.
+ *
+ * Differencing poses directly is noisy at odometry rates, and differencing them slowly (every 100ms) lags by up to the
+ * whole window. The filters smooth every sample instead, so the lag is bounded by how much the filters are told to
+ * trust the measurements rather than by a window length.
+ *
+ * The heading is unwrapped before filtering, so crossing +-180 degrees does not look like a full turn.
+ */
+class KinematicEstimator {
+  public:
+    /**
+     * Create an estimator
+     *
+     * @param position_stddev how noisy the measured x and y are (inch)
+     * @param jerk_stddev how quickly the acceleration can change (inch/s^3 per sqrt(Hz)). Higher follows changes
+     * faster but passes more noise
+     * @param heading_stddev_deg how noisy the measured heading is (deg)
+     * @param ang_jerk_stddev_deg how quickly the angular acceleration can change (deg/s^3 per sqrt(Hz))
+     */
+    KinematicEstimator(
+      double position_stddev = 0.02, double jerk_stddev = 300.0, double heading_stddev_deg = 0.05,
+      double ang_jerk_stddev_deg = 3000.0
+    );
+
+    /**
+     * Forget the motion so far and start again from a robot sitting still
+     *
+     * @param pose the pose the robot is sitting at
+     * @param time the time (s) of the pose
+     */
+    void reset(const Pose2d &pose, double time);
+
+    /**
+     * Step the filters forward to a new pose
+     *
+     * @param pose the newest pose from odometry
+     * @param time the time (s) the pose was measured at
+     */
+    void update(const Pose2d &pose, double time);
+
+    /**
+     * @return velocity of the robot in the field frame (inch/s)
+     */
+    Translation2d field_velocity() const;
+
+    /**
+     * @return acceleration of the robot in the field frame (inch/s^2)
+     */
+    Translation2d field_accel() const;
+
+    /**
+     * @return velocity of the robot in its own frame, rotated by the current heading (inch/s)
+     */
+    Translation2d body_velocity() const;
+
+    /**
+     * @return acceleration of the robot in its own frame, rotated by the current heading (inch/s^2)
+     */
+    Translation2d body_accel() const;
+
+    /**
+     * @return magnitude of the velocity (inch/s)
+     */
+    double speed() const;
+
+    /**
+     * @return rate of change of the speed, positive when speeding up (inch/s^2)
+     */
+    double accel() const;
+
+    /**
+     * @return angular velocity, counter clockwise positive (deg/s)
+     */
+    double ang_speed_deg() const;
+
+    /**
+     * @return angular acceleration, counter clockwise positive (deg/s^2)
+     */
+    double ang_accel_deg() const;
+
+  private:
+    using AxisFilter = KalmanFilter<3, 1, 1>;
+
+    /**
+     * Build the filter for one axis of a constant acceleration model
+     */
+    static AxisFilter make_filter(double measurement_stddev, double jerk_stddev);
+
+    /**
+     * Step one axis filter to a new measurement
+     */
+    static void step(AxisFilter &filter, double measurement, double dt);
+
+    AxisFilter x_filter;
+    AxisFilter y_filter;
+    AxisFilter heading_filter;
+
+    bool initialized = false;
+    double last_time = 0;
+    double last_heading_deg = 0;
+    double unwrapped_heading_deg = 0;
+    Rotation2d heading;
+};
@@ -0,0 +1,309 @@
+#pragma once
+
+#include <cstdint>
+#include <functional>
+#include <random>
+#include <vector>
+
+#include "core/subsystems/odometry/odometry_base.h"
+#include "core/utils/field_map.h"
+#include "core/utils/math/geometry/translation2d.h"
+#include "vex.h"
+
+/**
+ * RangeTable
+ *
+ * Precomputed distances from points on the field to the nearest wall along every direction. The field is divided into
+ * square cells and the directions into angle bins, and a ray is cast from the center of every cell in every direction
+ * once when the table is built. Looking up an expected range after that is an index calculation and a memory read,
+ * which is what lets a particle filter check hundreds of poses against every reading.
+ *
+ * The answer is the range from the center of the cell, so it can be off by up to half a cell diagonal. Keep the cell
+ * size well under the distance sensor's noise.
+ */
+class RangeTable {
+  public:
+    /**
+     * Build the table. Casts cells * cells * angle_bins rays, so this is slow; build it once before the match.
+     *
+     * @param walls the walls to cast rays against
+     * @param field_size length of the sides of the square field, which starts at (0, 0) (inch)
+     * @param cell_size length of the sides of a cell (inch)
+     * @param angle_bins number of directions to cast in
+     * @param max_range rays that don't hit a wall closer than this return this (inch)
+     */
+    RangeTable(
+      const std::vector<map_segment_t> &walls, double field_size, double cell_size, int angle_bins, double max_range
+    );
+
+    /**
+     * Look up the expected range for a batch of rays. Written as plain loops over arrays so the index math
+     * vectorizes.
+     *
+     * @param x x coordinate of each ray's origin (inch)
+     * @param y y coordinate of each ray's origin (inch)
+     * @param heading direction of each ray (rad)
+     * @param n number of rays
+     * @param[out] out the expected range of each ray (inch)
+     * @param[out] index scratch space for n cell indices
+     */
+    void lookup(const float *x, const float *y, const float *heading, size_t n, float *out, int32_t *index) const;
+
+    /**
+     * Look up the expected range of one ray
+     *
+     * @param from the origin and direction of the ray
+     * @return the expected range (inch)
+     */
+    float lookup(const Pose2d &from) const;
+
+    /**
+     * Cast a ray against a set of walls without the table
+     *
+     * @param walls the walls to cast against
+     * @param from the origin and direction of the ray
+     * @param max_range returned if no wall is closer than this (inch)
+     * @return the distance to the first wall hit (inch)
+     */
+    static double cast(const std::vector<map_segment_t> &walls, const Pose2d &from, double max_range);
+
+    /**
+     * Same as FieldMap::field_perimeter
+     * @param field_size length of the sides of the square field (inch)
+     * @return the four walls around the field
+     */
+    static std::vector<map_segment_t> field_perimeter(double field_size = 144.0) {
+        return FieldMap::field_perimeter(field_size);
+    }
+
+    /// @return the length of the sides of the field the table covers (inch)
+    double get_field_size() const { return field_size; }
+
+  private:
+    // Ranges are stored as hundredths of an inch, to fit a whole field in half the memory of floats
+    static constexpr float UNITS_PER_INCH = 100.0f;
+
+    double field_size;
+    float inv_cell_size;
+    int cells;
+    int angle_bins;
+    float bins_per_rad;
+    std::vector<uint16_t> ranges; // [cell_y][cell_x][angle_bin]
+};
+
+/**
+ * RangeSensor
+ *
+ * Something that measures the distance to the nearest wall in one direction, and where it is on the robot
+ */
+class RangeSensor {
+  public:
+    /**
+     * @param offset where the sensor is relative to the center of the robot, and the direction it points
+     * @param max_range readings further than this are not trusted (inch)
+     */
+    RangeSensor(const Pose2d &offset, double max_range) : offset(offset), max_range(max_range) {}
+    virtual ~RangeSensor() = default;
+
+    /**
+     * Read the sensor if it has a new reading
+     * @param[out] range the measured distance (inch). Only set if this returns true
+     * @return true if there was a new, valid reading
+     */
+    virtual bool read(double &range) = 0;
+
+    const Pose2d offset;
+    const double max_range;
+};
+
+/**
+ * A V5 distance sensor as a RangeSensor
+ */
+class DistanceRangeSensor : public RangeSensor {
+  public:
+    /**
+     * @param sensor the distance sensor
+     * @param offset where the sensor is relative to the center of the robot, and the direction it points
+     * @param max_range readings further than this are not trusted (inch). The sensor is rated to about 78 inches
+     */
+    DistanceRangeSensor(vex::distance &sensor, const Pose2d &offset, double max_range = 78.0);
+
+    /**
+     * Read the sensor if it has produced a new reading since the last read
+     * @param[out] range the measured distance (inch)
+     * @return true if there was a new reading, and the sensor saw something within max_range
+     */
+    bool read(double &range) override;
+
+  private:
+    vex::distance &sensor;
+    uint32_t last_timestamp = 0;
+};
+
+/**
+ * Stand-in for a distance sensor when there's no robot: casts a ray from wherever the robot really is, and adds noise.
+ * For running the localizer against a simulated field on the brain or a computer.
+ */
+class SimulatedRangeSensor : public RangeSensor {
+  public:
+    /**
+     * @param walls the simulated field
+     * @param true_pose returns where the simulated robot really is
+     * @param offset where the sensor is relative to the center of the robot, and the direction it points
+     * @param noise_stddev noise added to every reading (inch)
+     * @param outlier_chance chance a reading is something other than a wall, like another robot (0 to 1)
+     * @param max_range readings further than this are not returned (inch)
+     * @param seed seed for the noise, so a simulation can be run the same way twice
+     */
+    SimulatedRangeSensor(
+      const std::vector<map_segment_t> &walls, std::function<Pose2d()> true_pose, const Pose2d &offset,
+      double noise_stddev, double outlier_chance = 0.0, double max_range = 78.0, uint32_t seed = 1
+    );
+
+    /**
+     * Measure the simulated field
+     * @param[out] range the simulated distance (inch)
+     * @return true if the simulated wall is within max_range
+     */
+    bool read(double &range) override;
+
+  private:
+    std::vector<map_segment_t> walls;
+    std::function<Pose2d()> true_pose;
+    std::mt19937 rng;
+    std::normal_distribution<double> noise;
+    std::uniform_real_distribution<double> uniform;
+    double outlier_chance;
+};
+
+/**
+ * MonteCarloLocalizer
+ *
+ * Localizes the robot on a known field with a particle filter. Each particle is a guess at the robot's pose. Every
+ * update the particles are moved by the motion wheel odometry measured, plus noise in proportion to it. When the range
+ * sensors have new readings, each particle is weighted by how well the ranges it expects (from the RangeTable) match
+ * what the sensors measured, and once the weights have collapsed onto a few particles they are resampled with low
+ * variance resampling. The estimate is the weighted mean of the particles, published through OdometryBase.
+ *
+ * The particles are kept as a structure of arrays (all the x's together, all the y's together...) in floats, and the
+ * per particle work is done in plain loops over those arrays, so the compiler can vectorize them. All buffers are
+ * allocated when the localizer is constructed.
+ *
+ * The wrapped odometry should be constructed with is_async = false. The localizer calls its update() from its own
+ * update().
+ */
+class MonteCarloLocalizer : public OdometryBase {
+  public:
+    /// Range readings are only used once the robot has driven this far since the last readings were used (inch)
+    static constexpr double MIN_UPDATE_DISTANCE = 0.5;
+    /// ...or turned this far (deg)
+    static constexpr double MIN_UPDATE_ROTATION_DEG = 2.0;
+
+    /**
+     * mcl_config_t holds the tuning of the particle filter
+     */
+    typedef struct {
+        size_t num_particles;              ///< number of pose guesses. 500 to 1000 is a good range
+        double initial_xy_stddev;          ///< spread of the particles around a set_position() (inch)
+        double initial_heading_stddev_deg; ///< spread of the particles' headings around a set_position() (deg)
+        double trans_noise;                ///< translation noise per inch driven (inch/inch)
+        double rot_noise;                  ///< rotation noise per radian turned (rad/rad)
+        double trans_rot_noise;            ///< rotation noise per inch driven, for wheel scrub (rad/inch)
+        double range_stddev;               ///< noise of the range sensors, including the table's error (inch)
+        double outlier_weight;             ///< likelihood floor, so a reading off of another robot can't wipe out
+                                           ///< the right particles (0 to 1)
+    } mcl_config_t;
+
+    /**
+     * Create a localizer
+     *
+     * @param odom the wheel odometry to move the particles with. Should be constructed with is_async = false
+     * @param table the expected ranges on the field
+     * @param sensors the range sensors on the robot
+     * @param config the tuning of the particle filter
+     * @param is_async true to run in the background, false to call update() manually
+     */
+    MonteCarloLocalizer(
+      OdometryBase &odom, const RangeTable &table, std::vector<RangeSensor *> sensors, const mcl_config_t &config,
+      bool is_async = true
+    );
+
+    /**
+     * Move the particles with odometry, weight them with any new range readings, resample if needed and estimate
+     * @return the estimated pose
+     */
+    Pose2d update() override;
+
+    /**
+     * Scatter the particles around a new position
+     * @param newpos the position the robot is near
+     */
+    void set_position(const Pose2d &newpos = zero_pos) override;
+
+    /**
+     * How many particles are actually contributing. Near num_particles when the weights are even, near 1 when one
+     * particle has all of it
+     * @return the effective sample size after the last update
+     */
+    double get_effective_sample_size();
+
+  private:
+    /**
+     * Move every particle by a body frame motion plus noise scaled to it
+     */
+    void move_particles(double dx, double dy, double dtheta);
+
+    /**
+     * Multiply every particle's weight by the likelihood of a range reading
+     */
+    void weigh_particles(const RangeSensor &sensor, double range);
+
+    /**
+     * Normalize the weights and find the effective sample size
+     */
+    void normalize_weights();
+
+    /**
+     * Draw a new set of equally weighted particles in proportion to the weights
+     */
+    void resample();
+
+    /**
+     * Find the weighted mean pose of the particles
+     */
+    Pose2d estimate() const;
+
+    /**
+     * @return a uniformly random 32 bit number
+     */
+    uint32_t rng_next();
+
+    /**
+     * @return a random number with mean 0 and stddev 1. An approximation, exact normals are too slow for thousands
+     * of draws per update
+     */
+    float fast_normal();
+
+    OdometryBase &odom;
+    const RangeTable &table;
+    std::vector<RangeSensor *> sensors;
+    mcl_config_t config;
+
+    bool has_odom_pose = false;
+    Pose2d last_odom_pose;
+    double ess;
+
+    // Motion since range readings were last used
+    double moved_distance = 0;
+    double moved_rotation = 0;
+
+    // The particles, and a second set resample() writes into
+    std::vector<float> px, py, ptheta, weight;
+    std::vector<float> next_x, next_y, next_theta;
+
+    // Scratch for one sensor update
+    std::vector<float> cos_theta, sin_theta, ray_x, ray_y, ray_theta, expected;
+    std::vector<int32_t> ray_index;
+
+    uint32_t rng_state = 0x9e3779b9;
+};
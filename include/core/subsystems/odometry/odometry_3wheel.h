@@ -1,6 +1,7 @@
 #pragma once
 #include "core/subsystems/custom_encoder.h"
 #include "core/subsystems/odometry/odometry_base.h"
+#include "core/subsystems/odometry/sample_detector.h"
 #include "core/subsystems/tank_drive.h"
 
 /**
@@ -90,4 +91,10 @@ private:
 
   CustomEncoder &lside_fwd, &rside_fwd, &off_axis;
   odometry3wheel_cfg_t &cfg;
+
+  // encoder positions from the last update, used for finding deltas (deg). Set from the first sample
+  bool has_old_positions = false;
+  double lside_old = 0, rside_old = 0, offax_old = 0;
+  // tells repeated encoder readings apart from new ones
+  SampleDetector<3> sample_detector;
 };
\ No newline at end of file
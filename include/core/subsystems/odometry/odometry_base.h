@@ -5,11 +5,15 @@
 #undef __ARM_NEON__
 #undef __ARM_NEON
 #include <Eigen/Dense>
+#include <atomic>
 
 #include "core/robot_specs.h"
+#include "core/subsystems/odometry/kinematic_estimator.h"
 #include "core/utils/command_structure/auto_command.h"
 #include "core/utils/geometry.h"
 #include "core/utils/math/geometry/pose2d.h"
+#include "core/utils/pose_history.h"
+#include "core/utils/snapshot.h"
 #include "vex.h"
 
 #ifndef PI
@@ -25,11 +29,73 @@
  *
  * All future odometry implementations should extend this file and redefine update() function.
  *
+ * The background task calls update() on a fixed schedule, every DEFAULT_PERIOD_US unless changed with
+ * set_update_rate(). Deadlines are absolute (each is one period after the last deadline, not after the last update
+ * finished), so the rate doesn't drift with how long update() takes. The task sleeps with vexDelay(), so it wakes at
+ * the whole millisecond at or before each deadline: up to 1ms early, but without spinning. How well the schedule is
+ * kept is recorded in get_task_stats(). Implementations check whether their sensors have produced a new sample since
+ * the last update (see SampleDetector) and only integrate when they have, so each sample is integrated exactly once at
+ * the time it was measured.
+ *
+ * When running asynchronously, every new pose is also recorded in a history along with the time it was measured. This
+ * lets measurements that arrive late (a coprocessor, a distance sensor) be compared against where the robot was when
+ * they were taken with get_position_at(), instead of where it is now.
+ *
+ * The pose and velocities are published through a SeqLock after every update, so get_position() and the other
+ * getters never wait on the odometry task, which holds mut for the whole update().
+ *
  * @author Ryan McGee
  * @date Aug 11 2021
  */
 class OdometryBase {
   public:
+    /// Number of poses kept for get_position_at(). One is recorded per sensor sample, about every 10ms
+    static constexpr size_t HISTORY_SIZE = 200;
+    /// How often the background task checks the sensors for a new sample, unless changed with set_update_rate() (us)
+    static constexpr uint32_t DEFAULT_PERIOD_US = 2000;
+    /// How many periods behind schedule OverrunPolicy::CatchUp will try to make up before giving up and skipping
+    static constexpr uint32_t MAX_CATCH_UP_PERIODS = 5;
+    /// Number of bins in the period histogram. Each bin is an eighth of a period wide, so they cover up to 2 periods
+    static constexpr size_t PERIOD_HISTOGRAM_BINS = 16;
+
+    /**
+     * What the background task does when an update finishes after the next deadline has already passed
+     */
+    enum class OverrunPolicy {
+        CatchUp, ///< run the missed updates back to back until the task is back on schedule
+        Skip,    ///< drop the missed updates and wait for the next deadline on the original schedule
+    };
+
+    /**
+     * task_stats_t describes how well the background task is keeping to its schedule
+     */
+    typedef struct {
+        uint32_t period_us;      ///< the period the task is scheduled at
+        uint32_t updates;        ///< number of times update() has been called
+        uint32_t overruns;       ///< number of updates that finished after the following deadline
+        uint32_t skipped;        ///< number of deadlines dropped to get back on schedule
+        uint32_t max_jitter_us;  ///< latest an update has started after its deadline, not counting catch up
+        uint32_t last_update_us; ///< time the most recent update() took
+        uint32_t max_update_us;  ///< longest time an update() has taken
+        float avg_update_us;     ///< mean time an update() takes
+        /// Count of the actual time between the starts of consecutive updates. Bin i counts periods between i/8 and
+        /// (i+1)/8 of the scheduled period, the last bin counts everything longer
+        uint32_t period_histogram[PERIOD_HISTOGRAM_BINS];
+    } task_stats_t;
+
+    /**
+     * odometry_state_t is everything the odometry publishes after an update, read all at once
+     */
+    typedef struct {
+        Pose2d pos;                ///< position of the robot
+        double speed;              ///< the speed at which we are travelling (inch/s)
+        double accel;              ///< the rate at which we are accelerating (inch/s^2)
+        double ang_speed_deg;      ///< the speed at which we are turning (deg/s)
+        double ang_accel_deg;      ///< the rate at which we are accelerating our turn (deg/s^2)
+        Translation2d field_vel;   ///< velocity in the field frame (inch/s)
+        Translation2d field_accel; ///< acceleration in the field frame (inch/s^2)
+    } odometry_state_t;
+
     /**
      * Construct a new Odometry Base object
      *
@@ -44,7 +110,33 @@ class OdometryBase {
     virtual Pose2d get_position(void);
 
     /**
-     * Sets the current position of the robot
+     * Gets the position and velocities from the same update, so they agree with each other
+     * @return the latest published state
+     */
+    odometry_state_t get_state();
+
+    /**
+     * Gets the position the robot was at at some time in the past, interpolating between the recorded poses
+     * surrounding that time. Times older than the history return the oldest pose, times newer than the last update
+     * return the newest pose. If nothing has been recorded yet (not running async) the current position is returned.
+     *
+     * @param time the time to look up, in seconds since the brain started (same clock as vexSystemHighResTimeGet)
+     * @return the position that the odometry believes the robot was at
+     */
+    virtual Pose2d get_position_at(double time);
+
+    /**
+     * Gets when the newest sample an implementation integrated was measured. Meant for whatever calls update() on
+     * odometry that isn't running asynchronously, like PoseEstimator, to tell a new sample from the same one again.
+     * Reads without locking, so only call it from the task that calls update()
+     *
+     * @return the time passed to the last update_kinematics() (s), negative if there hasn't been one
+     */
+    double get_sample_time();
+
+    /**
+     * Sets the current position of the robot. Clears the pose history, since the old poses are no longer in the same
+     * frame as the new one.
      * @param newpos the new position that the odometry will believe it is at
      */
     virtual void set_position(const Pose2d &newpos = zero_pos);
@@ -64,6 +156,26 @@ class OdometryBase {
      */
     static int background_task(void *ptr);
 
+    /**
+     * Change how often the background task runs update(). Takes effect at the next deadline, which is rescheduled from
+     * then on at the new rate. Has no effect if the odometry isn't running asynchronously.
+     *
+     * @param hz the number of times per second to run update()
+     * @param policy what to do when an update runs past the next deadline
+     */
+    void set_update_rate(double hz, OverrunPolicy policy = OverrunPolicy::Skip);
+
+    /**
+     * Get the background task's timing statistics. Never waits on the odometry task
+     * @return how well the background task is keeping to its schedule. All zero if not running asynchronously
+     */
+    task_stats_t get_task_stats();
+
+    /**
+     * Clear the background task's timing statistics. Happens before the next update
+     */
+    void reset_task_stats();
+
     /**
      * End the background task. Cannot be restarted.
      * If the user wants to end the thread but keep the data up to date,
@@ -109,6 +221,30 @@ class OdometryBase {
      */
     double get_angular_accel_deg();
 
+    /**
+     * Get the current velocity in the field frame
+     * @return the velocity along the field's x and y axes (inch/s)
+     */
+    Translation2d get_field_velocity();
+
+    /**
+     * Get the current acceleration in the field frame
+     * @return the acceleration along the field's x and y axes (inch/s^2)
+     */
+    Translation2d get_field_accel();
+
+    /**
+     * Get the current velocity in the robot's frame
+     * @return the velocity along the robot's own x and y axes (inch/s)
+     */
+    Translation2d get_body_velocity();
+
+    /**
+     * Get the current acceleration in the robot's frame
+     * @return the acceleration along the robot's own x and y axes (inch/s^2)
+     */
+    Translation2d get_body_accel();
+
     inline static constexpr Pose2d zero_pos = Pose2d();
 
     /**
@@ -126,8 +262,74 @@ class OdometryBase {
      */
     Pose2d current_pos;
 
-    double speed;         /**< the speed at which we are travelling (inch/s)*/
-    double accel;         /**< the rate at which we are accelerating (inch/s^2)*/
-    double ang_speed_deg; /**< the speed at which we are turning (deg/s)*/
-    double ang_accel_deg; /**< the rate at which we are accelerating our turn (deg/s^2)*/
+    double speed;              /**< the speed at which we are travelling (inch/s)*/
+    double accel;              /**< the rate at which we are accelerating (inch/s^2)*/
+    double ang_speed_deg;      /**< the speed at which we are turning (deg/s)*/
+    double ang_accel_deg;      /**< the rate at which we are accelerating our turn (deg/s^2)*/
+    Translation2d field_vel;   /**< the velocity in the field frame (inch/s)*/
+    Translation2d field_accel; /**< the acceleration in the field frame (inch/s^2)*/
+
+  protected:
+    /**
+     * Step the velocity and acceleration estimate with current_pos, and copy the results into speed, accel,
+     * ang_speed_deg, ang_accel_deg, field_vel and field_accel. Implementations should call this once for every new
+     * sample they integrate, with mut held. This is also how the background task knows a new sample came in; if an
+     * implementation never calls it, every update() is treated as a new sample.
+     *
+     * @param time the time (s) the sensors behind current_pos were read
+     */
+    void update_kinematics(double time);
+
+    /**
+     * Publish current_pos and the velocities for the getters to read. Called by the background task after every
+     * update(), implementations that change their state elsewhere should call this afterwards. Must be called with
+     * mut held, since it is what keeps writers from publishing at the same time.
+     */
+    void publish_state();
+
+    /**
+     * Called by the background task with the pose returned by every update(). Records it in the history.
+     * Implementations that know when their pose was actually measured better than the background task does can
+     * override this to do nothing and push to the history themselves.
+     *
+     * @param time the time (s) update() was called
+     * @param pose the pose returned by update()
+     */
+    virtual void record_history(double time, const Pose2d &pose);
+
+    /**
+     * Recent poses and the time they were measured, used by get_position_at(). Guarded by mut
+     */
+    PoseHistory<HISTORY_SIZE> history;
+
+    /**
+     * Estimates velocity and acceleration from every pose update(). Reset by set_position(). Guarded by mut
+     */
+    KinematicEstimator kinematics;
+
+  private:
+    /**
+     * Sleep until an absolute time, to the millisecond: wakes up to 1ms before the deadline
+     * @param deadline_us the time to wake up at (us, same clock as vexSystemHighResTimeGet)
+     */
+    static void wait_until(uint64_t deadline_us);
+
+    /**
+     * Add one update to the timing statistics. Only called from the background task
+     */
+    void record_timing(uint64_t start_us, uint64_t end_us, uint64_t deadline_us, bool was_late);
+
+    bool is_async;
+    // Set by set_update_rate(), picked up by the background task at its next deadline
+    std::atomic<uint32_t> period_us{DEFAULT_PERIOD_US};
+    std::atomic<OverrunPolicy> overrun_policy{OverrunPolicy::Skip};
+    std::atomic<bool> stats_reset_requested{false};
+    // Timing statistics owned by the background task, and the copy everything else reads
+    task_stats_t task_stats{};
+    uint64_t last_start_us = 0;
+    SeqLock<task_stats_t> published_task_stats;
+    // Time (s) of the last sample passed to update_kinematics(), negative if there hasn't been one
+    double last_sample_time = -1;
+    // The state as of the last publish_state(), read without locking while the background task is running
+    SeqLock<odometry_state_t> state;
 };
\ No newline at end of file
@@ -6,6 +6,8 @@
 #undef __ARM_NEON
 #include <Eigen/Dense>
 
+#include "core/device/serial_service.h"
+#include "core/device/vdb/crc32.hpp"
 #include "core/subsystems/custom_encoder.h"
 #include "core/subsystems/odometry/odometry_base.h"
 #include "core/utils/math_util.h"
@@ -23,6 +25,30 @@
  * This is a "set and forget" class, meaning once the object is created, the robot will immediately begin
  * tracking it's movement in the background.
  *
+ * The port is read by the SerialService task shared with every other serial device. Packets are decoded as soon as
+ * they come off the wire, and the poses are stored along with the time they were measured so they can be looked up
+ * later with get_position_at(). Each pose is published to the getters as soon as it is decoded. update() only publishes
+ * the link statistics, it never touches the port.
+ *
+ * Two packet formats are understood, told apart by their decoded length. Which one the coprocessor sends is requested
+ * in the config packet (see send_config()). All values are little endian.
+ *
+ * Version 1 (28 bytes):
+ *   float x, y, rot (deg), speed, accel, ang_speed (deg/s), ang_accel (deg/s^2)
+ *
+ * Version 2 (40 bytes, 64 with covariance):
+ *   uint8_t  version        always 2
+ *   uint8_t  flags          bit 0 set if the covariance is included
+ *   uint16_t sequence       incremented by one every packet, used to count dropped packets
+ *   uint32_t sample_time    coprocessor clock (us) when the pose was measured, used to estimate latency
+ *   float    x ... ang_accel, the same 7 values as version 1
+ *   float    cov_xx, cov_xy, cov_xrot, cov_yy, cov_yrot, cov_rotrot (optional, rot in deg)
+ *   uint32_t crc32          CRC32 of every byte before it
+ *
+ * Received poses are stored in the OdometryBase history as they arrive rather than by the background task. For version
+ * 2 they are stored at the time they were measured on the coprocessor (converted to the brain's clock) rather than the
+ * time they were received.
+ *
  * https://rit.enterprise.slack.com/files/U04112Y5RB6/F080M01KPA5/predictperpindiculars2.pdf
  * 2024-2025 Notebook: Entries/Software Entries/Localization/N-Pod Odometry
  *
@@ -31,22 +57,73 @@
  */
 class OdometrySerial : public OdometryBase {
   public:
+    static constexpr uint8_t PROTOCOL_V1 = 1;
+    static constexpr uint8_t PROTOCOL_V2 = 2;
+    /// Flag set in a version 2 packet when the pose covariance is included
+    static constexpr uint8_t V2_FLAG_COVARIANCE = 0x01;
+
+    /// Size of a decoded pose packet: 7 floats (x, y, rot, speed, accel, ang_speed, ang_accel)
+    static constexpr size_t PACKET_SIZE = 28;
+    /// Size of the version 2 header: version, flags, sequence, sample time
+    static constexpr size_t V2_HEADER_SIZE = 8;
+    /// Size of the optional version 2 covariance: 6 floats of the upper triangle
+    static constexpr size_t V2_COVARIANCE_SIZE = 24;
+    static constexpr size_t CRC_SIZE = 4;
+    /// Size of the largest packet we accept, a version 2 packet with covariance
+    static constexpr size_t MAX_PACKET_SIZE = V2_HEADER_SIZE + PACKET_SIZE + V2_COVARIANCE_SIZE + CRC_SIZE;
+    /// Size of the config packet sent to the coprocessor
+    static constexpr size_t CONFIG_SIZE = 26;
+
+    /**
+     * serial_stats_t describes how the serial link behaved during the most recent update()
+     */
+    typedef struct {
+        double packet_age;         ///< age of the newest pose (s), negative if none have been received
+        uint64_t parse_time_us;    ///< time spent decoding packets since the previous update (us)
+        uint32_t packets_decoded;  ///< number of valid packets decoded since the previous update
+        uint32_t packets_rejected; ///< total number of packets thrown out for a bad length or encoding
+        uint32_t packets_corrupt;  ///< total number of packets that failed their checksum (v2 only)
+        uint32_t packets_dropped;  ///< total number of packets missing from the sequence (v2 only)
+        uint8_t protocol_version;  ///< version of the last valid packet, 0 if none have been received
+        double latency;            ///< estimated time from measurement to decode of the newest pose (s, v2 only)
+        double avg_latency;        ///< smoothed latency (s, v2 only)
+    } serial_stats_t;
+
     /**
      * Construct a new Odometry Serial Object
      */
     OdometrySerial(
       bool is_async, bool calc_vel_acc_on_brain, Pose2d initial_pose, Pose2d sensor_offset, int32_t port,
-      int32_t baudrate
+      int32_t baudrate, uint8_t protocol_version = PROTOCOL_V2
     );
 
-    void send_config(const Pose2d &initial_pose, const Pose2d &sensor_offset, const bool &calc_vel_acc_on_brain);
+    /**
+     * Send the starting pose, sensor offset and requested packet format to the coprocessor.
+     * Packets of either version are accepted regardless of the version requested, so a coprocessor that does not
+     * understand the request and keeps sending version 1 packets will still work.
+     *
+     * Config packet layout (26 bytes):
+     *   float initial x, y, rot (deg), offset x, y, rot (deg)
+     *   bool calc_vel_acc_on_brain
+     *   uint8_t protocol_version
+     *
+     * @param initial_pose the pose the coprocessor should start at
+     * @param sensor_offset the pose of the tracking sensor relative to the center of the robot
+     * @param calc_vel_acc_on_brain true if velocity and acceleration will be calculated on the brain
+     * @param protocol_version the packet format the coprocessor should send, PROTOCOL_V1 or PROTOCOL_V2
+     */
+    void send_config(
+      const Pose2d &initial_pose, const Pose2d &sensor_offset, const bool &calc_vel_acc_on_brain,
+      uint8_t protocol_version = PROTOCOL_V2
+    );
 
     int background_task(void *ptr);
 
     /**
-     * Update the current position of the robot once by reading a single packet from the serial port
+     * Publish the statistics for packets decoded since the last update. Packets themselves are decoded by the
+     * SerialService task as they arrive.
      *
-     * @return the robot's updated position
+     * @return the robot's newest position
      */
     Pose2d update() override;
 
@@ -55,22 +132,101 @@ class OdometrySerial : public OdometryBase {
      */
     void set_position(const Pose2d &new_pose) override;
 
-    int receive_cobs_packet(uint32_t port, uint8_t *buffer, size_t buffer_size);
-
-    Pose2d get_position(void) override;
+    /**
+     * Gets the position the robot was at at some time in the past, interpolating between the received poses
+     * surrounding that time. Times older than the stored history return the oldest pose, times newer than the last
+     * packet return the newest pose.
+     *
+     * @param time the time to look up, in seconds since the brain started (same clock as vexSystemHighResTimeGet)
+     * @return the position that the odometry believes the robot was at
+     */
+    Pose2d get_position_at(double time) override;
 
     Pose2d get_pose2d(void);
 
+    /**
+     * @return statistics about the serial link from the most recent update
+     */
+    serial_stats_t get_stats();
+
+    /**
+     * Gets the covariance of the newest pose, if the coprocessor sends it
+     *
+     * @param[out] cov the covariance of [x, y, rot (deg)]. Untouched if no covariance has been received
+     * @return true if a covariance has been received
+     */
+    bool get_covariance(Eigen::Matrix3d &cov);
+
     size_t cobs_decode(const uint8_t *buffer, size_t length, void *data);
 
     size_t cobs_encode(const void *data, size_t length, uint8_t *buffer);
 
-    double get_speed() override;
-
-    double get_accel() override;
+  protected:
+    /**
+     * Does nothing, poses are recorded in the history by the packet decoder at the time they were measured
+     */
+    void record_history(double time, const Pose2d &pose) override;
 
   private:
+    /**
+     * Called by the SerialService with every packet decoded from the wire
+     *
+     * @param packet the decoded bytes
+     * @param length the number of decoded bytes
+     */
+    void handle_frame(const uint8_t *packet, size_t length);
+
+    /**
+     * Check a packet's version and store its contents
+     *
+     * @param packet the decoded bytes
+     * @param length the number of decoded bytes
+     * @param rx_time the time (s) the packet was read off the port
+     * @return true if the packet was valid
+     */
+    bool decode_packet(const uint8_t *packet, size_t length, double rx_time);
+
+    /**
+     * Check and unpack a decoded version 2 packet
+     *
+     * @param packet the decoded bytes
+     * @param length the number of decoded bytes
+     * @param rx_time the time (s) the packet was read off the port
+     * @return true if the packet was valid
+     */
+    bool decode_v2_packet(const uint8_t *packet, size_t length, double rx_time);
+
+    /**
+     * Store the 7 pose floats shared by every packet version
+     *
+     * @param floats x, y, rot, speed, accel, ang_speed, ang_accel
+     * @param time the time (s, brain clock) the pose was measured at
+     * @return false if any of the values were not finite numbers
+     */
+    bool store_pose(const float *floats, double time);
+
+    /**
+     * Convert a coprocessor timestamp into the brain's clock.
+     *
+     * The offset between the clocks is estimated as the smallest (receive time - sample time) seen, less the time it
+     * takes the packet to go over the wire. That smallest gap is the packet that spent the least time waiting
+     * anywhere, so every other packet's latency is measured relative to it. The estimate is allowed to creep upward
+     * slowly so drift between the two clocks can not pin it to a stale minimum.
+     *
+     * @param sample_us the coprocessor timestamp of the sample (us)
+     * @param rx_time the time (s) the packet was read off the port
+     * @param wire_bytes the number of bytes the packet took on the wire
+     * @return the time (s, brain clock) the sample was measured at
+     */
+    double estimate_sample_time(uint32_t sample_us, double rx_time, size_t wire_bytes);
+
+    /// Allowed drift between the brain and coprocessor clocks (s/s)
+    static constexpr double CLOCK_DRIFT = 1e-4;
+    /// Smoothing factor for avg_latency
+    static constexpr double LATENCY_ALPHA = 0.05;
+
     int32_t _port;
+    int32_t baudrate;
 
     bool calc_vel_acc_on_brain;
 
@@ -78,8 +234,20 @@ class OdometrySerial : public OdometryBase {
 
     Pose2d pose_offset;
 
-    double speed;
-    double accel;
-    double ang_speed_deg;
-    double ang_accel_deg;
-};
\ No newline at end of file
+    // Counted by handle_frame() and published by update()
+    uint32_t decoded_since_update = 0;
+    uint64_t parse_us_since_update = 0;
+
+    // Version 2 sequence and timing state
+    bool has_sequence = false;
+    uint16_t last_sequence = 0;
+    bool has_sample_time = false;
+    uint32_t last_sample_us = 0;
+    uint32_t sample_wraps = 0;
+    double last_sample_time = 0;
+    double clock_offset = 0;
+
+    bool has_covariance = false;
+    Eigen::Matrix3d covariance;
+    serial_stats_t stats = {-1, 0, 0, 0, 0, 0, 0, 0, 0};
+};
@@ -2,6 +2,7 @@
 
 #include "core/subsystems/custom_encoder.h"
 #include "core/subsystems/odometry/odometry_base.h"
+#include "core/subsystems/odometry/sample_detector.h"
 #include "core/utils/geometry.h"
 #include "core/utils/moving_average.h"
 
@@ -79,9 +80,15 @@ class OdometryTank : public OdometryBase {
   private:
     /**
      * Get information from the input hardware and an existing position, and calculate a new current position
+     * @param config the robot's wheel diameter
+     * @param curr_pos the position before the wheels moved
+     * @param lside_diff how far the left side turned since curr_pos (rev)
+     * @param rside_diff how far the right side turned since curr_pos (rev)
+     * @param angle_deg the robot's heading now
+     * @return the new position
      */
     static Pose2d calculate_new_pos(
-      robot_specs_t &config, Pose2d &stored_info, double lside_diff, double rside_diff, double angle_deg
+      robot_specs_t &config, const Pose2d &curr_pos, double lside_diff, double rside_diff, double angle_deg
     );
 
     vex::motor_group *left_side, *right_side;
@@ -91,5 +98,9 @@ class OdometryTank : public OdometryBase {
     robot_specs_t &config;
 
     double rotation_offset = 0;
-    ExponentialMovingAverage ema = ExponentialMovingAverage(3);
+    // encoder positions from the last update, used for finding deltas (rev)
+    bool has_stored_revs = false;
+    double stored_lside_revs = 0, stored_rside_revs = 0;
+    // tells repeated sensor readings apart from new ones
+    SampleDetector<3> sample_detector;
 };
\ No newline at end of file
@@ -0,0 +1,181 @@
+#pragma once
+
+#include <array>
+
+#include "core/subsystems/odometry/odometry_base.h"
+#include "core/subsystems/odometry/sample_detector.h"
+#include "core/utils/math/estimator/unscented_kalman_filter.h"
+#include "core/utils/pose_history.h"
+#include "core/utils/snapshot.h"
+#include "vex.h"
+
+/**
+ * PoseEstimator
+ *
+ * Fuses wheel odometry, an IMU and absolute measurements of the robot's position into one pose estimate with an
+ * Unscented Kalman Filter. The state is the pose [x, y, heading (rad)].
+ *
+ * Every update the wrapped odometry is stepped. When it has a new sample, the twist it moved since the last sample
+ * predicts the state forward to the time that sample was measured. The IMU heading then corrects the state whenever
+ * the IMU has a new reading. Absolute measurements (a GPS sensor, a coprocessor's localization, distance sensors
+ * ranging off the field walls) can be added from any task with the time they were taken; they are applied with the
+ * next sample. Updates where the wrapped odometry has nothing new change nothing.
+ *
+ * Measurements that arrive late are latency compensated: the odometry poses are recorded, and the motion odometry saw
+ * between when the measurement was taken and now is used to carry it forward to now before it corrects the state.
+ *
+ * Heading residuals and means are wrapped, so a heading measurement of 179 degrees and an estimate of -179 degrees
+ * are 2 degrees apart rather than 358.
+ *
+ * The wrapped odometry should be constructed with is_async = false. The estimator calls its update() from its own
+ * update(), so there is only one odometry task and every odometry sample is predicted with exactly once.
+ */
+class PoseEstimator : public OdometryBase {
+  public:
+    static constexpr int STATES = 3;
+    static constexpr int INPUTS = 3;
+    static constexpr int OUTPUTS = 1;
+
+    /// Number of absolute measurements that can wait for the next update before the oldest are dropped
+    static constexpr size_t MAX_PENDING = 16;
+
+    /**
+     * pose_estimator_config_t holds how much to trust each source of information
+     */
+    typedef struct {
+        double pos_drift;         ///< how quickly wheel odometry's position error grows (inch per sqrt(s))
+        double heading_drift_deg; ///< how quickly wheel odometry's heading error grows (deg per sqrt(s))
+        double imu_stddev_deg;    ///< noise on the IMU's heading (deg)
+        double range_gate;        ///< ranges further than this from what the estimate expects are thrown out (inch)
+        double max_latency;       ///< measurements taken longer ago than this are thrown out (s)
+        double field_size;        ///< length of the sides of the square field that ranges are measured to (inch)
+    } pose_estimator_config_t;
+
+    /**
+     * estimator_stats_t counts what happened to the absolute measurements
+     */
+    typedef struct {
+        uint32_t applied;  ///< measurements used to correct the estimate
+        uint32_t rejected; ///< measurements thrown out for being too old or too far from the estimate
+        uint32_t dropped;  ///< measurements that were overwritten before an update could use them
+    } estimator_stats_t;
+
+    /**
+     * Create a pose estimator
+     *
+     * @param odom the wheel odometry to predict with. Should be constructed with is_async = false
+     * @param imu the inertial sensor to correct the heading with, or nullptr to not use one
+     * @param config how much to trust each source of information
+     * @param is_async true to run in the background, false to call update() manually
+     */
+    PoseEstimator(
+      OdometryBase &odom, vex::inertial *imu, const pose_estimator_config_t &config, bool is_async = true
+    );
+
+    /**
+     * Step the wrapped odometry. If it has a new sample, predict with the motion it saw, then correct with the IMU and
+     * any measurements that have arrived since the last sample
+     * @return the estimated pose
+     */
+    Pose2d update() override;
+
+    /**
+     * Sets the current position of the robot. The estimate is taken as exact, until odometry starts moving it again.
+     * @param newpos the new position that the estimator will believe it is at
+     */
+    void set_position(const Pose2d &newpos = zero_pos) override;
+
+    /**
+     * Add a measurement of the whole pose, like from a GPS sensor or a coprocessor. Safe to call from any task.
+     *
+     * @param pose the measured pose
+     * @param time the time the pose was measured (s, same clock as vexSystemHighResTimeGet)
+     * @param xy_stddev how noisy the measured x and y are (inch)
+     * @param heading_stddev_deg how noisy the measured heading is (deg)
+     */
+    void add_pose_measurement(const Pose2d &pose, double time, double xy_stddev, double heading_stddev_deg);
+
+    /**
+     * Add a distance sensor reading of the distance to a field wall. Safe to call from any task.
+     *
+     * @param range the measured distance (inch)
+     * @param time the time the distance was measured (s, same clock as vexSystemHighResTimeGet)
+     * @param sensor_offset where the sensor is on the robot and the direction it points, relative to the robot's center
+     * @param stddev how noisy the measured distance is (inch)
+     */
+    void add_range_measurement(double range, double time, const Pose2d &sensor_offset, double stddev);
+
+    /**
+     * @return counts of what happened to the absolute measurements
+     */
+    estimator_stats_t get_estimator_stats();
+
+    /**
+     * Find the distance from a point to the field walls along a direction
+     *
+     * @param from the point to measure from and the direction to measure in
+     * @param field_size the length of the sides of the square field
+     * @return the distance to the first wall hit (inch)
+     */
+    static double range_to_walls(const Pose2d &from, double field_size);
+
+  private:
+    using Filter = UnscentedKalmanFilter<STATES, INPUTS, OUTPUTS>;
+
+    enum class MeasurementType {
+        Pose,
+        Range,
+    };
+
+    typedef struct {
+        MeasurementType type;
+        double time;
+        Pose2d pose;      ///< the measured pose, or the sensor offset for a range
+        double range;     ///< the measured range, unused for a pose
+        double stddev[3]; ///< x, y and heading (rad) stddevs for a pose, only the first is used for a range
+    } measurement_t;
+
+    /**
+     * Queue a measurement for the next update, dropping the oldest if the queue is full
+     */
+    void add_measurement(const measurement_t &m);
+
+    /**
+     * Correct the estimate with one queued measurement. Must be called with mut held
+     * @param m the measurement
+     * @param now the time of the sample the filter is at (s)
+     * @return true if the measurement was used, false if it was thrown out
+     */
+    bool apply_measurement(const measurement_t &m, double now);
+
+    OdometryBase &odom;
+    vex::inertial *imu;
+    pose_estimator_config_t config;
+
+    Filter filter;
+
+    // Tells new samples from repeats for wrapped odometry that doesn't report its samples
+    SampleDetector<3> pose_detector;
+
+    // The last pose the wrapped odometry returned, and when
+    bool has_odom_pose = false;
+    Pose2d last_odom_pose;
+    double last_odom_time = 0;
+
+    // Wrapped odometry poses, to find how far the robot moved since a late measurement was taken
+    PoseHistory<HISTORY_SIZE> odom_history;
+
+    // Added to the IMU's heading (rad) so it agrees with set_position()
+    double imu_offset = 0;
+    uint32_t last_imu_timestamp = 0;
+
+    // Measurements waiting for the next update, guarded by pending_mut so any task can add them
+    vex::mutex pending_mut;
+    std::array<measurement_t, MAX_PENDING> pending;
+    size_t pending_count = 0;
+
+    // Counts of what happened to the measurements, guarded by pending_mut. Published after every change, with writes
+    // serialized by pending_mut, so get_estimator_stats() doesn't lock anything
+    estimator_stats_t stats{};
+    SeqLock<estimator_stats_t> published_stats;
+};
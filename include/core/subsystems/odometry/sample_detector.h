@@ -0,0 +1,61 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+
+/**
+ * SampleDetector
+ *
+ * Decides whether a set of odometry sensor readings is a new sample or the same one read again. Smart devices only
+ * send new data every 10ms or so, and the 3 wire encoders only change when the wheels move, so most polls of the
+ * sensors return exactly what the last one did. Integrating those polls wastes time and feeds the velocity estimate
+ * zero length steps followed by double length ones.
+ *
+ * A sample counts as new when any reading changed, or when a smart device timestamp advanced. If nothing has changed
+ * for MAX_SAMPLE_INTERVAL the readings are accepted anyway, since a robot sitting still is also a measurement and the
+ * velocity estimate needs it to come back down to zero.
+ *
+ * @tparam N the number of sensor readings that make up a sample
+ */
+template <size_t N> class SampleDetector {
+  public:
+    /// Longest time (s) readings are allowed to stay the same before they're accepted as a new sample anyway
+    static constexpr double MAX_SAMPLE_INTERVAL = 0.02;
+
+    /**
+     * Check a set of readings.
+     *
+     * @param readings the raw sensor readings, in any units, as long as they're consistent from call to call
+     * @param timestamp_ms the newest smart device timestamp (ms, brain clock) behind the readings, 0 if there is none
+     * @param now the current time (s)
+     * @param[out] time the time (s) the sample was measured. Only set if this returns true
+     * @return true if the readings should be integrated
+     */
+    bool is_new(const std::array<double, N> &readings, uint32_t timestamp_ms, double now, double &time) {
+        bool timestamp_advanced = timestamp_ms != 0 && timestamp_ms != last_timestamp_ms;
+        bool changed = !initialized || timestamp_advanced || readings != last_readings;
+        bool stale = now - last_time >= MAX_SAMPLE_INTERVAL;
+        if (!changed && !stale) {
+            return false;
+        }
+
+        // A device timestamp says when the data was actually produced, which is better than when we got around to
+        // reading it. Don't trust it if it would put the sample before the last one.
+        time = now;
+        if (timestamp_advanced && timestamp_ms / 1000.0 > last_time) {
+            time = timestamp_ms / 1000.0;
+        }
+
+        last_readings = readings;
+        last_timestamp_ms = timestamp_ms;
+        last_time = time;
+        initialized = true;
+        return true;
+    }
+
+  private:
+    bool initialized = false;
+    std::array<double, N> last_readings{};
+    uint32_t last_timestamp_ms = 0;
+    double last_time = 0;
+};
@@ -241,6 +241,25 @@ class OdometryPage : public Page {
     GraphDrawer velocity_graph;
 };
 
+/**
+ * @brief a page that shows how well the odometry background task is keeping to its schedule: the rate, overruns,
+ * jitter, how long update() takes and a histogram of the actual periods. Touch the screen to clear the statistics
+ */
+class OdometryTimingPage : public Page {
+  public:
+    /// @brief Create an odometry timing page
+    /// @param odom the odometry system to monitor. Must be running asynchronously to have anything to show
+    OdometryTimingPage(OdometryBase &odom);
+    /// @brief @see Page#update
+    void update(bool was_pressed, int x, int y) override;
+    /// @brief @see Page#draw
+    void draw(vex::brain::lcd &, bool first_draw, unsigned int frame_number) override;
+
+  private:
+    OdometryBase &odom;
+    GraphDrawer cost_graph;
+};
+
 /// @brief Simple page that stores no internal data. the draw and update functions use only global data rather than
 /// storing anything
 class FunctionPage : public Page {
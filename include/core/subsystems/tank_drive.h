@@ -302,4 +302,5 @@ class TankDrive {
     bool func_initialized = false; ///< used to control initialization of autonomous driving. (you only wan't to set the
                                    ///< target once, not every iteration that you're driving)
     bool is_pure_pursuit = false;  ///< true if we are driving with a pure pursuit system
+    PurePursuit::Tracker pure_pursuit_tracker; ///< how far along the current pure pursuit path the robot is
 };
\ No newline at end of file
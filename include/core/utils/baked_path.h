@@ -0,0 +1,236 @@
+#pragma once
+
+#include <array>
+#include <cmath>
+#include <cstddef>
+#include <vector>
+
+#include "core/utils/controls/trapezoid_profile.h"
+#include "core/utils/math/geometry/translation2d.h"
+#include "core/utils/pure_pursuit.h"
+
+/**
+ * Paths and motion profiles worked out by the compiler, for routes that never change.
+ *
+ * The functions here are constexpr versions of PurePursuit::smooth_path_hermite, PurePursuit::inject_path and
+ * TrapezoidProfile::calculate, with the same math in the same order. Assigned to a constexpr variable, the result is
+ * computed while compiling and stored as constant data, so nothing is computed when the program starts:
+ *
+ *   constexpr std::array<PurePursuit::hermite_point, 3> knots = {{{0, 0, 0, 40}, {40, 30, M_PI / 2, 40}, ...}};
+ *   constexpr auto curve = Baked::hermite<20>(knots);
+ *   constexpr auto route = Baked::inject<200>(curve, 1.0);
+ *   PurePursuit::Path path(route.to_vector(), 8);
+ *
+ * The standard library's sqrt, sin and cos aren't constexpr, so this has its own. They agree with the standard ones to
+ * within a few parts in 10^15.
+ */
+namespace Baked {
+
+/**
+ * Square root by Newton's method
+ */
+constexpr double sqrt(double x) {
+    if (x <= 0) {
+        return 0;
+    }
+    double guess = x > 1 ? x : 1;
+    for (int i = 0; i < 100; i++) {
+        double next = 0.5 * (guess + x / guess);
+        if (next >= guess) {
+            break;
+        }
+        guess = next;
+    }
+    return guess;
+}
+
+/**
+ * Sine by its Taylor series, after bringing x into [-pi, pi]
+ */
+constexpr double sin(double x) {
+    long turns = (long)(x / (2 * M_PI));
+    x -= turns * 2 * M_PI;
+    if (x > M_PI) {
+        x -= 2 * M_PI;
+    } else if (x < -M_PI) {
+        x += 2 * M_PI;
+    }
+    double term = x;
+    double sum = x;
+    for (int n = 1; n < 30; n++) {
+        term *= -x * x / ((2 * n) * (2 * n + 1));
+        sum += term;
+    }
+    return sum;
+}
+
+/**
+ * Cosine, as the sine a quarter turn ahead
+ */
+constexpr double cos(double x) { return sin(x + M_PI / 2); }
+
+/**
+ * Smallest whole number at least x
+ */
+constexpr double ceil(double x) {
+    double whole = (double)(long)x;
+    return whole < x ? whole + 1 : whole;
+}
+
+/**
+ * Not constexpr, so a path that doesn't fit its array stops the compiler here. At runtime the path is cut short
+ */
+inline void baked_path_too_long() {}
+
+/**
+ * A point on a baked path
+ */
+typedef struct {
+    double x;
+    double y;
+} point_t;
+
+/**
+ * A baked path: room for N points, of which the first size are used
+ */
+template <size_t N> struct path_t {
+    std::array<point_t, N> points;
+    size_t size;
+
+    /**
+     * Copy the points out for a PurePursuit::Path
+     */
+    std::vector<Translation2d> to_vector() const {
+        std::vector<Translation2d> out;
+        out.reserve(size);
+        for (size_t i = 0; i < size; i++) {
+            out.push_back(Translation2d(points[i].x, points[i].y));
+        }
+        return out;
+    }
+};
+
+/**
+ * PurePursuit::smooth_path_hermite, at compile time
+ *
+ * @tparam STEPS the number of points interpolated between knots
+ * @param knots the points to interpolate between, and the direction and strength of the path at them
+ * @return STEPS points per piece, plus the last knot
+ */
+template <size_t STEPS, size_t KNOTS>
+constexpr path_t<(KNOTS - 1) * STEPS + 1> hermite(const std::array<PurePursuit::hermite_point, KNOTS> &knots) {
+    path_t<(KNOTS - 1) * STEPS + 1> out{};
+    for (size_t i = 0; i + 1 < KNOTS; i++) {
+        const PurePursuit::hermite_point &a = knots[i];
+        const PurePursuit::hermite_point &b = knots[i + 1];
+        double t1x = a.mag * cos(a.dir), t1y = a.mag * sin(a.dir);
+        double t2x = b.mag * cos(b.dir), t2y = b.mag * sin(b.dir);
+        for (size_t t = 0; t < STEPS; t++) {
+            double s = (double)t / (double)STEPS;
+            double h1 = (2 * s - 3) * s * s + 1;
+            double h2 = (-2 * s + 3) * s * s;
+            double h3 = ((s - 2) * s + 1) * s;
+            double h4 = (s - 1) * s * s;
+            out.points[out.size++] = {
+              a.x * h1 + b.x * h2 + t1x * h3 + t2x * h4, a.y * h1 + b.y * h2 + t1y * h3 + t2y * h4
+            };
+        }
+    }
+    out.points[out.size++] = {knots[KNOTS - 1].x, knots[KNOTS - 1].y};
+    return out;
+}
+
+/**
+ * PurePursuit::inject_path, at compile time
+ *
+ * @tparam N_OUT room for the injected path. Stops the compiler if it's too small
+ * @param path the path to inject points into
+ * @param spacing the distance between injected points
+ * @return the path with points every spacing along each segment
+ */
+template <size_t N_OUT, size_t N_IN> constexpr path_t<N_OUT> inject(const path_t<N_IN> &path, double spacing) {
+    path_t<N_OUT> out{};
+    for (size_t i = 0; i + 1 < path.size; i++) {
+        point_t start = path.points[i];
+        double dx = path.points[i + 1].x - start.x;
+        double dy = path.points[i + 1].y - start.y;
+        double norm = sqrt(dx * dx + dy * dy);
+        int num_points = (int)ceil(norm / spacing);
+        if (norm > 0) {
+            dx = dx / norm * spacing;
+            dy = dy / norm * spacing;
+        }
+        for (int j = 0; j < num_points; j++) {
+            if (out.size >= N_OUT - 1) {
+                baked_path_too_long();
+                break;
+            }
+            out.points[out.size++] = {start.x + dx * j, start.y + dy * j};
+        }
+    }
+    out.points[out.size++] = path.points[path.size - 1];
+    return out;
+}
+
+/**
+ * TrapezoidProfile::calculate, sampled every dt seconds at compile time
+ *
+ * @tparam N the number of samples, at t = 0, dt, 2 dt, ... Samples after the end of the profile stay at the target
+ * @param x_initial the initial position
+ * @param x_target the target position
+ * @param v_max the maximum velocity
+ * @param accel the acceleration
+ * @param decel the deceleration
+ * @param dt the time between samples
+ * @return the state at each sample
+ */
+template <size_t N>
+constexpr std::array<motion_t, N>
+trapezoid(double x_initial, double x_target, double v_max, double accel, double decel, double dt) {
+    double distance = x_target - x_initial;
+    double abs_distance = distance < 0 ? -distance : distance;
+    int direction = distance > 0 ? 1 : -1;
+    double dist_accel = 0.5 * (v_max * v_max) / accel;
+    double dist_decel = 0.5 * (v_max * v_max) / decel;
+    double dist_full = dist_accel + dist_decel;
+
+    bool triangular = !(abs_distance > dist_full);
+    double v_peak = triangular ? sqrt((2 * abs_distance * accel * decel) / (accel + decel)) : v_max;
+    double time_accel = v_peak / accel;
+    double time_decel = v_peak / decel;
+    double time_cruise = triangular ? 0.0 : (abs_distance - dist_full) / v_max;
+    double time_total = time_accel + time_cruise + time_decel;
+
+    std::array<motion_t, N> out{};
+    for (size_t i = 0; i < N; i++) {
+        double t = i * dt;
+        t = t < 0 ? 0 : (t > time_total ? time_total : t);
+
+        double pos_local = 0, vel_local = 0, acc_local = 0;
+        if (t < time_accel) {
+            pos_local = 0.5 * accel * (t * t);
+            vel_local = accel * t;
+            acc_local = accel;
+        } else if (!triangular && (t < time_accel + time_cruise)) {
+            pos_local = dist_accel + v_max * (t - time_accel);
+            vel_local = v_max;
+            acc_local = 0.0;
+        } else if (triangular) {
+            double time_deceled = t - time_accel;
+            pos_local = (0.5 * accel * (time_accel * time_accel)) + (v_peak * time_deceled) -
+                        (0.5 * decel * (time_deceled * time_deceled));
+            vel_local = v_peak - (decel * time_deceled);
+            acc_local = -decel;
+        } else {
+            double time_deceled = t - (time_accel + time_cruise);
+            pos_local =
+              dist_accel + (v_max * (time_cruise + time_deceled)) - (0.5 * decel * (time_deceled * time_deceled));
+            vel_local = v_max - (decel * time_deceled);
+            acc_local = -decel;
+        }
+        out[i] = motion_t{x_initial + (direction * pos_local), direction * vel_local, direction * acc_local};
+    }
+    return out;
+}
+
+} // namespace Baked
@@ -9,6 +9,7 @@
  *      - drive_to_point
  *      - turn_to_heading
  *      - stop
+ *      - trajectory following
  *
  *    Also holds AutoCommand subclasses that wrap OdometryBase functions
  *
@@ -20,9 +21,12 @@
 
 #include "core/subsystems/tank_drive.h"
 #include "core/utils/command_structure/auto_command.h"
+#include "core/utils/controls/feedforward.h"
+#include "core/utils/controls/unicycle_controller.h"
 #include "core/utils/geometry.h"
 #include "vex.h"
 #include "core/utils/math/geometry/pose2d.h"
+#include "core/utils/trajectory.h"
 using namespace vex;
 
 // ==== DRIVING ====
@@ -254,6 +258,58 @@ private:
   double end_speed;
 };
 
+/**
+ * AutoCommand that drives a Trajectory by time. Every run() samples the trajectory at the time since the command
+ * started, lets the controller correct toward it, and turns the result into left and right wheel speeds for the
+ * feedforward. Each wheel's acceleration is the trajectory's, plus or minus how fast the turn is tightening or
+ * opening up, so the outside wheel of a curve gets its own. Finishes when the trajectory's time is up.
+ *
+ * There is no timeout by default, since the trajectory says how long it takes.
+ */
+class FollowTrajectoryCommand : public AutoCommand {
+public:
+  /**
+   * Construct a trajectory following AutoCommand
+   *
+   * @param drive_sys the drive to follow the trajectory with
+   * @param controller corrects the robot toward the trajectory, like a RamseteController or LTVUnicycleController
+   * @param trajectory the trajectory to follow
+   * @param ff_cfg feedforward from wheel speed (inch/s) and acceleration to drive_tank_raw's -1 to 1
+   * @param track_width the distance between the left and right wheels, dist_between_wheels in robot_specs_t (inch)
+   */
+  FollowTrajectoryCommand(TankDrive &drive_sys, UnicycleController &controller, Trajectory trajectory,
+                          FeedForward::ff_config_t &ff_cfg, double track_width);
+
+  /**
+   * Drive toward the trajectory's state for the current time
+   * @returns true when the trajectory is finished
+   */
+  bool run() override;
+
+  /*
+  * Returns a string describing the commands functionality
+  */
+  std::string toString() override;
+
+  /**
+   * Stop the drive system when it times out
+   */
+  void on_timeout() override;
+
+private:
+  TankDrive &drive_sys;
+  UnicycleController &controller;
+  Trajectory trajectory;
+  FeedForward ff;
+  double track_width;
+
+  bool started = false;
+  uint64_t start_us = 0;
+
+  // How far either side of now (s) the trajectory is sampled to find how fast its curvature is changing
+  static constexpr double CURVATURE_DT = 0.005;
+};
+
 /**
  * AutoCommand wrapper class for the stop() function in the
  * TankDrive class
@@ -110,6 +110,11 @@ template <int STATES, int INPUTS> class LinearQuadraticRegulator {
      */
     VectorU calculate(const VectorX &x, const VectorX &r) { return K_ * (r - x); }
 
+    /**
+     * Returns the gain matrix K.
+     */
+    const EMat<INPUTS, STATES> &K() const { return K_; }
+
     /**
      * Recomputes K to work for a time delayed state.
      *
@@ -0,0 +1,148 @@
+#pragma once
+
+#include <vector>
+
+#include "core/utils/math/geometry/pose2d.h"
+#include "core/utils/trajectory.h"
+
+/**
+ * UnicycleController
+ *
+ * Interface for controllers that keep a differential (tank) drive on a Trajectory. Each update compares where the
+ * robot is with the trajectory's state for the current time, and returns the speed and turn rate that bring it back:
+ * the trajectory's own speed and turn rate, plus a correction.
+ *
+ * The robot is treated as a unicycle: it can drive forward and turn, but not slide sideways. Errors are measured from
+ * the robot, so "along" is ahead of it and "cross" is to its left.
+ */
+class UnicycleController {
+  public:
+    /**
+     * output_t is what to drive at, for the center of the robot
+     */
+    typedef struct {
+        double vel;     ///< forward speed, negative backwards (inch/s)
+        double ang_vel; ///< turn rate, positive turning left (rad/s)
+    } output_t;
+
+    virtual ~UnicycleController() = default;
+
+    /**
+     * Find what to drive at to follow the trajectory
+     * @param current where the robot is
+     * @param ref the trajectory's state for now
+     * @return the speed and turn rate to drive at
+     */
+    virtual output_t calculate(const Pose2d &current, const Trajectory::state_t &ref) = 0;
+};
+
+/**
+ * RamseteController
+ *
+ * The nonlinear controller from "Control of Wheeled Mobile Robots: An Experimental Overview" (Oriolo, De Luca and
+ * Vendittelli), as used by FRC teams. Its correction is a closed form of the error, so an update is a handful of
+ * multiplies and a square root.
+ *
+ * b and zeta are usually given in meters as b = 2, zeta = 0.7. Distances here are in inches, so b comes out smaller:
+ * 2 rad^2/m^2 is about 0.0013 rad^2/inch^2.
+ */
+class RamseteController : public UnicycleController {
+  public:
+    /**
+     * ramsete_config_t holds the tuning of the controller
+     */
+    typedef struct {
+        double b;    ///< how hard to correct, like a proportional gain. Larger is more aggressive (rad^2/inch^2)
+        double zeta; ///< damping, from 0 to 1. Larger is less oscillation
+    } ramsete_config_t;
+
+    /**
+     * Create a controller
+     * @param config the tuning of the controller
+     */
+    RamseteController(const ramsete_config_t &config);
+
+    /**
+     * Find what to drive at to follow the trajectory
+     * @param current where the robot is
+     * @param ref the trajectory's state for now
+     * @return the speed and turn rate to drive at
+     */
+    output_t calculate(const Pose2d &current, const Trajectory::state_t &ref) override;
+
+  private:
+    ramsete_config_t config;
+};
+
+/**
+ * LTVUnicycleController
+ *
+ * A linear time-varying LQR. Near a trajectory, the robot's error (along, cross, heading) moves like a linear system
+ * whose only changing part is the speed: driving at v, a heading error turns into cross error at v per radian. For a
+ * given speed, an LQR finds the best gains for that system by solving a Riccati equation (DARE), which is far too
+ * slow to do every update.
+ *
+ * So the gains are solved once, when the controller is created, for speeds spread evenly from -max_vel to max_vel,
+ * and each update blends the two entries on either side of the trajectory's speed. The table is plain doubles, so it
+ * can be kept in a PrecomputeCache and loaded on later runs instead of being solved again.
+ *
+ * Tolerances set how the LQR weighs the errors against the corrections (Bryson's rule): how much error in each is
+ * acceptable, and how much correction is.
+ */
+class LTVUnicycleController : public UnicycleController {
+  public:
+    /**
+     * ltv_config_t holds the tolerances the gains are solved with, and the speeds they cover
+     */
+    typedef struct {
+        double along_tol;   ///< acceptable error ahead or behind (inch)
+        double cross_tol;   ///< acceptable error to the side (inch)
+        double heading_tol; ///< acceptable heading error (rad)
+        double vel_tol;     ///< acceptable speed correction (inch/s)
+        double ang_vel_tol; ///< acceptable turn rate correction (rad/s)
+        double dt;          ///< time between updates (s)
+        double max_vel;     ///< fastest speed in the table, either direction (inch/s)
+        int vel_bins;       ///< number of speeds in the table, at least 2
+    } ltv_config_t;
+
+    /// Gains stored per speed in the table, a 2x3 matrix by rows
+    static constexpr int GAINS_PER_BIN = 6;
+
+    /**
+     * Create a controller, solving the gains for every speed in the table
+     * @param config the tolerances and speeds
+     */
+    LTVUnicycleController(const ltv_config_t &config);
+
+    /**
+     * Create a controller with gains that were already solved, like ones loaded from a PrecomputeCache
+     * @param config the tolerances and speeds the gains were solved with
+     * @param gains the table, from get_gains()
+     */
+    LTVUnicycleController(const ltv_config_t &config, std::vector<double> gains);
+
+    /**
+     * Solve the gains for every speed in the table
+     * @param config the tolerances and speeds
+     * @return the table: GAINS_PER_BIN gains for each speed, from slowest to fastest
+     */
+    static std::vector<double> solve_gains(const ltv_config_t &config);
+
+    /**
+     * Find what to drive at to follow the trajectory
+     * @param current where the robot is
+     * @param ref the trajectory's state for now
+     * @return the speed and turn rate to drive at
+     */
+    output_t calculate(const Pose2d &current, const Trajectory::state_t &ref) override;
+
+    /**
+     * Get the table of gains, to store it
+     */
+    const std::vector<double> &get_gains() const;
+
+  private:
+    ltv_config_t config;
+    double bins_per_vel;
+    std::vector<double> gains;
+};
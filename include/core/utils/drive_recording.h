@@ -0,0 +1,274 @@
+#pragma once
+
+#include "vex.h"
+
+#include <atomic>
+#include <cstdint>
+#include <deque>
+#include <string>
+#include <vector>
+
+#include "core/subsystems/tank_drive.h"
+#include "core/utils/command_structure/auto_command.h"
+#include "core/utils/math/geometry/pose2d.h"
+
+/**
+ * drive_sample_t is one tick of a recorded drive: what the driver told the drive to do, and where the robot was
+ */
+typedef struct {
+    double left;  ///< left side command, as sent to drive_tank_raw (-1 to 1)
+    double right; ///< right side command, as sent to drive_tank_raw (-1 to 1)
+    Pose2d pose;  ///< where odometry had the robot
+} drive_sample_t;
+
+/**
+ * DriveRecordingCodec
+ *
+ * Turns drive samples into bytes and back. Every value is rounded to a whole number of small units, and each sample
+ * only stores how it differs from the one before: the change in the commands, and the change in the robot's velocity
+ * for the pose. Both are usually zero or close to it, so a sample starts with one byte of flags saying which changes
+ * aren't zero, followed by those changes as zigzag varints (small numbers of either sign take one byte). A robot
+ * sitting still takes one byte per sample, driving steadily a few.
+ *
+ * Since only whole units are stored, decoding gets back exactly the rounded values with no drift, however long the
+ * recording.
+ */
+class DriveRecordingCodec {
+  public:
+    /// Command units per 1.0 of command
+    static constexpr double COMMAND_UNITS = 1000.0;
+    /// Position units per inch
+    static constexpr double POSITION_UNITS = 64.0;
+    /// Heading units per degree
+    static constexpr double HEADING_UNITS = 10.0;
+    /// Most bytes one sample can take: the flags, then 5 varints of up to 5 bytes
+    static constexpr size_t MAX_SAMPLE_BYTES = 1 + 5 * 5;
+
+    /**
+     * Start a new stream
+     */
+    DriveRecordingCodec();
+
+    /**
+     * Go back to the start of a stream
+     */
+    void reset();
+
+    /**
+     * Add a sample to the stream
+     * @param sample the sample
+     * @param[out] out room for MAX_SAMPLE_BYTES bytes
+     * @return the number of bytes written
+     */
+    size_t encode(const drive_sample_t &sample, uint8_t *out);
+
+    /**
+     * Read the next sample from the stream. If the bytes run out partway through the sample, nothing is read, so it
+     * can be tried again once more bytes are available
+     *
+     * @param data the bytes of the stream, starting at the next sample
+     * @param len the number of bytes available
+     * @param[out] sample the sample
+     * @return the number of bytes read, or 0 if there weren't enough
+     */
+    size_t decode(const uint8_t *data, size_t len, drive_sample_t &sample);
+
+  private:
+    // Everything stored for the previous sample, in units: left, right, x, y, heading
+    static constexpr int NUM_FIELDS = 5;
+    // Fields from this one on store the change in velocity instead of the change in value
+    static constexpr int FIRST_POSE_FIELD = 2;
+
+    int32_t last[NUM_FIELDS];
+    int32_t last_delta[NUM_FIELDS];
+};
+
+/**
+ * DriveRecorder
+ *
+ * Records a driver's run to the SD card, to replay later as an autonomous with ReplayCommand.
+ *
+ * Drive through the recorder's drive_tank() or drive_arcade() instead of the TankDrive's; they do the same thing and
+ * remember the commands sent to the motors. Between start() and stop(), a task takes a sample of the latest commands
+ * and the odometry pose every PERIOD_MS, whatever rate the driver code runs at.
+ *
+ * The SD card is slow to write and can hold up whatever is writing to it, so the sampling task only encodes into
+ * memory. Full chunks of CHUNK_SIZE bytes are handed to a low priority task that appends them to the file.
+ *
+ * File format:
+ *   uint32_t magic            FILE_MAGIC
+ *   uint32_t period           time between samples (ms)
+ *   then samples from DriveRecordingCodec, until the end of the file
+ */
+class DriveRecorder {
+  public:
+    /// First 4 bytes of the file, "DRC1"
+    static constexpr uint32_t FILE_MAGIC = 0x31435244;
+    /// Time between samples (ms)
+    static constexpr uint32_t PERIOD_MS = 10;
+    /// Bytes collected before writing to the SD card
+    static constexpr size_t CHUNK_SIZE = 2048;
+
+    /**
+     * Create a recorder
+     * @param drive the drive to record. Must have odometry
+     * @param filename the file on the SD card to record to. Replaced when recording starts
+     */
+    DriveRecorder(TankDrive &drive, const std::string &filename = "recording.bin");
+
+    /**
+     * Start recording
+     * @return true if the file could be created
+     */
+    bool start();
+
+    /**
+     * Stop recording, and wait for everything to be written to the file
+     */
+    void stop();
+
+    /**
+     * Drive with TankDrive::drive_tank, and record it
+     */
+    void drive_tank(double left, double right, int power = 1, TankDrive::BrakeType bt = TankDrive::BrakeType::None);
+
+    /**
+     * Drive with TankDrive::drive_arcade, and record it
+     */
+    void drive_arcade(
+      double forward_back, double left_right, int power = 1, TankDrive::BrakeType bt = TankDrive::BrakeType::None
+    );
+
+    /**
+     * Get the number of samples recorded
+     */
+    size_t num_samples();
+
+    /**
+     * Get the number of bytes recorded, including ones not yet written
+     */
+    size_t num_bytes();
+
+    /**
+     * Get the average time it took to take and encode a sample (us)
+     */
+    double mean_sample_us();
+
+    /**
+     * Get the longest time it took to take and encode a sample (us)
+     */
+    uint32_t max_sample_us();
+
+  private:
+    static int sample_thread(void *ptr);
+    static int write_thread(void *ptr);
+
+    /**
+     * Take a sample and encode it into the current chunk, handing the chunk to the writer if it's full
+     */
+    void take_sample();
+
+    TankDrive &drive;
+    std::string filename;
+    DriveRecordingCodec codec;
+
+    vex::mutex mut;
+    vex::task sample_task;
+    vex::task write_task;
+    // recording is cleared to stop. sampling is cleared once the sample task has handed over its last chunk, and
+    // writing once the write task has written it
+    std::atomic<bool> recording{false};
+    std::atomic<bool> sampling{false};
+    std::atomic<bool> writing{false};
+
+    // The latest commands, guarded by mut
+    double left = 0;
+    double right = 0;
+
+    // The chunk being filled, and full chunks waiting to be written, guarded by mut
+    std::vector<uint8_t> chunk;
+    std::deque<std::vector<uint8_t>> full_chunks;
+
+    size_t samples = 0;
+    size_t bytes = 0;
+    uint64_t total_sample_us = 0;
+    uint32_t longest_sample_us = 0;
+};
+
+/**
+ * ReplayCommand
+ *
+ * Drives a recording made by DriveRecorder. Reads the file a little at a time as it goes, so a long recording doesn't
+ * take more memory than a short one.
+ *
+ * Each run() finds the sample for the time since the replay started, and sends its commands to the drive with a
+ * correction toward the recorded pose: the difference between where the robot is and where it was when the run was
+ * recorded, measured from the robot, times the gains. Set the gains to 0 to replay the commands blind.
+ *
+ * By default there is no timeout, since the replay takes as long as the recording.
+ */
+class ReplayCommand : public AutoCommand {
+  public:
+    /// Bytes read from the file at a time
+    static constexpr size_t BUFFER_SIZE = 512;
+
+    /**
+     * replay_config_t holds the gains of the correction toward the recorded pose
+     */
+    typedef struct {
+        double k_along;   ///< command per inch the robot is behind (or ahead of) the recording
+        double k_cross;   ///< turning command per inch the robot is to the side of the recording
+        double k_heading; ///< turning command per radian the robot is facing away from the recording
+    } replay_config_t;
+
+    /**
+     * Create a replay
+     * @param drive the drive to replay on. Must have odometry
+     * @param filename the recording on the SD card
+     * @param config the correction gains
+     */
+    ReplayCommand(TankDrive &drive, const std::string &filename, const replay_config_t &config);
+
+    /**
+     * Drive the sample for the current time
+     * @return true when the recording is finished, or couldn't be read
+     */
+    bool run() override;
+
+    /**
+     * Stop the drive and close the file
+     */
+    void on_timeout() override;
+
+    std::string toString() override;
+
+  private:
+    /**
+     * Read the next sample from the file, reading more of the file if needed
+     * @return false at the end of the file
+     */
+    bool next_sample();
+
+    /**
+     * Stop the drive and close the file
+     */
+    void finish();
+
+    TankDrive &drive;
+    std::string filename;
+    replay_config_t config;
+    DriveRecordingCodec codec;
+
+    FIL *file = nullptr;
+    bool started = false;
+    uint32_t period_ms = DriveRecorder::PERIOD_MS;
+    uint32_t start_ms = 0;
+
+    uint8_t buffer[BUFFER_SIZE];
+    size_t buffer_pos = 0;
+    size_t buffer_len = 0;
+
+    // The sample for the current time, and its index
+    drive_sample_t sample;
+    int64_t sample_index = -1;
+};
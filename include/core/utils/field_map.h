@@ -0,0 +1,215 @@
+#pragma once
+
+#include <cmath>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+#include "core/utils/math/geometry/pose2d.h"
+#include "core/utils/math/geometry/translation2d.h"
+
+/**
+ * map_segment_t is a straight wall on the field that a distance sensor can see
+ */
+typedef struct {
+    Translation2d start; ///< one end of the wall (inch)
+    Translation2d end;   ///< the other end of the wall (inch)
+} map_segment_t;
+
+/**
+ * Find how far along a ray it crosses a segment, solving origin + t * dir = start + s * (end - start) for t with s
+ * within 0 to 1. Shared by every ray cast against walls, so they all agree on what counts as a hit
+ *
+ * @param ox x of the origin of the ray
+ * @param oy y of the origin of the ray
+ * @param dx x of the direction of the ray, a unit vector
+ * @param dy y of the direction of the ray
+ * @param x x of the start of the segment
+ * @param y y of the start of the segment
+ * @param ex x of the end of the segment minus x of its start
+ * @param ey y of the end of the segment minus y of its start
+ * @return the distance along the ray (inch), or -1 if it misses the segment or runs parallel to it
+ */
+inline double ray_segment_distance(double ox, double oy, double dx, double dy, double x, double y, double ex,
+                                   double ey) {
+    double denom = dx * ey - dy * ex;
+    if (fabs(denom) < 1e-12) {
+        return -1; // parallel
+    }
+    double wx = x - ox;
+    double wy = y - oy;
+    double t = (wx * ey - wy * ex) / denom;
+    double s = (wx * dy - wy * dx) / denom;
+    return t >= 0 && s >= 0 && s <= 1 ? t : -1;
+}
+
+/**
+ * FieldMap
+ *
+ * The shape of the field: the walls around it, and the field elements (goals, barriers) on it as polygons. Answers the
+ * two questions that collision checks, distance sensors and planners all ask: how far is a point from the nearest
+ * wall, and how far does a ray go before it hits one.
+ *
+ * Distances come from a signed distance field worked out when the map is built: the exact distance at every corner of
+ * a grid of square cells, positive in the open, negative inside an element or past the walls. distance() blends the
+ * four corners around a point, so it's an index calculation and four reads. The blend is nearly exact along flat walls,
+ * and off by up to about half a cell where the distance has a crease: on a thin barrier, or halfway between two walls.
+ * It can read more room than there is, so is_clear() only trusts it when it says there's more than enough, and checks
+ * the edges themselves when it's close.
+ *
+ * Ray casts walk the (larger) ray cast cells the ray passes through in order (a grid DDA), testing only the edges that
+ * touch each cell, and stop at the first cell with a hit. They are exact.
+ *
+ * A map can be stored as a compact blob (see encode()), to keep field layouts in the program or on the SD card:
+ *   uint32_t magic            BLOB_MAGIC
+ *   uint16_t field_size       length of the sides of the field (hundredths of an inch)
+ *   uint16_t count            number of elements
+ *   count times:
+ *     uint16_t vertices       number of vertices
+ *     vertices times:
+ *       int16_t x, y          vertex (hundredths of an inch)
+ *   uint32_t crc32            CRC32 of every byte before it
+ */
+class FieldMap {
+  public:
+    /// First 4 bytes of a blob, "FMP1"
+    static constexpr uint32_t BLOB_MAGIC = 0x31504d46;
+
+    /**
+     * A field element, as the corners of a polygon in order (either direction). The last corner connects back to the
+     * first. Two corners make a thin barrier instead of an area
+     */
+    typedef std::vector<Translation2d> element_t;
+
+    /**
+     * Build a map. Finds the distance at every corner of every cell, so it's slow; build it once before the match.
+     *
+     * @param elements the field elements
+     * @param field_size length of the sides of the square field, which starts at (0, 0) (inch)
+     * @param resolution length of the sides of a distance field cell (inch)
+     * @param bucket_size length of the sides of a ray cast cell (inch)
+     */
+    FieldMap(
+      const std::vector<element_t> &elements, double field_size = 144.0, double resolution = 1.0,
+      double bucket_size = 12.0
+    );
+
+    /**
+     * Get the distance from a point to the nearest wall or element, from the distance field
+     * @param point the point to check
+     * @return the distance, negative if the point is inside an element or off the field (inch)
+     */
+    double distance(const Translation2d &point) const;
+
+    /**
+     * Get the distance from a point to the nearest wall or element, worked out exactly. Much slower than distance()
+     * @param point the point to check
+     * @return the distance, negative if the point is inside an element or off the field (inch)
+     */
+    double exact_distance(const Translation2d &point) const;
+
+    /**
+     * Get the direction away from the nearest wall or element: the way to push a robot that's too close
+     * @param point the point to check
+     * @return a unit vector, or (0, 0) if every direction is the same
+     */
+    Translation2d gradient(const Translation2d &point) const;
+
+    /**
+     * Get whether a circle fits at a point without touching anything. Exact: the distance field decides when it's sure,
+     * exact_distance() when it isn't
+     * @param point the center of the circle
+     * @param radius the radius of the circle, robot_radius in robot_specs_t for a robot (inch)
+     */
+    bool is_clear(const Translation2d &point, double radius) const;
+
+    /**
+     * Get whether a circle can move in a straight line without touching anything. Steps along the line as far as the
+     * distance field says is open each time, so open stretches take a few steps. Exact: near anything, the line is
+     * checked against the edges themselves
+     *
+     * @param start where the circle starts
+     * @param end where the circle ends
+     * @param radius the radius of the circle (inch)
+     */
+    bool is_clear(const Translation2d &start, const Translation2d &end, double radius) const;
+
+    /**
+     * Get the distance along a ray to the first wall or element it hits
+     * @param from the origin and direction of the ray
+     * @param max_range returned if nothing is closer than this (inch)
+     * @return the distance to the first hit (inch)
+     */
+    double cast(const Pose2d &from, double max_range) const;
+
+    /**
+     * Get every edge of the map, including the walls, to build a RangeTable or a SimulatedRangeSensor from
+     */
+    std::vector<map_segment_t> get_segments() const;
+
+    /**
+     * @param field_size length of the sides of the square field (inch)
+     * @return the four walls around the field
+     */
+    static std::vector<map_segment_t> field_perimeter(double field_size = 144.0);
+
+    /// @return the length of the sides of the field (inch)
+    double get_field_size() const { return field_size; }
+
+    /**
+     * Pack a map's elements into a blob
+     * @param elements the field elements. Coordinates are rounded to hundredths of an inch
+     * @param field_size length of the sides of the field (inch)
+     * @return the blob
+     */
+    static std::vector<uint8_t> encode(const std::vector<element_t> &elements, double field_size = 144.0);
+
+    /**
+     * Unpack a map's elements from a blob
+     * @param data the blob
+     * @param len the length of the blob in bytes
+     * @param[out] elements the field elements
+     * @param[out] field_size length of the sides of the field (inch)
+     * @return true if the blob was valid. elements and field_size are not changed if it wasn't
+     */
+    static bool decode(const uint8_t *data, size_t len, std::vector<element_t> &elements, double &field_size);
+
+  private:
+    /**
+     * An edge as its start and the vector to its end, the form both distance and ray tests use
+     */
+    typedef struct {
+        double x;
+        double y;
+        double dx;
+        double dy;
+    } edge_t;
+
+    /**
+     * Whether a point is inside any element
+     */
+    bool inside_element(double x, double y) const;
+
+    /**
+     * Whether a circle moving from a to b stays clear of every edge, checking each one. a has to be clear already
+     */
+    bool exact_move_clear(const Translation2d &a, const Translation2d &b, double radius) const;
+
+    double field_size;
+    double resolution;
+    double inv_resolution;
+    // Most distance() can be over the true distance by: half a cell diagonal, and the float rounding
+    double max_blend_error;
+    int nodes; // distance field corners along each side
+    std::vector<float> sdf; // [node_y][node_x]
+
+    std::vector<edge_t> edges;
+    // Polygon elements, as ranges of edges, for inside tests. Barriers have no inside
+    std::vector<std::pair<uint32_t, uint32_t>> areas;
+
+    double bucket_size;
+    int buckets;
+    // Edges touching each bucket, in CSR form: bucket b's edges are bucket_edges[bucket_start[b]..bucket_start[b+1]]
+    std::vector<uint32_t> bucket_start;
+    std::vector<uint16_t> bucket_edges;
+};
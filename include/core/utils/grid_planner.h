@@ -0,0 +1,149 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include "core/utils/math/geometry/translation2d.h"
+#include "core/utils/pure_pursuit.h"
+
+/**
+ * GridPlanner
+ *
+ * Finds a path across the field around obstacles, fast enough to re-plan in the middle of an autonomous.
+ *
+ * The field is split into square cells, and each cell is one bit: blocked or free. Obstacles are added already grown
+ * by the robot's radius (plus half a cell diagonal, so a line between two free cell centers can't clip an obstacle
+ * between them), so the robot can be planned for as if it were a point: any free cell is a place the center of the
+ * robot can be. The walls of the field are always blocked the same way.
+ *
+ * plan() runs A* over the cells, moving to any of the 8 neighbors without cutting the corners of blocked cells, then
+ * shortcuts the result: it drives straight from each corner for as long as the path stays in sight, which takes out
+ * the 45 degree zig-zags and leaves only the corners around obstacles.
+ *
+ * All of the search's buffers are allocated when the planner is created and reused, so plan() doesn't allocate
+ * except for the path it returns.
+ */
+class GridPlanner {
+  public:
+    /**
+     * Create a planner with an empty field
+     * @param robot_radius how far obstacles are grown, robot_radius in robot_specs_t (inch)
+     * @param resolution length of the sides of a cell (inch). Smaller fits through tighter gaps but plans slower
+     * @param field_size length of the sides of the square field, which starts at (0, 0) (inch)
+     */
+    GridPlanner(double robot_radius, double resolution = 2.0, double field_size = 144.0);
+
+    /**
+     * Remove every obstacle, leaving the walls
+     */
+    void clear();
+
+    /**
+     * Add a round obstacle, like a game object or another robot
+     * @param center the center of the obstacle
+     * @param radius the radius of the obstacle (inch)
+     */
+    void add_circle(const Translation2d &center, double radius);
+
+    /**
+     * Add a rectangular obstacle lined up with the field, like a goal
+     * @param corner one corner of the rectangle
+     * @param opposite the opposite corner
+     */
+    void add_rect(const Translation2d &corner, const Translation2d &opposite);
+
+    /**
+     * Add a thin obstacle, like a barrier
+     * @param start one end of the obstacle
+     * @param end the other end
+     */
+    void add_segment(const Translation2d &start, const Translation2d &end);
+
+    /**
+     * Get whether the robot's center can be at a point without touching anything
+     * @param point the point to check
+     */
+    bool is_free(const Translation2d &point) const;
+
+    /**
+     * Get whether the robot can drive straight between two points without touching anything
+     * @param start where the robot starts
+     * @param end where the robot ends
+     */
+    bool line_of_sight(const Translation2d &start, const Translation2d &end) const;
+
+    /**
+     * Find a path between two points. The start may be inside a grown obstacle (the robot may already be brushing
+     * one, or sitting against a wall): the path then starts by getting out to the closest free cell. The goal may not
+     *
+     * @param start where the robot is
+     * @param goal where the robot should go
+     * @return the corners of the path, starting at start and ending at goal. Empty if there's no way through
+     */
+    std::vector<Translation2d> plan_points(const Translation2d &start, const Translation2d &goal);
+
+    /**
+     * Find a path between two points, for pure pursuit
+     *
+     * @param start where the robot is
+     * @param goal where the robot should go
+     * @param radius the lookahead radius for pure pursuit
+     * @return the path, or an empty (invalid) Path if there's no way through
+     */
+    PurePursuit::Path plan(const Translation2d &start, const Translation2d &goal, double radius);
+
+    /**
+     * Get the number of cells the last plan() looked at, to see how hard the search was
+     */
+    size_t get_expanded() const;
+
+  private:
+    /**
+     * Block every cell whose center is within a distance of a segment (or a point, if start == end)
+     */
+    void block_near_segment(const Translation2d &start, const Translation2d &end, double dist);
+
+    /**
+     * Block every cell whose center is within a distance of an axis aligned rectangle
+     */
+    void block_near_rect(double min_x, double min_y, double max_x, double max_y, double dist);
+
+    void block_walls();
+
+    /**
+     * line_of_sight(), letting the line cross blocked cells until it first reaches a free one, if it enters them
+     * within escape of the start (inch)
+     */
+    bool line_of_sight(const Translation2d &start, const Translation2d &end, double escape) const;
+
+    /**
+     * Find the free cell whose center is closest to a point
+     * @return false if every cell is blocked
+     */
+    bool nearest_free(const Translation2d &point, uint32_t &index, double &dist) const;
+
+    bool blocked(int cx, int cy) const;
+    void set_blocked(int cx, int cy);
+    int cell_of(double v) const;
+    Translation2d center_of(uint32_t index) const;
+
+    double inflation;
+    double resolution;
+    double field_size;
+    int cells;
+    int words_per_row;
+    std::vector<uint64_t> grid; // [cy][cx / 64] bit cx % 64
+
+    // A* state, reused between searches. A cell's g and parent are only valid if its stamp is the current search's
+    typedef struct {
+        float f;
+        uint32_t index;
+    } open_entry_t;
+    std::vector<float> g;
+    std::vector<uint32_t> parent;
+    std::vector<uint32_t> seen_stamp;
+    std::vector<uint32_t> closed_stamp;
+    std::vector<open_entry_t> open;
+    uint32_t stamp = 0;
+    size_t expanded = 0;
+};
@@ -0,0 +1,255 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <utility>
+
+#include "core/utils/math/eigen_interface.h"
+
+namespace replay_filter_detail {
+// The UKF keeps its covariance as a square root, the KF keeps it whole. Snapshot whichever the filter has, so
+// restoring a UKF doesn't need a Cholesky decomposition.
+template <typename F> auto get_cov(const F &f, int) -> decltype(f.S()) { return f.S(); }
+template <typename F> auto get_cov(const F &f, long) -> decltype(f.P()) { return f.P(); }
+template <typename F, typename M> auto set_cov(F &f, const M &cov, int) -> decltype(f.set_S(cov)) { f.set_S(cov); }
+template <typename F, typename M> auto set_cov(F &f, const M &cov, long) -> decltype(f.set_P(cov)) { f.set_P(cov); }
+} // namespace replay_filter_detail
+
+/**
+ * Applies measurements that arrive late, or out of order, to a KalmanFilter or UnscentedKalmanFilter at the time they
+ * were taken rather than the time they showed up.
+ *
+ * Every predict() records a snapshot of the time, the input, and the state and covariance the predict produced,
+ * along with the corrections applied at that step. When a correction arrives that was measured before the newest
+ * snapshot, the filter is rewound to the snapshot nearest the time it was measured, the correction is applied there
+ * with any others from that step, and the filter is predicted forward again through the recorded inputs, re-applying
+ * the corrections recorded along the way.
+ *
+ * Replaying is the expensive part, one predict per step rewound. To keep a burst of late measurements from blowing
+ * the tick, each predict() allows at most max_replay_steps steps of replay until the next predict(). A correction that
+ * would need more than what's left is rejected.
+ *
+ * Corrections are given as a function that applies them to the filter, so any of the correct() overloads (custom
+ * measurement functions, residuals, noise) can be replayed. They are stored and called again on every replay that
+ * passes over them, so they must keep whatever they capture alive.
+ *
+ * @tparam Filter a KalmanFilter or UnscentedKalmanFilter
+ * @tparam HISTORY number of steps kept. The oldest measurement that can be applied is HISTORY steps old
+ * @tparam MAX_CORRECTIONS_PER_STEP number of corrections that can be recorded against one step
+ */
+template <typename Filter, size_t HISTORY, size_t MAX_CORRECTIONS_PER_STEP = 4> class ReplayFilter {
+    static_assert(HISTORY >= 2, "ReplayFilter needs at least two steps of history to rewind");
+
+  public:
+    using StateVector = typename Filter::StateVector;
+    using InputVector = typename Filter::InputVector;
+    using CovMatrix = decltype(replay_filter_detail::get_cov(std::declval<const Filter &>(), 0));
+    using Correction = std::function<void(Filter &)>;
+
+    /**
+     * replay_stats_t counts what the filter has done with corrections
+     */
+    typedef struct {
+        uint32_t applied;       ///< corrections applied, late or not
+        uint32_t replays;       ///< times the filter was rewound for a late correction
+        uint32_t replay_steps;  ///< total steps predicted again while replaying
+        uint32_t too_old;       ///< corrections older than the history, rejected
+        uint32_t over_budget;   ///< corrections that would have gone over the replay budget, rejected
+        uint32_t step_full;     ///< corrections rejected because their step had MAX_CORRECTIONS_PER_STEP already
+        uint32_t max_replayed;  ///< most steps replayed for one correction
+    } replay_stats_t;
+
+    /**
+     * Wrap a filter
+     *
+     * @param filter the filter to wrap, with its initial state and covariance already set. Copied
+     * @param max_replay_steps the most steps that may be replayed between two predicts
+     */
+    ReplayFilter(const Filter &filter, size_t max_replay_steps = HISTORY)
+        : filter_(filter), max_replay_steps_(max_replay_steps), replay_budget_(max_replay_steps) {}
+
+    /**
+     * Returns the wrapped filter. Changing its state directly should be followed by clear()
+     */
+    Filter &filter() { return filter_; }
+
+    /**
+     * Returns the current state estimate x-hat.
+     */
+    StateVector xhat() const { return filter_.xhat(); }
+
+    /**
+     * Projects the state forward to a new time with control input u, and records the step.
+     * The first call only records where the filter is; there is nothing to predict from yet.
+     *
+     * @param u the control input over the step
+     * @param time the time (s) to predict to. Must be after the last predict's time, otherwise this does nothing
+     */
+    void predict(const InputVector &u, double time) {
+        replay_budget_ = max_replay_steps_;
+        if (count_ > 0) {
+            double dt = time - newest().time;
+            if (dt <= 0) {
+                return;
+            }
+            filter_.predict(u, dt);
+        }
+
+        snapshot_t &snap = slots_[head_];
+        snap.time = time;
+        snap.u = u;
+        snap.xhat = filter_.xhat();
+        snap.cov = replay_filter_detail::get_cov(filter_, 0);
+        snap.num_corrections = 0;
+
+        head_ = (head_ + 1) % HISTORY;
+        if (count_ < HISTORY) {
+            count_++;
+        }
+    }
+
+    /**
+     * Apply a correction measured at some time. If the time is at or after the newest step it is applied right
+     * away, otherwise the filter is rewound to the step nearest the time and replayed.
+     *
+     * @param time the time (s) the measurement was taken
+     * @param correction applies the measurement to the filter, for example
+     *   [y](KF<2,1,1> &f) { f.correct(y, EVec<1>::Zero()); }
+     * @return false if the correction was rejected: older than the history, over the replay budget, or its step
+     * already had MAX_CORRECTIONS_PER_STEP corrections
+     */
+    bool correct(double time, const Correction &correction) {
+        if (count_ == 0) {
+            correction(filter_);
+            stats_.applied++;
+            return true;
+        }
+        if (time < at(0).time) {
+            stats_.too_old++;
+            return false;
+        }
+
+        size_t step = nearest_step(time);
+        size_t replay_steps = count_ - 1 - step;
+        snapshot_t &snap = at(step);
+        if (snap.num_corrections >= MAX_CORRECTIONS_PER_STEP) {
+            stats_.step_full++;
+            return false;
+        }
+        if (replay_steps > replay_budget_) {
+            stats_.over_budget++;
+            return false;
+        }
+
+        // Keep the step's corrections in time order, so a replay applies them the same way
+        size_t i = snap.num_corrections;
+        while (i > 0 && snap.corrections[i - 1].time > time) {
+            snap.corrections[i] = snap.corrections[i - 1];
+            i--;
+        }
+        snap.corrections[i] = {time, correction};
+        snap.num_corrections++;
+        stats_.applied++;
+
+        if (replay_steps == 0 && i == snap.num_corrections - 1) {
+            // The newest measurement at the newest step, nothing to redo
+            correction(filter_);
+            return true;
+        }
+
+        replay_from(step);
+        replay_budget_ -= replay_steps;
+        stats_.replays++;
+        stats_.replay_steps += replay_steps;
+        if (replay_steps > stats_.max_replayed) {
+            stats_.max_replayed = replay_steps;
+        }
+        return true;
+    }
+
+    /**
+     * Forget the recorded steps. Call after setting the filter's state directly, since the old steps no longer lead
+     * to it.
+     */
+    void clear() {
+        head_ = 0;
+        count_ = 0;
+    }
+
+    /**
+     * Returns counts of what the filter has done with corrections
+     */
+    const replay_stats_t &stats() const { return stats_; }
+
+  private:
+    struct correction_t {
+        double time;
+        Correction apply;
+    };
+
+    struct snapshot_t {
+        double time;
+        InputVector u;
+        StateVector xhat; // after predicting to time, before its corrections
+        CovMatrix cov;
+        std::array<correction_t, MAX_CORRECTIONS_PER_STEP> corrections;
+        size_t num_corrections;
+    };
+
+    // 0 is the oldest step, count_ - 1 the newest
+    snapshot_t &at(size_t i) { return slots_[(head_ + HISTORY - count_ + i) % HISTORY]; }
+    snapshot_t &newest() { return at(count_ - 1); }
+
+    /**
+     * Find the step whose time is nearest a time at or after the oldest step
+     */
+    size_t nearest_step(double time) {
+        if (time >= newest().time) {
+            return count_ - 1;
+        }
+        size_t low = 0;
+        size_t high = count_ - 1;
+        while (high - low > 1) {
+            size_t mid = low + (high - low) / 2;
+            if (at(mid).time <= time) {
+                low = mid;
+            } else {
+                high = mid;
+            }
+        }
+        return (time - at(low).time <= at(high).time - time) ? low : high;
+    }
+
+    /**
+     * Restore a step, re-apply its corrections, then predict and correct forward through every newer step
+     */
+    void replay_from(size_t step) {
+        snapshot_t &first = at(step);
+        filter_.set_xhat(first.xhat);
+        replay_filter_detail::set_cov(filter_, first.cov, 0);
+        for (size_t c = 0; c < first.num_corrections; c++) {
+            first.corrections[c].apply(filter_);
+        }
+
+        for (size_t k = step + 1; k < count_; k++) {
+            snapshot_t &prev = at(k - 1);
+            snapshot_t &snap = at(k);
+            filter_.predict(snap.u, snap.time - prev.time);
+            snap.xhat = filter_.xhat();
+            snap.cov = replay_filter_detail::get_cov(filter_, 0);
+            for (size_t c = 0; c < snap.num_corrections; c++) {
+                snap.corrections[c].apply(filter_);
+            }
+        }
+    }
+
+    Filter filter_;
+    std::array<snapshot_t, HISTORY> slots_;
+    size_t head_ = 0;  // index the next step will be written to
+    size_t count_ = 0; // number of valid steps
+    size_t max_replay_steps_;
+    size_t replay_budget_;
+    replay_stats_t stats_{};
+};
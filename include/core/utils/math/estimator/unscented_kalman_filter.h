@@ -140,8 +140,8 @@ template <int STATES, int INPUTS, int OUTPUTS> class UnscentedKalmanFilter {
       const std::function<OutputVector(const OutputVector &, const OutputVector &)> &residual_func_Y,
       const std::function<StateVector(const StateVector &, const StateVector &)> &add_func_X
     )
-        : f_(f), h_(h), integrator_(integrator), mean_func_X_(mean_func_X), mean_func_Y_(mean_func_Y),
-          residual_func_X_(residual_func_X), residual_func_Y_(residual_func_Y), add_func_X_(add_func_X) {
+        : f_(f), h_(h), mean_func_X_(mean_func_X), mean_func_Y_(mean_func_Y), residual_func_X_(residual_func_X),
+          residual_func_Y_(residual_func_Y), add_func_X_(add_func_X), integrator_(integrator) {
         sqrt_Q_ = state_stddevs.asDiagonal();
         measurement_stddevs_ = measurement_stddevs;
 
@@ -298,7 +298,7 @@ template <int STATES, int INPUTS, int OUTPUTS> class UnscentedKalmanFilter {
       const std::function<EVec<ROWS>(const StateVector &, const InputVector &)> &h,
       const EVec<ROWS> &measurement_stddevs
     ) {
-        auto mean_func_Y = [](const EMat<OUTPUTS, NUM_SIGMAS> &sigmas, const EVec<NUM_SIGMAS> &Wc) -> EVec<ROWS> {
+        auto mean_func_Y = [](const EMat<ROWS, NUM_SIGMAS> &sigmas, const EVec<NUM_SIGMAS> &Wc) -> EVec<ROWS> {
             return sigmas * Wc;
         };
         auto residual_func_X = [](const StateVector &a, const StateVector &b) -> StateVector { return a - b; };
@@ -372,11 +372,12 @@ template <int STATES, int INPUTS, int OUTPUTS> class UnscentedKalmanFilter {
         //   P_{xy} = Σ Wᵢ⁽ᶜ⁾[𝒳ᵢ - x̂][𝒴ᵢ - ŷ⁻]ᵀ
         //           i=0
         //
-        // equation (26)
+        // equation (26). 𝒳 is the sigma points regenerated above, the ones from the last predict are stale once an
+        // earlier correct has moved the mean
         EMat<STATES, ROWS> Pxy;
         Pxy.setZero();
         for (int i = 0; i < NUM_SIGMAS; ++i) {
-            Pxy += pts_.Wc(i) * (residual_func_X(sigmas_F_.template block<STATES, 1>(0, i), xhat_)) *
+            Pxy += pts_.Wc(i) * (residual_func_X(sigmas.template block<STATES, 1>(0, i), xhat_)) *
                    (residual_func_Y(sigmas_H.template block<ROWS, 1>(0, i), yhat)).transpose();
         }
 
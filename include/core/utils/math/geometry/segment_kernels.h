@@ -0,0 +1,127 @@
+#pragma once
+
+#include <cstddef>
+#include <vector>
+
+#include "core/utils/math/geometry/translation2d.h"
+
+/**
+ * The segments of a polyline stored as a structure of arrays: all the start x's together, all the start y's
+ * together, and so on, with what every query needs (the direction, its squared length, the arc length to its start)
+ * already worked out. Built once from the points, then only read.
+ *
+ * Segment i goes from point i to point i + 1, so there is one fewer segment than points.
+ */
+class SegmentBuffer {
+  public:
+    /**
+     * Create an empty buffer
+     */
+    SegmentBuffer() = default;
+
+    /**
+     * Build the segments between consecutive points
+     * @param points the polyline
+     */
+    SegmentBuffer(const std::vector<Translation2d> &points);
+
+    /// @return the number of segments
+    size_t size() const { return start_x.size(); }
+
+    std::vector<double> start_x;    ///< x of the start of each segment
+    std::vector<double> start_y;    ///< y of the start of each segment
+    std::vector<double> dx;         ///< x of the end minus x of the start
+    std::vector<double> dy;         ///< y of the end minus y of the start
+    std::vector<double> length;     ///< length of each segment
+    std::vector<double> inv_len_sq; ///< 1 / squared length, 0 for a segment with no length
+    std::vector<double> arc_start;  ///< distance along the polyline to the start of each segment
+};
+
+/**
+ * Batch geometry queries over a SegmentBuffer.
+ *
+ * Every kernel works on a range of segments [first, first + count) and writes one result per segment into arrays the
+ * caller owns, so nothing is allocated. The loops have no branches or calls in them so the compiler can vectorize
+ * them. Results are segment parameters t, where 0 is the start of the segment and 1 is the end.
+ */
+namespace SegmentKernels {
+
+/// Written in place of a t when the circle doesn't cross the segment
+constexpr double NO_INTERSECTION = -1;
+
+/**
+ * Intersect a circle with each segment, solving |start + t * d - center| = r for t in [0, 1].
+ *
+ * @param segs the segments
+ * @param first the first segment to check
+ * @param count the number of segments to check
+ * @param center the center of the circle
+ * @param r the radius of the circle
+ * @param[out] t_near the smaller solution on each segment, or NO_INTERSECTION (count long)
+ * @param[out] t_far the larger solution on each segment, or NO_INTERSECTION (count long)
+ */
+void circle_intersections(
+  const SegmentBuffer &segs, size_t first, size_t count, const Translation2d &center, double r, double *t_near,
+  double *t_far
+);
+
+/**
+ * Find the point on each segment closest to a point
+ *
+ * @param segs the segments
+ * @param first the first segment to check
+ * @param count the number of segments to check
+ * @param point the point to measure from
+ * @param[out] t the parameter of the closest point on each segment (count long)
+ * @param[out] dist_sq the squared distance from the point to it (count long)
+ */
+void closest_points(
+  const SegmentBuffer &segs, size_t first, size_t count, const Translation2d &point, double *t, double *dist_sq
+);
+
+/**
+ * Find the closest approach between one segment and each segment in a buffer
+ *
+ * @param segs the segments
+ * @param first the first segment to check
+ * @param count the number of segments to check
+ * @param a the start of the other segment
+ * @param b the end of the other segment
+ * @param[out] dist_sq the squared distance between the other segment and each segment, 0 if they cross (count long)
+ */
+void closest_approaches(
+  const SegmentBuffer &segs, size_t first, size_t count, const Translation2d &a, const Translation2d &b,
+  double *dist_sq
+);
+
+/**
+ * Find the closest point on a range of a polyline to a point
+ *
+ * @param segs the segments
+ * @param first the first segment to check
+ * @param count the number of segments to check
+ * @param point the point to measure from
+ * @param[out] t the parameter of the closest point, on the returned segment
+ * @param[out] dist_sq the squared distance from the point to it
+ * @return the index of the segment the closest point is on, or first if count is 0
+ */
+size_t nearest_on_polyline(
+  const SegmentBuffer &segs, size_t first, size_t count, const Translation2d &point, double &t, double &dist_sq
+);
+
+/**
+ * Find the circle intersection furthest along a range of a polyline
+ *
+ * @param segs the segments
+ * @param first the first segment to check
+ * @param count the number of segments to check
+ * @param center the center of the circle
+ * @param r the radius of the circle
+ * @param[out] t the parameter of the intersection, on the returned segment
+ * @return the index of the segment the intersection is on, or first + count if the circle doesn't cross the range
+ */
+size_t furthest_circle_intersection(
+  const SegmentBuffer &segs, size_t first, size_t count, const Translation2d &center, double r, double &t
+);
+
+} // namespace SegmentKernels
@@ -0,0 +1,139 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+
+#include "core/utils/math/geometry/pose2d.h"
+
+/**
+ * PoseHistory
+ *
+ * A fixed capacity ring buffer of timestamped poses. Once full, the oldest sample is overwritten by the newest. All
+ * storage is held inside the object, so pushing and querying never allocates.
+ *
+ * Samples are expected to be pushed in increasing time order. This lets sample_at() binary search the ring for the two
+ * samples surrounding the requested time, and interpolate between them along the twist connecting them (the same
+ * constant curvature arc that Pose2d::exp() integrates along) rather than a straight line.
+ *
+ * @tparam CAPACITY the maximum number of samples held before the oldest are overwritten
+ */
+template <size_t CAPACITY> class PoseHistory {
+    static_assert(CAPACITY >= 2, "PoseHistory needs room for at least two samples to interpolate");
+
+  public:
+    /**
+     * A pose and the time (seconds) at which it was measured
+     */
+    struct sample_t {
+        double time;
+        Pose2d pose;
+    };
+
+    /**
+     * Add a sample to the history. If the sample is older than the newest sample it is dropped, if it has the same
+     * timestamp it replaces the newest sample.
+     *
+     * @param time the time (seconds) the pose was measured at
+     * @param pose the measured pose
+     */
+    void push(double time, const Pose2d &pose) {
+        if (count > 0) {
+            sample_t &last = samples[(head + CAPACITY - 1) % CAPACITY];
+            if (time < last.time) {
+                return;
+            }
+            if (time == last.time) {
+                last.pose = pose;
+                return;
+            }
+        }
+
+        samples[head] = sample_t{time, pose};
+        head = (head + 1) % CAPACITY;
+        if (count < CAPACITY) {
+            count++;
+        }
+    }
+
+    /**
+     * Find the pose at some time in the past by interpolating between the two samples surrounding it.
+     * Times outside of the stored range are clamped to the oldest or newest sample.
+     *
+     * @param time the time (seconds) to look up
+     * @param[out] out the pose at that time. Untouched if the history is empty
+     * @return false if there are no samples to look up, true otherwise
+     */
+    bool sample_at(double time, Pose2d &out) const {
+        if (count == 0) {
+            return false;
+        }
+        if (time <= at(0).time) {
+            out = at(0).pose;
+            return true;
+        }
+        if (time >= at(count - 1).time) {
+            out = at(count - 1).pose;
+            return true;
+        }
+
+        // Find the first sample newer than the requested time. at(0) is older and at(count - 1) is newer, so this
+        // always lands between them.
+        size_t low = 0;
+        size_t high = count - 1;
+        while (high - low > 1) {
+            size_t mid = low + (high - low) / 2;
+            if (at(mid).time <= time) {
+                low = mid;
+            } else {
+                high = mid;
+            }
+        }
+
+        const sample_t &before = at(low);
+        const sample_t &after = at(high);
+        double frac = (time - before.time) / (after.time - before.time);
+
+        out = before.pose.exp(before.pose.log(after.pose) * frac);
+        return true;
+    }
+
+    /**
+     * Get a sample by age
+     * @param i index of the sample, 0 is the oldest and size() - 1 is the newest
+     * @return the sample
+     */
+    const sample_t &at(size_t i) const { return samples[(head + CAPACITY - count + i) % CAPACITY]; }
+
+    /**
+     * @return the most recently pushed sample. Invalid if the history is empty
+     */
+    const sample_t &newest() const { return at(count - 1); }
+
+    /**
+     * @return the oldest sample still held. Invalid if the history is empty
+     */
+    const sample_t &oldest() const { return at(0); }
+
+    /**
+     * @return the number of samples currently held
+     */
+    size_t size() const { return count; }
+
+    /**
+     * @return true if no samples have been pushed since construction or the last clear()
+     */
+    bool empty() const { return count == 0; }
+
+    /**
+     * Forget all samples
+     */
+    void clear() {
+        head = 0;
+        count = 0;
+    }
+
+  private:
+    std::array<sample_t, CAPACITY> samples;
+    size_t head = 0;  // index the next sample will be written to
+    size_t count = 0; // number of valid samples
+};
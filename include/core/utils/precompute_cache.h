@@ -0,0 +1,197 @@
+#pragma once
+
+#include "vex.h"
+
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+#include <functional>
+#include <map>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+/**
+ * A hash of everything that goes into computing something, used to find it in a PrecomputeCache. Start it with a name
+ * for what's being computed, then add every input: waypoints, limits, model parameters. Change the name (a version
+ * number on the end works) when the code that computes it changes, so old results aren't used.
+ *
+ * The hash is 64 bit FNV-1a over the bytes of the inputs. Add structs one field at a time: padding between fields
+ * isn't set to anything, so hashing a whole struct can give a different key for the same values.
+ */
+class CacheKey {
+  public:
+    /**
+     * Start a key
+     * @param name what's being computed
+     */
+    CacheKey(const std::string &name);
+
+    /**
+     * Add a number to the key
+     * @param value the number
+     * @return this key, to chain adds
+     */
+    template <typename T> CacheKey &add(T value) {
+        static_assert(std::is_arithmetic<T>::value, "add structs one field at a time");
+        return add_bytes(&value, sizeof(value));
+    }
+
+    /**
+     * Add a list to the key, like waypoints. The element type must have no padding, like Translation2d
+     * @param values the list
+     * @return this key, to chain adds
+     */
+    template <typename T> CacheKey &add(const std::vector<T> &values) {
+        static_assert(std::is_trivially_copyable<T>::value, "elements must be plain data");
+        add((uint32_t)values.size());
+        return add_bytes(values.data(), values.size() * sizeof(T));
+    }
+
+    /**
+     * Add a string to the key
+     * @param str the string
+     * @return this key, to chain adds
+     */
+    CacheKey &add(const std::string &str);
+    CacheKey &add(const char *str) { return add(std::string(str)); }
+
+    /**
+     * Get the hash
+     */
+    uint64_t value() const;
+
+  private:
+    CacheKey &add_bytes(const void *data, size_t len);
+
+    uint64_t hash;
+};
+
+/**
+ * PrecomputeCache
+ *
+ * Keeps things that are slow to compute but always come out the same (paths, trajectories, gains) in one file on the
+ * SD card, so they don't have to be computed again every time the program starts.
+ *
+ * Use it in three steps during pre-auton:
+ *   1. load() reads the whole file with one read.
+ *   2. add() every artifact with its key and the function that computes it. Ones found in the file are ready right
+ *      away.
+ *   3. start() computes the rest on a background task, then writes the file once with only the artifacts added this
+ *      run, so results for old inputs don't pile up.
+ * get() then returns an artifact, waiting for the background task if it hasn't been computed yet (or computing it on
+ * the spot if start() was never called).
+ *
+ * Artifacts are lists of plain data (Translation2d, Trajectory::state_t, doubles) stored as their bytes, so a file is
+ * only good for the program that wrote it. Keys should include anything that changes the layout.
+ *
+ * File format (little endian):
+ *   uint32_t magic            FILE_MAGIC
+ *   uint32_t count            number of entries
+ *   count times:
+ *     uint64_t key            CacheKey::value()
+ *     uint32_t size           number of bytes
+ *     uint8_t  data[size]
+ *   uint32_t crc32            CRC32 of every byte before it. A file that doesn't match is ignored
+ */
+class PrecomputeCache {
+  public:
+    /// First 4 bytes of the file, "PCC1"
+    static constexpr uint32_t FILE_MAGIC = 0x31434350;
+    /// How often get() checks whether the background task has finished (ms)
+    static constexpr uint32_t WAIT_DELAY_MS = 5;
+
+    /**
+     * Create a cache
+     * @param filename the file on the SD card to keep the artifacts in
+     */
+    PrecomputeCache(const std::string &filename = "precompute.bin");
+
+    /**
+     * Read the file. Entries in it are only used if add() is called with their key
+     * @return true if the file was there and valid
+     */
+    bool load();
+
+    /**
+     * Add an artifact. If it was loaded from the file it's ready now, otherwise start() computes it.
+     * @param key the hash of everything that goes into computing it
+     * @param compute computes it. Runs on the background task, so it must not use anything another task changes
+     */
+    template <typename T> void add(const CacheKey &key, std::function<std::vector<T>()> compute) {
+        static_assert(std::is_trivially_copyable<T>::value, "artifacts must be lists of plain data");
+        add_bytes(key.value(), [compute]() {
+            std::vector<T> value = compute();
+            std::vector<uint8_t> bytes(value.size() * sizeof(T));
+            if (!bytes.empty()) {
+                memcpy(bytes.data(), value.data(), bytes.size());
+            }
+            return bytes;
+        });
+    }
+
+    /**
+     * Compute every artifact that wasn't in the file on a background task, then save the file. Does nothing (and
+     * doesn't rewrite the file) if everything was found
+     */
+    void start();
+
+    /**
+     * Get an artifact, waiting for it if it's still being computed
+     * @param key the key it was added with
+     * @return the artifact, or an empty list if it was never added
+     */
+    template <typename T> std::vector<T> get(const CacheKey &key) {
+        static_assert(std::is_trivially_copyable<T>::value, "artifacts must be lists of plain data");
+        std::vector<uint8_t> bytes;
+        if (!get_bytes(key.value(), bytes) || bytes.size() % sizeof(T) != 0) {
+            return {};
+        }
+        std::vector<T> value(bytes.size() / sizeof(T));
+        if (!bytes.empty()) {
+            memcpy(value.data(), bytes.data(), bytes.size());
+        }
+        return value;
+    }
+
+    /**
+     * Get whether every artifact is ready
+     */
+    bool is_ready();
+
+    /**
+     * Get the number of artifacts that were found in the file
+     */
+    size_t num_hits();
+
+    /**
+     * Get the number of artifacts that had to be computed
+     */
+    size_t num_misses();
+
+  private:
+    void add_bytes(uint64_t key, std::function<std::vector<uint8_t>()> compute);
+    bool get_bytes(uint64_t key, std::vector<uint8_t> &out);
+
+    /**
+     * Write every artifact added this run to the file
+     */
+    bool save();
+
+    static int compute_thread(void *ptr);
+
+    std::string filename;
+    vex::mutex mut;
+    vex::task compute_task;
+
+    // Everything read from the file, by key
+    std::map<uint64_t, std::vector<uint8_t>> loaded;
+    // Artifacts added this run, by key. Missing until computed
+    std::map<uint64_t, std::vector<uint8_t>> ready;
+    // Artifacts still to be computed
+    std::vector<std::pair<uint64_t, std::function<std::vector<uint8_t>()>>> to_compute;
+
+    std::atomic<bool> computing{false};
+    size_t hits = 0;
+    size_t misses = 0;
+};
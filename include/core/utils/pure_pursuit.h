@@ -2,8 +2,11 @@
 
 #include "core/utils/geometry.h"
 #include "core/utils/math/geometry/pose2d.h"
+#include "core/utils/math/geometry/segment_kernels.h"
 #include "core/utils/math/geometry/translation2d.h"
 #include "vex.h"
+#include <memory>
+#include <utility>
 #include <vector>
 
 using namespace vex;
@@ -11,9 +14,29 @@ using namespace vex;
 namespace PurePursuit {
 /**
  * Wrapper for a vector of points, checking if any of the points are too close for pure pursuit
+ *
+ * A path is too close for pure pursuit when two of its segments come within the lookahead radius of each other while
+ * being more than a radius apart along the path: the lookahead circle could reach the later one early and cut the
+ * path short. Segments closer than that along the path (like the neighbors on a path with many points) are expected
+ * to be within a radius, and aren't counted.
+ *
+ * A Path never changes after it's created. Copies share the same points, so passing one by value (to a command, or
+ * to TankDrive::pure_pursuit every tick) doesn't copy them. The arc length from the start of the path to each point
+ * is found once when the path is created.
  */
 class Path {
   public:
+    /// A pair of segments that are too close, by index. Segment i goes from point i to point i + 1
+    typedef std::pair<size_t, size_t> conflict_t;
+
+    /// Most pairs of too close segments that are found before the check stops looking
+    static constexpr size_t MAX_CONFLICTS = 16;
+
+    /**
+     * Create an empty path, that is not valid
+     */
+    Path();
+
     /**
      * Create a Path
      * @param points the points that make up the path
@@ -24,23 +47,129 @@ class Path {
     /**
      * Get the points associated with this Path
      */
-    const std::vector<Translation2d> get_points();
+    const std::vector<Translation2d> &get_points() const;
+
+    /**
+     * Get the distance along the path from the first point to each point. The first is 0, the last is get_length()
+     */
+    const std::vector<double> &get_arc_lengths() const;
+
+    /**
+     * Get the total length of the path, following every segment
+     */
+    double get_length() const;
+
+    /**
+     * Get the path's segments, laid out for the batch queries in SegmentKernels
+     */
+    const SegmentBuffer &get_segments() const;
 
     /**
      * Get the radius associated with this Path
      */
-    double get_radius();
+    double get_radius() const;
 
     /**
      * Get whether this path will behave as expected
      */
-    bool is_valid();
+    bool is_valid() const;
+
+    /**
+     * Get the pairs of segments that made the path invalid by coming too close to each other, for finding what's
+     * wrong with a path. Empty if the path is valid
+     */
+    const std::vector<conflict_t> &get_conflicts() const;
 
   private:
-    std::vector<Translation2d> points;
-    double radius;
-    bool valid;
+    /**
+     * Find pairs of segments that come within a radius of each other, but are more than a radius apart along the path
+     * @param segs the path's segments
+     * @param radius the lookahead radius
+     * @return up to MAX_CONFLICTS pairs that are too close, earlier segment first
+     */
+    static std::vector<conflict_t> find_conflicts(const SegmentBuffer &segs, double radius);
+
+    struct path_data_t {
+        std::vector<Translation2d> points;
+        std::vector<double> arc_lengths;
+        SegmentBuffer segments;
+        std::vector<conflict_t> conflicts;
+        double radius;
+        bool valid;
+    };
+
+    std::shared_ptr<const path_data_t> data;
 };
+
+/**
+ * Follows a Path one update at a time, remembering how far along it the robot has gotten.
+ *
+ * The robot is tracked by a cursor on the segment it's closest to, which only moves forward. Each update only looks at
+ * the segments within a lookahead radius (by distance along the path) past the cursor, both to move the cursor and
+ * to find the lookahead point, so the cost of an update doesn't grow with the length of the path. It also means a
+ * path that comes back near itself won't pull the robot onto a later part early. The remaining distance comes from
+ * the path's arc lengths, without walking the path.
+ */
+class Tracker {
+  public:
+    /**
+     * Create a tracker with nothing to follow
+     */
+    Tracker() = default;
+
+    /**
+     * Create a tracker at the start of a path
+     * @param path the path to follow
+     */
+    Tracker(const Path &path);
+
+    /**
+     * Move the tracker back to the start of its path
+     */
+    void reset();
+
+    /**
+     * Move the cursor to the part of the path the robot is closest to, then find the lookahead point
+     * @param robot_pose the robot's current position
+     */
+    void update(const Pose2d &robot_pose);
+
+    /**
+     * Get the lookahead point found by the last update(). The furthest intersection of the lookahead circle with the
+     * path near the robot, or the end of the path if it's within the lookahead radius (or there is no intersection)
+     */
+    Translation2d get_lookahead() const;
+
+    /**
+     * Get whether the lookahead point is the end of the path
+     */
+    bool is_lookahead_end() const;
+
+    /**
+     * Get the distance left to drive as of the last update(). Along the path from the robot's closest point, or
+     * straight to the end once the end is the lookahead point
+     */
+    double get_remaining_dist() const;
+
+    /**
+     * Get the distance along the path to the point closest to the robot
+     */
+    double get_progress() const;
+
+    /**
+     * Get the index of the segment (from point i to i + 1) the robot is closest to
+     */
+    size_t get_segment() const;
+
+  private:
+    Path path;
+    size_t segment = 0;
+    double progress = 0;
+    Translation2d lookahead;
+    bool lookahead_is_end = false;
+    double remaining_dist = 0;
+};
+
 /**
  * Represents a piece of a cubic spline with s(x) = a(x-xi)^3 + b(x-xi)^2 + c(x-xi) + d
  * The x_start and x_end shows where the equation is valid.
@@ -95,6 +224,26 @@ extern std::vector<Translation2d> inject_path(const std::vector<Translation2d> &
 extern std::vector<Translation2d>
 smooth_path(const std::vector<Translation2d> &path, double weight_data, double weight_smooth, double tolerance);
 
+/**
+ * Returns the path smooth_path() converges to, found directly instead of by iterating.
+ *
+ * smooth_path() stops changing when every free point y_i is balanced between staying near its original point x_i and
+ * the middle of its neighbors:
+ *   weight_data * (x_i - y_i) + weight_smooth * (y_i-1 + y_i+1 - 2 y_i) = 0
+ * That's one equation per point with only three unknowns in it, so all of them together are a tridiagonal system,
+ * solved in one forward and one backward sweep. The time only depends on the number of points.
+ *
+ * @param path the points to smooth
+ * @param weight_data how strongly points are pulled back to where they started (alpha)
+ * @param weight_smooth how strongly points are pulled toward their neighbors (beta)
+ * @param pinned indices of points that must not move, besides the first and last
+ * @return the smoothed path, the same length as path
+ */
+extern std::vector<Translation2d> smooth_path_direct(
+  const std::vector<Translation2d> &path, double weight_data, double weight_smooth,
+  const std::vector<size_t> &pinned = {}
+);
+
 extern std::vector<Translation2d> smooth_path_cubic(const std::vector<Translation2d> &path, double res);
 
 /**
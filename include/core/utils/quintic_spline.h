@@ -0,0 +1,90 @@
+#pragma once
+
+#include <vector>
+
+#include "core/utils/math/geometry/translation2d.h"
+#include "core/utils/pure_pursuit.h"
+#include "core/utils/trajectory.h"
+
+/**
+ * A path through a list of knots made of quintic Hermite pieces. Each piece matches the position, direction and
+ * second derivative of its neighbors where they meet, so the curvature is continuous across knots, unlike
+ * PurePursuit::smooth_path_hermite where it jumps at every knot. The second derivative at each knot isn't given, so
+ * it's taken as the average of what a cubic Hermite piece on either side would have there.
+ *
+ * Each piece is stored as polynomial coefficients and evaluated with Horner's method. subdivide() places points by how
+ * much the path curves instead of a fixed number per piece: long straight pieces get a few points, tight curves as many
+ * as the tolerance needs.
+ */
+class QuinticSpline {
+  public:
+    /// Pieces are split at most this many times deep, so subdivide() always ends
+    static constexpr int MAX_DEPTH = 16;
+    /// Most the path can turn between two points from subdivide() (rad)
+    static constexpr double MAX_TURN = 0.2;
+
+    /**
+     * Build the spline through a list of knots
+     * @param knots where the path goes, the direction it goes there, and how strongly (the tangent's magnitude, like
+     * smooth_path_hermite)
+     */
+    QuinticSpline(const std::vector<PurePursuit::hermite_point> &knots);
+
+    /**
+     * Get the number of pieces, one fewer than the knots
+     */
+    size_t num_pieces() const;
+
+    /**
+     * Find a point on the spline
+     * @param u the piece plus how far along it (0 to 1) the point is, so 1.5 is halfway along the second piece.
+     * Clamped to the ends of the spline
+     * @return the point, the direction of the path there and its curvature
+     */
+    Trajectory::path_point_t evaluate(double u) const;
+
+    /**
+     * Place points along the spline, closer together where it curves. A piece between two points is split in half
+     * while the middle of it is more than tolerance from the straight line between them, it turns more than MAX_TURN,
+     * or it's longer than max_spacing.
+     *
+     * @param tolerance most the path can stray from the straight line between two points (inch)
+     * @param max_spacing most distance between two points, so a Trajectory has enough points on long straights to
+     * plan speeds with (inch). 0 for no limit
+     * @return the points, starting at the first knot and ending at the last, with their directions and curvatures
+     */
+    std::vector<Trajectory::path_point_t> subdivide(double tolerance, double max_spacing = 0) const;
+
+    /**
+     * subdivide(), for a path that only needs the positions, like a PurePursuit::Path
+     * @param tolerance most the path can stray from the straight line between two points (inch)
+     * @param max_spacing most distance between two points (inch). 0 for no limit
+     * @return the points, starting at the first knot and ending at the last
+     */
+    std::vector<Translation2d> subdivide_points(double tolerance, double max_spacing = 0) const;
+
+  private:
+    /**
+     * piece_t is one quintic piece, x(s) = x[0] + x[1] s + ... + x[5] s^5 for s from 0 to 1, and the same for y
+     */
+    typedef struct {
+        double x[6];
+        double y[6];
+    } piece_t;
+
+    /**
+     * Evaluate a piece
+     */
+    Trajectory::path_point_t evaluate(const piece_t &piece, double s) const;
+
+    /**
+     * Split [s0, s1] on a piece until it's within tolerance, adding the end of every part to out
+     */
+    void subdivide(
+      const piece_t &piece, double s0, const Trajectory::path_point_t &p0, double s1,
+      const Trajectory::path_point_t &p1, double tolerance, double max_spacing, int depth,
+      std::vector<Trajectory::path_point_t> &out
+    ) const;
+
+    std::vector<piece_t> pieces;
+};
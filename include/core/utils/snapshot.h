@@ -0,0 +1,84 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+#include <type_traits>
+
+#include "vex.h"
+
+/**
+ * SeqLock
+ *
+ * Shares a small, plain-old-data value between one writer and any number of readers without either side ever taking
+ * a mutex. Meant for state a background task owns and everything else polls, like the odometry pose or a flywheel's
+ * RPM: the writer never waits on readers, and readers never wait on the writer's update() finishing, only on the copy
+ * itself.
+ *
+ * The writer bumps a sequence number to odd, copies the value in, then bumps it back to even. A reader copies the
+ * value out and keeps it only if the sequence number was the same even number before and after the copy. Otherwise
+ * the writer was in the middle of a write, and the reader yields and tries again.
+ *
+ * Only one task may write at a time. If more than one task writes, they must be serialized by something else (for
+ * example a mutex the writers already hold).
+ *
+ * @tparam T the value to share. Must be trivially copyable since it is copied byte by byte
+ */
+template <typename T> class SeqLock {
+    static_assert(std::is_trivially_copyable<T>::value, "SeqLock copies T byte by byte, T must be trivially copyable");
+
+  public:
+    /**
+     * Create a SeqLock holding a value initialized T
+     */
+    SeqLock() : data() {}
+
+    /**
+     * Create a SeqLock holding an initial value
+     * @param initial the value readers will see until the first write
+     */
+    explicit SeqLock(const T &initial) : data(initial) {}
+
+    /**
+     * Publish a new value. Never blocks
+     * @param value the value to publish
+     */
+    void write(const T &value) {
+        uint32_t s = seq.load(std::memory_order_relaxed);
+        seq.store(s + 1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+        std::memcpy(&data, &value, sizeof(T));
+        seq.store(s + 2, std::memory_order_release);
+    }
+
+    /**
+     * Try once to copy out the latest value
+     * @param[out] out the latest value. May be garbage if this returns false
+     * @return false if the copy raced a write and must be retried
+     */
+    bool try_read(T &out) const {
+        uint32_t before = seq.load(std::memory_order_acquire);
+        if (before & 1) {
+            return false;
+        }
+        std::memcpy(&out, &data, sizeof(T));
+        std::atomic_thread_fence(std::memory_order_acquire);
+        return seq.load(std::memory_order_relaxed) == before;
+    }
+
+    /**
+     * Copy out the latest value, yielding to the writer if a write is in progress
+     * @return the latest value written
+     */
+    T read() const {
+        T out;
+        while (!try_read(out)) {
+            vex::this_thread::yield();
+        }
+        return out;
+    }
+
+  private:
+    std::atomic<uint32_t> seq{0}; // odd while a write is in progress
+    T data;
+};
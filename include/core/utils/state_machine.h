@@ -3,6 +3,8 @@
 #include <type_traits>
 #include <utility>
 
+#include "core/utils/snapshot.h"
+
 /**
  * @brief State Machine :))))))
  * A fun fun way of controlling stateful subsystems - used in the 2023-2024 Over
@@ -103,15 +105,11 @@ public:
 
   /**
    * @brief retrieve the current state of the state machine. This is safe to
-   * call from external threads
+   * call from external threads and never waits on the runner thread, even in
+   * the middle of a state's entry or exit
    * @return the current state
    */
-  IDType current_state() const {
-    mut.lock();
-    auto t = cur_type;
-    mut.unlock();
-    return t;
-  }
+  IDType current_state() const { return cur_type.read(); }
   /**
    * @brief send a message to the state machine from outside
    * @param msg the message to send
@@ -125,9 +123,9 @@ public:
 
 private:
   vex::task runner;
-  mutable vex::mutex mut;
+  vex::mutex mut; // guards incoming_msg
   MaybeMessage incoming_msg;
-  IDType cur_type;
+  SeqLock<IDType> cur_type; // only written by the runner thread
 
   /**
    * @brief the thread that does the running of the state machine.
@@ -144,7 +142,7 @@ private:
 
     cur_state->entry(derived);
 
-    sys.cur_type = cur_state->id();
+    sys.cur_type.write(cur_state->id());
 
     auto respond_to_message = [&](Message msg) {
       if (do_log) {
@@ -156,24 +154,20 @@ private:
 
       if (cur_state != next_state) {
         // switched states
-        sys.mut.lock();
-
         cur_state->exit(derived);
         next_state->entry(derived);
 
         delete cur_state;
 
         cur_state = next_state;
-        sys.cur_type = cur_state->id();
-
-        sys.mut.unlock();
+        sys.cur_type.write(cur_state->id());
       }
     };
 
     while (true) {
       if (do_log) {
         std::string str = to_string(cur_state->id());
-        std::string str2 = to_string(sys.cur_type);
+        std::string str2 = to_string(sys.cur_type.read());
 
         printf("state: %s %s\n", str.c_str(), str2.c_str());
       }
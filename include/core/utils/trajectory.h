@@ -0,0 +1,117 @@
+#pragma once
+
+#include <memory>
+#include <vector>
+
+#include "core/utils/math/geometry/pose2d.h"
+#include "core/utils/math/geometry/translation2d.h"
+
+/**
+ * A path with a speed worked out for every point along it, for a differential (tank) drive.
+ *
+ * The path is split into short pieces by distance along it, and each piece gets the fastest speed the robot can take
+ * it at: no faster than max_vel, slow enough on curves that the outside wheel stays under max_vel and the robot doesn't
+ * slide out (max_centripetal_accel). A forward pass then limits how fast the robot can speed up into each piece, and a
+ * backward pass how fast it has to slow down out of it, both by max_accel. Assuming constant acceleration across each
+ * piece gives the time the robot reaches every point.
+ *
+ * The result is a list of states sorted by time, and sample() finds the state at any time with a binary search. Like a
+ * PurePursuit::Path, a Trajectory never changes after it's created, and copies share the same states.
+ *
+ * Distances are in inches, times in seconds and angles in radians.
+ */
+class Trajectory {
+  public:
+    /**
+     * trajectory_config_t holds the limits a trajectory is generated with
+     */
+    typedef struct {
+        double max_vel;               ///< top speed of either side of the drive (inch/s)
+        double max_accel;             ///< fastest the robot can speed up or slow down (inch/s^2)
+        double max_centripetal_accel; ///< fastest the robot can turn without sliding, v^2 * curvature (inch/s^2)
+        double track_width;           ///< distance between the left and right wheels, dist_between_wheels in
+                                      ///< robot_specs_t (inch)
+        double start_vel;             ///< speed at the start of the path (inch/s)
+        double end_vel;               ///< speed at the end of the path (inch/s)
+        double spacing;               ///< distance between points when a list of waypoints is filled in (inch)
+        bool reversed;                ///< true to drive the path backwards, with the back of the robot leading
+    } trajectory_config_t;
+
+    /**
+     * path_point_t is one point on a path, with the direction the path is going and how sharply it's turning
+     */
+    typedef struct {
+        Pose2d pose;      ///< where the point is, and the direction of the path there
+        double curvature; ///< 1 / turning radius, positive turning left (1/inch)
+    } path_point_t;
+
+    /**
+     * state_t is where the robot should be, and how it should be moving, at one time
+     */
+    typedef struct {
+        double time;      ///< time since the start of the trajectory (s)
+        double dist;      ///< distance along the path (inch)
+        Pose2d pose;      ///< where the robot is, facing the way it's driving (or away from it, if reversed)
+        double vel;       ///< speed of the center of the robot, negative if reversed (inch/s)
+        double accel;     ///< rate the speed changes at (inch/s^2)
+        double curvature; ///< angular velocity / vel, positive turning left (1/inch)
+    } state_t;
+
+    /**
+     * Create an empty trajectory, that takes no time
+     */
+    Trajectory();
+
+    /**
+     * Generate a trajectory through a list of waypoints, connected by straight lines. The lines are filled in with
+     * points config.spacing apart, and the curvature at each point is the curvature of the circle through it and its
+     * neighbors, so a sharp corner in the waypoints makes the robot slow nearly to a stop. Smooth the waypoints first
+     * (or use path points from a spline) for a faster trajectory.
+     *
+     * @param waypoints the points to drive through
+     * @param config the limits to generate with
+     */
+    Trajectory(const std::vector<Translation2d> &waypoints, const trajectory_config_t &config);
+
+    /**
+     * Generate a trajectory along points sampled from a curve, such as a spline, that already know their direction and
+     * curvature. The points are used as they are, so they should be close together.
+     *
+     * @param path the points along the path, in order
+     * @param config the limits to generate with (spacing is not used)
+     */
+    Trajectory(const std::vector<path_point_t> &path, const trajectory_config_t &config);
+
+    /**
+     * Create a trajectory from states that were already generated, like ones loaded from a PrecomputeCache
+     * @param states the states, in order of time
+     */
+    explicit Trajectory(std::vector<state_t> states);
+
+    /**
+     * Find where the robot should be at a time, between the two states around it. Times before the start or after the
+     * end get the first or last state.
+     *
+     * @param t time since the start of the trajectory (s)
+     * @return the state at that time
+     */
+    state_t sample(double t) const;
+
+    /**
+     * Get the time it takes to drive the whole trajectory
+     */
+    double total_time() const;
+
+    /**
+     * Get the length of the path, following every point
+     */
+    double total_dist() const;
+
+    /**
+     * Get every state of the trajectory, in order of time
+     */
+    const std::vector<state_t> &get_states() const;
+
+  private:
+    std::shared_ptr<const std::vector<state_t>> states;
+};
@@ -0,0 +1,271 @@
+#include "core/device/serial_service.h"
+
+/**
+ * Get the service shared by every serial device. The service task is started the first time a port is added.
+ * @return the serial service
+ */
+SerialService &SerialService::instance() {
+    static SerialService service;
+    return service;
+}
+
+/**
+ * Enable a smart port as generic serial and start servicing it.
+ *
+ * @param port the vex::PORTXX to use
+ * @param baud the baud rate to run the port at (i.e. 115200)
+ * @param handler called on the service task with every packet decoded from the port
+ * @param max_frame_size the largest decoded packet to accept, longer packets are counted and dropped
+ * @param tx_buffer_size the number of encoded bytes that can wait to be sent
+ * @return false if the port was already added or there is no room for another port
+ */
+bool SerialService::add_port(
+  int32_t port, int32_t baud, FrameHandler handler, size_t max_frame_size, size_t tx_buffer_size
+) {
+    add_mut.lock();
+    size_t count = num_endpoints.load();
+    if (find(port) != nullptr || count >= MAX_PORTS) {
+        add_mut.unlock();
+        printf("SerialService: could not add port %ld\n", (long)port);
+        return false;
+    }
+
+    vexGenericSerialEnable(port, 0);
+    vexGenericSerialBaudrate(port, baud);
+
+    Endpoint *ep = new Endpoint();
+    ep->port = port;
+    ep->handler = std::move(handler);
+    // COBS adds a code byte every 254, plus one
+    ep->max_wire_size = max_frame_size + max_frame_size / 254 + 1;
+    ep->tx_ring.resize(tx_buffer_size);
+
+    // Reserve the worst case up front so receiving never allocates
+    ep->rx_wire.reserve(ep->max_wire_size);
+    ep->rx_decoded.reserve(ep->max_wire_size + ep->max_wire_size / 254);
+
+    endpoints[count] = ep;
+    num_endpoints.store(count + 1);
+
+    if (!started) {
+        service_task = vex::task(SerialService::service_thread, (void *)this, vex::thread::threadPriorityHigh);
+        started = true;
+    }
+    add_mut.unlock();
+    return true;
+}
+
+/**
+ * Queue a packet to be COBS encoded and sent.
+ *
+ * The packet is encoded straight into the port's ring buffer. The worst case encoded size is checked first so a packet
+ * is either queued whole or not at all.
+ *
+ * @param port the port to send on, must have been added with add_port()
+ * @param data the data to encode then write
+ * @param size the number of bytes of data
+ * @param leading_delimeter true to add a leading delimiter to the packet
+ * @return false if the port was never added or the transmit buffer does not have room for the packet
+ */
+bool SerialService::send_frame(int32_t port, const uint8_t *data, size_t size, bool leading_delimeter) {
+    Endpoint *ep = find(port);
+    if (ep == nullptr || size == 0) {
+        return false;
+    }
+
+    // One code byte every 254 data bytes plus the first, and the delimiters
+    size_t worst_case = size + size / 254 + 1 + 1 + (leading_delimeter ? 1 : 0);
+
+    ep->tx_mut.lock();
+    size_t capacity = ep->tx_ring.size();
+    if (capacity - ep->tx_count < worst_case) {
+        ep->stats.tx_overflows++;
+        ep->tx_mut.unlock();
+        return false;
+    }
+
+    uint8_t *ring = ep->tx_ring.data();
+    size_t tail = (ep->tx_head + ep->tx_count) % capacity;
+    size_t written = 0;
+    auto put = [&](uint8_t b) {
+        ring[(tail + written) % capacity] = b;
+        return written++;
+    };
+
+    if (leading_delimeter) {
+        put(0);
+    }
+    size_t code_at = put(1);
+    uint8_t code = 1;
+    for (size_t i = 0; i < size; i++) {
+        if (data[i] != 0) {
+            put(data[i]);
+            code++;
+        }
+        if (data[i] == 0 || code == 0xff) {
+            ring[(tail + code_at) % capacity] = code;
+            code_at = put(1);
+            code = 1;
+        }
+    }
+    ring[(tail + code_at) % capacity] = code;
+    put(0);
+
+    ep->tx_count += written;
+    ep->stats.frames_out++;
+    if (ep->tx_count > ep->stats.tx_high_water) {
+        ep->stats.tx_high_water = ep->tx_count;
+    }
+    ep->tx_mut.unlock();
+    return true;
+}
+
+/**
+ * @param port the port to look up
+ * @param[out] out the traffic counts for the port. Untouched if the port was never added
+ * @return false if the port was never added
+ */
+bool SerialService::get_stats(int32_t port, port_stats_t &out) {
+    Endpoint *ep = find(port);
+    if (ep == nullptr) {
+        return false;
+    }
+    ep->tx_mut.lock();
+    out = ep->stats;
+    out.tx_pending = ep->tx_count;
+    ep->tx_mut.unlock();
+    return true;
+}
+
+/**
+ * @return the endpoint for a port, or nullptr if the port was never added
+ */
+SerialService::Endpoint *SerialService::find(int32_t port) {
+    size_t count = num_endpoints.load();
+    for (size_t i = 0; i < count; i++) {
+        if (endpoints[i]->port == port) {
+            return endpoints[i];
+        }
+    }
+    return nullptr;
+}
+
+/**
+ * Write as much of the port's transmit buffer as the port will take without blocking.
+ * Only the contiguous run up to the end of the ring is written each call, the wrapped part goes out next time around.
+ *
+ * @return true if any bytes were written
+ */
+bool SerialService::write_pending(Endpoint &ep) {
+    ep.tx_mut.lock();
+    size_t pending = ep.tx_count;
+    size_t head = ep.tx_head;
+    ep.tx_mut.unlock();
+    if (pending == 0) {
+        return false;
+    }
+
+    int32_t num_free = vexGenericSerialWriteFree(ep.port);
+    if (num_free <= 0) {
+        return false;
+    }
+
+    size_t capacity = ep.tx_ring.size();
+    size_t to_send = pending;
+    if (to_send > capacity - head) {
+        to_send = capacity - head;
+    }
+    if (to_send > (size_t)num_free) {
+        to_send = num_free;
+    }
+
+    // send_frame() only ever appends past head + count, so the bytes being sent can't change under us
+    int32_t sent = vexGenericSerialTransmit(ep.port, ep.tx_ring.data() + head, to_send);
+    if (sent <= 0) {
+        return false;
+    }
+
+    ep.tx_mut.lock();
+    ep.tx_head = (ep.tx_head + sent) % capacity;
+    ep.tx_count -= sent;
+    ep.stats.bytes_out += sent;
+    ep.tx_mut.unlock();
+    return true;
+}
+
+/**
+ * Read every byte the port has buffered, dispatching any packets completed along the way.
+ * Only the bytes buffered when this was called are consumed, so a fast stream on one port can't starve the rest.
+ *
+ * @return true if any bytes were read
+ */
+bool SerialService::read_available(Endpoint &ep) {
+    int32_t avail = vexGenericSerialReceiveAvail(ep.port);
+    bool did_something = avail > 0;
+    while (avail > 0) {
+        int32_t to_read = avail < (int32_t)sizeof(read_buffer) ? avail : (int32_t)sizeof(read_buffer);
+        int32_t num_read = vexGenericSerialReceive(ep.port, read_buffer, to_read);
+        if (num_read <= 0) {
+            break;
+        }
+
+        ep.stats.bytes_in += num_read;
+        for (int32_t i = 0; i < num_read; i++) {
+            handle_incoming_byte(ep, read_buffer[i]);
+        }
+        avail -= num_read;
+    }
+    return did_something;
+}
+
+/**
+ * Add one byte from the wire to the packet being received. On a delimiter the packet is decoded and handed to the
+ * port's handler.
+ */
+void SerialService::handle_incoming_byte(Endpoint &ep, uint8_t byte) {
+    if (byte != 0) {
+        if (ep.rx_wire.size() < ep.max_wire_size) {
+            ep.rx_wire.push_back(byte);
+        } else {
+            // Too long for this port, throw it out when the delimiter shows up
+            ep.rx_overflow = true;
+        }
+        return;
+    }
+
+    if (ep.rx_overflow) {
+        ep.stats.rx_overflows++;
+    } else if (ep.rx_wire.size() != 0) {
+        COBSSerialDevice::cobs_decode(ep.rx_wire, ep.rx_decoded);
+        ep.stats.frames_in++;
+        if (ep.handler) {
+            ep.handler(ep.rx_decoded.data(), ep.rx_decoded.size());
+        }
+    }
+    // An empty packet is just back to back delimiters, nothing to do
+
+    ep.rx_wire.clear();
+    ep.rx_overflow = false;
+}
+
+/**
+ * The service task. Lame replacement for blocking IO: we can't wait on a port and let the scheduler work on something
+ * else, so every port is checked each time around. The task runs at high priority and the scheduler is cooperative, so
+ * it sleeps after every pass, even a busy one. Otherwise a coprocessor that never stops talking would keep it from
+ * ever yielding to odometry, the screen or user tasks.
+ */
+int SerialService::service_thread(void *vself) {
+    SerialService &self = *(SerialService *)vself;
+
+    while (true) {
+        size_t count = self.num_endpoints.load();
+        for (size_t i = 0; i < count; i++) {
+            Endpoint &ep = *self.endpoints[i];
+            self.write_pending(ep);
+            self.read_available(ep);
+        }
+
+        vexDelay(PASS_DELAY_MS);
+    }
+    return 0;
+}
@@ -73,6 +73,49 @@ void OdometryDataRecord::fetch() {
     Y->set_value((float)odom.get_position().y());
     ROT->set_value((float)odom.get_position().rotation().degrees());
 }
+/**
+ * Creates a record that contains a
+ * Uint32 of the scheduled period
+ * Uint32 of the number of updates
+ * Uint32 of the number of overruns
+ * Uint32 of the number of skipped deadlines
+ * Uint32 of the max jitter
+ * Float of the mean update() time
+ * Uint32 of the max update() time
+ * Record of the period histogram, one Uint32 per bin
+ * @param name the name of the record to create
+ * @param odom the odometry to get data from
+ */
+OdometryTimingRecord::OdometryTimingRecord(std::string name, OdometryBase &odom)
+    : Record(std::move(name)), odom(odom), period(new Uint32("Period(us)")), updates(new Uint32("Updates")),
+      overruns(new Uint32("Overruns")), skipped(new Uint32("Skipped")), max_jitter(new Uint32("Max Jitter(us)")),
+      avg_update(new Float("Avg Update(us)")), max_update(new Uint32("Max Update(us)")),
+      histogram(new Record("Period Histogram")) {
+    std::vector<PartPtr> bin_parts;
+    for (size_t i = 0; i < OdometryBase::PERIOD_HISTOGRAM_BINS; i++) {
+        // Bins are eighths of a period
+        bins.emplace_back(new Uint32(std::to_string(i) + "/8"));
+        bin_parts.push_back(bins.back());
+    }
+    histogram->set_fields(bin_parts);
+    Record::set_fields({period, updates, overruns, skipped, max_jitter, avg_update, max_update, histogram});
+}
+/**
+ * sets the data that the timing Parts hold
+ */
+void OdometryTimingRecord::fetch() {
+    OdometryBase::task_stats_t stats = odom.get_task_stats();
+    period->set_value(stats.period_us);
+    updates->set_value(stats.updates);
+    overruns->set_value(stats.overruns);
+    skipped->set_value(stats.skipped);
+    max_jitter->set_value(stats.max_jitter_us);
+    avg_update->set_value(stats.avg_update_us);
+    max_update->set_value(stats.max_update_us);
+    for (size_t i = 0; i < bins.size(); i++) {
+        bins[i]->set_value(stats.period_histogram[i]);
+    }
+}
 /**
  * Creates a record for taking odometry data from the debug board
  * @param name the name of the record to create
@@ -35,7 +35,7 @@ double Flywheel::measure_RPM() {
     return avger.get_value();
 }
 
-double Flywheel::getRPM() const { return avger.get_value(); }
+double Flywheel::getRPM() const { return state.read().rpm; }
 
 /**
  * Runs a thread that keeps track of updating flywheel RPM and controlling it accordingly
@@ -46,19 +46,23 @@ int spinRPMTask(void *wheelPointer) {
     // get the pid from the wheel and set its target to the RPM stored in the wheel.
     while (true) {
         double rpm = wheel.measure_RPM();
+        double output = 0.0;
+        bool on_target = false;
 
         if (wheel.target_rpm != 0) {
-            double output = wheel.ff.calculate(wheel.target_rpm, 0.0, 0.0);
+            output = wheel.ff.calculate(wheel.target_rpm, 0.0, 0.0);
             {
                 wheel.fb_mut.lock();
                 wheel.fb.update(rpm); // check the current velocity and update the PID with it.
 
                 output += wheel.fb.get();
+                on_target = wheel.fb.is_on_target();
                 wheel.fb_mut.unlock();
             }
 
             wheel.spin_raw(output, fwd); // set the motors to whatever feedforward tells them to do
         }
+        wheel.state.write({rpm, output, on_target});
         vexDelay(5);
     }
     return 0;
@@ -122,6 +126,8 @@ void Flywheel::stop() {
         rpm_task.stop();
         target_rpm = 0.0;
         motors.stop();
+        // the runner thread is gone, so we're the only writer now
+        state.write({getRPM(), 0.0, false});
     }
 }
 
@@ -146,7 +152,7 @@ class FlywheelPage : public screen::Page {
         double err = fabs(target - actual);
 
         avg_err.add_entry(err);
-        double volts = fw.fb.get() * 12.0;
+        double volts = fw.state.read().output * 12.0;
         gd.add_samples(std::vector<double>{target, actual, volts / 12.0 * 1000.0});
 
         gd.draw(screen, 200, 10, 220, 220);
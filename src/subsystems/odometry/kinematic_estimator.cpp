@@ -0,0 +1,149 @@
+#include "core/subsystems/odometry/kinematic_estimator.h"
+
+#include "core/subsystems/odometry/odometry_base.h"
+
+/**
+ * Create an estimator
+ *
+ * @param position_stddev how noisy the measured x and y are (inch)
+ * @param jerk_stddev how quickly the acceleration can change (inch/s^3 per sqrt(Hz))
+ * @param heading_stddev_deg how noisy the measured heading is (deg)
+ * @param ang_jerk_stddev_deg how quickly the angular acceleration can change (deg/s^3 per sqrt(Hz))
+ */
+KinematicEstimator::KinematicEstimator(
+  double position_stddev, double jerk_stddev, double heading_stddev_deg, double ang_jerk_stddev_deg
+)
+    : x_filter(make_filter(position_stddev, jerk_stddev)), y_filter(make_filter(position_stddev, jerk_stddev)),
+      heading_filter(make_filter(heading_stddev_deg, ang_jerk_stddev_deg)), heading(0) {}
+
+/**
+ * Build the filter for one axis of a constant acceleration model
+ *
+ *   d/dt [p, v, a] = [v, a, 0], y = p
+ *
+ * Process noise is only put on the acceleration, the position and velocity pick it up through the model.
+ */
+KinematicEstimator::AxisFilter KinematicEstimator::make_filter(double measurement_stddev, double jerk_stddev) {
+    EMat<3, 3> A;
+    A << 0, 1, 0, //
+      0, 0, 1,    //
+      0, 0, 0;
+    EMat<3, 1> B = EMat<3, 1>::Zero();
+    EMat<1, 3> C;
+    C << 1, 0, 0;
+    EMat<1, 1> D = EMat<1, 1>::Zero();
+
+    EVec<3> state_stddevs(0.0, 0.0, jerk_stddev);
+    EVec<1> measurement_stddevs;
+    measurement_stddevs << measurement_stddev;
+
+    return AxisFilter(A, B, C, D, state_stddevs, measurement_stddevs);
+}
+
+/**
+ * Forget the motion so far and start again from a robot sitting still
+ *
+ * @param pose the pose the robot is sitting at
+ * @param time the time (s) of the pose
+ */
+void KinematicEstimator::reset(const Pose2d &pose, double time) {
+    last_heading_deg = pose.rotation().degrees();
+    unwrapped_heading_deg = last_heading_deg;
+    heading = pose.rotation();
+
+    x_filter.reset();
+    y_filter.reset();
+    heading_filter.reset();
+    x_filter.set_xhat(0, pose.x());
+    y_filter.set_xhat(0, pose.y());
+    heading_filter.set_xhat(0, unwrapped_heading_deg);
+
+    last_time = time;
+    initialized = true;
+}
+
+/**
+ * Step the filters forward to a new pose
+ *
+ * @param pose the newest pose from odometry
+ * @param time the time (s) the pose was measured at
+ */
+void KinematicEstimator::update(const Pose2d &pose, double time) {
+    if (!initialized) {
+        reset(pose, time);
+        return;
+    }
+
+    double dt = time - last_time;
+    last_time = time;
+
+    double heading_deg = pose.rotation().degrees();
+    unwrapped_heading_deg += OdometryBase::smallest_angle(last_heading_deg, heading_deg);
+    last_heading_deg = heading_deg;
+    heading = pose.rotation();
+
+    step(x_filter, pose.x(), dt);
+    step(y_filter, pose.y(), dt);
+    step(heading_filter, unwrapped_heading_deg, dt);
+}
+
+/**
+ * Step one axis filter to a new measurement. A repeated timestamp only corrects, it can't move the model forward.
+ */
+void KinematicEstimator::step(AxisFilter &filter, double measurement, double dt) {
+    static const EVec<1> u = EVec<1>::Zero();
+    if (dt > 0) {
+        filter.predict(u, dt);
+    }
+    EVec<1> y;
+    y << measurement;
+    filter.correct(y, u);
+}
+
+/**
+ * @return velocity of the robot in the field frame (inch/s)
+ */
+Translation2d KinematicEstimator::field_velocity() const { return Translation2d(x_filter.xhat(1), y_filter.xhat(1)); }
+
+/**
+ * @return acceleration of the robot in the field frame (inch/s^2)
+ */
+Translation2d KinematicEstimator::field_accel() const { return Translation2d(x_filter.xhat(2), y_filter.xhat(2)); }
+
+/**
+ * @return velocity of the robot in its own frame, rotated by the current heading (inch/s)
+ */
+Translation2d KinematicEstimator::body_velocity() const { return field_velocity().rotate_by(-heading); }
+
+/**
+ * @return acceleration of the robot in its own frame, rotated by the current heading (inch/s^2)
+ */
+Translation2d KinematicEstimator::body_accel() const { return field_accel().rotate_by(-heading); }
+
+/**
+ * @return magnitude of the velocity (inch/s)
+ */
+double KinematicEstimator::speed() const { return field_velocity().norm(); }
+
+/**
+ * The rate of change of the speed is the part of the acceleration along the direction of travel
+ * @return rate of change of the speed, positive when speeding up (inch/s^2)
+ */
+double KinematicEstimator::accel() const {
+    Translation2d vel = field_velocity();
+    double speed = vel.norm();
+    if (speed < 1e-6) {
+        return field_accel().norm();
+    }
+    return (vel * field_accel()) / speed;
+}
+
+/**
+ * @return angular velocity, counter clockwise positive (deg/s)
+ */
+double KinematicEstimator::ang_speed_deg() const { return heading_filter.xhat(1); }
+
+/**
+ * @return angular acceleration, counter clockwise positive (deg/s^2)
+ */
+double KinematicEstimator::ang_accel_deg() const { return heading_filter.xhat(2); }
@@ -0,0 +1,450 @@
+#include "core/subsystems/odometry/monte_carlo_localizer.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace {
+constexpr float TWO_PI_F = 2.0f * (float)PI;
+
+/**
+ * Wrap an angle to [-pi, pi) without branching, so loops calling it still vectorize
+ */
+inline float wrap_angle(float rad) { return rad - TWO_PI_F * floorf((rad + (float)PI) / TWO_PI_F); }
+} // namespace
+
+/**
+ * Build the table by casting a ray from the center of every cell in every direction
+ *
+ * @param walls the walls to cast rays against
+ * @param field_size length of the sides of the square field, which starts at (0, 0) (inch)
+ * @param cell_size length of the sides of a cell (inch)
+ * @param angle_bins number of directions to cast in
+ * @param max_range rays that don't hit a wall closer than this return this (inch)
+ */
+RangeTable::RangeTable(
+  const std::vector<map_segment_t> &walls, double field_size, double cell_size, int angle_bins, double max_range
+)
+    : field_size(field_size), inv_cell_size(1.0f / (float)cell_size), cells((int)ceil(field_size / cell_size)),
+      angle_bins(angle_bins), bins_per_rad((float)angle_bins / TWO_PI_F) {
+    ranges.resize((size_t)cells * cells * angle_bins);
+
+    size_t i = 0;
+    for (int cy = 0; cy < cells; cy++) {
+        for (int cx = 0; cx < cells; cx++) {
+            Translation2d center((cx + 0.5) * cell_size, (cy + 0.5) * cell_size);
+            for (int b = 0; b < angle_bins; b++) {
+                double range = cast(walls, Pose2d(center, b * 2 * PI / angle_bins), max_range);
+                ranges[i++] = (uint16_t)std::min(range * UNITS_PER_INCH, 65535.0);
+            }
+        }
+    }
+}
+
+/**
+ * Look up the expected range for a batch of rays. The first loop is only arithmetic so it vectorizes, the second is
+ * the gather from the table.
+ */
+void RangeTable::lookup(const float *x, const float *y, const float *heading, size_t n, float *out, int32_t *index)
+  const {
+    const int max_cell = cells - 1;
+    for (size_t i = 0; i < n; i++) {
+        int32_t cx = std::min(std::max((int32_t)(x[i] * inv_cell_size), 0), max_cell);
+        int32_t cy = std::min(std::max((int32_t)(y[i] * inv_cell_size), 0), max_cell);
+        // Headings are within [-pi, pi), shift them positive before rounding to a bin
+        int32_t bin = (int32_t)((heading[i] + TWO_PI_F) * bins_per_rad + 0.5f) % angle_bins;
+        index[i] = (cy * cells + cx) * angle_bins + bin;
+    }
+
+    const float scale = 1.0f / UNITS_PER_INCH;
+    for (size_t i = 0; i < n; i++) {
+        out[i] = ranges[index[i]] * scale;
+    }
+}
+
+/**
+ * Look up the expected range of one ray
+ *
+ * @param from the origin and direction of the ray
+ * @return the expected range (inch)
+ */
+float RangeTable::lookup(const Pose2d &from) const {
+    float x = from.x();
+    float y = from.y();
+    float heading = from.rotation().wrapped_radians_180();
+    float out;
+    int32_t index;
+    lookup(&x, &y, &heading, 1, &out, &index);
+    return out;
+}
+
+/**
+ * Cast a ray against a set of walls without the table. Keeps the closest ray_segment_distance() in front of the ray.
+ *
+ * @param walls the walls to cast against
+ * @param from the origin and direction of the ray
+ * @param max_range returned if no wall is closer than this (inch)
+ * @return the distance to the first wall hit (inch)
+ */
+double RangeTable::cast(const std::vector<map_segment_t> &walls, const Pose2d &from, double max_range) {
+    double dx = from.rotation().f_cos();
+    double dy = from.rotation().f_sin();
+    double best = max_range;
+
+    for (const map_segment_t &wall : walls) {
+        double t = ray_segment_distance(from.x(), from.y(), dx, dy, wall.start.x(), wall.start.y(),
+                                        wall.end.x() - wall.start.x(), wall.end.y() - wall.start.y());
+        if (t >= 0 && t < best) {
+            best = t;
+        }
+    }
+    return best;
+}
+
+/**
+ * @param sensor the distance sensor
+ * @param offset where the sensor is relative to the center of the robot, and the direction it points
+ * @param max_range readings further than this are not trusted (inch)
+ */
+DistanceRangeSensor::DistanceRangeSensor(vex::distance &sensor, const Pose2d &offset, double max_range)
+    : RangeSensor(offset, max_range), sensor(sensor) {}
+
+/**
+ * Read the sensor if it has produced a new reading since the last read
+ * @param[out] range the measured distance (inch)
+ * @return true if there was a new reading, and the sensor saw something within max_range
+ */
+bool DistanceRangeSensor::read(double &range) {
+    uint32_t timestamp = sensor.timestamp();
+    if (timestamp == last_timestamp) {
+        return false;
+    }
+    last_timestamp = timestamp;
+
+    if (!sensor.isObjectDetected()) {
+        return false;
+    }
+    double reading = sensor.objectDistance(vex::distanceUnits::in);
+    if (reading > max_range) {
+        return false;
+    }
+    range = reading;
+    return true;
+}
+
+/**
+ * @param walls the simulated field
+ * @param true_pose returns where the simulated robot really is
+ * @param offset where the sensor is relative to the center of the robot, and the direction it points
+ * @param noise_stddev noise added to every reading (inch)
+ * @param outlier_chance chance a reading is something other than a wall (0 to 1)
+ * @param max_range readings further than this are not returned (inch)
+ * @param seed seed for the noise
+ */
+SimulatedRangeSensor::SimulatedRangeSensor(
+  const std::vector<map_segment_t> &walls, std::function<Pose2d()> true_pose, const Pose2d &offset,
+  double noise_stddev, double outlier_chance, double max_range, uint32_t seed
+)
+    : RangeSensor(offset, max_range), walls(walls), true_pose(std::move(true_pose)), rng(seed),
+      noise(0.0, noise_stddev), uniform(0.0, 1.0), outlier_chance(outlier_chance) {}
+
+/**
+ * Measure the simulated field
+ * @param[out] range the simulated distance (inch)
+ * @return true if the simulated wall is within max_range
+ */
+bool SimulatedRangeSensor::read(double &range) {
+    Pose2d sensor_pose = true_pose() + Transform2d(offset.translation(), offset.rotation());
+    double reading = RangeTable::cast(walls, sensor_pose, 2 * max_range);
+    if (uniform(rng) < outlier_chance) {
+        // Something got between the sensor and the wall
+        reading *= uniform(rng);
+    }
+    reading += noise(rng);
+
+    if (reading > max_range || reading < 0) {
+        return false;
+    }
+    range = reading;
+    return true;
+}
+
+/**
+ * Create a localizer
+ *
+ * @param odom the wheel odometry to move the particles with. Should be constructed with is_async = false
+ * @param table the expected ranges on the field
+ * @param sensors the range sensors on the robot
+ * @param config the tuning of the particle filter
+ * @param is_async true to run in the background, false to call update() manually
+ */
+MonteCarloLocalizer::MonteCarloLocalizer(
+  OdometryBase &odom, const RangeTable &table, std::vector<RangeSensor *> sensors, const mcl_config_t &config,
+  bool is_async
+)
+    : OdometryBase(is_async), odom(odom), table(table), sensors(std::move(sensors)), config(config),
+      ess(config.num_particles) {
+    size_t n = config.num_particles;
+    for (std::vector<float> *v :
+         {&px, &py, &ptheta, &weight, &next_x, &next_y, &next_theta, &ray_x, &ray_y, &ray_theta, &expected, &cos_theta,
+          &sin_theta}) {
+        v->resize(n);
+    }
+    ray_index.resize(n);
+
+    set_position(zero_pos);
+}
+
+/**
+ * Move the particles with odometry, weight them with any new range readings, resample if needed and estimate
+ * @return the estimated pose
+ */
+Pose2d MonteCarloLocalizer::update() {
+    Pose2d odom_pose = odom.update();
+    if (!has_odom_pose) {
+        has_odom_pose = true;
+        last_odom_pose = odom_pose;
+    }
+
+    // The motion since the last update, in the robot's frame at the last update
+    Transform2d delta = odom_pose - last_odom_pose;
+    last_odom_pose = odom_pose;
+    double dx = delta.translation().x();
+    double dy = delta.translation().y();
+    double dtheta = delta.rotation().wrapped_radians_180();
+    if (dx != 0 || dy != 0 || dtheta != 0) {
+        move_particles(dx, dy, dtheta);
+        moved_distance += hypot(dx, dy);
+        moved_rotation += fabs(dtheta);
+    }
+
+    // Weighing the same scene over and over while sitting still would make the filter overconfident in whatever it
+    // believes, so readings are only used once the robot has moved a bit. They are still read to keep up to date.
+    bool can_weigh = moved_distance >= MIN_UPDATE_DISTANCE || moved_rotation >= MIN_UPDATE_ROTATION_DEG * PI / 180.0;
+    bool weighed = false;
+    for (RangeSensor *sensor : sensors) {
+        double range;
+        if (sensor->read(range) && can_weigh) {
+            if (!weighed) {
+                size_t n = config.num_particles;
+                for (size_t i = 0; i < n; i++) {
+                    cos_theta[i] = cosf(ptheta[i]);
+                    sin_theta[i] = sinf(ptheta[i]);
+                }
+            }
+            weigh_particles(*sensor, range);
+            weighed = true;
+        }
+    }
+
+    if (weighed) {
+        moved_distance = 0;
+        moved_rotation = 0;
+        normalize_weights();
+        if (ess < config.num_particles / 2.0) {
+            resample();
+        }
+    }
+
+    current_pos = estimate();
+    update_kinematics(vexSystemHighResTimeGet() / 1000000.0);
+    return current_pos;
+}
+
+/**
+ * Move every particle by a body frame motion, plus noise that grows with the size of the motion. The noise is drawn
+ * first so the loop applying it has no calls into the random number generator and vectorizes.
+ */
+void MonteCarloLocalizer::move_particles(double dx, double dy, double dtheta) {
+    const size_t n = config.num_particles;
+    const float dist = hypot(dx, dy);
+    const float trans_sd = config.trans_noise * dist;
+    const float rot_sd = config.rot_noise * fabs(dtheta) + config.trans_rot_noise * dist;
+
+    // ray_* are free until the next sensor update, use them for the noise
+    float *noise_x = ray_x.data();
+    float *noise_y = ray_y.data();
+    float *noise_theta = ray_theta.data();
+    for (size_t i = 0; i < n; i++) {
+        noise_x[i] = trans_sd * fast_normal();
+        noise_y[i] = trans_sd * fast_normal();
+        noise_theta[i] = rot_sd * fast_normal();
+    }
+
+    const float fdx = dx;
+    const float fdy = dy;
+    const float fdtheta = dtheta;
+    float *x = px.data();
+    float *y = py.data();
+    float *theta = ptheta.data();
+    for (size_t i = 0; i < n; i++) {
+        float mx = fdx + noise_x[i];
+        float my = fdy + noise_y[i];
+        float c = cosf(theta[i]);
+        float s = sinf(theta[i]);
+        x[i] += mx * c - my * s;
+        y[i] += mx * s + my * c;
+        theta[i] = wrap_angle(theta[i] + fdtheta + noise_theta[i]);
+    }
+}
+
+/**
+ * Multiply every particle's weight by the likelihood of a range reading: a gaussian around the range the table expects
+ * from where the sensor would be on that particle, plus a floor for readings that hit something not on the map.
+ * Particles off of the field get the floor alone.
+ */
+void MonteCarloLocalizer::weigh_particles(const RangeSensor &sensor, double range) {
+    const size_t n = config.num_particles;
+    const float ox = sensor.offset.x();
+    const float oy = sensor.offset.y();
+    const float otheta = sensor.offset.rotation().wrapped_radians_180();
+
+    const float *x = px.data();
+    const float *y = py.data();
+    const float *theta = ptheta.data();
+    for (size_t i = 0; i < n; i++) {
+        ray_x[i] = x[i] + ox * cos_theta[i] - oy * sin_theta[i];
+        ray_y[i] = y[i] + ox * sin_theta[i] + oy * cos_theta[i];
+        ray_theta[i] = wrap_angle(theta[i] + otheta);
+    }
+
+    table.lookup(ray_x.data(), ray_y.data(), ray_theta.data(), n, expected.data(), ray_index.data());
+
+    const float measured = range;
+    const float inv_two_var = 1.0f / (2.0f * config.range_stddev * config.range_stddev);
+    const float floor_weight = config.outlier_weight;
+    const float size = table.get_field_size();
+    float *w = weight.data();
+    for (size_t i = 0; i < n; i++) {
+        float err = measured - expected[i];
+        float likelihood = expf(-err * err * inv_two_var) + floor_weight;
+        bool on_field = x[i] >= 0 && x[i] <= size && y[i] >= 0 && y[i] <= size;
+        w[i] *= on_field ? likelihood : floor_weight;
+    }
+}
+
+/**
+ * Normalize the weights and find the effective sample size. If every weight underflowed the filter has lost track,
+ * start the weights over evenly rather than dividing by zero.
+ */
+void MonteCarloLocalizer::normalize_weights() {
+    const size_t n = config.num_particles;
+    float *w = weight.data();
+    float sum = 0;
+    for (size_t i = 0; i < n; i++) {
+        sum += w[i];
+    }
+
+    if (!(sum > 0) || !std::isfinite(sum)) {
+        std::fill(weight.begin(), weight.end(), 1.0f / n);
+        ess = n;
+        return;
+    }
+
+    float inv_sum = 1.0f / sum;
+    float sum_sq = 0;
+    for (size_t i = 0; i < n; i++) {
+        w[i] *= inv_sum;
+        sum_sq += w[i] * w[i];
+    }
+    ess = 1.0 / sum_sq;
+}
+
+/**
+ * Low variance resampling: one random offset, then n evenly spaced pointers walk the cumulative weights. Particles
+ * are kept in proportion to their weight with less randomness than drawing n times, and it is O(n).
+ */
+void MonteCarloLocalizer::resample() {
+    const size_t n = config.num_particles;
+    const float step = 1.0f / n;
+    float pointer = step * ((rng_next() >> 8) * (1.0f / (1 << 24)));
+    float cumulative = weight[0];
+    size_t src = 0;
+
+    for (size_t m = 0; m < n; m++) {
+        while (pointer > cumulative && src < n - 1) {
+            src++;
+            cumulative += weight[src];
+        }
+        next_x[m] = px[src];
+        next_y[m] = py[src];
+        next_theta[m] = ptheta[src];
+        pointer += step;
+    }
+
+    px.swap(next_x);
+    py.swap(next_y);
+    ptheta.swap(next_theta);
+    std::fill(weight.begin(), weight.end(), step);
+    ess = n;
+}
+
+/**
+ * Find the weighted mean pose of the particles, averaging the headings on the circle
+ */
+Pose2d MonteCarloLocalizer::estimate() const {
+    const size_t n = config.num_particles;
+    double x = 0;
+    double y = 0;
+    double c = 0;
+    double s = 0;
+    for (size_t i = 0; i < n; i++) {
+        x += weight[i] * px[i];
+        y += weight[i] * py[i];
+        c += weight[i] * cosf(ptheta[i]);
+        s += weight[i] * sinf(ptheta[i]);
+    }
+    return Pose2d(x, y, atan2(s, c));
+}
+
+/**
+ * Scatter the particles around a new position
+ * @param newpos the position the robot is near
+ */
+void MonteCarloLocalizer::set_position(const Pose2d &newpos) {
+    mut.lock();
+    const size_t n = config.num_particles;
+    const float xy_sd = config.initial_xy_stddev;
+    const float theta_sd = config.initial_heading_stddev_deg * PI / 180.0;
+    for (size_t i = 0; i < n; i++) {
+        px[i] = newpos.x() + xy_sd * fast_normal();
+        py[i] = newpos.y() + xy_sd * fast_normal();
+        ptheta[i] = wrap_angle(newpos.rotation().wrapped_radians_180() + theta_sd * fast_normal());
+    }
+    std::fill(weight.begin(), weight.end(), 1.0f / n);
+    ess = n;
+    moved_distance = 0;
+    moved_rotation = 0;
+    mut.unlock();
+
+    OdometryBase::set_position(newpos);
+}
+
+/**
+ * @return the effective sample size after the last update
+ */
+double MonteCarloLocalizer::get_effective_sample_size() {
+    mut.lock();
+    double out = ess;
+    mut.unlock();
+    return out;
+}
+
+/**
+ * xorshift32, plenty random for spreading particles and much cheaper than the standard library engines
+ */
+uint32_t MonteCarloLocalizer::rng_next() {
+    rng_state ^= rng_state << 13;
+    rng_state ^= rng_state >> 17;
+    rng_state ^= rng_state << 5;
+    return rng_state;
+}
+
+/**
+ * The sum of 4 uniform numbers is close to normal (Irwin-Hall). Shifted to mean 0 and scaled to stddev 1
+ */
+float MonteCarloLocalizer::fast_normal() {
+    uint32_t a = rng_next();
+    uint32_t b = rng_next();
+    float sum = (a & 0xffff) + (a >> 16) + (b & 0xffff) + (b >> 16);
+    return (sum * (1.0f / 65536.0f) - 2.0f) * 1.7320508f;
+}
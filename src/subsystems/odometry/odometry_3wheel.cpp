@@ -8,17 +8,30 @@ Odometry3Wheel::Odometry3Wheel(
 
 /**
  * Update the current position of the robot once, using the current state of
- * the encoders and the previous known location
+ * the encoders and the previous known location. If the encoders haven't
+ * changed since the last update, nothing is integrated.
  *
  * @return the robot's updated position
  */
 Pose2d Odometry3Wheel::update() {
-    static double lside_old = 0, rside_old = 0, offax_old = 0;
-
     double lside = lside_fwd.position(deg);
     double rside = rside_fwd.position(deg);
     double offax = off_axis.position(deg);
 
+    // 3 wire encoders have no timestamp, they're new whenever they change
+    double sample_time;
+    if (!sample_detector.is_new({lside, rside, offax}, 0, vexSystemHighResTimeGet() / 1000000.0, sample_time)) {
+        return current_pos;
+    }
+
+    // The first sample only sets where the encoders start, so they don't have to be zeroed
+    if (!has_old_positions) {
+        has_old_positions = true;
+        lside_old = lside;
+        rside_old = rside;
+        offax_old = offax;
+    }
+
     double lside_delta = lside - lside_old;
     double rside_delta = rside - rside_old;
     double offax_delta = offax - offax_old;
@@ -29,45 +42,8 @@ Pose2d Odometry3Wheel::update() {
 
     Pose2d updated_pos = calculate_new_pos(lside_delta, rside_delta, offax_delta, current_pos, cfg);
 
-    static Pose2d last_pos = updated_pos;
-    static double last_speed = 0;
-    static double last_ang_speed = 0;
-    static timer tmr;
-
-    double speed_local = 0;
-    double accel_local = 0;
-    double ang_speed_local = 0;
-    double ang_accel_local = 0;
-    bool update_vel_accel = tmr.time(sec) > 0.1;
-
-    // This loop runs too fast. Only check at LEAST every 1/10th sec
-    if (update_vel_accel) {
-        // Calculate robot velocity
-        speed_local = updated_pos.translation().distance(last_pos.translation()) / tmr.time(sec);
-
-        // Calculate robot acceleration
-        accel_local = (speed_local - last_speed) / tmr.time(sec);
-
-        // Calculate robot angular velocity (deg/sec)
-        ang_speed_local =
-          smallest_angle(updated_pos.rotation().degrees(), last_pos.rotation().degrees()) / tmr.time(sec);
-
-        // Calculate robot angular acceleration (deg/sec^2)
-        ang_accel_local = (ang_speed_local - last_ang_speed) / tmr.time(sec);
-
-        tmr.reset();
-        last_pos = updated_pos;
-        last_speed = speed_local;
-        last_ang_speed = ang_speed_local;
-    }
-
     this->current_pos = updated_pos;
-    if (update_vel_accel) {
-        this->speed = speed_local;
-        this->accel = accel_local;
-        this->ang_speed_deg = ang_speed_local;
-        this->ang_accel_deg = ang_accel_local;
-    }
+    update_kinematics(sample_time);
 
     return current_pos;
 }
@@ -107,9 +83,11 @@ Pose2d Odometry3Wheel::calculate_new_pos(
     // Change in displacement as a vector, on the local coordinate system (+y = robot fwd)
     Translation2d local_displacement(dist_local_x, dist_local_y);
 
-    // Rotate the local displacement to match the old robot's rotation
+    // Rotate the local displacement to match the robot's rotation. The robot turned while it moved, so use the
+    // rotation halfway through the turn, where the chord of the arc it drove points
     double dir_delta_from_trans_rad = local_displacement.theta().radians() - (PI / 2.0);
-    double global_dir_rad = wrap_angle_rad(dir_delta_from_trans_rad + old_pos.rotation().radians());
+    double mid_rotation_rad = old_pos.rotation().radians() + delta_angle_rad / 2.0;
+    double global_dir_rad = wrap_angle_rad(dir_delta_from_trans_rad + mid_rotation_rad);
     Translation2d global_displacement(local_displacement.norm(), Rotation2d(global_dir_rad));
 
     // Tack on the position change to the old position
@@ -5,7 +5,9 @@
  *
  * @param is_async True to run constantly in the background, false to call update() manually
  */
-OdometryBase::OdometryBase(bool is_async) : current_pos(this->zero_pos) {
+OdometryBase::OdometryBase(bool is_async)
+    : current_pos(this->zero_pos), speed(0), accel(0), ang_speed_deg(0), ang_accel_deg(0), is_async(is_async) {
+    publish_state();
     if (is_async) {
         handle = new vex::task(background_task, (void *)this);
     }
@@ -15,22 +17,153 @@ OdometryBase::OdometryBase(bool is_async) : current_pos(this->zero_pos) {
  * Function that runs in the background task. This function pointer is passed
  * to the vex::task constructor.
  *
+ * Runs update() once per period on an absolute schedule: each deadline is the last one plus the period, so time spent
+ * in update() and late wakeups don't add up into a slower rate. When an update runs past the next deadline it is
+ * counted as an overrun and the overrun policy decides whether the missed updates are made up or dropped.
+ *
  * @param ptr Pointer to OdometryBase object
  * @return Required integer return code. Unused.
  */
 int OdometryBase::background_task(void *ptr) {
     OdometryBase &obj = *((OdometryBase *)ptr);
     vexDelay(1000);
+
+    uint32_t period = obj.period_us.load();
+    uint64_t deadline = vexSystemHighResTimeGet();
+    bool was_late = false;
     while (!obj.end_task) {
+        if (!was_late) {
+            wait_until(deadline);
+        }
+
+        uint64_t start = vexSystemHighResTimeGet();
         obj.mut.lock();
-        obj.update();
+        double previous_sample = obj.last_sample_time;
+        double now = start / 1000000.0;
+        Pose2d pose = obj.update();
+
+        if (obj.last_sample_time != previous_sample) {
+            // A new sample was integrated, record it at the time it was measured
+            obj.record_history(obj.last_sample_time, pose);
+            obj.publish_state();
+        } else if (obj.last_sample_time < 0) {
+            // This implementation doesn't report samples, so every update is one
+            obj.record_history(now, pose);
+            obj.publish_state();
+        }
         obj.mut.unlock();
-        vexDelay(5);
+        uint64_t end = vexSystemHighResTimeGet();
+
+        obj.record_timing(start, end, deadline, was_late);
+
+        // A new rate starts a new schedule from now
+        uint32_t new_period = obj.period_us.load();
+        if (new_period != period) {
+            period = new_period;
+            obj.task_stats.period_us = period;
+            deadline = end;
+        }
+
+        deadline += period;
+        was_late = end > deadline;
+        if (was_late) {
+            obj.task_stats.overruns++;
+            uint64_t behind = (end - deadline) / period;
+            if (obj.overrun_policy.load() == OverrunPolicy::Skip || behind >= MAX_CATCH_UP_PERIODS) {
+                // Drop every deadline that has already gone by and wait for the next one on the schedule
+                deadline += (behind + 1) * period;
+                obj.task_stats.skipped += behind + 1;
+                was_late = false;
+            }
+        }
+        obj.published_task_stats.write(obj.task_stats);
     }
 
     return 0;
 }
 
+/**
+ * Sleep until an absolute time, to the millisecond. vexDelay() only has millisecond resolution, so this wakes up at the
+ * last whole millisecond at or before the deadline: up to 1ms early, but never late and never spinning.
+ *
+ * @param deadline_us the time to wake up at (us, same clock as vexSystemHighResTimeGet)
+ */
+void OdometryBase::wait_until(uint64_t deadline_us) {
+    uint64_t now = vexSystemHighResTimeGet();
+    if (now < deadline_us) {
+        vexDelay((deadline_us - now) / 1000);
+    }
+}
+
+/**
+ * Add one update to the timing statistics. Only called from the background task
+ *
+ * @param start_us when the update started
+ * @param end_us when the update finished
+ * @param deadline_us when the update was scheduled to start
+ * @param was_late true if this update is making up for an overrun, so starting after its deadline is expected
+ */
+void OdometryBase::record_timing(uint64_t start_us, uint64_t end_us, uint64_t deadline_us, bool was_late) {
+    if (stats_reset_requested.exchange(false)) {
+        task_stats = {};
+        last_start_us = 0;
+    }
+    task_stats.period_us = period_us.load();
+
+    uint32_t cost = end_us - start_us;
+    task_stats.updates++;
+    task_stats.last_update_us = cost;
+    if (cost > task_stats.max_update_us) {
+        task_stats.max_update_us = cost;
+    }
+    task_stats.avg_update_us += (cost - task_stats.avg_update_us) / task_stats.updates;
+
+    if (!was_late && start_us > deadline_us && start_us - deadline_us > task_stats.max_jitter_us) {
+        task_stats.max_jitter_us = start_us - deadline_us;
+    }
+
+    if (last_start_us != 0) {
+        size_t bin = (start_us - last_start_us) * 8 / task_stats.period_us;
+        if (bin >= PERIOD_HISTOGRAM_BINS) {
+            bin = PERIOD_HISTOGRAM_BINS - 1;
+        }
+        task_stats.period_histogram[bin]++;
+    }
+    last_start_us = start_us;
+}
+
+/**
+ * Change how often the background task runs update()
+ *
+ * @param hz the number of times per second to run update()
+ * @param policy what to do when an update runs past the next deadline
+ */
+void OdometryBase::set_update_rate(double hz, OverrunPolicy policy) {
+    if (hz <= 0) {
+        printf("OdometryBase: update rate must be positive, got %f\n", hz);
+        return;
+    }
+    uint32_t period = (uint32_t)(1000000.0 / hz);
+    overrun_policy.store(policy);
+    period_us.store(period > 0 ? period : 1);
+}
+
+/**
+ * Gets when the newest sample an implementation integrated was measured. Only call from the task that calls update()
+ * @return the time passed to the last update_kinematics() (s), negative if there hasn't been one
+ */
+double OdometryBase::get_sample_time() { return last_sample_time; }
+
+/**
+ * Get the background task's timing statistics
+ */
+OdometryBase::task_stats_t OdometryBase::get_task_stats() { return published_task_stats.read(); }
+
+/**
+ * Clear the background task's timing statistics
+ */
+void OdometryBase::reset_task_stats() { stats_reset_requested.store(true); }
+
 /**
  * End the background task. Cannot be restarted.
  * If the user wants to end the thread but keep the data up to date,
@@ -41,11 +174,59 @@ void OdometryBase::end_async() { this->end_task = true; }
 /**
  * Gets the current position and rotation
  */
-Pose2d OdometryBase::get_position(void) {
+Pose2d OdometryBase::get_position(void) { return get_state().pos; }
+
+/**
+ * Gets the position and velocities from the same update.
+ * While the background task is running this reads the published snapshot and never waits on update(). Otherwise
+ * update() is being called by hand and may not have published, so read the fields directly.
+ */
+OdometryBase::odometry_state_t OdometryBase::get_state() {
+    if (is_async && !end_task) {
+        return state.read();
+    }
+
+    mut.lock();
+    odometry_state_t out = {current_pos, speed, accel, ang_speed_deg, ang_accel_deg, field_vel, field_accel};
+    mut.unlock();
+    return out;
+}
+
+/**
+ * Publish current_pos and the velocities for the getters to read. Must be called with mut held.
+ */
+void OdometryBase::publish_state() {
+    state.write({current_pos, speed, accel, ang_speed_deg, ang_accel_deg, field_vel, field_accel});
+}
+
+/**
+ * Step the velocity and acceleration estimate with current_pos, and copy the results out. Must be called with mut held.
+ *
+ * @param time the time (s) the sensors behind current_pos were read
+ */
+void OdometryBase::update_kinematics(double time) {
+    last_sample_time = time;
+    kinematics.update(current_pos, time);
+
+    speed = kinematics.speed();
+    accel = kinematics.accel();
+    ang_speed_deg = kinematics.ang_speed_deg();
+    ang_accel_deg = kinematics.ang_accel_deg();
+    field_vel = kinematics.field_velocity();
+    field_accel = kinematics.field_accel();
+}
+
+/**
+ * Gets the position the robot was at at some time in the past
+ *
+ * @param time the time to look up, in seconds since the brain started
+ * @return the position that the odometry believes the robot was at
+ */
+Pose2d OdometryBase::get_position_at(double time) {
     mut.lock();
 
-    // Create a new struct to pass-by-value
     Pose2d out = current_pos;
+    history.sample_at(time, out);
 
     mut.unlock();
 
@@ -53,12 +234,26 @@ Pose2d OdometryBase::get_position(void) {
 }
 
 /**
- * Sets the current position of the robot
+ * Called by the background task with the pose returned by every update(). Records it in the history.
+ *
+ * @param time the time (s) update() was called
+ * @param pose the pose returned by update()
+ */
+void OdometryBase::record_history(double time, const Pose2d &pose) { history.push(time, pose); }
+
+/**
+ * Sets the current position of the robot, and forgets the poses from before
  */
 void OdometryBase::set_position(const Pose2d &newpos) {
     mut.lock();
 
     current_pos = newpos;
+    history.clear();
+    // A jump in position isn't motion
+    kinematics.reset(newpos, vexSystemHighResTimeGet() / 1000000.0);
+    speed = accel = ang_speed_deg = ang_accel_deg = 0;
+    field_vel = field_accel = Translation2d();
+    publish_state();
 
     mut.unlock();
 }
@@ -91,34 +286,24 @@ double OdometryBase::smallest_angle(double start_deg, double end_deg) {
     return retval;
 }
 
-double OdometryBase::get_speed() {
-    mut.lock();
-    double retval = speed;
-    mut.unlock();
+double OdometryBase::get_speed() { return get_state().speed; }
 
-    return retval;
-}
+double OdometryBase::get_accel() { return get_state().accel; }
 
-double OdometryBase::get_accel() {
-    mut.lock();
-    double retval = accel;
-    mut.unlock();
+double OdometryBase::get_angular_speed_deg() { return get_state().ang_speed_deg; }
 
-    return retval;
-}
+double OdometryBase::get_angular_accel_deg() { return get_state().ang_accel_deg; }
 
-double OdometryBase::get_angular_speed_deg() {
-    mut.lock();
-    double retval = ang_speed_deg;
-    mut.unlock();
+Translation2d OdometryBase::get_field_velocity() { return get_state().field_vel; }
 
-    return retval;
-}
+Translation2d OdometryBase::get_field_accel() { return get_state().field_accel; }
 
-double OdometryBase::get_angular_accel_deg() {
-    mut.lock();
-    double retval = ang_accel_deg;
-    mut.unlock();
+Translation2d OdometryBase::get_body_velocity() {
+    odometry_state_t s = get_state();
+    return s.field_vel.rotate_by(-s.pos.rotation());
+}
 
-    return retval;
+Translation2d OdometryBase::get_body_accel() {
+    odometry_state_t s = get_state();
+    return s.field_accel.rotate_by(-s.pos.rotation());
 }
@@ -33,23 +33,25 @@
  * Construct a new Odometry Serial Object
  */
 OdometrySerial::OdometrySerial(
-  bool is_async, bool calc_vel_acc_on_brain, Pose2d initial_pose, Pose2d sensor_offset, int32_t port, int32_t baudrate
+  bool is_async, bool calc_vel_acc_on_brain, Pose2d initial_pose, Pose2d sensor_offset, int32_t port, int32_t baudrate,
+  uint8_t protocol_version
 )
     : OdometryBase(is_async), calc_vel_acc_on_brain(calc_vel_acc_on_brain), pose(Pose2d(0, 0, 0)),
-      pose_offset(Pose2d(0, 0, 0)), _port(port) {
-    vexGenericSerialEnable(_port, 0);
-    vexGenericSerialBaudrate(_port, baudrate);
-    send_config(initial_pose, sensor_offset, calc_vel_acc_on_brain);
+      pose_offset(Pose2d(0, 0, 0)), _port(port), baudrate(baudrate) {
+    SerialService::instance().add_port(
+      _port, baudrate, [this](const uint8_t *packet, size_t length) { handle_frame(packet, length); },
+      MAX_PACKET_SIZE, 64
+    );
+    send_config(initial_pose, sensor_offset, calc_vel_acc_on_brain, protocol_version);
 }
 
 /**
- * Send
+ * Send the starting pose, sensor offset and requested packet format to the coprocessor.
  */
 void OdometrySerial::send_config(
-  const Pose2d &initial_pose, const Pose2d &sensor_offset, const bool &calc_vel_acc_on_brain
+  const Pose2d &initial_pose, const Pose2d &sensor_offset, const bool &calc_vel_acc_on_brain, uint8_t protocol_version
 ) {
-    uint8_t raw[(sizeof(initial_pose)) + sizeof(calc_vel_acc_on_brain)];
-    uint8_t cobs_encoded[sizeof(raw) + 1];
+    uint8_t raw[CONFIG_SIZE];
 
     float initialx = (float)initial_pose.x();
     float initialy = (float)initial_pose.y();
@@ -66,84 +68,211 @@ void OdometrySerial::send_config(
     memcpy(&raw[16], &offsety, sizeof(float));
     memcpy(&raw[20], &offsetrot, sizeof(float));
     memcpy(&raw[24], &calc_vel_acc_on_brain, sizeof(bool));
+    raw[25] = protocol_version;
 
-    cobs_encode(raw, sizeof(raw), cobs_encoded);
+    SerialService::instance().send_frame(_port, raw, sizeof(raw));
+}
+
+/**
+ * Publish the statistics for packets decoded since the last update. Packets themselves are decoded by the
+ * SerialService task as they arrive.
+ *
+ * @return the robot's newest position
+ */
+Pose2d OdometrySerial::update() {
+    double now = vexSystemHighResTimeGet() / 1000000.0;
+
+    stats.packets_decoded = decoded_since_update;
+    stats.parse_time_us = parse_us_since_update;
+    stats.packet_age = history.empty() ? -1 : now - history.newest().time;
+    decoded_since_update = 0;
+    parse_us_since_update = 0;
 
-    vexGenericSerialTransmit(_port, cobs_encoded, sizeof(cobs_encoded));
+    return current_pos;
 }
 
 /**
- * Attempts to recieve an entire packet encoded with COBS, stops at delimiter or there's a buffer overflow
- *
- * @param port the port number the serial is plugged into, counts from 0 instead of 1
- * @param buffer pointer to a uint8_t[] where we put the data
- * @param buffer_size length in bytes of the buffer
- * @return 0 success
- */
-int OdometrySerial::receive_cobs_packet(uint32_t port, uint8_t *buffer, size_t buffer_size) {
-    size_t index = 0;
-
-    while (true) {
-        // wait for a byte (we read byte by byte into our own buffer rather than grabbing the whole packet all at once)
-        if (vexGenericSerialReceiveAvail(port) > 0) {
-            uint8_t character = vexGenericSerialReadChar(port);
-
-            // if delimiter
-            if (character == 0x00) {
-                return index; // return packet length
-            }
-
-            // store character in buffer
-            if (index < buffer_size) {
-                buffer[index++] = character;
-            } else {
-                // buffer overflow
-                printf("bufferoverflow\n");
-                return -1;
-            }
+ * Called by the SerialService with every packet decoded from the wire. The service calls this as soon as the
+ * delimiter is read, so now is as close to the receive time as we can get.
+ *
+ * @param packet the decoded bytes
+ * @param length the number of decoded bytes
+ */
+void OdometrySerial::handle_frame(const uint8_t *packet, size_t length) {
+    uint64_t start_us = vexSystemHighResTimeGet();
+    double rx_time = start_us / 1000000.0;
+
+    mut.lock();
+    if (decode_packet(packet, length, rx_time)) {
+        decoded_since_update++;
+    }
+    parse_us_since_update += vexSystemHighResTimeGet() - start_us;
+    mut.unlock();
+}
+
+/**
+ * Check a packet's version and store its contents. The packet version is told apart by the decoded length.
+ *
+ * @param packet the decoded bytes
+ * @param length the number of decoded bytes
+ * @param rx_time the time (s) the packet was read off the port
+ * @return true if the packet was valid
+ */
+bool OdometrySerial::decode_packet(const uint8_t *packet, size_t length, double rx_time) {
+    if (length == PACKET_SIZE) {
+        float floats[PACKET_SIZE / sizeof(float)];
+        memcpy(floats, packet, PACKET_SIZE);
+        if (!store_pose(floats, rx_time)) {
+            stats.packets_rejected++;
+            return false;
         }
-        vex::this_thread::yield();
+        stats.protocol_version = PROTOCOL_V1;
+        return true;
+    }
+
+    if (length > V2_HEADER_SIZE && packet[0] == PROTOCOL_V2) {
+        return decode_v2_packet(packet, length, rx_time);
     }
+
+    stats.packets_rejected++;
+    return false;
 }
 
 /**
- * Update the current position of the robot once by reading a single packet from the serial port, then updating all over
- * values, velocity, accel
+ * Check and unpack a decoded version 2 packet
  *
- * @return the robot's updated position
+ * @param packet the decoded bytes
+ * @param length the number of decoded bytes
+ * @param rx_time the time (s) the packet was read off the port
+ * @return true if the packet was valid
  */
-Pose2d OdometrySerial::update() {
-    uint8_t cobs_encoded_size;
-    uint8_t packet_size;
-
-    cobs_encoded_size = 29;
-    packet_size = 28;
-
-    uint8_t cobs_encoded[cobs_encoded_size];
-    uint8_t decoded_packet[packet_size];
-
-    int packet_length = receive_cobs_packet(_port, cobs_encoded, cobs_encoded_size);
-    Pose2d updated_pose(0, 0, 0);
-
-    if (packet_length == cobs_encoded_size) {
-        if (cobs_decode(cobs_encoded, packet_length, decoded_packet) == packet_size) {
-            float *floats = (float *)decoded_packet;
-
-            updated_pose = Pose2d(Translation2d(floats[0], floats[1]), from_degrees(floats[2]));
-            this->pose = updated_pose;
-            this->speed = floats[3];
-            this->accel = floats[4];
-            this->ang_speed_deg = floats[5];
-            this->ang_accel_deg = floats[6];
-        } else {
-            printf("OdometrySerial: Invalid COBS encoding\n");
-            return {0, 0, 0};
+bool OdometrySerial::decode_v2_packet(const uint8_t *packet, size_t length, double rx_time) {
+    uint8_t flags = packet[1];
+    bool with_covariance = (flags & V2_FLAG_COVARIANCE) != 0;
+    size_t expected_len = V2_HEADER_SIZE + PACKET_SIZE + (with_covariance ? V2_COVARIANCE_SIZE : 0) + CRC_SIZE;
+    if (length != expected_len) {
+        stats.packets_rejected++;
+        return false;
+    }
+
+    uint32_t crc;
+    memcpy(&crc, &packet[length - CRC_SIZE], sizeof(crc));
+    if (CRC32::calculate(packet, length - CRC_SIZE) != crc) {
+        stats.packets_corrupt++;
+        return false;
+    }
+
+    uint16_t sequence;
+    uint32_t sample_us;
+    float floats[PACKET_SIZE / sizeof(float)];
+    memcpy(&sequence, &packet[2], sizeof(sequence));
+    memcpy(&sample_us, &packet[4], sizeof(sample_us));
+    memcpy(floats, &packet[V2_HEADER_SIZE], PACKET_SIZE);
+
+    if (has_sequence) {
+        uint16_t gap = sequence - last_sequence;
+        if (gap == 0) {
+            // Repeated packet, we already have it
+            stats.packets_rejected++;
+            return false;
         }
-    } else if (packet_length == -1) {
-        printf("OdometrySerial: Buffer overflow\n");
-        return {0, 0, 0};
+        // A huge jump backwards is the coprocessor restarting, not 60000 lost packets
+        if (gap < 0x8000) {
+            stats.packets_dropped += gap - 1;
+        }
+    }
+    has_sequence = true;
+    last_sequence = sequence;
+
+    // The wire carries the packet plus one byte of COBS overhead and the delimiter
+    double sample_time = estimate_sample_time(sample_us, rx_time, length + 2);
+    if (!store_pose(floats, sample_time)) {
+        stats.packets_rejected++;
+        return false;
+    }
+
+    if (with_covariance) {
+        float cov[V2_COVARIANCE_SIZE / sizeof(float)];
+        memcpy(cov, &packet[V2_HEADER_SIZE + PACKET_SIZE], V2_COVARIANCE_SIZE);
+        covariance << cov[0], cov[1], cov[2], //
+          cov[1], cov[3], cov[4],             //
+          cov[2], cov[4], cov[5];
+        has_covariance = true;
     }
-    return pose;
+
+    double latency = rx_time - sample_time;
+    stats.latency = latency;
+    if (stats.protocol_version != PROTOCOL_V2) {
+        stats.avg_latency = latency;
+    } else {
+        stats.avg_latency += LATENCY_ALPHA * (latency - stats.avg_latency);
+    }
+    stats.protocol_version = PROTOCOL_V2;
+
+    return true;
+}
+
+/**
+ * Store the 7 pose floats shared by every packet version
+ *
+ * @param floats x, y, rot, speed, accel, ang_speed, ang_accel
+ * @param time the time (s, brain clock) the pose was measured at
+ * @return false if any of the values were not finite numbers
+ */
+bool OdometrySerial::store_pose(const float *floats, double time) {
+    for (size_t i = 0; i < PACKET_SIZE / sizeof(float); i++) {
+        if (!std::isfinite(floats[i])) {
+            return false;
+        }
+    }
+
+    this->pose = Pose2d(Translation2d(floats[0], floats[1]), from_degrees(floats[2]));
+    this->current_pos = this->pose.relative_to(pose_offset);
+
+    // The field frame vectors always come from the brain, the coprocessor only sends magnitudes
+    update_kinematics(time);
+    if (!calc_vel_acc_on_brain) {
+        this->speed = floats[3];
+        this->accel = floats[4];
+        this->ang_speed_deg = floats[5];
+        this->ang_accel_deg = floats[6];
+    }
+
+    history.push(time, this->pose);
+    publish_state();
+    return true;
+}
+
+/**
+ * Convert a coprocessor timestamp into the brain's clock.
+ *
+ * @param sample_us the coprocessor timestamp of the sample (us)
+ * @param rx_time the time (s) the packet was read off the port
+ * @param wire_bytes the number of bytes the packet took on the wire
+ * @return the time (s, brain clock) the sample was measured at
+ */
+double OdometrySerial::estimate_sample_time(uint32_t sample_us, double rx_time, size_t wire_bytes) {
+    // The coprocessor clock wraps every ~71 minutes
+    if (has_sample_time && sample_us < last_sample_us) {
+        sample_wraps++;
+    }
+    last_sample_us = sample_us;
+    double sample_time = (sample_wraps * 4294967296.0 + sample_us) / 1000000.0;
+
+    // 8 data bits + start + stop bit per byte
+    double wire_time = wire_bytes * 10.0 / baudrate;
+    double offset = rx_time - sample_time - wire_time;
+
+    if (!has_sample_time) {
+        clock_offset = offset;
+    } else {
+        double creep = CLOCK_DRIFT * (sample_time - last_sample_time);
+        clock_offset = fmin(offset, clock_offset + creep);
+    }
+    has_sample_time = true;
+    last_sample_time = sample_time;
+
+    return sample_time + clock_offset;
 }
 
 /**
@@ -151,18 +280,35 @@ Pose2d OdometrySerial::update() {
  *
  * @param new_pose the pose to set the odometry to
  */
-void OdometrySerial::set_position(const Pose2d &new_pose) { pose_offset = new_pose; }
+void OdometrySerial::set_position(const Pose2d &new_pose) {
+    mut.lock();
+    pose_offset = new_pose;
+    current_pos = pose.relative_to(pose_offset);
+    kinematics.reset(current_pos, vexSystemHighResTimeGet() / 1000000.0);
+    publish_state();
+    mut.unlock();
+}
 
 /**
- * Gets the current position and rotation
+ * Gets the position the robot was at at some time in the past
  *
- * @return the position that the odometry believes the robot is at
+ * @param time the time to look up, in seconds since the brain started
+ * @return the position that the odometry believes the robot was at
  */
-Pose2d OdometrySerial::get_position(void) {
-    Pose2d pose = get_pose2d();
-    return pose;
+Pose2d OdometrySerial::get_position_at(double time) {
+    mut.lock();
+    Pose2d past_pose = pose;
+    history.sample_at(time, past_pose);
+    Pose2d out = past_pose.relative_to(pose_offset);
+    mut.unlock();
+    return out;
 }
 
+/**
+ * Does nothing, poses are recorded in the history by the packet decoder at the time they were measured
+ */
+void OdometrySerial::record_history(double /*time*/, const Pose2d & /*pose*/) {}
+
 /**
  * Gets the current position and rotation
  *
@@ -170,6 +316,38 @@ Pose2d OdometrySerial::get_position(void) {
  */
 Pose2d OdometrySerial::get_pose2d(void) { return pose.relative_to(pose_offset); }
 
+/**
+ * @return statistics about the serial link from the most recent update
+ */
+OdometrySerial::serial_stats_t OdometrySerial::get_stats() {
+    mut.lock();
+    serial_stats_t out = stats;
+    mut.unlock();
+
+    // Packets too long to be ours are thrown out by the service before they reach us
+    SerialService::port_stats_t port_stats;
+    if (SerialService::instance().get_stats(_port, port_stats)) {
+        out.packets_rejected += port_stats.rx_overflows;
+    }
+    return out;
+}
+
+/**
+ * Gets the covariance of the newest pose, if the coprocessor sends it
+ *
+ * @param[out] cov the covariance of [x, y, rot (deg)]. Untouched if no covariance has been received
+ * @return true if a covariance has been received
+ */
+bool OdometrySerial::get_covariance(Eigen::Matrix3d &cov) {
+    mut.lock();
+    bool has = has_covariance;
+    if (has) {
+        cov = covariance;
+    }
+    mut.unlock();
+    return has;
+}
+
 /** COBS encode data to buffer
  *
  * @param data Pointer to input data to encode
@@ -231,15 +409,3 @@ size_t OdometrySerial::cobs_decode(const uint8_t *buffer, size_t length, void *d
 
     return (size_t)(decode - (uint8_t *)data);
 }
-
-double OdometrySerial::get_speed() {
-    double retval = speed;
-
-    return retval;
-}
-
-double OdometrySerial::get_accel() {
-    double retval = accel;
-
-    return retval;
-}
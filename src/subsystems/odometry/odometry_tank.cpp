@@ -63,10 +63,11 @@ void OdometryTank::set_position(const Pose2d &newpos) {
 
 /**
  * Update, store and return the current position of the robot. Only use if not initializing
- * with a separate thread.
+ * with a separate thread. If the sensors haven't produced a new sample since the last update, nothing is integrated.
  */
 Pose2d OdometryTank::update() {
     double lside_revs = 0, rside_revs = 0;
+    uint32_t imu_timestamp = 0;
 
     if (left_side != NULL && right_side != NULL) {
         lside_revs = left_side->position(vex::rotationUnits::rev) / config.odom_gear_ratio;
@@ -80,9 +81,6 @@ Pose2d OdometryTank::update() {
     }
 
     double angle = 0;
-    if (!imu->installed()) {
-        // printf("NO IMU DETECTED\n");
-    }
     // If the IMU data was passed in, use it for rotational data
     if (imu == NULL || imu->installed() == false) {
         // Get the difference in distance driven between the two sides
@@ -97,6 +95,7 @@ Pose2d OdometryTank::update() {
     } else {
         // Translate "clockwise positive" to "CCW negative"
         angle = -imu->rotation(vex::rotationUnits::deg);
+        imu_timestamp = imu->timestamp();
     }
 
     // Offset the angle, if we've done a set_position
@@ -109,71 +108,56 @@ Pose2d OdometryTank::update() {
         angle += 360;
     }
 
-    current_pos = calculate_new_pos(config, current_pos, lside_revs, rside_revs, angle);
-
-    static Pose2d last_pos = current_pos;
-    static double last_speed = 0;
-    static double last_ang_speed = 0;
-    static timer tmr;
-    bool update_vel_accel = tmr.time(sec) > 0.02;
-
-    // This loop runs too fast. Only check at LEAST every 1/10th sec
-    if (update_vel_accel) {
-        // Calculate robot velocity
-        double this_speed = current_pos.translation().distance(last_pos.translation()) / tmr.time(sec);
-        ema.add_entry(this_speed);
-        speed = ema.get_value();
-        // Calculate robot acceleration
-        accel = (speed - last_speed) / tmr.time(sec);
-
-        // Calculate robot angular velocity (deg/sec)
-        ang_speed_deg = smallest_angle(current_pos.rotation().degrees(), last_pos.rotation().degrees()) / tmr.time(sec);
-
-        // Calculate robot angular acceleration (deg/sec^2)
-        ang_accel_deg = (ang_speed_deg - last_ang_speed) / tmr.time(sec);
-
-        tmr.reset();
-        last_pos = current_pos;
-        last_speed = speed;
-        last_ang_speed = ang_speed_deg;
+    double sample_time;
+    if (!sample_detector.is_new(
+          {lside_revs, rside_revs, angle}, imu_timestamp, vexSystemHighResTimeGet() / 1000000.0, sample_time
+        )) {
+        return current_pos;
+    }
+
+    // The first sample only sets where the encoders start, so they don't have to be zeroed
+    if (!has_stored_revs) {
+        has_stored_revs = true;
+        stored_lside_revs = lside_revs;
+        stored_rside_revs = rside_revs;
     }
 
+    current_pos = calculate_new_pos(
+      config, current_pos, lside_revs - stored_lside_revs, rside_revs - stored_rside_revs, angle
+    );
+
+    // Store the left and right encoder values to find the difference in the next iteration
+    stored_lside_revs = lside_revs;
+    stored_rside_revs = rside_revs;
+
+    update_kinematics(sample_time);
+
     return current_pos;
 }
 
 /**
  * Using information about the robot's mechanical structure and sensors, calculate a new position
  * of the robot, relative to when this method was previously ran.
+ *
+ * The robot is assumed to have driven along an arc between the old and new headings, so the chord of that arc points
+ * halfway between them.
  */
 Pose2d OdometryTank::calculate_new_pos(
-  robot_specs_t &config, Pose2d &curr_pos, double lside_revs, double rside_revs, double angle_deg
+  robot_specs_t &config, const Pose2d &curr_pos, double lside_diff, double rside_diff, double angle_deg
 ) {
-    Pose2d new_pos(0, 0, 0);
-
-    static double stored_lside_revs = lside_revs;
-    static double stored_rside_revs = rside_revs;
-
     // Convert the revolutions into "change in distance", and average the values for a "distance driven"
-    double lside_diff = (lside_revs - stored_lside_revs) * PI * config.odom_wheel_diam;
-    double rside_diff = (rside_revs - stored_rside_revs) * PI * config.odom_wheel_diam;
-    double dist_driven = (lside_diff + rside_diff) / 2.0;
-
-    double angle = angle_deg * PI / 180.0; // Degrees to radians
+    double lside_dist = lside_diff * PI * config.odom_wheel_diam;
+    double rside_dist = rside_diff * PI * config.odom_wheel_diam;
+    double dist_driven = (lside_dist + rside_dist) / 2.0;
 
-    // Create a vector from the change in distance in the current direction of the robot
-    // deg2rad((smallest_angle(curr_pos.rot, angle_deg)/2 + curr_pos.rot, dist_driven)
-    Translation2d chg_point(dist_driven, Rotation2d(angle));
+    Rotation2d angle = from_degrees(angle_deg);
+    double turned = (angle - curr_pos.rotation()).wrapped_radians_180();
+    Rotation2d chord_angle(curr_pos.rotation().radians() + turned / 2.0);
 
-    // Create a vector from the current position in reference to X,Y=0,0
-    Translation2d curr_point(curr_pos.x(), curr_pos.y());
+    // Create a vector from the change in distance in the direction the robot drove
+    Translation2d chg_point(dist_driven, chord_angle);
 
-    // Tack on the "difference" vector to the current vector
-    Translation2d new_point = curr_point + chg_point;
-    new_pos = Pose2d(new_point, from_degrees(angle_deg));
-
-    // Store the left and right encoder values to find the difference in the next iteration
-    stored_lside_revs = lside_revs;
-    stored_rside_revs = rside_revs;
-
-    return new_pos;
-}
\ No newline at end of file
+    // Tack on the "difference" vector to the current position
+    Translation2d new_point = curr_pos.translation() + chg_point;
+    return Pose2d(new_point, angle);
+}
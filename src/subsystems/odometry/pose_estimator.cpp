@@ -0,0 +1,335 @@
+#include "core/subsystems/odometry/pose_estimator.h"
+
+#include <cmath>
+#include <limits>
+
+namespace {
+
+/**
+ * Wrap an angle to [-pi, pi)
+ */
+double wrap_angle(double rad) {
+    rad = fmod(rad + PI, 2 * PI);
+    if (rad < 0) {
+        rad += 2 * PI;
+    }
+    return rad - PI;
+}
+
+/**
+ * The process model: the input is the robot's velocity in its own frame [vx, vy, omega], rotated into the field frame
+ */
+EVec<3> pose_dynamics(const EVec<3> &x, const EVec<3> &u) {
+    double c = cos(x(2));
+    double s = sin(x(2));
+    return EVec<3>(u(0) * c - u(1) * s, u(0) * s + u(1) * c, u(2));
+}
+
+/**
+ * Weighted mean of a set of states, averaging the heading on the circle
+ */
+EVec<3> state_mean(const EMat<3, 5> &sigmas, const EVec<5> &Wm) {
+    EVec<3> mean = sigmas * Wm;
+    double sin_sum = 0;
+    double cos_sum = 0;
+    for (int i = 0; i < 5; i++) {
+        sin_sum += Wm(i) * sin(sigmas(2, i));
+        cos_sum += Wm(i) * cos(sigmas(2, i));
+    }
+    mean(2) = atan2(sin_sum, cos_sum);
+    return mean;
+}
+
+EVec<3> state_residual(const EVec<3> &a, const EVec<3> &b) {
+    EVec<3> r = a - b;
+    r(2) = wrap_angle(r(2));
+    return r;
+}
+
+EVec<3> state_add(const EVec<3> &a, const EVec<3> &b) {
+    EVec<3> r = a + b;
+    r(2) = wrap_angle(r(2));
+    return r;
+}
+
+/**
+ * Weighted mean of a set of heading measurements, averaged on the circle
+ */
+EVec<1> heading_mean(const EMat<1, 5> &sigmas, const EVec<5> &Wm) {
+    double sin_sum = 0;
+    double cos_sum = 0;
+    for (int i = 0; i < 5; i++) {
+        sin_sum += Wm(i) * sin(sigmas(0, i));
+        cos_sum += Wm(i) * cos(sigmas(0, i));
+    }
+    EVec<1> mean;
+    mean << atan2(sin_sum, cos_sum);
+    return mean;
+}
+
+EVec<1> heading_residual(const EVec<1> &a, const EVec<1> &b) {
+    EVec<1> r;
+    r << wrap_angle(a(0) - b(0));
+    return r;
+}
+
+EVec<1> heading_measurement(const EVec<3> &x, const EVec<3> &) {
+    EVec<1> y;
+    y << x(2);
+    return y;
+}
+
+EVec<1> range_mean(const EMat<1, 5> &sigmas, const EVec<5> &Wm) { return sigmas * Wm; }
+
+EVec<1> range_residual(const EVec<1> &a, const EVec<1> &b) { return a - b; }
+
+} // namespace
+
+/**
+ * Create a pose estimator
+ *
+ * @param odom the wheel odometry to predict with. Should be constructed with is_async = false
+ * @param imu the inertial sensor to correct the heading with, or nullptr to not use one
+ * @param config how much to trust each source of information
+ * @param is_async true to run in the background, false to call update() manually
+ */
+PoseEstimator::PoseEstimator(
+  OdometryBase &odom, vex::inertial *imu, const pose_estimator_config_t &config, bool is_async
+)
+    : OdometryBase(is_async), odom(odom), imu(imu), config(config),
+      filter(
+        pose_dynamics, heading_measurement, RK4_with_input<STATES, INPUTS>,
+        EVec<3>(config.pos_drift, config.pos_drift, config.heading_drift_deg * PI / 180.0),
+        EVec<1>(config.imu_stddev_deg * PI / 180.0), state_mean, heading_mean, state_residual, heading_residual,
+        state_add
+      ) {}
+
+/**
+ * Step the wrapped odometry. If it has a new sample, predict with the motion it saw, then correct with the IMU and any
+ * measurements that have arrived since the last sample. Everything happens at the time the sample was measured, so the
+ * filter and the velocity estimate see one step per sample instead of a burst after several empty polls.
+ * @return the estimated pose
+ */
+Pose2d PoseEstimator::update() {
+    double now = vexSystemHighResTimeGet() / 1000000.0;
+    double previous_sample = odom.get_sample_time();
+    Pose2d odom_pose = odom.update();
+
+    // Odometry that reports its samples says when it has a new one. For any other, a new sample is a new pose, or the
+    // same pose held long enough to mean the robot is sitting still
+    double sample_time = odom.get_sample_time();
+    if (sample_time < 0) {
+        std::array<double, 3> readings = {odom_pose.x(), odom_pose.y(), odom_pose.rotation().radians()};
+        if (!pose_detector.is_new(readings, 0, now, sample_time)) {
+            return current_pos;
+        }
+    } else if (sample_time == previous_sample) {
+        return current_pos;
+    }
+
+    if (!has_odom_pose) {
+        has_odom_pose = true;
+        last_odom_pose = odom_pose;
+        last_odom_time = sample_time;
+    }
+
+    // Predict with the velocity that carries the last odometry pose to this one along an arc
+    double dt = sample_time - last_odom_time;
+    if (dt > 0) {
+        Twist2d twist = last_odom_pose.log(odom_pose);
+        EVec<3> u(twist.dx() / dt, twist.dy() / dt, twist.dtheta() / dt);
+        filter.predict(u, dt);
+        last_odom_pose = odom_pose;
+        last_odom_time = sample_time;
+    }
+    odom_history.push(sample_time, odom_pose);
+
+    static const EVec<3> no_input = EVec<3>::Zero();
+    if (imu != nullptr && imu->installed()) {
+        uint32_t imu_timestamp = imu->timestamp();
+        if (imu_timestamp != last_imu_timestamp) {
+            last_imu_timestamp = imu_timestamp;
+            EVec<1> heading;
+            heading << wrap_angle(-imu->rotation(vex::rotationUnits::deg) * PI / 180.0 + imu_offset);
+            filter.correct(no_input, heading);
+        }
+    }
+
+    // Take the waiting measurements, so adding more doesn't wait on the corrections
+    std::array<measurement_t, MAX_PENDING> to_apply;
+    size_t num_to_apply;
+    pending_mut.lock();
+    num_to_apply = pending_count;
+    for (size_t i = 0; i < pending_count; i++) {
+        to_apply[i] = pending[i];
+    }
+    pending_count = 0;
+    pending_mut.unlock();
+
+    uint32_t applied = 0;
+    for (size_t i = 0; i < num_to_apply; i++) {
+        if (apply_measurement(to_apply[i], sample_time)) {
+            applied++;
+        }
+    }
+    if (num_to_apply > 0) {
+        pending_mut.lock();
+        stats.applied += applied;
+        stats.rejected += num_to_apply - applied;
+        published_stats.write(stats);
+        pending_mut.unlock();
+    }
+
+    current_pos = Pose2d(filter.xhat(0), filter.xhat(1), filter.xhat(2));
+    update_kinematics(sample_time);
+    return current_pos;
+}
+
+/**
+ * Correct the estimate with one queued measurement. Must be called with mut held
+ *
+ * The measurement describes the robot at m.time, but the filter holds the robot now. Odometry is good over short
+ * times, so the motion it recorded since m.time is used to relate the two: the robot at m.time is the current state
+ * moved back by that motion.
+ *
+ * @param m the measurement
+ * @param now the time of the sample the filter is at (s)
+ * @return true if the measurement was used, false if it was thrown out for being too old or too far from the estimate
+ */
+bool PoseEstimator::apply_measurement(const measurement_t &m, double now) {
+    Pose2d odom_then;
+    if (now - m.time > config.max_latency || !odom_history.sample_at(m.time, odom_then)) {
+        return false;
+    }
+    // Where the robot was at m.time, in the frame of where it is now
+    Transform2d now_to_then = odom_then - last_odom_pose;
+
+    static const EVec<3> no_input = EVec<3>::Zero();
+    if (m.type == MeasurementType::Pose) {
+        // Carry the measured pose forward by the motion since it was taken, then it measures the state directly
+        Pose2d measured_now = m.pose + now_to_then.inverse();
+        EVec<3> y(measured_now.x(), measured_now.y(), measured_now.rotation().wrapped_radians_180());
+        EVec<3> stddevs(m.stddev[0], m.stddev[1], m.stddev[2]);
+
+        filter.correct<3>(
+          no_input, y, [](const EVec<3> &x, const EVec<3> &) -> EVec<3> { return x; }, stddevs, state_mean,
+          state_residual, state_residual, state_add
+        );
+    } else {
+        Transform2d sensor(m.pose.translation(), m.pose.rotation());
+        double field_size = config.field_size;
+        auto expected_range = [now_to_then, sensor, field_size](const EVec<3> &x, const EVec<3> &) -> EVec<1> {
+            Pose2d robot_then = Pose2d(x(0), x(1), x(2)) + now_to_then;
+            EVec<1> r;
+            r << range_to_walls(robot_then + sensor, field_size);
+            return r;
+        };
+
+        // A reading off of something other than a wall (another robot, a game object) is nowhere near what's
+        // expected, and would drag the estimate off
+        if (fabs(m.range - expected_range(filter.xhat(), no_input)(0)) > config.range_gate) {
+            return false;
+        }
+
+        EVec<1> y;
+        y << m.range;
+        EVec<1> stddevs;
+        stddevs << m.stddev[0];
+        filter.correct<1>(no_input, y, expected_range, stddevs, range_mean, range_residual, state_residual, state_add);
+    }
+    return true;
+}
+
+/**
+ * Sets the current position of the robot. The estimate is taken as exact, until odometry starts moving it again.
+ * @param newpos the new position that the estimator will believe it is at
+ */
+void PoseEstimator::set_position(const Pose2d &newpos) {
+    mut.lock();
+    filter.reset();
+    filter.set_xhat(EVec<3>(newpos.x(), newpos.y(), newpos.rotation().wrapped_radians_180()));
+    if (imu != nullptr) {
+        imu_offset = newpos.rotation().radians() + imu->rotation(vex::rotationUnits::deg) * PI / 180.0;
+    }
+    // Old measurements were taken in the old frame
+    pending_mut.lock();
+    pending_count = 0;
+    pending_mut.unlock();
+    odom_history.clear();
+    mut.unlock();
+
+    OdometryBase::set_position(newpos);
+}
+
+/**
+ * Add a measurement of the whole pose. Safe to call from any task.
+ *
+ * @param pose the measured pose
+ * @param time the time the pose was measured (s, same clock as vexSystemHighResTimeGet)
+ * @param xy_stddev how noisy the measured x and y are (inch)
+ * @param heading_stddev_deg how noisy the measured heading is (deg)
+ */
+void PoseEstimator::add_pose_measurement(const Pose2d &pose, double time, double xy_stddev, double heading_stddev_deg) {
+    add_measurement({MeasurementType::Pose, time, pose, 0, {xy_stddev, xy_stddev, heading_stddev_deg * PI / 180.0}});
+}
+
+/**
+ * Add a distance sensor reading of the distance to a field wall. Safe to call from any task.
+ *
+ * @param range the measured distance (inch)
+ * @param time the time the distance was measured (s, same clock as vexSystemHighResTimeGet)
+ * @param sensor_offset where the sensor is on the robot and the direction it points, relative to the robot's center
+ * @param stddev how noisy the measured distance is (inch)
+ */
+void PoseEstimator::add_range_measurement(double range, double time, const Pose2d &sensor_offset, double stddev) {
+    add_measurement({MeasurementType::Range, time, sensor_offset, range, {stddev, 0, 0}});
+}
+
+/**
+ * Queue a measurement for the next update, dropping the oldest if the queue is full
+ */
+void PoseEstimator::add_measurement(const measurement_t &m) {
+    pending_mut.lock();
+    if (pending_count == MAX_PENDING) {
+        for (size_t i = 1; i < MAX_PENDING; i++) {
+            pending[i - 1] = pending[i];
+        }
+        pending_count--;
+        stats.dropped++;
+        published_stats.write(stats);
+    }
+    pending[pending_count++] = m;
+    pending_mut.unlock();
+}
+
+/**
+ * Reads the latest published counts without taking a mutex, so it never waits on an update
+ * @return counts of what happened to the absolute measurements
+ */
+PoseEstimator::estimator_stats_t PoseEstimator::get_estimator_stats() { return published_stats.read(); }
+
+/**
+ * Find the distance from a point to the field walls along a direction. The field is the square from (0, 0) to
+ * (field_size, field_size).
+ *
+ * @param from the point to measure from and the direction to measure in
+ * @param field_size the length of the sides of the square field
+ * @return the distance to the first wall hit (inch)
+ */
+double PoseEstimator::range_to_walls(const Pose2d &from, double field_size) {
+    double c = from.rotation().f_cos();
+    double s = from.rotation().f_sin();
+    double best = std::numeric_limits<double>::infinity();
+
+    if (c > 1e-9) {
+        best = std::min(best, (field_size - from.x()) / c);
+    } else if (c < -1e-9) {
+        best = std::min(best, -from.x() / c);
+    }
+    if (s > 1e-9) {
+        best = std::min(best, (field_size - from.y()) / s);
+    } else if (s < -1e-9) {
+        best = std::min(best, -from.y() / s);
+    }
+    return best;
+}
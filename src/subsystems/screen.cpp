@@ -335,6 +335,63 @@ void OdometryPage::update(bool was_pressed, int x, int y) {
     (void)was_pressed;
 }
 
+OdometryTimingPage::OdometryTimingPage(OdometryBase &odom)
+    : odom(odom), cost_graph(30, 0.0, 0.0, {vex::green, vex::red}, 2) {}
+
+void OdometryTimingPage::update(bool was_pressed, int x, int y) {
+    (void)x;
+    (void)y;
+    if (was_pressed) {
+        odom.reset_task_stats();
+    }
+}
+
+void OdometryTimingPage::draw(
+  vex::brain::lcd &scr, bool first_draw [[maybe_unused]], unsigned int frame_number [[maybe_unused]]
+) {
+    OdometryBase::task_stats_t stats = odom.get_task_stats();
+    if (stats.updates == 0) {
+        scr.printAt(45, 110, "Odometry not running async");
+        return;
+    }
+
+    scr.printAt(45, 30, "%.1f Hz (%lu us)", 1000000.0 / stats.period_us, (unsigned long)stats.period_us);
+    scr.printAt(45, 50, "updates  %lu", (unsigned long)stats.updates);
+    scr.printAt(45, 70, "overruns %lu", (unsigned long)stats.overruns);
+    scr.printAt(45, 90, "skipped  %lu", (unsigned long)stats.skipped);
+    scr.printAt(45, 110, "jitter   %lu us", (unsigned long)stats.max_jitter_us);
+    scr.printAt(45, 130, "update   %.0f/%lu us", stats.avg_update_us, (unsigned long)stats.max_update_us);
+
+    cost_graph.add_samples(std::vector<double>{(double)stats.last_update_us, (double)stats.period_us});
+    cost_graph.draw(scr, 45, 140, 180, 90);
+
+    // Period histogram, bars scaled to the fullest bin
+    const int hist_x = 250;
+    const int hist_y = 20;
+    const int hist_w = 176;
+    const int hist_h = 180;
+    const int bar_w = hist_w / (int)OdometryBase::PERIOD_HISTOGRAM_BINS;
+
+    uint32_t most = 1;
+    for (size_t i = 0; i < OdometryBase::PERIOD_HISTOGRAM_BINS; i++) {
+        if (stats.period_histogram[i] > most) {
+            most = stats.period_histogram[i];
+        }
+    }
+
+    scr.setPenColor(vex::color::white);
+    scr.drawLine(hist_x, hist_y + hist_h, hist_x + hist_w, hist_y + hist_h);
+    for (size_t i = 0; i < OdometryBase::PERIOD_HISTOGRAM_BINS; i++) {
+        int h = (int)((double)stats.period_histogram[i] / most * hist_h);
+        // Bins 7 and 8 are either side of the scheduled period
+        vex::color col = (i == 7 || i == 8) ? vex::color::green : vex::color::orange;
+        scr.drawRectangle(hist_x + (int)i * bar_w, hist_y + hist_h - h, bar_w - 2, h, col);
+    }
+    scr.printAt(hist_x, hist_y + hist_h + 20, "0");
+    scr.printAt(hist_x + hist_w / 2 - 10, hist_y + hist_h + 20, "1T");
+    scr.printAt(hist_x + hist_w - 30, hist_y + hist_h + 20, "2T+");
+}
+
 bool SliderWidget::update(bool was_pressed, int x, int y) {
     const double margin = 10.0;
     if (was_pressed) {
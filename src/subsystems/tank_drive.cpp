@@ -584,31 +584,34 @@ double TankDrive::modify_inputs(double input, int power) { return sign(input) *
 bool TankDrive::pure_pursuit(
   PurePursuit::Path path, directionType dir, Feedback &feedback, double max_speed, double end_speed
 ) {
-    std::vector<Translation2d> points = path.get_points();
+    const std::vector<Translation2d> &points = path.get_points();
     if (!path.is_valid()) {
         printf("WARNING: Unexpected pure pursuit path - some segments intersect or are too close\n");
     }
     Pose2d robot_pose = odometry->get_position();
 
-    // On function initialization, send the path-length estimate to the feedback controller
+    // On function initialization, send the path-length estimate to the feedback controller, and start tracking the
+    // robot from the start of the path
     if (!func_initialized) {
         if (dir != directionType::rev) {
-            feedback.init(-estimate_path_length(points), 0);
+            feedback.init(-path.get_length(), 0);
         } else {
-            feedback.init(estimate_path_length(points), 0);
+            feedback.init(path.get_length(), 0);
         }
+        pure_pursuit_tracker = PurePursuit::Tracker(path);
 
         func_initialized = true;
     }
 
-    Translation2d lookahead = PurePursuit::get_lookahead(points, odometry->get_position(), path.get_radius());
+    pure_pursuit_tracker.update(robot_pose);
+    Translation2d lookahead = pure_pursuit_tracker.get_lookahead();
     Translation2d localized = lookahead - robot_pose.translation();
 
     Translation2d last_point = points[points.size() - 1];
-    bool is_last_point = (lookahead == last_point);
+    bool is_last_point = pure_pursuit_tracker.is_lookahead_end();
 
     double correction = 0;
-    double dist_remaining = PurePursuit::estimate_remaining_dist(points, robot_pose, path.get_radius());
+    double dist_remaining = pure_pursuit_tracker.get_remaining_dist();
     double angle_diff = 0;
 
     // Robot is facing forwards / backwards, change the bot's angle by 180
@@ -9,6 +9,7 @@
  *      - drive_to_point
  *      - turn_to_heading
  *      - stop
+ *      - trajectory following
  *
  *    Also holds AutoCommand subclasses that wrap OdometryBase functions
  *
@@ -264,7 +265,7 @@ bool PurePursuitCommand::run() { return drive_sys.pure_pursuit(path, dir, feedba
  */
 std::string PurePursuitCommand::toString() {
     std::string returnStr = "Driving through ";
-    std::vector<Translation2d> thePoints = path.get_points();
+    const std::vector<Translation2d> &thePoints = path.get_points();
     for (int i = 0; i < thePoints.size(); i++) {
         returnStr.append("(");
         returnStr.append(double_to_string(thePoints.at(i).x()) + ", " + double_to_string(thePoints.at(i).y()) + ") \n");
@@ -281,6 +282,72 @@ void PurePursuitCommand::on_timeout() {
     drive_sys.reset_auto();
 }
 
+/**
+ * Construct a trajectory following AutoCommand
+ *
+ * @param drive_sys the drive to follow the trajectory with
+ * @param controller corrects the robot toward the trajectory
+ * @param trajectory the trajectory to follow
+ * @param ff_cfg feedforward from wheel speed (inch/s) and acceleration to drive_tank_raw's -1 to 1
+ * @param track_width the distance between the left and right wheels (inch)
+ */
+FollowTrajectoryCommand::FollowTrajectoryCommand(
+  TankDrive &drive_sys, UnicycleController &controller, Trajectory trajectory, FeedForward::ff_config_t &ff_cfg,
+  double track_width
+)
+    : drive_sys(drive_sys), controller(controller), trajectory(trajectory), ff(ff_cfg), track_width(track_width) {
+    timeout_seconds = 0;
+}
+
+/**
+ * Drive toward the trajectory's state for the current time. The first run starts the clock
+ * @returns true when the trajectory is finished
+ */
+bool FollowTrajectoryCommand::run() {
+    if (!started) {
+        started = true;
+        start_us = vexSystemHighResTimeGet();
+    }
+    double t = (vexSystemHighResTimeGet() - start_us) / 1000000.0;
+    if (t >= trajectory.total_time()) {
+        drive_sys.stop();
+        return true;
+    }
+
+    Trajectory::state_t ref = trajectory.sample(t);
+    UnicycleController::output_t out = controller.calculate(drive_sys.get_position(), ref);
+    double left_vel = out.vel - out.ang_vel * track_width / 2;
+    double right_vel = out.vel + out.ang_vel * track_width / 2;
+
+    // The turn rate is vel * curvature, so it changes with accel * curvature + vel * (rate the curvature changes), and
+    // the outside wheel speeds up by that much more than the center. The curvature's rate comes from the states
+    // either side of now
+    Trajectory::state_t before = trajectory.sample(t - CURVATURE_DT);
+    Trajectory::state_t after = trajectory.sample(t + CURVATURE_DT);
+    double span = after.time - before.time;
+    double curvature_rate = span > 0 ? (after.curvature - before.curvature) / span : 0;
+    double ang_accel = ref.accel * ref.curvature + ref.vel * curvature_rate;
+    double left_accel = ref.accel - ang_accel * track_width / 2;
+    double right_accel = ref.accel + ang_accel * track_width / 2;
+
+    double left = clamp(ff.calculate(left_vel, left_accel), -1, 1);
+    double right = clamp(ff.calculate(right_vel, right_accel), -1, 1);
+    drive_sys.drive_tank_raw(left, right);
+    return false;
+}
+
+/*
+ * Returns a string describing the commands functionality
+ */
+std::string FollowTrajectoryCommand::toString() {
+    return "Following a trajectory for " + double_to_string(trajectory.total_time()) + " seconds";
+}
+
+/**
+ * Stop the drive system when it times out
+ */
+void FollowTrajectoryCommand::on_timeout() { drive_sys.stop(); }
+
 /**
  * Construct a DriveStop Command
  * @param drive_sys the drive system we are commanding
@@ -0,0 +1,140 @@
+#include "core/utils/controls/unicycle_controller.h"
+
+#include <algorithm>
+#include <cmath>
+
+#include "core/utils/controls/state_space/linear_quadratic_regulator.h"
+
+namespace {
+
+// Below this speed the cross error can't be corrected at all, and the Riccati equation has no solution. Solve there
+// for this speed instead, which gives (nearly) no cross correction
+constexpr double MIN_LTV_VEL = 1e-4;
+
+} // namespace
+
+/**
+ * Create a controller
+ * @param config the tuning of the controller
+ */
+RamseteController::RamseteController(const ramsete_config_t &config) : config(config) {}
+
+/**
+ * Find what to drive at to follow the trajectory
+ *
+ *   k = 2 zeta sqrt(w_ref^2 + b v_ref^2)
+ *   v = v_ref cos(e_heading) + k e_along
+ *   w = w_ref + k e_heading + b v_ref sin(e_heading) / e_heading e_cross
+ *
+ * @param current where the robot is
+ * @param ref the trajectory's state for now
+ * @return the speed and turn rate to drive at
+ */
+UnicycleController::output_t RamseteController::calculate(const Pose2d &current, const Trajectory::state_t &ref) {
+    Pose2d error = ref.pose.relative_to(current);
+    double e_heading = error.rotation().wrapped_radians_180();
+    double v_ref = ref.vel;
+    double w_ref = ref.vel * ref.curvature;
+
+    double k = 2 * config.zeta * sqrt(w_ref * w_ref + config.b * v_ref * v_ref);
+    // sin(x) / x, by its series near 0
+    double sinc = fabs(e_heading) < 1e-6 ? 1 - e_heading * e_heading / 6 : sin(e_heading) / e_heading;
+
+    return {
+      v_ref * cos(e_heading) + k * error.x(), w_ref + k * e_heading + config.b * v_ref * sinc * error.y()
+    };
+}
+
+/**
+ * Create a controller, solving the gains for every speed in the table
+ * @param config the tolerances and speeds
+ */
+LTVUnicycleController::LTVUnicycleController(const ltv_config_t &config)
+    : LTVUnicycleController(config, solve_gains(config)) {}
+
+/**
+ * Create a controller with gains that were already solved
+ * @param config the tolerances and speeds the gains were solved with
+ * @param gains the table, from get_gains()
+ */
+LTVUnicycleController::LTVUnicycleController(const ltv_config_t &config, std::vector<double> gains)
+    : config(config), bins_per_vel((config.vel_bins - 1) / (2 * config.max_vel)), gains(std::move(gains)) {
+    if (this->gains.size() != (size_t)config.vel_bins * GAINS_PER_BIN) {
+        printf("LTVUnicycleController: gain table doesn't match the config, solving again\n");
+        this->gains = solve_gains(config);
+    }
+}
+
+/**
+ * Solve the gains for every speed in the table. At speed v, the error [along, cross, heading] moves like
+ *
+ *   d/dt error = A error + B correction
+ *   A = [0 0 0]    B = [1 0]
+ *       [0 0 v]        [0 0]
+ *       [0 0 0]        [0 1]
+ *
+ * with the correction being [speed, turn rate]
+ *
+ * @param config the tolerances and speeds
+ * @return the table: GAINS_PER_BIN gains for each speed, from slowest to fastest
+ */
+std::vector<double> LTVUnicycleController::solve_gains(const ltv_config_t &config) {
+    EMat<3, 2> B = EMat<3, 2>::Zero();
+    B(0, 0) = 1;
+    B(2, 1) = 1;
+    EVec<3> q_tol(config.along_tol, config.cross_tol, config.heading_tol);
+    EVec<2> r_tol(config.vel_tol, config.ang_vel_tol);
+
+    std::vector<double> out;
+    out.reserve((size_t)config.vel_bins * GAINS_PER_BIN);
+    for (int i = 0; i < config.vel_bins; i++) {
+        double vel = -config.max_vel + 2 * config.max_vel * i / (config.vel_bins - 1);
+        if (fabs(vel) < MIN_LTV_VEL) {
+            vel = MIN_LTV_VEL;
+        }
+        EMat<3, 3> A = EMat<3, 3>::Zero();
+        A(1, 2) = vel;
+
+        LinearQuadraticRegulator<3, 2> lqr(A, B, q_tol, r_tol, config.dt);
+        const EMat<2, 3> &K = lqr.K();
+        for (int row = 0; row < 2; row++) {
+            for (int col = 0; col < 3; col++) {
+                out.push_back(K(row, col));
+            }
+        }
+    }
+    return out;
+}
+
+/**
+ * Find what to drive at to follow the trajectory: the gains for the trajectory's speed, blended from the two table
+ * entries around it, times the error
+ *
+ * @param current where the robot is
+ * @param ref the trajectory's state for now
+ * @return the speed and turn rate to drive at
+ */
+UnicycleController::output_t LTVUnicycleController::calculate(const Pose2d &current, const Trajectory::state_t &ref) {
+    Pose2d error = ref.pose.relative_to(current);
+    double e[3] = {error.x(), error.y(), error.rotation().wrapped_radians_180()};
+
+    double pos = std::max(0.0, std::min((double)(config.vel_bins - 1), (ref.vel + config.max_vel) * bins_per_vel));
+    int bin = std::min((int)pos, config.vel_bins - 2);
+    double t = pos - bin;
+    const double *lo = &gains[bin * GAINS_PER_BIN];
+    const double *hi = lo + GAINS_PER_BIN;
+
+    double u[2] = {0, 0};
+    for (int row = 0; row < 2; row++) {
+        for (int col = 0; col < 3; col++) {
+            int i = row * 3 + col;
+            u[row] += (lo[i] + (hi[i] - lo[i]) * t) * e[col];
+        }
+    }
+    return {ref.vel + u[0], ref.vel * ref.curvature + u[1]};
+}
+
+/**
+ * Get the table of gains, to store it
+ */
+const std::vector<double> &LTVUnicycleController::get_gains() const { return gains; }
@@ -0,0 +1,429 @@
+#include "core/utils/drive_recording.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+namespace {
+
+// Heading units in a whole turn, to find the short way between two headings
+constexpr int32_t HEADING_UNITS_PER_TURN = (int32_t)(360 * DriveRecordingCodec::HEADING_UNITS);
+
+/**
+ * Write a number as a zigzag varint: the sign moved to the lowest bit, then 7 bits per byte with the high bit set on
+ * every byte but the last
+ * @return the number of bytes written
+ */
+size_t put_varint(int32_t value, uint8_t *out) {
+    uint32_t zigzag = ((uint32_t)value << 1) ^ (uint32_t)(value >> 31);
+    size_t len = 0;
+    while (zigzag >= 0x80) {
+        out[len++] = (uint8_t)(zigzag | 0x80);
+        zigzag >>= 7;
+    }
+    out[len++] = (uint8_t)zigzag;
+    return len;
+}
+
+/**
+ * Read a zigzag varint
+ * @return the number of bytes read, or 0 if the bytes ran out first
+ */
+size_t take_varint(const uint8_t *data, size_t len, int32_t &value) {
+    uint32_t zigzag = 0;
+    for (size_t i = 0; i < len && i < 5; i++) {
+        zigzag |= (uint32_t)(data[i] & 0x7f) << (7 * i);
+        if ((data[i] & 0x80) == 0) {
+            value = (int32_t)(zigzag >> 1) ^ -(int32_t)(zigzag & 1);
+            return i + 1;
+        }
+    }
+    return 0;
+}
+
+} // namespace
+
+/**
+ * Start a new stream
+ */
+DriveRecordingCodec::DriveRecordingCodec() { reset(); }
+
+/**
+ * Go back to the start of a stream, where every value and velocity is zero
+ */
+void DriveRecordingCodec::reset() {
+    for (int i = 0; i < NUM_FIELDS; i++) {
+        last[i] = 0;
+        last_delta[i] = 0;
+    }
+}
+
+/**
+ * Add a sample to the stream
+ * @param sample the sample
+ * @param[out] out room for MAX_SAMPLE_BYTES bytes
+ * @return the number of bytes written
+ */
+size_t DriveRecordingCodec::encode(const drive_sample_t &sample, uint8_t *out) {
+    int32_t value[NUM_FIELDS];
+    value[0] = (int32_t)lround(sample.left * COMMAND_UNITS);
+    value[1] = (int32_t)lround(sample.right * COMMAND_UNITS);
+    value[2] = (int32_t)lround(sample.pose.x() * POSITION_UNITS);
+    value[3] = (int32_t)lround(sample.pose.y() * POSITION_UNITS);
+
+    // Headings are kept unwrapped, so crossing 0 degrees is a small change instead of a whole turn
+    int32_t heading = (int32_t)lround(sample.pose.rotation().wrapped_degrees_360() * HEADING_UNITS);
+    int32_t turn = (heading - last[4]) % HEADING_UNITS_PER_TURN;
+    if (turn >= HEADING_UNITS_PER_TURN / 2) {
+        turn -= HEADING_UNITS_PER_TURN;
+    } else if (turn < -HEADING_UNITS_PER_TURN / 2) {
+        turn += HEADING_UNITS_PER_TURN;
+    }
+    value[4] = last[4] + turn;
+
+    uint8_t flags = 0;
+    size_t len = 1;
+    for (int i = 0; i < NUM_FIELDS; i++) {
+        int32_t delta = value[i] - last[i];
+        int32_t stored = i < FIRST_POSE_FIELD ? delta : delta - last_delta[i];
+        if (stored != 0) {
+            flags |= 1 << i;
+            len += put_varint(stored, out + len);
+        }
+        last[i] = value[i];
+        last_delta[i] = delta;
+    }
+    out[0] = flags;
+    return len;
+}
+
+/**
+ * Read the next sample from the stream. The state only changes once the whole sample has been read
+ *
+ * @param data the bytes of the stream, starting at the next sample
+ * @param len the number of bytes available
+ * @param[out] sample the sample
+ * @return the number of bytes read, or 0 if there weren't enough
+ */
+size_t DriveRecordingCodec::decode(const uint8_t *data, size_t len, drive_sample_t &sample) {
+    if (len == 0) {
+        return 0;
+    }
+    uint8_t flags = data[0];
+    size_t pos = 1;
+    int32_t value[NUM_FIELDS];
+    int32_t delta[NUM_FIELDS];
+    for (int i = 0; i < NUM_FIELDS; i++) {
+        int32_t stored = 0;
+        if (flags & (1 << i)) {
+            size_t read = take_varint(data + pos, len - pos, stored);
+            if (read == 0) {
+                return 0;
+            }
+            pos += read;
+        }
+        delta[i] = i < FIRST_POSE_FIELD ? stored : last_delta[i] + stored;
+        value[i] = last[i] + delta[i];
+    }
+
+    memcpy(last, value, sizeof(last));
+    memcpy(last_delta, delta, sizeof(last_delta));
+    sample.left = value[0] / COMMAND_UNITS;
+    sample.right = value[1] / COMMAND_UNITS;
+    sample.pose = Pose2d(value[2] / POSITION_UNITS, value[3] / POSITION_UNITS, from_degrees(value[4] / HEADING_UNITS));
+    return pos;
+}
+
+/**
+ * Create a recorder
+ * @param drive the drive to record. Must have odometry
+ * @param filename the file on the SD card to record to. Replaced when recording starts
+ */
+DriveRecorder::DriveRecorder(TankDrive &drive, const std::string &filename) : drive(drive), filename(filename) {}
+
+/**
+ * Start recording: replace the file, start the chunk with the header and start the tasks
+ * @return true if the file could be created
+ */
+bool DriveRecorder::start() {
+    if (recording) {
+        return true;
+    }
+    vex::brain::sdcard sd;
+    if (!sd.isInserted() || sd.savefile(filename.c_str(), NULL, 0) < 0) {
+        printf("DriveRecorder: can't create %s\n", filename.c_str());
+        return false;
+    }
+
+    mut.lock();
+    codec.reset();
+    chunk.clear();
+    chunk.reserve(CHUNK_SIZE);
+    full_chunks.clear();
+    uint32_t header[2] = {FILE_MAGIC, PERIOD_MS};
+    chunk.insert(chunk.end(), (uint8_t *)header, (uint8_t *)header + sizeof(header));
+    samples = 0;
+    bytes = sizeof(header);
+    total_sample_us = 0;
+    longest_sample_us = 0;
+    mut.unlock();
+
+    recording = true;
+    sampling = true;
+    writing = true;
+    sample_task = vex::task(DriveRecorder::sample_thread, (void *)this);
+    write_task = vex::task(DriveRecorder::write_thread, (void *)this, vex::thread::threadPriorityLow);
+    return true;
+}
+
+/**
+ * Stop recording, and wait for the tasks to write everything to the file
+ */
+void DriveRecorder::stop() {
+    if (!recording) {
+        return;
+    }
+    recording = false;
+    while (writing) {
+        vexDelay(PERIOD_MS);
+    }
+}
+
+/**
+ * Drive with TankDrive::drive_tank, and record the commands it sends to the motors
+ */
+void DriveRecorder::drive_tank(double left, double right, int power, TankDrive::BrakeType bt) {
+    mut.lock();
+    this->left = TankDrive::modify_inputs(left, power);
+    this->right = TankDrive::modify_inputs(right, power);
+    mut.unlock();
+    drive.drive_tank(left, right, power, bt);
+}
+
+/**
+ * Drive with TankDrive::drive_arcade, and record the commands it sends to the motors
+ */
+void DriveRecorder::drive_arcade(double forward_back, double left_right, int power, TankDrive::BrakeType bt) {
+    forward_back = TankDrive::modify_inputs(forward_back, power);
+    left_right = TankDrive::modify_inputs(left_right, power);
+    drive_tank(forward_back + left_right, forward_back - left_right, 1, bt);
+}
+
+/**
+ * Get the number of samples recorded
+ */
+size_t DriveRecorder::num_samples() {
+    mut.lock();
+    size_t out = samples;
+    mut.unlock();
+    return out;
+}
+
+/**
+ * Get the number of bytes recorded, including ones not yet written
+ */
+size_t DriveRecorder::num_bytes() {
+    mut.lock();
+    size_t out = bytes;
+    mut.unlock();
+    return out;
+}
+
+/**
+ * Get the average time it took to take and encode a sample (us)
+ */
+double DriveRecorder::mean_sample_us() {
+    mut.lock();
+    double out = samples > 0 ? (double)total_sample_us / samples : 0;
+    mut.unlock();
+    return out;
+}
+
+/**
+ * Get the longest time it took to take and encode a sample (us)
+ */
+uint32_t DriveRecorder::max_sample_us() {
+    mut.lock();
+    uint32_t out = longest_sample_us;
+    mut.unlock();
+    return out;
+}
+
+/**
+ * Take a sample every PERIOD_MS on an absolute schedule, so a slow sample doesn't push every one after it back. Hands
+ * the last partial chunk to the writer when recording stops
+ */
+int DriveRecorder::sample_thread(void *ptr) {
+    DriveRecorder &rec = *(DriveRecorder *)ptr;
+    uint32_t deadline = vexSystemTimeGet();
+    while (rec.recording) {
+        rec.take_sample();
+
+        deadline += PERIOD_MS;
+        uint32_t now = vexSystemTimeGet();
+        if ((int32_t)(deadline - now) > 0) {
+            vexDelay(deadline - now);
+        }
+    }
+
+    rec.mut.lock();
+    if (!rec.chunk.empty()) {
+        rec.full_chunks.push_back(std::move(rec.chunk));
+        rec.chunk = std::vector<uint8_t>();
+    }
+    rec.mut.unlock();
+    rec.sampling = false;
+    return 0;
+}
+
+/**
+ * Append full chunks to the file as they come, until recording has stopped and there are none left
+ */
+int DriveRecorder::write_thread(void *ptr) {
+    DriveRecorder &rec = *(DriveRecorder *)ptr;
+    vex::brain::sdcard sd;
+    while (true) {
+        // Checked before taking the chunks, so once sampling has stopped its last chunk is among them
+        bool last = !rec.sampling;
+        rec.mut.lock();
+        std::deque<std::vector<uint8_t>> to_write;
+        to_write.swap(rec.full_chunks);
+        rec.mut.unlock();
+
+        for (std::vector<uint8_t> &c : to_write) {
+            if (sd.appendfile(rec.filename.c_str(), c.data(), c.size()) != (int32_t)c.size()) {
+                printf("DriveRecorder: error writing %s\n", rec.filename.c_str());
+            }
+        }
+        if (last) {
+            break;
+        }
+        vexDelay(5 * PERIOD_MS);
+    }
+    rec.writing = false;
+    return 0;
+}
+
+/**
+ * Take a sample and encode it into the current chunk, handing the chunk to the writer if it's full
+ */
+void DriveRecorder::take_sample() {
+    uint64_t start = vexSystemHighResTimeGet();
+    Pose2d pose = drive.get_position();
+
+    mut.lock();
+    drive_sample_t sample = {left, right, pose};
+    uint8_t encoded[DriveRecordingCodec::MAX_SAMPLE_BYTES];
+    size_t len = codec.encode(sample, encoded);
+    chunk.insert(chunk.end(), encoded, encoded + len);
+    if (chunk.size() + DriveRecordingCodec::MAX_SAMPLE_BYTES > CHUNK_SIZE) {
+        full_chunks.push_back(std::move(chunk));
+        chunk = std::vector<uint8_t>();
+        chunk.reserve(CHUNK_SIZE);
+    }
+    samples++;
+    bytes += len;
+
+    uint32_t took = (uint32_t)(vexSystemHighResTimeGet() - start);
+    total_sample_us += took;
+    longest_sample_us = std::max(longest_sample_us, took);
+    mut.unlock();
+}
+
+/**
+ * Create a replay
+ * @param drive the drive to replay on. Must have odometry
+ * @param filename the recording on the SD card
+ * @param config the correction gains
+ */
+ReplayCommand::ReplayCommand(TankDrive &drive, const std::string &filename, const replay_config_t &config)
+    : drive(drive), filename(filename), config(config) {
+    timeout_seconds = 0;
+}
+
+/**
+ * Drive the sample for the current time. The first run opens the file and starts the clock
+ * @return true when the recording is finished, or couldn't be read
+ */
+bool ReplayCommand::run() {
+    if (!started) {
+        started = true;
+        file = vexFileOpen(filename.c_str(), "rb");
+        uint32_t header[2];
+        if (file == nullptr || vexFileRead((char *)header, 1, sizeof(header), file) != (int32_t)sizeof(header) ||
+            header[0] != DriveRecorder::FILE_MAGIC || header[1] == 0) {
+            printf("ReplayCommand: can't read %s\n", filename.c_str());
+            finish();
+            return true;
+        }
+        period_ms = header[1];
+        codec.reset();
+        buffer_pos = buffer_len = 0;
+        sample_index = -1;
+        start_ms = vexSystemTimeGet();
+    }
+    if (file == nullptr) {
+        return true;
+    }
+
+    // Catch up to the sample for now, skipping any that went by between runs
+    int64_t target_index = (vexSystemTimeGet() - start_ms) / period_ms;
+    while (sample_index < target_index) {
+        if (!next_sample()) {
+            finish();
+            return true;
+        }
+        sample_index++;
+    }
+
+    // Where the robot should be, seen from where it is
+    Pose2d error = sample.pose.relative_to(drive.get_position());
+    double along = config.k_along * error.x();
+    double turn = config.k_cross * error.y() + config.k_heading * error.rotation().wrapped_radians_180();
+    double left = std::max(-1.0, std::min(1.0, sample.left + along - turn));
+    double right = std::max(-1.0, std::min(1.0, sample.right + along + turn));
+    drive.drive_tank_raw(left, right);
+    return false;
+}
+
+/**
+ * Stop the drive and close the file
+ */
+void ReplayCommand::on_timeout() { finish(); }
+
+std::string ReplayCommand::toString() { return "Replaying " + filename; }
+
+/**
+ * Read the next sample from the file. When what's left of the buffer doesn't hold a whole sample, moves it to the front
+ * and fills the rest from the file
+ * @return false at the end of the file
+ */
+bool ReplayCommand::next_sample() {
+    size_t read = codec.decode(buffer + buffer_pos, buffer_len - buffer_pos, sample);
+    if (read == 0) {
+        buffer_len -= buffer_pos;
+        memmove(buffer, buffer + buffer_pos, buffer_len);
+        buffer_pos = 0;
+        int32_t got = vexFileRead((char *)buffer + buffer_len, 1, BUFFER_SIZE - buffer_len, file);
+        if (got > 0) {
+            buffer_len += got;
+        }
+        read = codec.decode(buffer, buffer_len, sample);
+        if (read == 0) {
+            return false;
+        }
+    }
+    buffer_pos += read;
+    return true;
+}
+
+/**
+ * Stop the drive and close the file
+ */
+void ReplayCommand::finish() {
+    drive.stop();
+    if (file != nullptr) {
+        vexFileClose(file);
+        file = nullptr;
+    }
+}
@@ -0,0 +1,462 @@
+#include "core/utils/field_map.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <limits>
+
+#include "core/device/vdb/crc32.hpp"
+
+namespace {
+
+// Blob coordinates are hundredths of an inch
+constexpr double BLOB_UNITS_PER_INCH = 100.0;
+
+/**
+ * Squared distance from a point to the segment from (x, y) to (x + dx, y + dy)
+ */
+double dist_sq_to_edge(double px, double py, double x, double y, double dx, double dy) {
+    double len_sq = dx * dx + dy * dy;
+    double t = len_sq > 0 ? ((px - x) * dx + (py - y) * dy) / len_sq : 0;
+    t = std::max(0.0, std::min(1.0, t));
+    double ex = x + t * dx - px;
+    double ey = y + t * dy - py;
+    return ex * ex + ey * ey;
+}
+
+/**
+ * Squared distance between the segments from (ax, ay) to (ax + adx, ay + ady) and from (x, y) to (x + dx, y + dy).
+ * Segments that cross get -1, so even a circle with no radius can't pass through a barrier. Any others are closest at
+ * one of the four ends
+ */
+double segment_dist_sq(double ax, double ay, double adx, double ady, double x, double y, double dx, double dy) {
+    double d1 = adx * (y - ay) - ady * (x - ax);
+    double d2 = adx * (y + dy - ay) - ady * (x + dx - ax);
+    double d3 = dx * (ay - y) - dy * (ax - x);
+    double d4 = dx * (ay + ady - y) - dy * (ax + adx - x);
+    if ((d1 > 0) != (d2 > 0) && (d3 > 0) != (d4 > 0)) {
+        return -1;
+    }
+    return std::min({dist_sq_to_edge(ax, ay, x, y, dx, dy), dist_sq_to_edge(ax + adx, ay + ady, x, y, dx, dy),
+                     dist_sq_to_edge(x, y, ax, ay, adx, ady), dist_sq_to_edge(x + dx, y + dy, ax, ay, adx, ady)});
+}
+
+template <typename T> void put(std::vector<uint8_t> &out, T value) {
+    size_t pos = out.size();
+    out.resize(pos + sizeof(T));
+    memcpy(&out[pos], &value, sizeof(T));
+}
+
+template <typename T> bool take(const uint8_t *data, size_t end, size_t &pos, T &value) {
+    if (pos + sizeof(T) > end) {
+        return false;
+    }
+    memcpy(&value, data + pos, sizeof(T));
+    pos += sizeof(T);
+    return true;
+}
+
+} // namespace
+
+/**
+ * Build a map: turn the elements and walls into edges, sort the edges into ray cast buckets, and find the exact
+ * distance at every corner of the distance field
+ *
+ * @param elements the field elements
+ * @param field_size length of the sides of the square field, which starts at (0, 0) (inch)
+ * @param resolution length of the sides of a distance field cell (inch)
+ * @param bucket_size length of the sides of a ray cast cell (inch)
+ */
+FieldMap::FieldMap(const std::vector<element_t> &elements, double field_size, double resolution, double bucket_size)
+    : field_size(field_size), resolution(resolution), inv_resolution(1.0 / resolution),
+      max_blend_error(resolution * M_SQRT1_2 + 1e-4), nodes((int)ceil(field_size / resolution) + 1),
+      bucket_size(bucket_size), buckets(std::max(1, (int)ceil(field_size / bucket_size))) {
+    for (const map_segment_t &wall : field_perimeter(field_size)) {
+        edges.push_back({wall.start.x(), wall.start.y(), wall.end.x() - wall.start.x(), wall.end.y() - wall.start.y()});
+    }
+    for (const element_t &element : elements) {
+        if (element.size() < 2) {
+            continue;
+        }
+        uint32_t first = edges.size();
+        // A barrier is one edge. A polygon's last corner connects back to its first
+        size_t num_edges = element.size() == 2 ? 1 : element.size();
+        for (size_t i = 0; i < num_edges; i++) {
+            const Translation2d &a = element[i];
+            const Translation2d &b = element[(i + 1) % element.size()];
+            edges.push_back({a.x(), a.y(), b.x() - a.x(), b.y() - a.y()});
+        }
+        if (element.size() > 2) {
+            areas.push_back({first, (uint32_t)edges.size()});
+        }
+    }
+
+    // Bucket every edge by its bounding box, grown a hair so an edge right on a bucket's side is in both buckets
+    const double slop = 1e-6;
+    auto bucket_range = [&](const edge_t &e, int &x0, int &y0, int &x1, int &y1) {
+        auto to_bucket = [&](double v) {
+            return std::max(0, std::min(buckets - 1, (int)floor(v / this->bucket_size)));
+        };
+        x0 = to_bucket(std::min(e.x, e.x + e.dx) - slop);
+        x1 = to_bucket(std::max(e.x, e.x + e.dx) + slop);
+        y0 = to_bucket(std::min(e.y, e.y + e.dy) - slop);
+        y1 = to_bucket(std::max(e.y, e.y + e.dy) + slop);
+    };
+    bucket_start.assign((size_t)buckets * buckets + 1, 0);
+    for (const edge_t &e : edges) {
+        int x0, y0, x1, y1;
+        bucket_range(e, x0, y0, x1, y1);
+        for (int by = y0; by <= y1; by++) {
+            for (int bx = x0; bx <= x1; bx++) {
+                bucket_start[by * buckets + bx + 1]++;
+            }
+        }
+    }
+    for (size_t b = 1; b < bucket_start.size(); b++) {
+        bucket_start[b] += bucket_start[b - 1];
+    }
+    bucket_edges.resize(bucket_start.back());
+    std::vector<uint32_t> fill(bucket_start.begin(), bucket_start.end() - 1);
+    for (size_t i = 0; i < edges.size(); i++) {
+        int x0, y0, x1, y1;
+        bucket_range(edges[i], x0, y0, x1, y1);
+        for (int by = y0; by <= y1; by++) {
+            for (int bx = x0; bx <= x1; bx++) {
+                bucket_edges[fill[by * buckets + bx]++] = (uint16_t)i;
+            }
+        }
+    }
+
+    sdf.resize((size_t)nodes * nodes);
+    for (int ny = 0; ny < nodes; ny++) {
+        for (int nx = 0; nx < nodes; nx++) {
+            sdf[ny * nodes + nx] = (float)exact_distance(Translation2d(nx * resolution, ny * resolution));
+        }
+    }
+}
+
+/**
+ * Get the distance from a point to the nearest wall or element, blended from the four distance field corners around
+ * it. Points past the edge of the distance field get the distance at the edge, minus how far past it they are
+ *
+ * @param point the point to check
+ * @return the distance, negative if the point is inside an element or off the field (inch)
+ */
+double FieldMap::distance(const Translation2d &point) const {
+    double max_f = nodes - 1;
+    double fx = point.x() * inv_resolution;
+    double fy = point.y() * inv_resolution;
+    double cfx = std::max(0.0, std::min(max_f, fx));
+    double cfy = std::max(0.0, std::min(max_f, fy));
+    double outside = 0;
+    if (cfx != fx || cfy != fy) {
+        outside = hypot(fx - cfx, fy - cfy) * resolution;
+    }
+
+    int ix = std::min((int)cfx, nodes - 2);
+    int iy = std::min((int)cfy, nodes - 2);
+    double tx = cfx - ix;
+    double ty = cfy - iy;
+    const float *row = &sdf[iy * nodes + ix];
+    double bottom = row[0] + (row[1] - row[0]) * tx;
+    double top = row[nodes] + (row[nodes + 1] - row[nodes]) * tx;
+    return bottom + (top - bottom) * ty - outside;
+}
+
+/**
+ * Get the distance from a point to the nearest wall or element by checking every edge
+ *
+ * @param point the point to check
+ * @return the distance, negative if the point is inside an element or off the field (inch)
+ */
+double FieldMap::exact_distance(const Translation2d &point) const {
+    double px = point.x();
+    double py = point.y();
+    double best = std::numeric_limits<double>::infinity();
+    for (const edge_t &e : edges) {
+        best = std::min(best, dist_sq_to_edge(px, py, e.x, e.y, e.dx, e.dy));
+    }
+    best = sqrt(best);
+
+    bool off_field = px < 0 || py < 0 || px > field_size || py > field_size;
+    return off_field || inside_element(px, py) ? -best : best;
+}
+
+/**
+ * Get the direction away from the nearest wall or element, from the slope of the distance field. Past the edge of the
+ * distance field, this points back onto it
+ *
+ * @param point the point to check
+ * @return a unit vector, or (0, 0) if every direction is the same
+ */
+Translation2d FieldMap::gradient(const Translation2d &point) const {
+    double max_f = nodes - 1;
+    double fx = point.x() * inv_resolution;
+    double fy = point.y() * inv_resolution;
+    double cfx = std::max(0.0, std::min(max_f, fx));
+    double cfy = std::max(0.0, std::min(max_f, fy));
+
+    double gx = cfx - fx;
+    double gy = cfy - fy;
+    if (gx == 0 && gy == 0) {
+        int ix = std::min((int)cfx, nodes - 2);
+        int iy = std::min((int)cfy, nodes - 2);
+        double tx = cfx - ix;
+        double ty = cfy - iy;
+        const float *row = &sdf[iy * nodes + ix];
+        gx = (row[1] - row[0]) * (1 - ty) + (row[nodes + 1] - row[nodes]) * ty;
+        gy = (row[nodes] - row[0]) * (1 - tx) + (row[nodes + 1] - row[1]) * tx;
+    }
+
+    double norm = hypot(gx, gy);
+    if (norm == 0) {
+        return Translation2d(0, 0);
+    }
+    return Translation2d(gx / norm, gy / norm);
+}
+
+/**
+ * Get whether a circle fits at a point without touching anything. The distance field is 1 inch per inch at worst, so
+ * the blend of the four corners is never more than max_blend_error over the true distance. Past that, the field is
+ * trusted; within it, the exact distance decides
+ *
+ * @param point the center of the circle
+ * @param radius the radius of the circle (inch)
+ */
+bool FieldMap::is_clear(const Translation2d &point, double radius) const {
+    double dist = distance(point);
+    if (dist - max_blend_error >= radius) {
+        return true;
+    }
+    if (dist + max_blend_error < radius) {
+        return false;
+    }
+    return exact_distance(point) >= radius;
+}
+
+/**
+ * Get whether a circle can move in a straight line without touching anything. Nothing is closer than distance() -
+ * max_blend_error to a point, so the circle can move that far, less its radius, along the line before it needs
+ * checking again. Once that's less than a quarter of a cell, the field can't be trusted to see something thin, and the
+ * rest of the line is checked against every edge instead
+ *
+ * @param start where the circle starts
+ * @param end where the circle ends
+ * @param radius the radius of the circle (inch)
+ */
+bool FieldMap::is_clear(const Translation2d &start, const Translation2d &end, double radius) const {
+    Translation2d delta = end - start;
+    double len = delta.norm();
+    double min_step = resolution / 4;
+    double t = 0;
+    while (true) {
+        Translation2d point = len > 0 ? start + delta * (t / len) : start;
+        double room = distance(point) - max_blend_error - radius;
+        if (room < min_step) {
+            if (t == 0 && exact_distance(point) < radius) {
+                return false;
+            }
+            return exact_move_clear(point, end, radius);
+        }
+        if (t >= len) {
+            return true;
+        }
+        t = std::min(len, t + room);
+    }
+}
+
+/**
+ * Get the distance along a ray to the first wall or element it hits. Walks the buckets along the ray in order with
+ * the Amanatides and Woo grid traversal, testing each edge in a bucket with ray_segment_distance(), like
+ * RangeTable::cast. An edge can be in more than one bucket, so a hit might be further along than the bucket it was
+ * found in; the walk stops once the closest hit so far is before the end of the current bucket, since every bucket
+ * before that has been checked
+ *
+ * @param from the origin and direction of the ray
+ * @param max_range returned if nothing is closer than this (inch)
+ * @return the distance to the first hit (inch)
+ */
+double FieldMap::cast(const Pose2d &from, double max_range) const {
+    double ox = from.x();
+    double oy = from.y();
+    if (ox < 0 || oy < 0 || ox > field_size || oy > field_size) {
+        return 0; // already past the walls
+    }
+    double dx = from.rotation().f_cos();
+    double dy = from.rotation().f_sin();
+    const double inf = std::numeric_limits<double>::infinity();
+
+    int bx = std::min(buckets - 1, (int)(ox / bucket_size));
+    int by = std::min(buckets - 1, (int)(oy / bucket_size));
+    int step_x = dx > 0 ? 1 : -1;
+    int step_y = dy > 0 ? 1 : -1;
+    double next_x = dx != 0 ? ((bx + (dx > 0 ? 1 : 0)) * bucket_size - ox) / dx : inf;
+    double next_y = dy != 0 ? ((by + (dy > 0 ? 1 : 0)) * bucket_size - oy) / dy : inf;
+    double delta_x = dx != 0 ? bucket_size / fabs(dx) : inf;
+    double delta_y = dy != 0 ? bucket_size / fabs(dy) : inf;
+
+    double best = max_range;
+    while (true) {
+        int b = by * buckets + bx;
+        for (uint32_t k = bucket_start[b]; k < bucket_start[b + 1]; k++) {
+            const edge_t &e = edges[bucket_edges[k]];
+            double t = ray_segment_distance(ox, oy, dx, dy, e.x, e.y, e.dx, e.dy);
+            if (t >= 0 && t < best) {
+                best = t;
+            }
+        }
+
+        double bucket_exit = std::min(next_x, next_y);
+        if (best <= bucket_exit) {
+            return best;
+        }
+        if (next_x < next_y) {
+            bx += step_x;
+            next_x += delta_x;
+        } else {
+            by += step_y;
+            next_y += delta_y;
+        }
+        if (bx < 0 || by < 0 || bx >= buckets || by >= buckets) {
+            return best;
+        }
+    }
+}
+
+/**
+ * Get every edge of the map, including the walls
+ */
+std::vector<map_segment_t> FieldMap::get_segments() const {
+    std::vector<map_segment_t> out;
+    out.reserve(edges.size());
+    for (const edge_t &e : edges) {
+        out.push_back({Translation2d(e.x, e.y), Translation2d(e.x + e.dx, e.y + e.dy)});
+    }
+    return out;
+}
+
+/**
+ * @param field_size length of the sides of the square field (inch)
+ * @return the four walls around the field
+ */
+std::vector<map_segment_t> FieldMap::field_perimeter(double field_size) {
+    Translation2d bl(0, 0);
+    Translation2d br(field_size, 0);
+    Translation2d tr(field_size, field_size);
+    Translation2d tl(0, field_size);
+    return {{bl, br}, {br, tr}, {tr, tl}, {tl, bl}};
+}
+
+/**
+ * Pack a map's elements into a blob
+ * @param elements the field elements. Coordinates are rounded to hundredths of an inch
+ * @param field_size length of the sides of the field (inch)
+ * @return the blob
+ */
+std::vector<uint8_t> FieldMap::encode(const std::vector<element_t> &elements, double field_size) {
+    auto to_units = [](double v) -> int16_t {
+        double units = round(v * BLOB_UNITS_PER_INCH);
+        return (int16_t)std::max(-32768.0, std::min(32767.0, units));
+    };
+
+    std::vector<uint8_t> out;
+    put<uint32_t>(out, BLOB_MAGIC);
+    put<uint16_t>(out, (uint16_t)std::min(65535.0, round(field_size * BLOB_UNITS_PER_INCH)));
+    put<uint16_t>(out, (uint16_t)elements.size());
+    for (const element_t &element : elements) {
+        put<uint16_t>(out, (uint16_t)element.size());
+        for (const Translation2d &vertex : element) {
+            put<int16_t>(out, to_units(vertex.x()));
+            put<int16_t>(out, to_units(vertex.y()));
+        }
+    }
+    put<uint32_t>(out, CRC32::calculate(out.data(), out.size()));
+    return out;
+}
+
+/**
+ * Unpack a map's elements from a blob
+ * @param data the blob
+ * @param len the length of the blob in bytes
+ * @param[out] elements the field elements
+ * @param[out] field_size length of the sides of the field (inch)
+ * @return true if the blob was valid. elements and field_size are not changed if it wasn't
+ */
+bool FieldMap::decode(const uint8_t *data, size_t len, std::vector<element_t> &elements, double &field_size) {
+    uint32_t magic, crc;
+    if (len < 2 * sizeof(uint32_t) + 2 * sizeof(uint16_t)) {
+        printf("FieldMap: blob too short\n");
+        return false;
+    }
+    size_t end = len - sizeof(crc);
+    memcpy(&magic, data, sizeof(magic));
+    memcpy(&crc, data + end, sizeof(crc));
+    if (magic != BLOB_MAGIC || CRC32::calculate(data, end) != crc) {
+        printf("FieldMap: blob is corrupt\n");
+        return false;
+    }
+
+    size_t pos = sizeof(magic);
+    uint16_t size_units, count;
+    take(data, end, pos, size_units);
+    take(data, end, pos, count);
+    std::vector<element_t> decoded(count);
+    for (element_t &element : decoded) {
+        uint16_t vertices;
+        if (!take(data, end, pos, vertices)) {
+            printf("FieldMap: blob is cut short\n");
+            return false;
+        }
+        element.reserve(vertices);
+        for (uint16_t i = 0; i < vertices; i++) {
+            int16_t x, y;
+            if (!take(data, end, pos, x) || !take(data, end, pos, y)) {
+                printf("FieldMap: blob is cut short\n");
+                return false;
+            }
+            element.push_back(Translation2d(x / BLOB_UNITS_PER_INCH, y / BLOB_UNITS_PER_INCH));
+        }
+    }
+
+    elements = std::move(decoded);
+    field_size = size_units / BLOB_UNITS_PER_INCH;
+    return true;
+}
+
+/**
+ * Whether a point is inside any element, by counting how many of its edges a ray from the point crosses
+ */
+bool FieldMap::inside_element(double x, double y) const {
+    for (const std::pair<uint32_t, uint32_t> &area : areas) {
+        bool inside = false;
+        for (uint32_t i = area.first; i < area.second; i++) {
+            const edge_t &e = edges[i];
+            if ((e.y > y) != (e.y + e.dy > y)) {
+                double cross_x = e.x + (y - e.y) / e.dy * e.dx;
+                if (x < cross_x) {
+                    inside = !inside;
+                }
+            }
+        }
+        if (inside) {
+            return true;
+        }
+    }
+    return false;
+}
+
+/**
+ * Whether a circle moving from a to b stays clear of every edge. a has to be clear already: then staying radius away
+ * from every edge means never crossing one, so b is on the same side of all of them
+ */
+bool FieldMap::exact_move_clear(const Translation2d &a, const Translation2d &b, double radius) const {
+    double radius_sq = radius * radius;
+    double dx = b.x() - a.x();
+    double dy = b.y() - a.y();
+    for (const edge_t &e : edges) {
+        if (segment_dist_sq(a.x(), a.y(), dx, dy, e.x, e.y, e.dx, e.dy) < radius_sq) {
+            return false;
+        }
+    }
+    return true;
+}
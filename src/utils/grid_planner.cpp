@@ -0,0 +1,412 @@
+#include "core/utils/grid_planner.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace {
+
+/**
+ * Squared distance from a point to the segment between a and b
+ */
+double dist_sq_to_segment(double px, double py, double ax, double ay, double bx, double by) {
+    double dx = bx - ax;
+    double dy = by - ay;
+    double len_sq = dx * dx + dy * dy;
+    double t = len_sq > 0 ? std::min(std::max(((px - ax) * dx + (py - ay) * dy) / len_sq, 0.0), 1.0) : 0;
+    double ex = px - (ax + t * dx);
+    double ey = py - (ay + t * dy);
+    return ex * ex + ey * ey;
+}
+
+// Heuristic scale for breaking ties. Paths can come out this much longer than the shortest, at most
+constexpr double TIE_BREAK = 1.001;
+
+} // namespace
+
+/**
+ * Create a planner with an empty field
+ * @param robot_radius how far obstacles are grown (inch)
+ * @param resolution length of the sides of a cell (inch)
+ * @param field_size length of the sides of the square field (inch)
+ */
+GridPlanner::GridPlanner(double robot_radius, double resolution, double field_size)
+    : inflation(robot_radius + resolution * M_SQRT1_2), resolution(resolution), field_size(field_size) {
+    cells = (int)ceil(field_size / resolution);
+    words_per_row = (cells + 63) / 64;
+    grid.assign((size_t)words_per_row * cells, 0);
+
+    size_t num_cells = (size_t)cells * cells;
+    g.resize(num_cells);
+    parent.resize(num_cells);
+    seen_stamp.assign(num_cells, 0);
+    closed_stamp.assign(num_cells, 0);
+    open.reserve(num_cells);
+
+    block_walls();
+}
+
+/**
+ * Remove every obstacle, leaving the walls
+ */
+void GridPlanner::clear() {
+    std::fill(grid.begin(), grid.end(), 0);
+    block_walls();
+}
+
+/**
+ * Add a round obstacle
+ * @param center the center of the obstacle
+ * @param radius the radius of the obstacle (inch)
+ */
+void GridPlanner::add_circle(const Translation2d &center, double radius) {
+    block_near_segment(center, center, radius + inflation);
+}
+
+/**
+ * Add a rectangular obstacle lined up with the field
+ * @param corner one corner of the rectangle
+ * @param opposite the opposite corner
+ */
+void GridPlanner::add_rect(const Translation2d &corner, const Translation2d &opposite) {
+    block_near_rect(
+      std::min(corner.x(), opposite.x()), std::min(corner.y(), opposite.y()), std::max(corner.x(), opposite.x()),
+      std::max(corner.y(), opposite.y()), inflation
+    );
+}
+
+/**
+ * Add a thin obstacle
+ * @param start one end of the obstacle
+ * @param end the other end
+ */
+void GridPlanner::add_segment(const Translation2d &start, const Translation2d &end) {
+    block_near_segment(start, end, inflation);
+}
+
+void GridPlanner::block_near_segment(const Translation2d &start, const Translation2d &end, double dist) {
+    int x0 = std::max(cell_of(std::min(start.x(), end.x()) - dist), 0);
+    int x1 = std::min(cell_of(std::max(start.x(), end.x()) + dist), cells - 1);
+    int y0 = std::max(cell_of(std::min(start.y(), end.y()) - dist), 0);
+    int y1 = std::min(cell_of(std::max(start.y(), end.y()) + dist), cells - 1);
+    double dist_sq = dist * dist;
+    for (int cy = y0; cy <= y1; cy++) {
+        double py = (cy + 0.5) * resolution;
+        for (int cx = x0; cx <= x1; cx++) {
+            double px = (cx + 0.5) * resolution;
+            if (dist_sq_to_segment(px, py, start.x(), start.y(), end.x(), end.y()) <= dist_sq) {
+                set_blocked(cx, cy);
+            }
+        }
+    }
+}
+
+void GridPlanner::block_near_rect(double min_x, double min_y, double max_x, double max_y, double dist) {
+    int x0 = std::max(cell_of(min_x - dist), 0);
+    int x1 = std::min(cell_of(max_x + dist), cells - 1);
+    int y0 = std::max(cell_of(min_y - dist), 0);
+    int y1 = std::min(cell_of(max_y + dist), cells - 1);
+    double dist_sq = dist * dist;
+    for (int cy = y0; cy <= y1; cy++) {
+        double py = (cy + 0.5) * resolution;
+        double ey = std::max(std::max(min_y - py, py - max_y), 0.0);
+        for (int cx = x0; cx <= x1; cx++) {
+            double px = (cx + 0.5) * resolution;
+            double ex = std::max(std::max(min_x - px, px - max_x), 0.0);
+            if (ex * ex + ey * ey <= dist_sq) {
+                set_blocked(cx, cy);
+            }
+        }
+    }
+}
+
+void GridPlanner::block_walls() {
+    for (int cy = 0; cy < cells; cy++) {
+        double py = (cy + 0.5) * resolution;
+        for (int cx = 0; cx < cells; cx++) {
+            double px = (cx + 0.5) * resolution;
+            if (std::min(std::min(px, py), std::min(field_size - px, field_size - py)) < inflation) {
+                set_blocked(cx, cy);
+            }
+        }
+    }
+}
+
+bool GridPlanner::blocked(int cx, int cy) const {
+    if (cx < 0 || cy < 0 || cx >= cells || cy >= cells) {
+        return true;
+    }
+    return (grid[(size_t)cy * words_per_row + cx / 64] >> (cx % 64)) & 1;
+}
+
+void GridPlanner::set_blocked(int cx, int cy) {
+    grid[(size_t)cy * words_per_row + cx / 64] |= (uint64_t)1 << (cx % 64);
+}
+
+int GridPlanner::cell_of(double v) const { return (int)floor(v / resolution); }
+
+Translation2d GridPlanner::center_of(uint32_t index) const {
+    return Translation2d((index % cells + 0.5) * resolution, (index / cells + 0.5) * resolution);
+}
+
+/**
+ * Get whether the robot's center can be at a point without touching anything
+ * @param point the point to check
+ */
+bool GridPlanner::is_free(const Translation2d &point) const { return !blocked(cell_of(point.x()), cell_of(point.y())); }
+
+/**
+ * Get whether the robot can drive straight between two points without touching anything
+ *
+ * @param start where the robot starts
+ * @param end where the robot ends
+ */
+bool GridPlanner::line_of_sight(const Translation2d &start, const Translation2d &end) const {
+    return line_of_sight(start, end, 0);
+}
+
+/**
+ * Walk every cell the line between two points passes through (Amanatides and Woo), looking for a blocked one. When
+ * the start is inside a grown obstacle the line has to get out of it first, so blocked cells are let through until the
+ * first free one, as long as the line enters them within escape of the start
+ *
+ * @param start where the robot starts
+ * @param end where the robot ends
+ * @param escape how far from the start the line may still be getting out of a grown obstacle (inch)
+ */
+bool GridPlanner::line_of_sight(const Translation2d &start, const Translation2d &end, double escape) const {
+    double x = start.x() / resolution;
+    double y = start.y() / resolution;
+    double dx = end.x() / resolution - x;
+    double dy = end.y() / resolution - y;
+    int cx = (int)floor(x);
+    int cy = (int)floor(y);
+    int end_cx = (int)floor(x + dx);
+    int end_cy = (int)floor(y + dy);
+
+    int step_x = dx > 0 ? 1 : -1;
+    int step_y = dy > 0 ? 1 : -1;
+    // How far along the line (0 to 1) each step across a cell takes, and where the next x and y cell borders are
+    double delta_x = dx != 0 ? fabs(1 / dx) : INFINITY;
+    double delta_y = dy != 0 ? fabs(1 / dy) : INFINITY;
+    double next_x = dx != 0 ? ((dx > 0 ? cx + 1 - x : x - cx) * delta_x) : INFINITY;
+    double next_y = dy != 0 ? ((dy > 0 ? cy + 1 - y : y - cy) * delta_y) : INFINITY;
+
+    // Fraction of the line walked when it entered the current cell, and the last fraction it may still be escaping at
+    double entered = 0;
+    double escape_until = std::hypot(dx, dy) > 0 ? escape / (std::hypot(dx, dy) * resolution) : 0;
+    bool escaping = escape > 0;
+
+    int steps = abs(end_cx - cx) + abs(end_cy - cy);
+    for (int i = 0; i <= steps; i++) {
+        if (blocked(cx, cy)) {
+            if (!escaping || entered > escape_until) {
+                return false;
+            }
+        } else {
+            escaping = false;
+        }
+        entered = std::min(next_x, next_y);
+        if (next_x < next_y) {
+            next_x += delta_x;
+            cx += step_x;
+        } else {
+            next_y += delta_y;
+            cy += step_y;
+        }
+    }
+    return true;
+}
+
+/**
+ * Find the free cell with its center closest to a point, searching outward one ring of cells at a time
+ * @param point the point, usually inside a grown obstacle
+ * @param[out] index the closest free cell
+ * @param[out] dist the distance from the point to that cell's center (inch)
+ * @return false if every cell is blocked
+ */
+bool GridPlanner::nearest_free(const Translation2d &point, uint32_t &index, double &dist) const {
+    int px = std::min(std::max(cell_of(point.x()), 0), cells - 1);
+    int py = std::min(std::max(cell_of(point.y()), 0), cells - 1);
+    double best_sq = INFINITY;
+    for (int ring = 0; ring < cells; ring++) {
+        // Every cell in this ring is at least this far from the point, so nothing further out can be closer
+        double ring_min = std::max(ring - 0.5, 0.0) * resolution;
+        if (ring_min * ring_min > best_sq) {
+            break;
+        }
+        for (int cy = py - ring; cy <= py + ring; cy++) {
+            // Only the top and bottom rows of the ring are whole, the rows between just have their two ends
+            int step = (cy == py - ring || cy == py + ring) ? 1 : std::max(2 * ring, 1);
+            for (int cx = px - ring; cx <= px + ring; cx += step) {
+                if (blocked(cx, cy)) {
+                    continue;
+                }
+                double ex = (cx + 0.5) * resolution - point.x();
+                double ey = (cy + 0.5) * resolution - point.y();
+                if (ex * ex + ey * ey < best_sq) {
+                    best_sq = ex * ex + ey * ey;
+                    index = cy * cells + cx;
+                }
+            }
+        }
+    }
+    dist = sqrt(best_sq);
+    return best_sq != INFINITY;
+}
+
+/**
+ * Find a path between two points. If the start is inside a grown obstacle, the search starts from the closest free
+ * cell instead, and the path gets out to it first
+ *
+ * @param start where the robot is
+ * @param goal where the robot should go
+ * @return the corners of the path, starting at start and ending at goal. Empty if there's no way through
+ */
+std::vector<Translation2d> GridPlanner::plan_points(const Translation2d &start, const Translation2d &goal) {
+    expanded = 0;
+    int sx = std::min(std::max(cell_of(start.x()), 0), cells - 1);
+    int sy = std::min(std::max(cell_of(start.y()), 0), cells - 1);
+    int gx = cell_of(goal.x());
+    int gy = cell_of(goal.y());
+    if (blocked(gx, gy)) {
+        return {};
+    }
+
+    // A start inside a grown obstacle searches from the closest free cell. Lines from the start may cross blocked
+    // cells on the way out, as far as that cell (plus half a cell diagonal, for lines leaving at another angle)
+    uint32_t start_index = sy * cells + sx;
+    double escape = 0;
+    bool escaped = blocked(sx, sy);
+    if (escaped) {
+        if (!nearest_free(start, start_index, escape)) {
+            return {};
+        }
+        escape += resolution * M_SQRT1_2;
+        sx = start_index % cells;
+        sy = start_index / cells;
+    }
+    if (line_of_sight(start, goal, escape)) {
+        return {start, goal};
+    }
+
+    // A fresh stamp marks every cell unseen without clearing anything
+    stamp++;
+    if (stamp == 0) {
+        std::fill(seen_stamp.begin(), seen_stamp.end(), 0);
+        std::fill(closed_stamp.begin(), closed_stamp.end(), 0);
+        stamp = 1;
+    }
+
+    // Octile distance: the length of the best 8 connected path with nothing in the way. Scaled up a hair so that of
+    // two cells with the same f, the one further along is expanded first, instead of every cell on an open field
+    auto heuristic = [gx, gy](int cx, int cy) -> float {
+        int ax = abs(cx - gx);
+        int ay = abs(cy - gy);
+        return (float)((std::max(ax, ay) + (M_SQRT2 - 1) * std::min(ax, ay)) * TIE_BREAK);
+    };
+    // Heap order for the open list: smallest f on top
+    auto heap_order = [](const open_entry_t &a, const open_entry_t &b) { return a.f > b.f; };
+
+    static const int DX[8] = {1, -1, 0, 0, 1, 1, -1, -1};
+    static const int DY[8] = {0, 0, 1, -1, 1, -1, 1, -1};
+    static const float COST[8] = {1, 1, 1, 1, (float)M_SQRT2, (float)M_SQRT2, (float)M_SQRT2, (float)M_SQRT2};
+
+    uint32_t goal_index = gy * cells + gx;
+    open.clear();
+    g[start_index] = 0;
+    parent[start_index] = start_index;
+    seen_stamp[start_index] = stamp;
+    open.push_back({heuristic(sx, sy), start_index});
+
+    bool found = false;
+    while (!open.empty()) {
+        std::pop_heap(open.begin(), open.end(), heap_order);
+        uint32_t index = open.back().index;
+        open.pop_back();
+        // A cell can be in the open list more than once, if a shorter way to it was found after it was added
+        if (closed_stamp[index] == stamp) {
+            continue;
+        }
+        closed_stamp[index] = stamp;
+        expanded++;
+        if (index == goal_index) {
+            found = true;
+            break;
+        }
+
+        int cx = index % cells;
+        int cy = index / cells;
+        for (int dir = 0; dir < 8; dir++) {
+            int nx = cx + DX[dir];
+            int ny = cy + DY[dir];
+            if (blocked(nx, ny)) {
+                continue;
+            }
+            // No cutting corners: a diagonal move needs both cells beside it free
+            if (dir >= 4 && (blocked(cx + DX[dir], cy) || blocked(cx, cy + DY[dir]))) {
+                continue;
+            }
+            uint32_t next = ny * cells + nx;
+            if (closed_stamp[next] == stamp) {
+                continue;
+            }
+            float next_g = g[index] + COST[dir];
+            if (seen_stamp[next] != stamp || next_g < g[next]) {
+                seen_stamp[next] = stamp;
+                g[next] = next_g;
+                parent[next] = index;
+                open.push_back({next_g + heuristic(nx, ny), next});
+                std::push_heap(open.begin(), open.end(), heap_order);
+            }
+        }
+    }
+    if (!found) {
+        return {};
+    }
+
+    // Walk back from the goal, using the real start and goal in place of their cells' centers
+    std::vector<Translation2d> cell_path;
+    cell_path.push_back(goal);
+    for (uint32_t index = parent[goal_index]; index != start_index; index = parent[index]) {
+        cell_path.push_back(center_of(index));
+    }
+    if (escaped) {
+        cell_path.push_back(center_of(start_index));
+    }
+    cell_path.push_back(start);
+    std::reverse(cell_path.begin(), cell_path.end());
+
+    // Shortcut: keep going straight from the last corner until the next point can't be seen from it, then put a
+    // corner at the last point that could
+    std::vector<Translation2d> out;
+    out.push_back(start);
+    size_t corner = 0;
+    for (size_t i = 2; i < cell_path.size(); i++) {
+        if (!line_of_sight(cell_path[corner], cell_path[i], corner == 0 ? escape : 0)) {
+            corner = i - 1;
+            out.push_back(cell_path[corner]);
+        }
+    }
+    out.push_back(goal);
+    return out;
+}
+
+/**
+ * Find a path between two points, for pure pursuit
+ * @param start where the robot is
+ * @param goal where the robot should go
+ * @param radius the lookahead radius for pure pursuit
+ * @return the path, or an empty (invalid) Path if there's no way through
+ */
+PurePursuit::Path GridPlanner::plan(const Translation2d &start, const Translation2d &goal, double radius) {
+    std::vector<Translation2d> points = plan_points(start, goal);
+    if (points.empty()) {
+        return PurePursuit::Path();
+    }
+    return PurePursuit::Path(points, radius);
+}
+
+/**
+ * Get the number of cells the last plan() looked at
+ */
+size_t GridPlanner::get_expanded() const { return expanded; }
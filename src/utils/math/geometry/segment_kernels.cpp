@@ -0,0 +1,234 @@
+#include "core/utils/math/geometry/segment_kernels.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+// The polyline queries run the batch kernels over chunks this long, so their scratch fits on the stack
+static constexpr size_t CHUNK_SIZE = 32;
+
+/**
+ * Build the segments between consecutive points
+ * @param points the polyline
+ */
+SegmentBuffer::SegmentBuffer(const std::vector<Translation2d> &points) {
+    size_t n = points.size() < 2 ? 0 : points.size() - 1;
+    start_x.resize(n);
+    start_y.resize(n);
+    dx.resize(n);
+    dy.resize(n);
+    length.resize(n);
+    inv_len_sq.resize(n);
+    arc_start.resize(n);
+
+    double arc = 0;
+    for (size_t i = 0; i < n; i++) {
+        start_x[i] = points[i].x();
+        start_y[i] = points[i].y();
+        dx[i] = points[i + 1].x() - points[i].x();
+        dy[i] = points[i + 1].y() - points[i].y();
+        double len_sq = dx[i] * dx[i] + dy[i] * dy[i];
+        length[i] = sqrt(len_sq);
+        inv_len_sq[i] = len_sq > 0 ? 1.0 / len_sq : 0;
+        arc_start[i] = arc;
+        arc += length[i];
+    }
+}
+
+/**
+ * Intersect a circle with each segment, solving |start + t * d - center| = r for t in [0, 1].
+ *
+ * @param segs the segments
+ * @param first the first segment to check
+ * @param count the number of segments to check
+ * @param center the center of the circle
+ * @param r the radius of the circle
+ * @param[out] t_near the smaller solution on each segment, or NO_INTERSECTION (count long)
+ * @param[out] t_far the larger solution on each segment, or NO_INTERSECTION (count long)
+ */
+void SegmentKernels::circle_intersections(
+  const SegmentBuffer &segs, size_t first, size_t count, const Translation2d &center, double r, double *t_near,
+  double *t_far
+) {
+    const double *sx = segs.start_x.data() + first;
+    const double *sy = segs.start_y.data() + first;
+    const double *dx = segs.dx.data() + first;
+    const double *dy = segs.dy.data() + first;
+    const double *inv_len_sq = segs.inv_len_sq.data() + first;
+    const double cx = center.x();
+    const double cy = center.y();
+    const double r_sq = r * r;
+
+    for (size_t i = 0; i < count; i++) {
+        // a t^2 + b t + c = 0, divided through by a (the squared length) ahead of time
+        double fx = sx[i] - cx;
+        double fy = sy[i] - cy;
+        double half_b = (fx * dx[i] + fy * dy[i]) * inv_len_sq[i];
+        double c = (fx * fx + fy * fy - r_sq) * inv_len_sq[i];
+        double discriminant = half_b * half_b - c;
+        bool crosses = discriminant >= 0 && inv_len_sq[i] > 0;
+        double root = sqrt(std::max(discriminant, 0.0));
+        double near = -half_b - root;
+        double far = -half_b + root;
+        t_near[i] = (crosses && near >= 0 && near <= 1) ? near : NO_INTERSECTION;
+        t_far[i] = (crosses && far >= 0 && far <= 1) ? far : NO_INTERSECTION;
+    }
+}
+
+/**
+ * Find the point on each segment closest to a point
+ *
+ * @param segs the segments
+ * @param first the first segment to check
+ * @param count the number of segments to check
+ * @param point the point to measure from
+ * @param[out] t the parameter of the closest point on each segment (count long)
+ * @param[out] dist_sq the squared distance from the point to it (count long)
+ */
+void SegmentKernels::closest_points(
+  const SegmentBuffer &segs, size_t first, size_t count, const Translation2d &point, double *t, double *dist_sq
+) {
+    const double *sx = segs.start_x.data() + first;
+    const double *sy = segs.start_y.data() + first;
+    const double *dx = segs.dx.data() + first;
+    const double *dy = segs.dy.data() + first;
+    const double *inv_len_sq = segs.inv_len_sq.data() + first;
+    const double px = point.x();
+    const double py = point.y();
+
+    for (size_t i = 0; i < count; i++) {
+        double rx = px - sx[i];
+        double ry = py - sy[i];
+        double ti = std::min(std::max((rx * dx[i] + ry * dy[i]) * inv_len_sq[i], 0.0), 1.0);
+        double ex = rx - ti * dx[i];
+        double ey = ry - ti * dy[i];
+        t[i] = ti;
+        dist_sq[i] = ex * ex + ey * ey;
+    }
+}
+
+/**
+ * Find the closest approach between one segment and each segment in a buffer
+ *
+ * @param segs the segments
+ * @param first the first segment to check
+ * @param count the number of segments to check
+ * @param a the start of the other segment
+ * @param b the end of the other segment
+ * @param[out] dist_sq the squared distance between the other segment and each segment, 0 if they cross (count long)
+ */
+void SegmentKernels::closest_approaches(
+  const SegmentBuffer &segs, size_t first, size_t count, const Translation2d &a, const Translation2d &b,
+  double *dist_sq
+) {
+    const double *sx = segs.start_x.data() + first;
+    const double *sy = segs.start_y.data() + first;
+    const double *dx = segs.dx.data() + first;
+    const double *dy = segs.dy.data() + first;
+    const double *inv_len_sq = segs.inv_len_sq.data() + first;
+    const double ax = a.x();
+    const double ay = a.y();
+    const double abx = b.x() - a.x();
+    const double aby = b.y() - a.y();
+    const double ab_len_sq = abx * abx + aby * aby;
+    const double ab_inv_len_sq = ab_len_sq > 0 ? 1.0 / ab_len_sq : 0;
+
+    for (size_t i = 0; i < count; i++) {
+        // Segments that don't cross are closest at an end of one of them. Distances from a and b to this segment:
+        double rax = ax - sx[i];
+        double ray = ay - sy[i];
+        double rbx = rax + abx;
+        double rby = ray + aby;
+        double ta = std::min(std::max((rax * dx[i] + ray * dy[i]) * inv_len_sq[i], 0.0), 1.0);
+        double tb = std::min(std::max((rbx * dx[i] + rby * dy[i]) * inv_len_sq[i], 0.0), 1.0);
+        double eax = rax - ta * dx[i], eay = ray - ta * dy[i];
+        double ebx = rbx - tb * dx[i], eby = rby - tb * dy[i];
+
+        // and from this segment's ends to the other one, which sees them at -ra and -ra + d
+        double qx = -rax, qy = -ray;
+        double wx = qx + dx[i], wy = qy + dy[i];
+        double ts = std::min(std::max((qx * abx + qy * aby) * ab_inv_len_sq, 0.0), 1.0);
+        double te = std::min(std::max((wx * abx + wy * aby) * ab_inv_len_sq, 0.0), 1.0);
+        double esx = qx - ts * abx, esy = qy - ts * aby;
+        double eex = wx - te * abx, eey = wy - te * aby;
+
+        double closest = std::min(
+          std::min(eax * eax + eay * eay, ebx * ebx + eby * eby), std::min(esx * esx + esy * esy, eex * eex + eey * eey)
+        );
+
+        // Segments cross when each one's ends are on opposite sides of the other
+        double side_a = dx[i] * ray - dy[i] * rax;
+        double side_b = dx[i] * rby - dy[i] * rbx;
+        double side_s = abx * qy - aby * qx;
+        double side_e = abx * wy - aby * wx;
+        bool crosses = side_a * side_b < 0 && side_s * side_e < 0;
+        dist_sq[i] = crosses ? 0.0 : closest;
+    }
+}
+
+/**
+ * Find the closest point on a range of a polyline to a point
+ *
+ * @param segs the segments
+ * @param first the first segment to check
+ * @param count the number of segments to check
+ * @param point the point to measure from
+ * @param[out] t the parameter of the closest point, on the returned segment
+ * @param[out] dist_sq the squared distance from the point to it
+ * @return the index of the segment the closest point is on, or first if count is 0
+ */
+size_t SegmentKernels::nearest_on_polyline(
+  const SegmentBuffer &segs, size_t first, size_t count, const Translation2d &point, double &t, double &dist_sq
+) {
+    double chunk_t[CHUNK_SIZE];
+    double chunk_dist_sq[CHUNK_SIZE];
+    size_t best = first;
+    t = 0;
+    dist_sq = std::numeric_limits<double>::infinity();
+
+    for (size_t start = first; start < first + count; start += CHUNK_SIZE) {
+        size_t n = std::min(CHUNK_SIZE, first + count - start);
+        closest_points(segs, start, n, point, chunk_t, chunk_dist_sq);
+        for (size_t i = 0; i < n; i++) {
+            if (chunk_dist_sq[i] < dist_sq) {
+                dist_sq = chunk_dist_sq[i];
+                t = chunk_t[i];
+                best = start + i;
+            }
+        }
+    }
+    return best;
+}
+
+/**
+ * Find the circle intersection furthest along a range of a polyline
+ *
+ * @param segs the segments
+ * @param first the first segment to check
+ * @param count the number of segments to check
+ * @param center the center of the circle
+ * @param r the radius of the circle
+ * @param[out] t the parameter of the intersection, on the returned segment
+ * @return the index of the segment the intersection is on, or first + count if the circle doesn't cross the range
+ */
+size_t SegmentKernels::furthest_circle_intersection(
+  const SegmentBuffer &segs, size_t first, size_t count, const Translation2d &center, double r, double &t
+) {
+    double chunk_near[CHUNK_SIZE];
+    double chunk_far[CHUNK_SIZE];
+    size_t found = first + count;
+    t = NO_INTERSECTION;
+
+    for (size_t start = first; start < first + count; start += CHUNK_SIZE) {
+        size_t n = std::min(CHUNK_SIZE, first + count - start);
+        circle_intersections(segs, start, n, center, r, chunk_near, chunk_far);
+        for (size_t i = 0; i < n; i++) {
+            double ti = std::max(chunk_near[i], chunk_far[i]);
+            if (ti != NO_INTERSECTION) {
+                found = start + i;
+                t = ti;
+            }
+        }
+    }
+    return found;
+}
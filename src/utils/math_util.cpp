@@ -123,16 +123,8 @@ std::pair<double, double> calculate_linear_regression(std::vector<std::pair<doub
 double estimate_path_length(const std::vector<Translation2d> &points) {
     double dist = 0;
 
-    for (Translation2d p : points) {
-        static Translation2d last_p = p;
-
-        // Ignore the first point
-        if (p == last_p) {
-            continue;
-        }
-
-        dist += p.distance(last_p);
-        last_p = p;
+    for (size_t i = 1; i < points.size(); i++) {
+        dist += points[i].distance(points[i - 1]);
     }
 
     return dist;
@@ -0,0 +1,247 @@
+#include "core/utils/precompute_cache.h"
+
+#include "core/device/vdb/crc32.hpp"
+
+// 64 bit FNV-1a
+static constexpr uint64_t FNV_OFFSET_BASIS = 0xcbf29ce484222325ULL;
+static constexpr uint64_t FNV_PRIME = 0x100000001b3ULL;
+
+/**
+ * Start a key
+ * @param name what's being computed
+ */
+CacheKey::CacheKey(const std::string &name) : hash(FNV_OFFSET_BASIS) { add(name); }
+
+/**
+ * Add a string to the key
+ * @param str the string
+ * @return this key, to chain adds
+ */
+CacheKey &CacheKey::add(const std::string &str) {
+    add((uint32_t)str.size());
+    return add_bytes(str.data(), str.size());
+}
+
+/**
+ * Get the hash
+ */
+uint64_t CacheKey::value() const { return hash; }
+
+CacheKey &CacheKey::add_bytes(const void *data, size_t len) {
+    const uint8_t *bytes = (const uint8_t *)data;
+    for (size_t i = 0; i < len; i++) {
+        hash = (hash ^ bytes[i]) * FNV_PRIME;
+    }
+    return *this;
+}
+
+/**
+ * Create a cache
+ * @param filename the file on the SD card to keep the artifacts in
+ */
+PrecomputeCache::PrecomputeCache(const std::string &filename) : filename(filename) {}
+
+/**
+ * Read the file with one read
+ * @return true if the file was there and valid
+ */
+bool PrecomputeCache::load() {
+    vex::brain::sdcard sd;
+    if (!sd.isInserted() || !sd.exists(filename.c_str())) {
+        printf("PrecomputeCache: no %s, computing everything\n", filename.c_str());
+        return false;
+    }
+
+    int32_t size = sd.size(filename.c_str());
+    if (size < (int32_t)(2 * sizeof(uint32_t) + sizeof(uint32_t))) {
+        return false;
+    }
+    std::vector<uint8_t> file(size);
+    if (sd.loadfile(filename.c_str(), file.data(), size) != size) {
+        printf("PrecomputeCache: error reading %s\n", filename.c_str());
+        return false;
+    }
+
+    uint32_t crc;
+    memcpy(&crc, &file[size - sizeof(crc)], sizeof(crc));
+    uint32_t magic;
+    memcpy(&magic, &file[0], sizeof(magic));
+    if (magic != FILE_MAGIC || CRC32::calculate(file.data(), size - sizeof(crc)) != crc) {
+        printf("PrecomputeCache: %s is corrupt, computing everything\n", filename.c_str());
+        return false;
+    }
+
+    uint32_t count;
+    memcpy(&count, &file[sizeof(magic)], sizeof(count));
+    size_t pos = sizeof(magic) + sizeof(count);
+    size_t end = size - sizeof(crc);
+    std::map<uint64_t, std::vector<uint8_t>> entries;
+    for (uint32_t i = 0; i < count; i++) {
+        uint64_t key;
+        uint32_t len;
+        if (pos + sizeof(key) + sizeof(len) > end) {
+            return false;
+        }
+        memcpy(&key, &file[pos], sizeof(key));
+        memcpy(&len, &file[pos + sizeof(key)], sizeof(len));
+        pos += sizeof(key) + sizeof(len);
+        if (pos + len > end) {
+            return false;
+        }
+        entries[key] = std::vector<uint8_t>(file.begin() + pos, file.begin() + pos + len);
+        pos += len;
+    }
+
+    mut.lock();
+    loaded = std::move(entries);
+    mut.unlock();
+    return true;
+}
+
+void PrecomputeCache::add_bytes(uint64_t key, std::function<std::vector<uint8_t>()> compute) {
+    mut.lock();
+    auto found = loaded.find(key);
+    if (found != loaded.end()) {
+        ready[key] = found->second;
+        hits++;
+    } else if (ready.count(key) == 0) {
+        to_compute.push_back({key, std::move(compute)});
+        misses++;
+    }
+    mut.unlock();
+}
+
+/**
+ * Compute every artifact that wasn't in the file on a background task, then save the file
+ */
+void PrecomputeCache::start() {
+    mut.lock();
+    bool any = !to_compute.empty();
+    mut.unlock();
+    if (!any || computing.exchange(true)) {
+        return;
+    }
+    compute_task = vex::task(PrecomputeCache::compute_thread, (void *)this, vex::thread::threadPriorityLow);
+}
+
+int PrecomputeCache::compute_thread(void *ptr) {
+    PrecomputeCache &self = *(PrecomputeCache *)ptr;
+    while (true) {
+        self.mut.lock();
+        if (self.to_compute.empty()) {
+            self.mut.unlock();
+            break;
+        }
+        auto job = std::move(self.to_compute.back());
+        self.to_compute.pop_back();
+        self.mut.unlock();
+
+        // Compute without the lock, so get() can return artifacts that are already ready
+        std::vector<uint8_t> bytes = job.second();
+        self.mut.lock();
+        self.ready[job.first] = std::move(bytes);
+        self.mut.unlock();
+    }
+    self.save();
+    self.computing = false;
+    return 0;
+}
+
+bool PrecomputeCache::get_bytes(uint64_t key, std::vector<uint8_t> &out) {
+    while (true) {
+        mut.lock();
+        auto found = ready.find(key);
+        if (found != ready.end()) {
+            out = found->second;
+            mut.unlock();
+            return true;
+        }
+        auto job = to_compute.begin();
+        while (job != to_compute.end() && job->first != key) {
+            job++;
+        }
+
+        // start() wasn't called: compute it here instead of waiting for a task that isn't coming
+        if (job != to_compute.end() && !computing) {
+            auto compute = std::move(job->second);
+            to_compute.erase(job);
+            mut.unlock();
+            std::vector<uint8_t> bytes = compute();
+            mut.lock();
+            ready[key] = bytes;
+            mut.unlock();
+            out = std::move(bytes);
+            return true;
+        }
+        bool pending = job != to_compute.end();
+        mut.unlock();
+
+        // Being computed right now if the background task is still going
+        if (!pending && !computing) {
+            printf("PrecomputeCache: %016llx was never added\n", (unsigned long long)key);
+            return false;
+        }
+        vexDelay(WAIT_DELAY_MS);
+    }
+}
+
+/**
+ * Get whether every artifact is ready
+ */
+bool PrecomputeCache::is_ready() {
+    mut.lock();
+    bool done = to_compute.empty() && !computing;
+    mut.unlock();
+    return done;
+}
+
+/**
+ * Get the number of artifacts that were found in the file
+ */
+size_t PrecomputeCache::num_hits() { return hits; }
+
+/**
+ * Get the number of artifacts that had to be computed
+ */
+size_t PrecomputeCache::num_misses() { return misses; }
+
+/**
+ * Write every artifact added this run to the file
+ */
+bool PrecomputeCache::save() {
+    vex::brain::sdcard sd;
+    if (!sd.isInserted()) {
+        printf("PrecomputeCache: no SD card, not saving\n");
+        return false;
+    }
+
+    mut.lock();
+    std::vector<uint8_t> file(2 * sizeof(uint32_t));
+    uint32_t magic = FILE_MAGIC;
+    uint32_t count = ready.size();
+    memcpy(&file[0], &magic, sizeof(magic));
+    memcpy(&file[sizeof(magic)], &count, sizeof(count));
+    for (const auto &entry : ready) {
+        uint64_t key = entry.first;
+        uint32_t len = entry.second.size();
+        size_t pos = file.size();
+        file.resize(pos + sizeof(key) + sizeof(len) + len);
+        memcpy(&file[pos], &key, sizeof(key));
+        memcpy(&file[pos + sizeof(key)], &len, sizeof(len));
+        if (len > 0) {
+            memcpy(&file[pos + sizeof(key) + sizeof(len)], entry.second.data(), len);
+        }
+    }
+    mut.unlock();
+
+    uint32_t crc = CRC32::calculate(file.data(), file.size());
+    size_t pos = file.size();
+    file.resize(pos + sizeof(crc));
+    memcpy(&file[pos], &crc, sizeof(crc));
+
+    if (sd.savefile(filename.c_str(), file.data(), file.size()) != (int32_t)file.size()) {
+        printf("PrecomputeCache: error writing %s\n", filename.c_str());
+        return false;
+    }
+    return true;
+}
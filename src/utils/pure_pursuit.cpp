@@ -1,107 +1,348 @@
 #include "core/utils/pure_pursuit.h"
 
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+
+#include "core/utils/math_util.h"
+
+/**
+ * Create an empty path, that is not valid
+ */
+PurePursuit::Path::Path() : data(std::make_shared<const path_data_t>(path_data_t{{}, {}, {}, {}, 0, false})) {}
+
 /**
  * Create a Path
  * @param points the points that make up the path
  * @param radius the lookahead radius for pure pursuit
  */
 PurePursuit::Path::Path(std::vector<Translation2d> points, double radius) {
-    this->points = points;
-    this->radius = radius;
-    this->valid = true;
-
-    for (int i = 0; i < points.size() - 1; i++) {
-        for (int j = i + 2; j < points.size() - 1; j++) {
-            // Iterate over points on the segments discretely and compare distances
-            double segment_i_dist = points[i].distance(points[i + 1]);
-            if (segment_i_dist == 0) {
-                segment_i_dist = 0.1;
+    path_data_t new_data;
+    new_data.radius = radius;
+    new_data.valid = points.size() >= 2;
+
+    new_data.arc_lengths.reserve(points.size());
+    double length = 0;
+    for (size_t i = 0; i < points.size(); i++) {
+        if (i > 0) {
+            length += points[i - 1].distance(points[i]);
+        }
+        new_data.arc_lengths.push_back(length);
+    }
+
+    new_data.segments = SegmentBuffer(points);
+    new_data.conflicts = find_conflicts(new_data.segments, radius);
+    if (!new_data.conflicts.empty()) {
+        new_data.valid = false;
+    }
+    new_data.points = std::move(points);
+    data = std::make_shared<const path_data_t>(std::move(new_data));
+}
+
+/**
+ * Get the points associated with this Path
+ */
+const std::vector<Translation2d> &PurePursuit::Path::get_points() const { return data->points; }
+
+/**
+ * Get the distance along the path from the first point to each point. The first is 0, the last is get_length()
+ */
+const std::vector<double> &PurePursuit::Path::get_arc_lengths() const { return data->arc_lengths; }
+
+/**
+ * Get the total length of the path, following every segment
+ */
+double PurePursuit::Path::get_length() const { return data->arc_lengths.empty() ? 0 : data->arc_lengths.back(); }
+
+/**
+ * Get the path's segments, laid out for the batch queries in SegmentKernels
+ */
+const SegmentBuffer &PurePursuit::Path::get_segments() const { return data->segments; }
+
+/**
+ * Get the radius associated with this Path
+ */
+double PurePursuit::Path::get_radius() const { return data->radius; }
+
+/**
+ * Get whether this path will behave as expected
+ */
+bool PurePursuit::Path::is_valid() const { return data->valid; }
+
+/**
+ * Get the pairs of segments that made the path invalid by coming too close to each other
+ */
+const std::vector<PurePursuit::Path::conflict_t> &PurePursuit::Path::get_conflicts() const { return data->conflicts; }
+
+/**
+ * Find pairs of segments that come within a radius of each other, but are more than a radius apart along the path.
+ *
+ * Every segment is put in the cells of a uniform grid that its bounding box touches. Each segment is then only
+ * measured against the segments in the cells within a radius of it, so the work grows with the number of segments
+ * rather than its square, as long as the path doesn't pile up in one place. The grid is hashed into a table about twice
+ * as long as the number of entries, so a path spread over a large area doesn't need a large grid.
+ *
+ * @param segs the path's segments
+ * @param radius the lookahead radius
+ * @return up to MAX_CONFLICTS pairs that are too close, earlier segment first
+ */
+std::vector<PurePursuit::Path::conflict_t> PurePursuit::Path::find_conflicts(const SegmentBuffer &segs, double radius) {
+    std::vector<conflict_t> conflicts;
+    const size_t n = segs.size();
+    if (n < 3 || radius <= 0) {
+        return conflicts;
+    }
+
+    // Cells about as big as a segment (or the radius, if that's bigger) keep both the number of cells a segment
+    // touches and the number of segments in a cell small
+    double total_length = segs.arc_start[n - 1] + segs.length[n - 1];
+    double cell_size = std::max(radius, total_length / n);
+    double min_x = segs.start_x[0];
+    double min_y = segs.start_y[0];
+    for (size_t i = 0; i < n; i++) {
+        min_x = std::min(min_x, std::min(segs.start_x[i], segs.start_x[i] + segs.dx[i]));
+        min_y = std::min(min_y, std::min(segs.start_y[i], segs.start_y[i] + segs.dy[i]));
+    }
+    min_x -= radius;
+    min_y -= radius;
+
+    // The range of cells a segment's bounding box covers, grown by a margin
+    struct cell_range_t {
+        int x0, y0, x1, y1;
+    };
+    auto cells_of = [&](size_t i, double margin) -> cell_range_t {
+        double x0 = std::min(segs.start_x[i], segs.start_x[i] + segs.dx[i]) - margin;
+        double x1 = std::max(segs.start_x[i], segs.start_x[i] + segs.dx[i]) + margin;
+        double y0 = std::min(segs.start_y[i], segs.start_y[i] + segs.dy[i]) - margin;
+        double y1 = std::max(segs.start_y[i], segs.start_y[i] + segs.dy[i]) + margin;
+        return {
+          (int)floor((x0 - min_x) / cell_size), (int)floor((y0 - min_y) / cell_size),
+          (int)floor((x1 - min_x) / cell_size), (int)floor((y1 - min_y) / cell_size)
+        };
+    };
+
+    // A few long diagonal segments can cover far more cells than the rest of the path. Grow the cells until the
+    // entries are in proportion to the number of segments
+    size_t num_entries;
+    while (true) {
+        num_entries = 0;
+        for (size_t i = 0; i < n; i++) {
+            cell_range_t r = cells_of(i, 0);
+            num_entries += (size_t)(r.x1 - r.x0 + 1) * (r.y1 - r.y0 + 1);
+        }
+        if (num_entries <= 8 * n) {
+            break;
+        }
+        cell_size *= 2;
+    }
+    size_t num_buckets = 1;
+    while (num_buckets < 2 * num_entries) {
+        num_buckets <<= 1;
+    }
+    auto bucket_of = [num_buckets](int cx, int cy) -> size_t {
+        return ((uint32_t)cx * 73856093u ^ (uint32_t)cy * 19349663u) & (num_buckets - 1);
+    };
+
+    // Counting sort the segments into their buckets: bucket b holds entries[bucket_start[b] .. bucket_start[b + 1])
+    std::vector<uint32_t> bucket_start(num_buckets + 1, 0);
+    for (size_t i = 0; i < n; i++) {
+        cell_range_t r = cells_of(i, 0);
+        for (int cx = r.x0; cx <= r.x1; cx++) {
+            for (int cy = r.y0; cy <= r.y1; cy++) {
+                bucket_start[bucket_of(cx, cy) + 1]++;
             }
-            double segment_j_dist = points[j].distance(points[j + 1]);
-            if (segment_j_dist == 0) {
-                segment_j_dist = 0.1;
+        }
+    }
+    for (size_t b = 0; b < num_buckets; b++) {
+        bucket_start[b + 1] += bucket_start[b];
+    }
+    std::vector<uint32_t> entries(num_entries);
+    std::vector<uint32_t> fill(bucket_start.begin(), bucket_start.end() - 1);
+    for (size_t i = 0; i < n; i++) {
+        cell_range_t r = cells_of(i, 0);
+        for (int cx = r.x0; cx <= r.x1; cx++) {
+            for (int cy = r.y0; cy <= r.y1; cy++) {
+                entries[fill[bucket_of(cx, cy)]++] = i;
             }
-            for (double t1 = 0; t1 <= 1; t1 += radius / segment_i_dist) {
-                Translation2d p1(0, 0);
-                p1 = Translation2d(
-                  (points[i].x() + t1 * (points[i + 1].x() - points[i].x())),
-                  (points[i].y() + t1 * (points[i + 1].y() - points[i].y()))
-                );
-
-                for (double t2 = 0; t2 <= 1; t2 += radius / segment_j_dist) {
-                    Translation2d p2(0, 0);
-                    p2 = Translation2d(
-                      (points[j].x() + t2 * (points[j + 1].x() - points[j].x())),
-                      (points[j].y() + t2 * (points[j + 1].y() - points[j].y()))
-                    );
-
-                    if (p1.distance(p2) < radius) {
-                        this->valid = false;
-                        return;
+        }
+    }
+
+    // The last segment each one was measured against, so a segment in several cells is only measured once
+    std::vector<uint32_t> last_checked(n, UINT32_MAX);
+    for (size_t i = 0; i < n && conflicts.size() < MAX_CONFLICTS; i++) {
+        Translation2d start(segs.start_x[i], segs.start_y[i]);
+        Translation2d end(segs.start_x[i] + segs.dx[i], segs.start_y[i] + segs.dy[i]);
+        double end_arc = segs.arc_start[i] + segs.length[i];
+
+        cell_range_t r = cells_of(i, radius);
+        for (int cx = r.x0; cx <= r.x1; cx++) {
+            for (int cy = r.y0; cy <= r.y1; cy++) {
+                size_t b = bucket_of(cx, cy);
+                for (uint32_t e = bucket_start[b]; e < bucket_start[b + 1]; e++) {
+                    uint32_t j = entries[e];
+                    // Only later segments, and only those far enough along that the lookahead shouldn't reach them
+                    if (j <= i + 1 || last_checked[j] == i || segs.arc_start[j] - end_arc <= radius) {
+                        continue;
+                    }
+                    last_checked[j] = i;
+
+                    double dist_sq;
+                    SegmentKernels::closest_approaches(segs, j, 1, start, end, &dist_sq);
+                    if (dist_sq < radius * radius && conflicts.size() < MAX_CONFLICTS) {
+                        conflicts.push_back({i, j});
                     }
                 }
             }
         }
     }
+
+    std::sort(conflicts.begin(), conflicts.end(), [](const conflict_t &a, const conflict_t &b) {
+        return a.first < b.first || (a.first == b.first && a.second < b.second);
+    });
+    return conflicts;
 }
 
 /**
- * Get the points associated with this Path
+ * Create a tracker at the start of a path
+ * @param path the path to follow
  */
-const std::vector<Translation2d> PurePursuit::Path::get_points() { return this->points; }
+PurePursuit::Tracker::Tracker(const Path &path) : path(path) { reset(); }
 
 /**
- * Get the radius associated with this Path
+ * Move the tracker back to the start of its path
  */
-double PurePursuit::Path::get_radius() { return this->radius; }
+void PurePursuit::Tracker::reset() {
+    segment = 0;
+    progress = 0;
+    lookahead_is_end = false;
+    lookahead = path.get_points().empty() ? Translation2d() : path.get_points().front();
+    remaining_dist = path.get_length();
+}
 
 /**
- * Get whether this path will behave as expected
+ * Move the cursor to the part of the path the robot is closest to, then find the lookahead point
+ * @param robot_pose the robot's current position
  */
-bool PurePursuit::Path::is_valid() { return this->valid; }
+void PurePursuit::Tracker::update(const Pose2d &robot_pose) {
+    const std::vector<Translation2d> &points = path.get_points();
+    const double radius = path.get_radius();
+    const Translation2d robot = robot_pose.translation();
+
+    if (points.size() < 2) {
+        lookahead = points.empty() ? robot : points.front();
+        lookahead_is_end = true;
+        remaining_dist = robot.distance(lookahead);
+        return;
+    }
+    const SegmentBuffer &segments = path.get_segments();
+
+    // Number of segments from the cursor that start no further along the path than a distance
+    auto segments_within = [&](double dist) -> size_t {
+        auto last = std::upper_bound(segments.arc_start.begin() + segment, segments.arc_start.end(), dist);
+        return std::max<size_t>(last - (segments.arc_start.begin() + segment), 1);
+    };
+
+    // Move the cursor to the closest point on the segments within a radius ahead. The robot can't have gotten further
+    // than that in one update, since it was steering toward a point a radius away
+    double t;
+    double dist_sq;
+    size_t closest_segment =
+      SegmentKernels::nearest_on_polyline(segments, segment, segments_within(progress + radius), robot, t, dist_sq);
+    double closest_progress = segments.arc_start[closest_segment] + t * segments.length[closest_segment];
+    if (closest_progress >= progress) {
+        segment = closest_segment;
+        progress = closest_progress;
+    }
+
+    const Translation2d &end = points.back();
+    if (robot.distance(end) <= radius) {
+        lookahead = end;
+        lookahead_is_end = true;
+        remaining_dist = robot.distance(end);
+        return;
+    }
+
+    // The lookahead is the furthest intersection with the circle, along the path. Any point on the circle is at most a
+    // radius plus the robot's distance from the path further along than the cursor
+    size_t window = segments_within(progress + radius + sqrt(dist_sq));
+    size_t hit = SegmentKernels::furthest_circle_intersection(segments, segment, window, robot, radius, t);
+    if (hit < segment + window) {
+        lookahead = points[hit] + (points[hit + 1] - points[hit]) * t;
+        lookahead_is_end = false;
+    } else {
+        lookahead = end;
+        lookahead_is_end = true;
+    }
+
+    remaining_dist = lookahead_is_end ? robot.distance(end) : path.get_length() - progress;
+}
 
 /**
- * Returns points of the intersections of a line segment and a circle. The line
- * segment is defined by two points, and the circle is defined by a center and radius.
+ * Get the lookahead point found by the last update()
  */
-std::vector<Translation2d>
-PurePursuit::line_circle_intersections(Translation2d center, double r, Translation2d point1, Translation2d point2) {
-    std::vector<Translation2d> intersections = {};
+Translation2d PurePursuit::Tracker::get_lookahead() const { return lookahead; }
+
+/**
+ * Get whether the lookahead point is the end of the path
+ */
+bool PurePursuit::Tracker::is_lookahead_end() const { return lookahead_is_end; }
+
+/**
+ * Get the distance left to drive as of the last update()
+ */
+double PurePursuit::Tracker::get_remaining_dist() const { return remaining_dist; }
 
-    // Do future calculations relative to the circle's center
+/**
+ * Get the distance along the path to the point closest to the robot
+ */
+double PurePursuit::Tracker::get_progress() const { return progress; }
 
-    point1 = point1 - center;
-    point2 = point2 - center;
+/**
+ * Get the index of the segment (from point i to i + 1) the robot is closest to
+ */
+size_t PurePursuit::Tracker::get_segment() const { return segment; }
 
-    double x1, x2, y1, y2;
-    // Handling an infinite slope using mx+b and x^2 + y^2 = r^2
-    if (point1.x() - point2.x() == 0) {
-        x1 = point1.x();
-        y1 = sqrt(pow(r, 2) - pow(x1, 2));
-        x2 = point1.x();
-        y2 = -sqrt(pow(r, 2) - pow(x2, 2));
+namespace {
+/**
+ * Solve |point1 + t * (point2 - point1) - center| = r for the t's in [0, 1], smallest first
+ * @return the number of solutions written to t
+ */
+int segment_circle_params(Translation2d center, double r, Translation2d point1, Translation2d point2, double t[2]) {
+    Translation2d along = point2 - point1;
+    Translation2d from_center = point1 - center;
+    double a = along * along;
+    if (a == 0) {
+        return 0;
     }
-    // Non-infinite slope using mx+b and x^2 + y^2 = r^2
-    else {
-        double m = (point1.y() - point2.y()) / (point1.x() - point2.x());
-        double b = point1.y() - (m * point1.x());
-
-        x1 = ((-m * b) + sqrt(pow(r, 2) + (pow(m, 2) * pow(r, 2)) - pow(b, 2))) / (1 + pow(m, 2));
-        y1 = m * x1 + b;
-        x2 = ((-m * b) - sqrt(pow(r, 2) + (pow(m, 2) * pow(r, 2)) - pow(b, 2))) / (1 + pow(m, 2));
-        y2 = m * x2 + b;
+    double half_b = (from_center * along) / a;
+    double c = (from_center * from_center - r * r) / a;
+    double discriminant = half_b * half_b - c;
+    if (discriminant < 0) {
+        return 0;
     }
-
-    // The equations used define an infinitely long line, so we check if the detected intersection falls on the line
-    // segment.
-    if (x1 >= fmin(point1.x(), point2.x()) && x1 <= fmax(point1.x(), point2.x()) &&
-        y1 >= fmin(point1.y(), point2.y()) && y1 <= fmax(point1.y(), point2.y())) {
-        intersections.push_back(Translation2d(x1 + center.x(), y1 + center.y()));
+    double root = sqrt(discriminant);
+    int found = 0;
+    for (double candidate : {-half_b - root, -half_b + root}) {
+        if (candidate >= 0 && candidate <= 1) {
+            t[found++] = candidate;
+        }
     }
+    return found;
+}
+} // namespace
+
+/**
+ * Returns points of the intersections of a line segment and a circle. The line
+ * segment is defined by two points, and the circle is defined by a center and radius.
+ */
+std::vector<Translation2d>
+PurePursuit::line_circle_intersections(Translation2d center, double r, Translation2d point1, Translation2d point2) {
+    std::vector<Translation2d> intersections = {};
 
-    if (x2 >= fmin(point1.x(), point2.x()) && x2 <= fmax(point1.x(), point2.x()) &&
-        y2 >= fmin(point1.y(), point2.y()) && y2 <= fmax(point1.y(), point2.y())) {
-        intersections.push_back(Translation2d(x2 + center.x(), y2 + center.y()));
+    double t[2];
+    int found = segment_circle_params(center, r, point1, point2, t);
+    for (int i = 0; i < found; i++) {
+        intersections.push_back(point1 + (point2 - point1) * t[i]);
     }
 
     return intersections;
@@ -120,15 +361,16 @@ PurePursuit::get_lookahead(const std::vector<Translation2d> &path, Pose2d robot_
     }
 
     // Check each line segment of the path for potential targets
-    for (int i = 0; i < path.size() - 1; i++) {
+    for (int i = 0; i < (int)path.size() - 1; i++) {
         Translation2d start = path[i];
         Translation2d end = path[i + 1];
 
-        std::vector<Translation2d> intersections =
-          PurePursuit::line_circle_intersections(robot_loc.translation(), radius, start, end);
+        double t[2];
+        int found = segment_circle_params(robot_loc.translation(), radius, start, end, t);
         // Choose the intersection that is closest to the end of the line segment
         // This prioritizes the closest intersection to the end of the path
-        for (Translation2d intersection : intersections) {
+        for (int j = 0; j < found; j++) {
+            Translation2d intersection = start + (end - start) * t[j];
             if (intersection.distance(end) < target.distance(end)) {
                 target = intersection;
             }
@@ -205,6 +447,61 @@ PurePursuit::inject_path(const std::vector<Translation2d> &path, double spacing)
     return new_path;
 }
 
+/**
+ * Returns the path smooth_path() converges to, found directly with a tridiagonal solve
+ *
+ * @param path the points to smooth
+ * @param weight_data how strongly points are pulled back to where they started (alpha)
+ * @param weight_smooth how strongly points are pulled toward their neighbors (beta)
+ * @param pinned indices of points that must not move, besides the first and last
+ * @return the smoothed path, the same length as path
+ */
+std::vector<Translation2d> PurePursuit::smooth_path_direct(
+  const std::vector<Translation2d> &path, double weight_data, double weight_smooth, const std::vector<size_t> &pinned
+) {
+    size_t n = path.size();
+    if (n < 3) {
+        return path;
+    }
+
+    // Row i is lower[i] * y_i-1 + diag[i] * y_i + upper[i] * y_i+1 = rhs_i. A fixed point's row is just y_i = x_i
+    std::vector<bool> fixed(n, false);
+    fixed[0] = fixed[n - 1] = true;
+    for (size_t i : pinned) {
+        if (i < n) {
+            fixed[i] = true;
+        }
+    }
+
+    // Thomas algorithm: eliminate the lower diagonal going forward (keeping the new upper diagonal and right hand
+    // side), then back substitute
+    std::vector<double> upper(n), rhs_x(n), rhs_y(n);
+    for (size_t i = 0; i < n; i++) {
+        double lower = fixed[i] ? 0 : -weight_smooth;
+        double diag = fixed[i] ? 1 : weight_data + 2 * weight_smooth;
+        double up = fixed[i] ? 0 : -weight_smooth;
+        double x = fixed[i] ? path[i].x() : weight_data * path[i].x();
+        double y = fixed[i] ? path[i].y() : weight_data * path[i].y();
+        if (i > 0) {
+            diag -= lower * upper[i - 1];
+            x -= lower * rhs_x[i - 1];
+            y -= lower * rhs_y[i - 1];
+        }
+        upper[i] = up / diag;
+        rhs_x[i] = x / diag;
+        rhs_y[i] = y / diag;
+    }
+
+    std::vector<Translation2d> new_path(n);
+    new_path[n - 1] = Translation2d(rhs_x[n - 1], rhs_y[n - 1]);
+    for (size_t i = n - 1; i > 0; i--) {
+        rhs_x[i - 1] -= upper[i - 1] * rhs_x[i];
+        rhs_y[i - 1] -= upper[i - 1] * rhs_y[i];
+        new_path[i - 1] = Translation2d(rhs_x[i - 1], rhs_y[i - 1]);
+    }
+    return new_path;
+}
+
 /**
  * Interpolates a smooth path given a list of waypoints using hermite splines.
  * For more information: https://www.youtube.com/watch?v=hG0p4XgePSA.
@@ -229,11 +526,11 @@ PurePursuit::smooth_path_hermite(const std::vector<hermite_point> &path, double
             // Scale s from 0.0 to 1.0
             double s = (double)t / (double)steps;
 
-            // Hermite Blending functions
-            double h1 = 2 * pow(s, 3) - 3 * pow(s, 2) + 1;
-            double h2 = -2 * pow(s, 3) + 3 * pow(s, 2);
-            double h3 = pow(s, 3) - 2 * pow(s, 2) + s;
-            double h4 = pow(s, 3) - pow(s, 2);
+            // Hermite Blending functions, in Horner form
+            double h1 = (2 * s - 3) * s * s + 1;
+            double h2 = (-2 * s + 3) * s * s;
+            double h3 = ((s - 2) * s + 1) * s;
+            double h4 = (s - 1) * s * s;
 
             // Calculate the point
             Translation2d pv = p1 * h1 + p2 * h2 + t1 * h3 + t2 * h4;
@@ -265,13 +562,14 @@ double PurePursuit::estimate_remaining_dist(const std::vector<Translation2d> &pa
     double dist = 0;
 
     // Run through the path backwards, adding distances
-    for (int i = path.size() - 1; i >= 0; i--) {
+    for (int i = path.size() - 1; i >= 1; i--) {
         // Test if the robot is between the two points
-        auto pts = PurePursuit::line_circle_intersections(robot_pose.translation(), radius, path[i - 1], path[i]);
+        double t[2];
+        int found = segment_circle_params(robot_pose.translation(), radius, path[i - 1], path[i], t);
 
         // There is an intersection? Robot is between the points so add the distance
         // from the bot to the next point and end.
-        if (!pts.empty()) {
+        if (found > 0) {
             dist += robot_pose.translation().distance(path[i]);
             return dist;
         }
@@ -0,0 +1,174 @@
+#include "core/utils/quintic_spline.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace {
+
+/**
+ * Second derivative at the start (s = 0) and end (s = 1) of a cubic Hermite piece
+ */
+Translation2d cubic_start_accel(const Translation2d &p0, const Translation2d &v0, const Translation2d &p1,
+                                const Translation2d &v1) {
+    return p0 * -6 + v0 * -4 + p1 * 6 + v1 * -2;
+}
+
+Translation2d cubic_end_accel(const Translation2d &p0, const Translation2d &v0, const Translation2d &p1,
+                              const Translation2d &v1) {
+    return p0 * 6 + v0 * 2 + p1 * -6 + v1 * 4;
+}
+
+/**
+ * Distance from a point to the segment between a and b
+ */
+double dist_to_segment(const Translation2d &p, const Translation2d &a, const Translation2d &b) {
+    Translation2d ab = b - a;
+    double len_sq = ab * ab;
+    double t = len_sq > 0 ? std::min(std::max(((p - a) * ab) / len_sq, 0.0), 1.0) : 0;
+    return p.distance(a + ab * t);
+}
+
+} // namespace
+
+/**
+ * Build the spline through a list of knots
+ * @param knots where the path goes, the direction it goes there, and how strongly
+ */
+QuinticSpline::QuinticSpline(const std::vector<PurePursuit::hermite_point> &knots) {
+    if (knots.size() < 2) {
+        return;
+    }
+    size_t n = knots.size();
+    std::vector<Translation2d> pos(n), vel(n), accel(n);
+    for (size_t i = 0; i < n; i++) {
+        pos[i] = knots[i].getPoint();
+        vel[i] = knots[i].getTangent();
+    }
+
+    // The cubic pieces' second derivatives, averaged where two pieces meet
+    accel[0] = cubic_start_accel(pos[0], vel[0], pos[1], vel[1]);
+    accel[n - 1] = cubic_end_accel(pos[n - 2], vel[n - 2], pos[n - 1], vel[n - 1]);
+    for (size_t i = 1; i + 1 < n; i++) {
+        accel[i] = (cubic_end_accel(pos[i - 1], vel[i - 1], pos[i], vel[i]) +
+                    cubic_start_accel(pos[i], vel[i], pos[i + 1], vel[i + 1])) *
+                   0.5;
+    }
+
+    // The quintic with the given position, first and second derivative at both ends, as polynomial coefficients
+    pieces.resize(n - 1);
+    for (size_t i = 0; i + 1 < n; i++) {
+        const Translation2d &p0 = pos[i], &v0 = vel[i], &a0 = accel[i];
+        const Translation2d &p1 = pos[i + 1], &v1 = vel[i + 1], &a1 = accel[i + 1];
+        Translation2d c[6] = {
+          p0,
+          v0,
+          a0 * 0.5,
+          p0 * -10 + v0 * -6 + a0 * -1.5 + a1 * 0.5 + v1 * -4 + p1 * 10,
+          p0 * 15 + v0 * 8 + a0 * 1.5 + a1 * -1 + v1 * 7 + p1 * -15,
+          p0 * -6 + v0 * -3 + a0 * -0.5 + a1 * 0.5 + v1 * -3 + p1 * 6,
+        };
+        for (int k = 0; k < 6; k++) {
+            pieces[i].x[k] = c[k].x();
+            pieces[i].y[k] = c[k].y();
+        }
+    }
+}
+
+/**
+ * Get the number of pieces, one fewer than the knots
+ */
+size_t QuinticSpline::num_pieces() const { return pieces.size(); }
+
+/**
+ * Evaluate a piece
+ */
+Trajectory::path_point_t QuinticSpline::evaluate(const piece_t &p, double s) const {
+    // Horner's method for the position and both derivatives
+    double x = ((((p.x[5] * s + p.x[4]) * s + p.x[3]) * s + p.x[2]) * s + p.x[1]) * s + p.x[0];
+    double y = ((((p.y[5] * s + p.y[4]) * s + p.y[3]) * s + p.y[2]) * s + p.y[1]) * s + p.y[0];
+    double dx = (((5 * p.x[5] * s + 4 * p.x[4]) * s + 3 * p.x[3]) * s + 2 * p.x[2]) * s + p.x[1];
+    double dy = (((5 * p.y[5] * s + 4 * p.y[4]) * s + 3 * p.y[3]) * s + 2 * p.y[2]) * s + p.y[1];
+    double ddx = ((20 * p.x[5] * s + 12 * p.x[4]) * s + 6 * p.x[3]) * s + 2 * p.x[2];
+    double ddy = ((20 * p.y[5] * s + 12 * p.y[4]) * s + 6 * p.y[3]) * s + 2 * p.y[2];
+
+    double speed_sq = dx * dx + dy * dy;
+    double curvature = speed_sq > 0 ? (dx * ddy - dy * ddx) / (speed_sq * sqrt(speed_sq)) : 0;
+    return {Pose2d(x, y, Rotation2d(dx, dy)), curvature};
+}
+
+/**
+ * Find a point on the spline
+ * @param u the piece plus how far along it the point is
+ * @return the point, the direction of the path there and its curvature
+ */
+Trajectory::path_point_t QuinticSpline::evaluate(double u) const {
+    if (pieces.empty()) {
+        return {Pose2d(), 0};
+    }
+    u = std::min(std::max(u, 0.0), (double)pieces.size());
+    size_t i = std::min((size_t)u, pieces.size() - 1);
+    return evaluate(pieces[i], u - i);
+}
+
+/**
+ * Split [s0, s1] on a piece until it's within tolerance, adding the end of every part to out
+ */
+void QuinticSpline::subdivide(
+  const piece_t &piece, double s0, const Trajectory::path_point_t &p0, double s1, const Trajectory::path_point_t &p1,
+  double tolerance, double max_spacing, int depth, std::vector<Trajectory::path_point_t> &out
+) const {
+    double s_mid = (s0 + s1) / 2;
+    Trajectory::path_point_t mid = evaluate(piece, s_mid);
+
+    Translation2d a = p0.pose.translation();
+    Translation2d b = p1.pose.translation();
+    bool too_far = dist_to_segment(mid.pose.translation(), a, b) > tolerance;
+    bool too_sharp = fabs((p1.pose.rotation() - p0.pose.rotation()).wrapped_radians_180()) > MAX_TURN;
+    bool too_long = max_spacing > 0 && a.distance(b) > max_spacing;
+
+    if (depth < MAX_DEPTH && (too_far || too_sharp || too_long)) {
+        subdivide(piece, s0, p0, s_mid, mid, tolerance, max_spacing, depth + 1, out);
+        subdivide(piece, s_mid, mid, s1, p1, tolerance, max_spacing, depth + 1, out);
+    } else {
+        out.push_back(p1);
+    }
+}
+
+/**
+ * Place points along the spline, closer together where it curves
+ * @param tolerance most the path can stray from the straight line between two points (inch)
+ * @param max_spacing most distance between two points (inch). 0 for no limit
+ * @return the points, starting at the first knot and ending at the last, with their directions and curvatures
+ */
+std::vector<Trajectory::path_point_t> QuinticSpline::subdivide(double tolerance, double max_spacing) const {
+    std::vector<Trajectory::path_point_t> out;
+    if (pieces.empty()) {
+        return out;
+    }
+    out.push_back(evaluate(pieces[0], 0));
+    for (const piece_t &piece : pieces) {
+        // Always split each piece once, so a piece whose middle happens to land on its chord (an S) is still checked
+        Trajectory::path_point_t start = evaluate(piece, 0);
+        Trajectory::path_point_t mid = evaluate(piece, 0.5);
+        Trajectory::path_point_t end = evaluate(piece, 1);
+        subdivide(piece, 0, start, 0.5, mid, tolerance, max_spacing, 1, out);
+        subdivide(piece, 0.5, mid, 1, end, tolerance, max_spacing, 1, out);
+    }
+    return out;
+}
+
+/**
+ * subdivide(), for a path that only needs the positions
+ * @param tolerance most the path can stray from the straight line between two points (inch)
+ * @param max_spacing most distance between two points (inch). 0 for no limit
+ * @return the points, starting at the first knot and ending at the last
+ */
+std::vector<Translation2d> QuinticSpline::subdivide_points(double tolerance, double max_spacing) const {
+    std::vector<Trajectory::path_point_t> path = subdivide(tolerance, max_spacing);
+    std::vector<Translation2d> out;
+    out.reserve(path.size());
+    for (const Trajectory::path_point_t &point : path) {
+        out.push_back(point.pose.translation());
+    }
+    return out;
+}
@@ -0,0 +1,263 @@
+#include "core/utils/trajectory.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+
+namespace {
+
+/**
+ * Fill in a polyline with points a fixed distance apart along it. The last waypoint is always included, so the last
+ * piece may be shorter than the spacing.
+ */
+std::vector<Translation2d> resample(const std::vector<Translation2d> &waypoints, double spacing) {
+    std::vector<Translation2d> out;
+    out.push_back(waypoints[0]);
+
+    // distance along the current segment to place the next point at
+    double next = spacing;
+    for (size_t i = 0; i + 1 < waypoints.size(); i++) {
+        Translation2d start = waypoints[i];
+        Translation2d delta = waypoints[i + 1] - start;
+        double length = delta.norm();
+        if (length == 0) {
+            continue;
+        }
+        while (next < length) {
+            out.push_back(start + delta * (next / length));
+            next += spacing;
+        }
+        next -= length;
+    }
+
+    // Don't leave a sliver of a piece at the end
+    if (out.size() > 1 && out.back().distance(waypoints.back()) < spacing * 0.25) {
+        out.pop_back();
+    }
+    out.push_back(waypoints.back());
+    return out;
+}
+
+/**
+ * Signed curvature of the circle through three points, positive when a -> b -> c turns left. 0 if two of them are in
+ * the same place
+ */
+double curvature_through(const Translation2d &a, const Translation2d &b, const Translation2d &c) {
+    Translation2d ab = b - a;
+    Translation2d bc = c - b;
+    double denom = ab.norm() * bc.norm() * a.distance(c);
+    if (denom == 0) {
+        return 0;
+    }
+    double cross = ab.x() * bc.y() - ab.y() * bc.x();
+    return 2 * cross / denom;
+}
+
+} // namespace
+
+/**
+ * Create an empty trajectory, that takes no time
+ */
+Trajectory::Trajectory() : states(std::make_shared<const std::vector<state_t>>()) {}
+
+/**
+ * Generate a trajectory through a list of waypoints, connected by straight lines
+ * @param waypoints the points to drive through
+ * @param config the limits to generate with
+ */
+Trajectory::Trajectory(const std::vector<Translation2d> &waypoints, const trajectory_config_t &config)
+    : Trajectory() {
+    if (waypoints.size() < 2 || config.spacing <= 0) {
+        printf("Trajectory: need at least 2 waypoints and a positive spacing\n");
+        return;
+    }
+
+    std::vector<Translation2d> points = resample(waypoints, config.spacing);
+    size_t n = points.size();
+    std::vector<path_point_t> path;
+    path.reserve(n);
+    for (size_t i = 0; i < n; i++) {
+        // Central differences in the middle, one sided at the ends
+        const Translation2d &prev = points[i == 0 ? 0 : i - 1];
+        const Translation2d &next = points[i == n - 1 ? n - 1 : i + 1];
+        Translation2d dir = next - prev;
+        double curvature = (i == 0 || i == n - 1) ? 0 : curvature_through(prev, points[i], next);
+        path.push_back({Pose2d(points[i], Rotation2d(dir.x(), dir.y())), curvature});
+    }
+
+    // Copy the neighbor's curvature to the ends instead of pretending they're straight
+    if (n > 2) {
+        path[0].curvature = path[1].curvature;
+        path[n - 1].curvature = path[n - 2].curvature;
+    }
+
+    *this = Trajectory(path, config);
+}
+
+/**
+ * Generate a trajectory along points sampled from a curve that already know their direction and curvature
+ * @param path the points along the path, in order
+ * @param config the limits to generate with
+ */
+Trajectory::Trajectory(const std::vector<path_point_t> &path, const trajectory_config_t &config) : Trajectory() {
+    if (path.empty() || config.max_vel <= 0 || config.max_accel <= 0) {
+        printf("Trajectory: need a path, and a positive max_vel and max_accel\n");
+        return;
+    }
+
+    size_t n = path.size();
+    std::vector<state_t> out(n);
+
+    // Distance along the path, and the fastest each point can be taken on its own
+    std::vector<double> limit(n);
+    double dist = 0;
+    for (size_t i = 0; i < n; i++) {
+        if (i > 0) {
+            dist += path[i - 1].pose.translation().distance(path[i].pose.translation());
+        }
+        double abs_curvature = fabs(path[i].curvature);
+        limit[i] = config.max_vel / (1 + abs_curvature * config.track_width / 2);
+        if (config.max_centripetal_accel > 0 && abs_curvature > 0) {
+            limit[i] = std::min(limit[i], sqrt(config.max_centripetal_accel / abs_curvature));
+        }
+        out[i].dist = dist;
+        out[i].pose = path[i].pose;
+        out[i].vel = limit[i];
+        out[i].curvature = path[i].curvature;
+    }
+
+    // Forward pass: can't speed up faster than max_accel
+    out[0].vel = std::min(out[0].vel, fabs(config.start_vel));
+    for (size_t i = 1; i < n; i++) {
+        double ds = out[i].dist - out[i - 1].dist;
+        out[i].vel = std::min(out[i].vel, sqrt(out[i - 1].vel * out[i - 1].vel + 2 * config.max_accel * ds));
+    }
+
+    // Backward pass: can't slow down faster than max_accel either
+    out[n - 1].vel = std::min(out[n - 1].vel, fabs(config.end_vel));
+    for (size_t i = n - 1; i > 0; i--) {
+        double ds = out[i].dist - out[i - 1].dist;
+        out[i - 1].vel = std::min(out[i - 1].vel, sqrt(out[i].vel * out[i].vel + 2 * config.max_accel * ds));
+    }
+
+    // Constant acceleration across each piece gives the time and acceleration
+    std::vector<state_t> timed;
+    timed.reserve(n + 1);
+    double time = 0;
+    for (size_t i = 0; i < n; i++) {
+        state_t state = out[i];
+        state.time = time;
+        state.accel = 0;
+        if (i + 1 < n) {
+            double ds = out[i + 1].dist - out[i].dist;
+            double v0 = out[i].vel;
+            double v1 = out[i + 1].vel;
+            if (ds > 0 && v0 + v1 > 0) {
+                state.accel = (v1 * v1 - v0 * v0) / (2 * ds);
+                time += 2 * ds / (v0 + v1);
+            } else if (ds > 0) {
+                // Starting and stopping on the same piece (a path shorter than its spacing, say): split it at its
+                // middle, speeding up to there and slowing back down, so sample() moves through it
+                double v_mid = std::min({sqrt(config.max_accel * ds), limit[i], limit[i + 1]});
+                state.accel = v_mid * v_mid / ds;
+                timed.push_back(state);
+                time += ds / v_mid;
+
+                double turned = (out[i + 1].pose.rotation() - out[i].pose.rotation()).wrapped_radians_180();
+                Translation2d mid = (out[i].pose.translation() + out[i + 1].pose.translation()) * 0.5;
+                state.time = time;
+                state.dist = out[i].dist + ds / 2;
+                state.pose = Pose2d(mid, out[i].pose.rotation() + Rotation2d(turned / 2));
+                state.vel = v_mid;
+                state.accel = -v_mid * v_mid / ds;
+                state.curvature = (out[i].curvature + out[i + 1].curvature) / 2;
+                time += ds / v_mid;
+            }
+        }
+        timed.push_back(state);
+    }
+    out = std::move(timed);
+    if (out.size() > 1) {
+        out.back().accel = out[out.size() - 2].accel;
+    }
+
+    // Driving backwards, the robot faces away from the path and turns the other way relative to its own velocity
+    double dir = config.reversed ? -1 : 1;
+    for (state_t &state : out) {
+        if (config.reversed) {
+            state.pose = Pose2d(state.pose.translation(), state.pose.rotation() + Rotation2d(M_PI));
+        }
+        state.vel *= dir;
+        state.accel *= dir;
+        state.curvature *= dir;
+    }
+
+    states = std::make_shared<const std::vector<state_t>>(std::move(out));
+}
+
+/**
+ * Create a trajectory from states that were already generated
+ * @param states the states, in order of time
+ */
+Trajectory::Trajectory(std::vector<state_t> states)
+    : states(std::make_shared<const std::vector<state_t>>(std::move(states))) {}
+
+/**
+ * Find where the robot should be at a time, between the two states around it
+ * @param t time since the start of the trajectory (s)
+ * @return the state at that time
+ */
+Trajectory::state_t Trajectory::sample(double t) const {
+    const std::vector<state_t> &s = *states;
+    if (s.empty()) {
+        return state_t{0, 0, Pose2d(), 0, 0, 0};
+    }
+    if (t <= s.front().time) {
+        return s.front();
+    }
+    if (t >= s.back().time) {
+        return s.back();
+    }
+
+    // The last state at or before t
+    auto after = std::upper_bound(s.begin(), s.end(), t, [](double t, const state_t &state) {
+        return t < state.time;
+    });
+    const state_t &prev = *(after - 1);
+    const state_t &next = *after;
+
+    // Speed and distance follow the piece's constant acceleration, the pose and curvature follow the distance
+    double dt = t - prev.time;
+    double vel = prev.vel + prev.accel * dt;
+    double moved = fabs(prev.vel * dt + 0.5 * prev.accel * dt * dt);
+    double piece = next.dist - prev.dist;
+    double frac = piece > 0 ? std::min(std::max(moved / piece, 0.0), 1.0) : 0;
+
+    Translation2d pos = prev.pose.translation() + (next.pose.translation() - prev.pose.translation()) * frac;
+    double turned = (next.pose.rotation() - prev.pose.rotation()).wrapped_radians_180();
+    Rotation2d heading = prev.pose.rotation() + Rotation2d(turned * frac);
+
+    return state_t{
+      t,
+      prev.dist + moved,
+      Pose2d(pos, heading),
+      vel,
+      prev.accel,
+      prev.curvature + (next.curvature - prev.curvature) * frac,
+    };
+}
+
+/**
+ * Get the time it takes to drive the whole trajectory
+ */
+double Trajectory::total_time() const { return states->empty() ? 0 : states->back().time; }
+
+/**
+ * Get the length of the path, following every point
+ */
+double Trajectory::total_dist() const { return states->empty() ? 0 : states->back().dist; }
+
+/**
+ * Get every state of the trajectory, in order of time
+ */
+const std::vector<Trajectory::state_t> &Trajectory::get_states() const { return *states; }
@@ -0,0 +1,56 @@
+#pragma once
+
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+
+#include "sim.h"
+
+/**
+ * Checks and timing for the host tests. A test counts its failed checks in host_test::failures and ends with
+ * sim::finish(host_test::failures). Timings are printed for reading, never checked: they depend on the computer
+ */
+namespace host_test {
+
+inline int failures = 0;
+
+/**
+ * Count a failed check, and say where it was
+ */
+inline void fail(const char *file, int line, const char *what) {
+    printf("%s:%d: check failed: %s\n", file, line, what);
+    failures++;
+}
+
+/**
+ * Run a function many times and find how long one call took on average
+ *
+ * @param iters how many times to run it
+ * @param fn the function
+ * @return the average time of a call (ns)
+ */
+template <typename Fn> double time_ns(int iters, Fn &&fn) {
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < iters; i++) {
+        fn();
+    }
+    return std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count() / iters;
+}
+
+} // namespace host_test
+
+#define CHECK(cond)                                                                                                    \
+    do {                                                                                                               \
+        if (!(cond)) {                                                                                                 \
+            host_test::fail(__FILE__, __LINE__, #cond);                                                                \
+        }                                                                                                              \
+    } while (0)
+
+#define CHECK_NEAR(a, b, tol)                                                                                          \
+    do {                                                                                                               \
+        double check_a_ = (a), check_b_ = (b);                                                                         \
+        if (!(std::fabs(check_a_ - check_b_) <= (tol))) {                                                              \
+            printf("  %s = %g, %s = %g\n", #a, check_a_, #b, check_b_);                                               \
+            host_test::fail(__FILE__, __LINE__, #a " within " #tol " of " #b);                                         \
+        }                                                                                                              \
+    } while (0)
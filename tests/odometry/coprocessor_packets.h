@@ -0,0 +1,61 @@
+#pragma once
+
+#include <cstring>
+#include <vector>
+
+#include "core/device/vdb/crc32.hpp"
+#include "core/subsystems/odometry/odometry_serial.h"
+
+/**
+ * Packets as an odometry coprocessor sends them to OdometrySerial, encoded for the wire: COBS, then a 0 delimiter
+ */
+namespace coprocessor_packets {
+
+/**
+ * Build a version 1 packet: the 7 pose floats alone
+ * @param pose x, y, rot (deg), speed, accel, ang_speed, ang_accel
+ */
+inline std::vector<uint8_t> v1(const float pose[7]) {
+    std::vector<uint8_t> raw(OdometrySerial::PACKET_SIZE);
+    memcpy(raw.data(), pose, OdometrySerial::PACKET_SIZE);
+    return raw;
+}
+
+/**
+ * Build a version 2 packet: header, the 7 pose floats, the covariance if given, and a CRC32
+ *
+ * @param sequence the packet's sequence number
+ * @param sample_us when the coprocessor measured the pose, on its own clock (us)
+ * @param pose x, y, rot (deg), speed, accel, ang_speed, ang_accel
+ * @param covariance the upper triangle of the pose covariance, 6 floats, or nullptr to leave it out
+ */
+inline std::vector<uint8_t> v2(uint16_t sequence, uint32_t sample_us, const float pose[7], const float *covariance) {
+    size_t len = OdometrySerial::V2_HEADER_SIZE + OdometrySerial::PACKET_SIZE +
+                 (covariance != nullptr ? OdometrySerial::V2_COVARIANCE_SIZE : 0);
+    std::vector<uint8_t> raw(len + OdometrySerial::CRC_SIZE);
+    raw[0] = OdometrySerial::PROTOCOL_V2;
+    raw[1] = covariance != nullptr ? OdometrySerial::V2_FLAG_COVARIANCE : 0;
+    memcpy(&raw[2], &sequence, sizeof(sequence));
+    memcpy(&raw[4], &sample_us, sizeof(sample_us));
+    memcpy(&raw[OdometrySerial::V2_HEADER_SIZE], pose, OdometrySerial::PACKET_SIZE);
+    if (covariance != nullptr) {
+        memcpy(&raw[OdometrySerial::V2_HEADER_SIZE + OdometrySerial::PACKET_SIZE], covariance,
+               OdometrySerial::V2_COVARIANCE_SIZE);
+    }
+    uint32_t crc = CRC32::calculate(raw.data(), len);
+    memcpy(&raw[len], &crc, sizeof(crc));
+    return raw;
+}
+
+/**
+ * COBS encode a packet and add the delimiter, ready to go on the wire
+ */
+inline std::vector<uint8_t> wire(OdometrySerial &odom, const std::vector<uint8_t> &raw) {
+    std::vector<uint8_t> out(raw.size() + raw.size() / 254 + 2);
+    size_t n = odom.cobs_encode(raw.data(), raw.size(), out.data());
+    out.resize(n);
+    out.push_back(0);
+    return out;
+}
+
+} // namespace coprocessor_packets
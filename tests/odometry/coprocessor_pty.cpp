@@ -0,0 +1,151 @@
+// A stand-in odometry coprocessor on the other end of a pty. OdometrySerial talks to it through the SerialService
+// task the same way it would a real one over a smart port: it sends the configuration, and the coprocessor answers
+// with version 2 packets every 10 ms, in real time.
+//
+// The coprocessor's stream has what a real link sees: packets lost on the way, one corrupted, covariance on some,
+// its sequence number wrapping, its microsecond clock wrapping, and a restart part way through that sets both back to
+// zero. The decoded pose, the counts, and the latency estimate are checked as the packets come in.
+
+#include <pty.h>
+#include <termios.h>
+#include <thread>
+#include <unistd.h>
+
+#include "coprocessor_packets.h"
+#include "host_test.h"
+
+namespace {
+
+constexpr int32_t PORT = vex::PORT1;
+constexpr int PACKETS = 150;
+constexpr int PERIOD_MS = 10;
+constexpr int RESTART_AT = 120;                        // the coprocessor restarts before sending this packet
+constexpr uint16_t FIRST_SEQ = 65500;                  // so the sequence number wraps after 36 packets
+constexpr uint32_t CLOCK_START = 0xFFFFFFFFu - 500000; // so the clock wraps after half a second
+
+bool lost(int i) { return i == 30 || i == 31; }
+bool corrupted(int i) { return i == 50; }
+
+/**
+ * Read the configuration packet the brain sends when OdometrySerial starts
+ * @return the decoded packet, empty if it didn't arrive in a second
+ */
+std::vector<uint8_t> read_config(OdometrySerial &odom, int fd) {
+    std::vector<uint8_t> wire;
+    for (int i = 0; i < 1000 && (wire.empty() || wire.back() != 0); i++) {
+        uint8_t buf[64];
+        ssize_t n = read(fd, buf, sizeof(buf));
+        if (n > 0) {
+            wire.insert(wire.end(), buf, buf + n);
+        } else {
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+    }
+    std::vector<uint8_t> config(wire.size() + 8);
+    config.resize(odom.cobs_decode(wire.data(), wire.size(), config.data()));
+    return config;
+}
+
+/**
+ * Send the pose stream: packet i puts the robot at x = i. Each pose is "measured", then sent 1 ms later
+ */
+void coprocessor(OdometrySerial &odom, int fd) {
+    const float cov[6] = {0.5f, 0, 0, 0.5f, 0, 0.01f};
+    auto start = std::chrono::steady_clock::now();
+    auto restart = start;
+    for (int i = 0; i < PACKETS; i++) {
+        std::this_thread::sleep_until(start + std::chrono::milliseconds(i * PERIOD_MS));
+        if (i == RESTART_AT) {
+            restart = std::chrono::steady_clock::now();
+        }
+        uint64_t since_start =
+          std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - restart).count();
+        uint16_t seq = i < RESTART_AT ? (uint16_t)(FIRST_SEQ + i) : (uint16_t)(i - RESTART_AT);
+        uint32_t sample_us = i < RESTART_AT ? (uint32_t)(CLOCK_START + since_start) : (uint32_t)since_start;
+        float pose[7] = {(float)i, 0, 0, 0, 0, 0, 0};
+        std::vector<uint8_t> raw = coprocessor_packets::v2(seq, sample_us, pose, i % 10 == 0 ? cov : nullptr);
+
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        if (lost(i)) {
+            continue;
+        }
+        if (corrupted(i)) {
+            raw[12] ^= 0x40;
+        }
+        std::vector<uint8_t> w = coprocessor_packets::wire(odom, raw);
+        if (write(fd, w.data(), w.size()) != (ssize_t)w.size()) {
+            host_test::fail(__FILE__, __LINE__, "write to the pty");
+        }
+    }
+}
+
+} // namespace
+
+int main() {
+    int master, slave;
+    if (openpty(&master, &slave, nullptr, nullptr, nullptr) != 0) {
+        perror("openpty");
+        sim::finish(1);
+    }
+    // Bytes both ways, no line discipline: no echo, no newline translation
+    termios tio;
+    tcgetattr(slave, &tio);
+    cfmakeraw(&tio);
+    tcsetattr(slave, TCSANOW, &tio);
+    sim::serial_attach(PORT, master);
+
+    OdometrySerial odom(false, false, Pose2d(0, 0, 0), Pose2d(0, 0, 0), PORT, 115200);
+
+    std::vector<uint8_t> config = read_config(odom, slave);
+    CHECK(config.size() == OdometrySerial::CONFIG_SIZE);
+    CHECK(config.size() > 25 && config[25] == OdometrySerial::PROTOCOL_V2);
+
+    std::thread copro(coprocessor, std::ref(odom), slave);
+
+    // Update like the odometry task would, and watch the latency estimate the whole way, across both wraps and the
+    // restart. Nothing in the pipe delays a packet more than a few ms, so the estimate shouldn't either
+    uint32_t decoded = 0;
+    double max_latency = 0, min_latency = 1e9;
+    double last_x = -1;
+    bool went_backwards = false;
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+    while (std::chrono::steady_clock::now() < deadline) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(PERIOD_MS));
+        odom.update();
+        OdometrySerial::serial_stats_t stats = odom.get_stats();
+        decoded += stats.packets_decoded;
+        double x = odom.get_position().x();
+        if (stats.protocol_version == OdometrySerial::PROTOCOL_V2) {
+            max_latency = std::max(max_latency, stats.latency);
+            min_latency = std::min(min_latency, stats.latency);
+            went_backwards |= x < last_x;
+            last_x = x;
+        }
+        if (x == PACKETS - 1) {
+            break;
+        }
+    }
+    copro.join();
+
+    OdometrySerial::serial_stats_t stats = odom.get_stats();
+    printf("decoded %u, corrupt %u, dropped %u, rejected %u\n", decoded, stats.packets_corrupt, stats.packets_dropped,
+           stats.packets_rejected);
+    printf("latency estimate: %.2f ms to %.2f ms, smoothed %.2f ms at the end\n", min_latency * 1000,
+           max_latency * 1000, stats.avg_latency * 1000);
+
+    CHECK(odom.get_position().x() == PACKETS - 1);
+    CHECK(!went_backwards);
+    CHECK(decoded == PACKETS - 3);
+    CHECK(stats.packets_corrupt == 1);
+    // 30, 31 and the corrupted 50. The sequence wrap and the restart aren't losses
+    CHECK(stats.packets_dropped == 3);
+    CHECK(stats.packets_rejected == 0);
+    CHECK(min_latency > 0);
+    CHECK(max_latency < 0.05);
+    CHECK(stats.avg_latency > 0 && stats.avg_latency < 0.05);
+    Eigen::Matrix3d c;
+    CHECK(odom.get_covariance(c));
+    CHECK_NEAR(c(2, 2), 0.01, 1e-6);
+
+    sim::finish(host_test::failures);
+}
@@ -0,0 +1,138 @@
+// Feeds KinematicEstimator poses from known motion and checks the velocity and acceleration it reports: steady
+// motion in any direction, heading wrapping past 180 degrees, uneven time steps, resets, and the +-50 in/s^2 ramps
+// with quantized, noisy positions that it was compared against 10 Hz finite differences on.
+
+#include <random>
+
+#include "core/subsystems/odometry/kinematic_estimator.h"
+#include "host_test.h"
+
+namespace {
+
+constexpr double DT = 0.005; // odometry tick (s)
+
+/**
+ * Steady motion at 30 in/s along a diagonal while facing 90 degrees: the field velocity is the diagonal, the body
+ * velocity is that rotated into the robot's frame, and nothing is accelerating
+ */
+void check_steady_motion() {
+    KinematicEstimator ke;
+    const Translation2d vel(30 * cos(M_PI / 6), 30 * sin(M_PI / 6));
+    ke.reset(Pose2d(0, 0, from_degrees(90)), 0);
+    for (int i = 1; i <= 400; i++) {
+        double t = i * DT;
+        ke.update(Pose2d(vel * t, from_degrees(90)), t);
+    }
+    CHECK_NEAR(ke.speed(), 30, 0.01);
+    CHECK_NEAR(ke.field_velocity().x(), vel.x(), 0.01);
+    CHECK_NEAR(ke.field_velocity().y(), vel.y(), 0.01);
+    // Facing +y, motion along +x is to the robot's right
+    CHECK_NEAR(ke.body_velocity().x(), vel.y(), 0.01);
+    CHECK_NEAR(ke.body_velocity().y(), -vel.x(), 0.01);
+    CHECK_NEAR(ke.accel(), 0, 0.05);
+    CHECK_NEAR(ke.field_accel().norm(), 0, 0.05);
+    CHECK_NEAR(ke.ang_speed_deg(), 0, 1e-6);
+}
+
+/**
+ * Turning counter clockwise at 90 deg/s through 180 degrees, with the time between poses anywhere from 2 to 15 ms
+ */
+void check_heading_wrap() {
+    KinematicEstimator ke;
+    std::mt19937 rng(3);
+    std::uniform_real_distribution<double> step(0.002, 0.015);
+    double t = 0, worst = 0;
+    ke.reset(Pose2d(0, 0, from_degrees(100)), 0);
+    while (t < 3) {
+        t += step(rng);
+        ke.update(Pose2d(0, 0, from_degrees(100 + 90 * t)), t);
+        if (t > 0.5) {
+            worst = std::max(worst, std::fabs(ke.ang_speed_deg() - 90));
+        }
+    }
+    printf("turning through 180 deg at 90 deg/s with uneven steps: worst angular speed error %.3f deg/s\n", worst);
+    CHECK(worst < 1);
+    CHECK_NEAR(ke.ang_accel_deg(), 0, 1);
+    CHECK_NEAR(ke.speed(), 0, 1e-6);
+}
+
+/**
+ * A reset to a far away pose is not motion
+ */
+void check_reset() {
+    KinematicEstimator ke;
+    for (int i = 0; i <= 200; i++) {
+        ke.update(Pose2d(20 * i * DT, 0, 0), i * DT);
+    }
+    CHECK_NEAR(ke.speed(), 20, 0.05);
+    ke.reset(Pose2d(100, 100, from_degrees(45)), 200 * DT);
+    ke.update(Pose2d(100, 100, from_degrees(45)), 201 * DT);
+    CHECK_NEAR(ke.speed(), 0, 1e-6);
+    CHECK_NEAR(ke.accel(), 0, 1e-6);
+    CHECK_NEAR(ke.ang_speed_deg(), 0, 1e-6);
+}
+
+/**
+ * Speed up at 50 in/s^2 for a second, hold, slow down at 50 in/s^2, while turning at 90 deg/s. Positions are
+ * quantized to 0.01 in with 0.01 in of noise. Compared with differencing the positions every 100 ms, which is what
+ * the odometry classes did before
+ */
+void check_ramps() {
+    KinematicEstimator ke;
+    std::mt19937 rng(1);
+    std::normal_distribution<double> noise(0, 0.01);
+    double x = 0, v = 0, th = 170;
+    double fd_last_x = 0, fd_t = 0, fd_speed = 0;
+    double err_kf = 0, err_fd = 0, err_accel = 0;
+    int n = 0, n_accel = 0;
+    for (int i = 0; i <= 600; i++) {
+        double t = i * DT;
+        double a = t < 1 ? 50 : (t < 2 ? 0 : -50);
+        x += v * DT + 0.5 * a * DT * DT;
+        v += a * DT;
+        th += 90 * DT;
+        double measured = std::round((x + noise(rng)) / 0.01) * 0.01;
+        ke.update(Pose2d(measured, 0, from_degrees(th)), t);
+        if (t - fd_t > 0.1) {
+            fd_speed = (measured - fd_last_x) / (t - fd_t);
+            fd_last_x = measured;
+            fd_t = t;
+        }
+        if (t > 0.3) {
+            err_kf += std::fabs(ke.speed() - std::fabs(v));
+            err_fd += std::fabs(fd_speed - std::fabs(v));
+            // Away from where the acceleration steps, and from stopping, where the direction of travel is noise
+            if (std::fabs(t - 1) > 0.3 && std::fabs(t - 2) > 0.3 && v > 5) {
+                err_accel += std::fabs(ke.accel() - a);
+                n_accel++;
+            }
+            n++;
+        }
+    }
+    printf("ramps: mean speed error %.2f in/s filtered, %.2f in/s with 10 Hz differences; mean accel error %.1f "
+           "in/s^2 while moving, away from the steps\n",
+           err_kf / n, err_fd / n, err_accel / n_accel);
+    CHECK(err_kf / n < 1);
+    CHECK(err_kf / n < err_fd / n);
+    CHECK(err_accel / n_accel < 15);
+    CHECK_NEAR(ke.ang_speed_deg(), 90, 2);
+}
+
+} // namespace
+
+int main() {
+    check_steady_motion();
+    check_heading_wrap();
+    check_reset();
+    check_ramps();
+
+    KinematicEstimator ke;
+    int i = 0;
+    double ns = host_test::time_ns(200000, [&] {
+        i++;
+        ke.update(Pose2d(i * 0.1, i * 0.05, from_degrees(i * 0.3)), i * DT);
+    });
+    printf("update: %.0f ns\n", ns);
+
+    sim::finish(host_test::failures);
+}
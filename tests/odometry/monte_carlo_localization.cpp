@@ -0,0 +1,130 @@
+// Drives MonteCarloLocalizer for 20 s around a field with a wall across the middle, over odometry that reads 4% long,
+// with four simulated distance sensors that see something other than a wall 5% of the time. Run at 500, 750 and 1000
+// particles: checks the localizer beats odometry alone and recovers from a wrong starting pose, and prints what an
+// update() costs on average and at worst. Also checks the RangeTable against casting rays directly.
+
+#include <algorithm>
+#include <random>
+
+#include "core/subsystems/odometry/monte_carlo_localizer.h"
+#include "host_test.h"
+#include "scripted_odometry.h"
+
+namespace {
+
+constexpr double DT = 0.005;  // odometry tick (s)
+constexpr int TICKS = 4000;   // 20 s
+constexpr int SETTLE = 500;   // ticks to recover from the wrong starting pose
+constexpr double MARGIN = 24; // the robot turns away from the walls when it gets this close (inch)
+
+std::vector<map_segment_t> field() {
+    std::vector<map_segment_t> walls = RangeTable::field_perimeter(144);
+    walls.push_back({Translation2d(48, 72), Translation2d(96, 72)});
+    walls.push_back({Translation2d(72, 48), Translation2d(72, 60)});
+    return walls;
+}
+
+/**
+ * Looking a range up in the table has to agree with casting the ray, to within what the cell size and angle bins
+ * allow
+ */
+void check_table(const RangeTable &table, const std::vector<map_segment_t> &walls) {
+    std::mt19937 rng(9);
+    std::uniform_real_distribution<double> pos(1, 143), angle(-M_PI, M_PI);
+    std::vector<double> errors;
+    for (int i = 0; i < 20000; i++) {
+        Pose2d from(pos(rng), pos(rng), angle(rng));
+        errors.push_back(std::fabs(table.lookup(from) - RangeTable::cast(walls, from, 100)));
+    }
+    std::sort(errors.begin(), errors.end());
+    double median = errors[errors.size() / 2], p90 = errors[errors.size() * 9 / 10];
+    printf("table vs ray cast: median error %.2f in, 90th percentile %.2f in\n", median, p90);
+    // Half a 2 in cell's diagonal, plus a little for the 4 degree bins
+    CHECK(median < 1.0);
+    CHECK(p90 < 3.0);
+}
+
+typedef struct {
+    double rms_odom, rms_mcl, worst_after_settle, update_avg_us, update_worst_us;
+} run_result_t;
+
+run_result_t run(const RangeTable &table, const std::vector<map_segment_t> &walls, size_t particles) {
+    std::mt19937 rng(2);
+    std::normal_distribution<double> n(0, 1);
+    sim::set_time_us(1000000);
+
+    const Pose2d start(30, 30, 0.0);
+    Pose2d truth = start;
+    auto true_pose = [&] { return truth; };
+    SimulatedRangeSensor front(walls, true_pose, Pose2d(6, 0, 0.0), 0.5, 0.05, 78, 1);
+    SimulatedRangeSensor left(walls, true_pose, Pose2d(0, 6, M_PI / 2), 0.5, 0.05, 78, 2);
+    SimulatedRangeSensor right(walls, true_pose, Pose2d(0, -6, -M_PI / 2), 0.5, 0.05, 78, 3);
+    SimulatedRangeSensor back(walls, true_pose, Pose2d(-6, 0, M_PI), 0.5, 0.05, 78, 4);
+
+    ScriptedOdometry odom;
+    Pose2d odo(0, 0, 0.0);
+    odom.pose = odo;
+    MonteCarloLocalizer::mcl_config_t cfg{particles, 3.0, 5.0, 0.05, 0.05, 0.002, 1.5, 0.02};
+    MonteCarloLocalizer mcl(odom, table, {&front, &left, &right, &back}, cfg, false);
+    // Told the robot is 4 in and 5 degrees from where it is
+    mcl.set_position(Pose2d(33, 27, 0.08));
+
+    run_result_t res{};
+    double se_odom = 0, se_mcl = 0, total_us = 0;
+    for (int k = 0; k < TICKS; k++) {
+        sim::advance_us((uint64_t)(DT * 1e6));
+        double t = k * DT;
+        double v = 25, w = 0.6 * sin(t * 0.5);
+        bool near_wall = truth.x() > 144 - MARGIN || truth.x() < MARGIN || truth.y() > 144 - MARGIN ||
+                         truth.y() < MARGIN;
+        double turn = near_wall ? 0.02 : 0;
+        truth = truth.exp(Twist2d(v * DT, 0, w * DT + turn));
+        odo = odo.exp(Twist2d(v * DT * 1.04 + 0.01 * n(rng), 0.004 * n(rng), (w * DT + turn) * 1.03 + 0.0008 * n(rng)));
+        odom.pose = odo;
+
+        auto before = std::chrono::steady_clock::now();
+        Pose2d est = mcl.update();
+        double us = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - before).count();
+        total_us += us;
+        res.update_worst_us = std::max(res.update_worst_us, us);
+
+        Pose2d odom_field = start + (odo - Pose2d(0, 0, 0.0));
+        double e_odom = odom_field.translation().distance(truth.translation());
+        double e_mcl = est.translation().distance(truth.translation());
+        se_odom += e_odom * e_odom;
+        se_mcl += e_mcl * e_mcl;
+        if (k > SETTLE) {
+            res.worst_after_settle = std::max(res.worst_after_settle, e_mcl);
+        }
+    }
+    res.rms_odom = sqrt(se_odom / TICKS);
+    res.rms_mcl = sqrt(se_mcl / TICKS);
+    res.update_avg_us = total_us / TICKS;
+    printf("%4zu particles: rms error %5.2f in (odometry alone %5.2f), worst after %.1f s %5.2f in, effective "
+           "sample size %4.0f  update %5.1f us average, %6.1f us worst\n",
+           particles, res.rms_mcl, res.rms_odom, SETTLE * DT, res.worst_after_settle, mcl.get_effective_sample_size(),
+           res.update_avg_us, res.update_worst_us);
+    return res;
+}
+
+} // namespace
+
+int main() {
+    sim::use_fake_clock(true);
+
+    std::vector<map_segment_t> walls = field();
+    auto before = std::chrono::steady_clock::now();
+    RangeTable table(walls, 144, 2, 90, 100);
+    printf("table build: %.0f ms\n",
+           std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - before).count());
+    check_table(table, walls);
+
+    for (size_t particles : {500, 750, 1000}) {
+        run_result_t r = run(table, walls, particles);
+        CHECK(r.rms_mcl < 3.0);
+        CHECK(r.rms_mcl < r.rms_odom / 2);
+        CHECK(r.worst_after_settle < 6.0);
+    }
+
+    sim::finish(host_test::failures);
+}
@@ -0,0 +1,136 @@
+// OdometryNWheel with 2 to 6 wheels, double and float, against the class as it was before its kinematics were
+// precomputed (nwheel_reference.h). All three are fed the same random encoder motion: the double path has to track
+// the reference, the float path has to stay close to the double one, and what an update() costs is printed for each.
+//
+// update() also steps the KinematicEstimator, which costs the same in all three, so the difference between the
+// reference and the double path is what precomputing saved.
+
+#include <algorithm>
+#include <random>
+#include <utility>
+
+#include "core/subsystems/odometry/odometry_nwheel.h"
+#include "host_test.h"
+#include "nwheel_reference.h"
+
+namespace {
+
+constexpr int CHECK_TICKS = 4096;
+constexpr int TIMED_TICKS = 40000;
+constexpr int TIMED_ROUNDS = 5;
+
+// Wheels spread around a 3 in circle, each pointing its own way
+template <int N> std::array<tracking_wheel_cfg_t, N> wheel_cfgs() {
+    std::array<tracking_wheel_cfg_t, N> c;
+    for (int i = 0; i < N; i++) {
+        c[i] = {3 * cos(i * 2.1), 3 * sin(i * 2.1), i * 2.1 + M_PI / 2 + 0.3 * i, 1.375};
+    }
+    return c;
+}
+
+template <int N, size_t... I>
+std::array<CustomEncoder, N> make_encoders(vex::triport::port *ports, std::index_sequence<I...>) {
+    return {CustomEncoder(ports[I], 90)...};
+}
+
+template <int N> std::array<CustomEncoder, N> make_encoders(vex::triport::port *ports) {
+    return make_encoders<N>(ports, std::make_index_sequence<N>());
+}
+
+template <int N> struct rig_t {
+    vex::triport::port ref_ports[N], dbl_ports[N], flt_ports[N];
+    ReferenceNWheel<N> ref;
+    OdometryNWheel<N> dbl;
+    OdometryNWheel<N, float> flt;
+
+    rig_t()
+        : ref(make_encoders<N>(ref_ports), wheel_cfgs<N>(), nullptr, false),
+          dbl(make_encoders<N>(dbl_ports), wheel_cfgs<N>(), nullptr, false),
+          flt(make_encoders<N>(flt_ports), wheel_cfgs<N>(), nullptr, false) {}
+
+    // Turn every wheel a random amount, the same on all three
+    void move(std::mt19937 &rng) {
+        std::uniform_real_distribution<double> deg(0, 3);
+        for (int i = 0; i < N; i++) {
+            double d = deg(rng) + i * 0.5;
+            ref_ports[i].sim_deg += d;
+            dbl_ports[i].sim_deg += d;
+            flt_ports[i].sim_deg += d;
+        }
+        sim::advance_us(1000);
+    }
+};
+
+double heading_diff(const Transform2d &a, const Transform2d &b) {
+    return std::fabs((a.rotation() - b.rotation()).radians());
+}
+
+// The best of a few rounds, so a round the OS interrupted doesn't count
+template <int N, typename Odom> double time_updates(Odom &odom, vex::triport::port *ports) {
+    std::mt19937 rng(1);
+    std::uniform_real_distribution<double> deg(0, 3);
+    double best = 1e9;
+    for (int round = 0; round < TIMED_ROUNDS; round++) {
+        best = std::min(best, host_test::time_ns(TIMED_TICKS, [&] {
+            for (int i = 0; i < N; i++) {
+                ports[i].sim_deg += deg(rng) + i * 0.5;
+            }
+            sim::advance_us(1000);
+            odom.update();
+        }));
+    }
+    return best;
+}
+
+template <int N> void run() {
+    rig_t<N> rig;
+    std::mt19937 rng(N);
+
+    // Per tick, so the difference doesn't just measure how far the poses have drifted apart by the end
+    double worst_dbl = 0, worst_flt = 0, worst_flt_rad = 0;
+    for (int k = 0; k < CHECK_TICKS; k++) {
+        Pose2d ref_before = rig.ref.get_position(), dbl_before = rig.dbl.get_position();
+        Pose2d flt_before = rig.flt.get_position();
+        rig.move(rng);
+        Transform2d ref_step = rig.ref.update() - ref_before;
+        Transform2d dbl_step = rig.dbl.update() - dbl_before;
+        Transform2d flt_step = rig.flt.update() - flt_before;
+        worst_dbl = std::max(worst_dbl, ref_step.translation().distance(dbl_step.translation()));
+        worst_flt = std::max(worst_flt, flt_step.translation().distance(dbl_step.translation()));
+        worst_flt_rad = std::max(worst_flt_rad, heading_diff(flt_step, dbl_step));
+    }
+
+    double ref_ns = time_updates<N>(rig.ref, rig.ref_ports);
+    double dbl_ns = time_updates<N>(rig.dbl, rig.dbl_ports);
+    double flt_ns = time_updates<N>(rig.flt, rig.flt_ports);
+    printf("N=%d  update: reference %4.0f ns, double %4.0f ns (%+4.0f), float %4.0f ns (%+4.0f)  |  per tick: double "
+           "vs reference %.1e in, float vs double %.1e in %.1e rad\n",
+           N, ref_ns, dbl_ns, dbl_ns - ref_ns, flt_ns, flt_ns - ref_ns, worst_dbl, worst_flt, worst_flt_rad);
+
+    CHECK(worst_dbl < 1e-9);
+    CHECK(worst_flt < 1e-5);
+    CHECK(worst_flt_rad < 1e-5);
+}
+
+} // namespace
+
+int main() {
+    sim::use_fake_clock(true);
+    sim::set_time_us(1000000);
+
+    KinematicEstimator ke;
+    int tick = 0;
+    double ke_ns = host_test::time_ns(TIMED_TICKS, [&] {
+        tick++;
+        ke.update(Pose2d(tick * 0.1, tick * 0.05, from_degrees(tick * 0.3)), tick * 0.001);
+    });
+    printf("of each update(), about %.0f ns is the KinematicEstimator\n", ke_ns);
+
+    run<2>();
+    run<3>();
+    run<4>();
+    run<5>();
+    run<6>();
+
+    sim::finish(host_test::failures);
+}
@@ -0,0 +1,117 @@
+#pragma once
+
+#include <array>
+
+#include "core/subsystems/custom_encoder.h"
+#include "core/subsystems/odometry/odometry_base.h"
+#include "core/subsystems/odometry/odometry_nwheel.h"
+#include "core/subsystems/odometry/sample_detector.h"
+
+/**
+ * OdometryNWheel as it was before its kinematics were folded into one precomputed matrix: encoders read in radians,
+ * the pseudo-inverse applied to the deltas scaled by a diagonal of the radii, and the new pose built through Pose2d.
+ * Kept as the reference the benchmark compares the current class against.
+ */
+template <int WHEELS> class ReferenceNWheel : public OdometryBase {
+public:
+  ReferenceNWheel(
+    const std::array<CustomEncoder, WHEELS> &encoders, const std::array<tracking_wheel_cfg_t, WHEELS> wheel_configs,
+    vex::inertial *imu, bool is_async
+  )
+      : OdometryBase(is_async), imu(imu), encoders(encoders) {
+    Eigen::Matrix<double, WHEELS, 3> transfer_matrix;
+    for (int i = 0; i < WHEELS; i++) {
+      double x = wheel_configs[i].x;
+      double y = wheel_configs[i].y;
+      double theta_rad = wheel_configs[i].theta_rad;
+      wheel_radii(i) = wheel_configs[i].radius;
+
+      double x_factor = cos(theta_rad);
+      double y_factor = -sin(theta_rad);
+      double theta_factor = -(x * sin(theta_rad)) - (y * cos(theta_rad));
+      if (fabs(y_factor) < 1e-9) {
+        y_factor = 0;
+      }
+      if (fabs(x_factor) < 1e-9) {
+        x_factor = 0;
+      }
+      transfer_matrix.row(i) << x_factor, y_factor, theta_factor;
+    }
+
+    transfer_matrix_pseudoinverse = transfer_matrix.completeOrthogonalDecomposition().pseudoInverse();
+    old_wheel_angles.fill(0);
+  }
+
+  Pose2d update() override {
+    // wheel angles (radians), then the imu rotation (revs)
+    std::array<double, WHEELS + 1> readings;
+    uint32_t imu_timestamp = 0;
+    for (int i = 0; i < WHEELS; i++) {
+      readings[i] = encoders[i].position(rev) * M_PI * 2;
+    }
+    readings[WHEELS] = 0;
+    if (imu != nullptr) {
+      readings[WHEELS] = imu->rotation(vex::rotationUnits::rev);
+      imu_timestamp = imu->timestamp();
+    }
+
+    double sample_time;
+    if (!sample_detector.is_new(readings, imu_timestamp, vexSystemHighResTimeGet() / 1000000.0, sample_time)) {
+      return current_pos;
+    }
+
+    Eigen::Vector<double, WHEELS> radian_deltas;
+    for (int i = 0; i < WHEELS; i++) {
+      radian_deltas(i) = readings[i] - old_wheel_angles[i];
+      old_wheel_angles[i] = readings[i];
+    }
+
+    if (imu != nullptr) {
+      angle = -readings[WHEELS] * 2 * M_PI + angle_offset;
+      if (!has_old_angle) {
+        old_angle = angle;
+        has_old_angle = true;
+      }
+    }
+
+    current_pos = calculate_new_pos(radian_deltas, current_pos);
+    update_kinematics(sample_time);
+
+    if (imu != nullptr) {
+      old_angle = angle;
+    }
+    return current_pos;
+  }
+
+private:
+  Pose2d calculate_new_pos(Eigen::Vector<double, WHEELS> radian_deltas, Pose2d old_pose) {
+    Eigen::Vector3d pose_delta = transfer_matrix_pseudoinverse * (radian_deltas.asDiagonal() * wheel_radii);
+    Eigen::Vector3d old_pose_vector{old_pose.x(), old_pose.y(), old_pose.rotation().radians()};
+    if (imu != nullptr) {
+      pose_delta(2) = angle - old_angle;
+    }
+    Pose2d pose_delta2d(pose_delta);
+    Pose2d old_pose_Pose2d(old_pose_vector);
+
+    Pose2d new_pose = old_pose_Pose2d.exp(pose_delta);
+    if (imu != nullptr) {
+      new_pose = Pose2d(new_pose.translation(), Rotation2d(angle));
+    }
+    return new_pose;
+  }
+
+  // values used for imu integration (radians)
+  double angle = 0;
+  double old_angle = 0;
+  double angle_offset = 0;
+  bool has_old_angle = false;
+
+  vex::inertial *imu;
+
+  Eigen::Matrix<double, 3, WHEELS> transfer_matrix_pseudoinverse;
+
+  std::array<CustomEncoder, WHEELS> encoders;
+  Eigen::Vector<double, WHEELS> wheel_radii;
+  Eigen::Vector<double, WHEELS> old_wheel_angles;
+  SampleDetector<WHEELS + 1> sample_detector;
+};
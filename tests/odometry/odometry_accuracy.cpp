@@ -0,0 +1,277 @@
+// Drives every wheel odometry implementation along known trajectories and compares what it tracks with the truth.
+//
+// Each trajectory is a body twist (forward, left, turn rate) over time, integrated exactly on a 1 ms step. The
+// readings each implementation expects (tracking wheel encoders, an IMU) are synthesized from the motion, optionally
+// with wheel slip, encoder quantization and IMU noise, and update() is run every 10 ms like the background task.
+//
+// With the noise off every implementation has to end up where the robot did. With it on, the error has to stay small,
+// and how it grows over the run is printed along with what an update() costs.
+
+#include <array>
+#include <functional>
+#include <random>
+
+#include "core/subsystems/odometry/odometry_3wheel.h"
+#include "core/subsystems/odometry/odometry_nwheel.h"
+#include "core/subsystems/odometry/odometry_tank.h"
+#include "host_test.h"
+
+namespace {
+
+constexpr double DURATION = 10.0;  // length of each run (s)
+constexpr double SIM_DT = 0.001;   // step of the ground truth (s)
+constexpr int UPDATE_EVERY = 10;   // steps between update() calls
+constexpr int REPORT_EVERY = 2000; // steps between error reports
+
+typedef struct {
+    const char *name;
+    bool holonomic; // needs a robot that can drive sideways
+    std::function<void(double t, double &fwd, double &left, double &omega)> twist;
+} trajectory_t;
+
+typedef struct {
+    bool enabled;
+    double slip;          // stddev of the multiplicative error on each wheel's travel per step
+    double quant_deg;     // encoder resolution (deg)
+    double imu_noise_deg; // stddev of the IMU's heading noise (deg)
+} noise_t;
+
+typedef struct {
+    double final_err;                               // distance from the truth at the end (inch)
+    double final_heading_err_deg;                   // heading error at the end (deg)
+    double err_at[(int)(DURATION * 1000) / REPORT_EVERY]; // distance from the truth every REPORT_EVERY steps (inch)
+    double update_ns;                               // average cost of update()
+} result_t;
+
+std::mt19937 rng;
+std::normal_distribution<double> unit_normal(0, 1);
+
+/**
+ * Drive an odometry along a trajectory
+ *
+ * @param odom the odometry, built with is_async = false
+ * @param imu the IMU it reads, or nullptr
+ * @param traj the trajectory
+ * @param noise the noise to add
+ * @param synth moves the simulated sensors by one step of motion in the robot frame (fwd, left, dtheta)
+ */
+template <typename Odom, typename Synth>
+result_t run(Odom &odom, vex::inertial *imu, const trajectory_t &traj, const noise_t &noise, Synth synth) {
+    rng.seed(7);
+    sim::set_time_us(1000000);
+    Pose2d truth(0, 0, 0);
+    double heading = 0; // unwrapped
+    odom.set_position(truth);
+    odom.update();
+
+    result_t res{};
+    double total_ns = 0;
+    int updates = 0;
+    for (int i = 1; i <= (int)(DURATION / SIM_DT); i++) {
+        double fwd, left, omega;
+        traj.twist(i * SIM_DT, fwd, left, omega);
+        fwd *= SIM_DT;
+        left *= SIM_DT;
+        omega *= SIM_DT;
+        synth(fwd, left, omega);
+
+        truth = truth.exp(Eigen::Vector3d(fwd, left, omega));
+        heading += omega;
+        if (imu != nullptr) {
+            // The real sensor counts clockwise
+            imu->sim_deg = -heading * 180 / M_PI + (noise.enabled ? noise.imu_noise_deg * unit_normal(rng) : 0);
+            imu->sim_timestamp++;
+        }
+        sim::advance_us((uint64_t)(SIM_DT * 1e6));
+
+        if (i % UPDATE_EVERY == 0) {
+            auto start = std::chrono::steady_clock::now();
+            odom.update();
+            total_ns += std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+            updates++;
+        }
+        if (i % REPORT_EVERY == 0) {
+            res.err_at[i / REPORT_EVERY - 1] = odom.get_position().translation().distance(truth.translation());
+        }
+    }
+    Pose2d est = odom.get_position();
+    res.final_err = est.translation().distance(truth.translation());
+    res.final_heading_err_deg = (est.rotation() - Rotation2d(heading)).wrapped_degrees_180();
+    res.update_ns = total_ns / updates;
+    return res;
+}
+
+double slipped(const noise_t &noise, double travel) {
+    return noise.enabled ? travel * (1 + noise.slip * unit_normal(rng)) : travel;
+}
+
+double quantized(const noise_t &noise, double deg) {
+    return noise.enabled ? std::round(deg / noise.quant_deg) * noise.quant_deg : deg;
+}
+
+void report(const char *traj, const char *odom, const noise_t &noise, const result_t &r) {
+    printf("%-14s %-12s %-5s final %7.3f in %8.3f deg  error every 2s:", traj, odom, noise.enabled ? "noisy" : "exact",
+           r.final_err, r.final_heading_err_deg);
+    for (double e : r.err_at) {
+        printf(" %6.3f", e);
+    }
+    printf("  update %6.0f ns\n", r.update_ns);
+
+    // Exact readings have to track the exact motion. Noisy ones are seeded, so their error is repeatable, but it's
+    // only held to being small: 2% slip on every wheel can't be tracked perfectly
+    double tol = noise.enabled ? 2.0 : 0.02;
+    double heading_tol = noise.enabled ? 5.0 : 0.05;
+    CHECK(r.final_err < tol);
+    CHECK(std::fabs(r.final_heading_err_deg) < heading_tol);
+}
+
+void run_all(const trajectory_t &traj, const noise_t &noise) {
+    // Tank drive with tracking wheels 12 in apart, with and without an IMU for heading
+    for (bool use_imu : {false, true}) {
+        if (traj.holonomic) {
+            break;
+        }
+        vex::triport::port lp, rp;
+        CustomEncoder le(lp, 90), re(rp, 90);
+        robot_specs_t specs{};
+        specs.odom_wheel_diam = 2.75;
+        specs.odom_gear_ratio = 1;
+        specs.dist_between_wheels = 12;
+        vex::inertial imu(vex::PORT1);
+        OdometryTank odom(le, re, specs, use_imu ? &imu : nullptr, false);
+        double ld = 0, rd = 0;
+        result_t r = run(odom, use_imu ? &imu : nullptr, traj, noise, [&](double fwd, double, double dth) {
+            ld += slipped(noise, fwd - dth * 6) / (M_PI * 2.75) * 360;
+            rd += slipped(noise, fwd + dth * 6) / (M_PI * 2.75) * 360;
+            lp.sim_deg = quantized(noise, ld);
+            rp.sim_deg = quantized(noise, rd);
+        });
+        report(traj.name, use_imu ? "tank+imu" : "tank", noise, r);
+    }
+
+    // Three tracking wheels: two 10 in apart, and one 3 in behind the center pointing sideways
+    {
+        vex::triport::port lp, rp, op;
+        CustomEncoder le(lp, 90), re(rp, 90), oe(op, 90);
+        Odometry3Wheel::odometry3wheel_cfg_t cfg{10, 3, 2.75};
+        Odometry3Wheel odom(le, re, oe, cfg, false);
+        double ld = 0, rd = 0, od = 0;
+        result_t r = run(odom, nullptr, traj, noise, [&](double fwd, double left, double dth) {
+            ld += slipped(noise, fwd - dth * 5) / 1.375 * 180 / M_PI;
+            rd += slipped(noise, fwd + dth * 5) / 1.375 * 180 / M_PI;
+            od += slipped(noise, -left + dth * 3) / 1.375 * 180 / M_PI;
+            lp.sim_deg = quantized(noise, ld);
+            rp.sim_deg = quantized(noise, rd);
+            op.sim_deg = quantized(noise, od);
+        });
+        report(traj.name, "3wheel", noise, r);
+    }
+
+    // Four tracking wheels at odd angles, with and without an IMU
+    for (bool use_imu : {false, true}) {
+        vex::triport::port p[4];
+        std::array<tracking_wheel_cfg_t, 4> cfgs = {
+          {{0, 5, 0, 1.375}, {0, -5, 0, 1.375}, {-3, 0, M_PI / 2, 1.375}, {3, 2, M_PI / 4, 1.375}}
+        };
+        std::array<CustomEncoder, 4> encs = {
+          CustomEncoder(p[0], 90), CustomEncoder(p[1], 90), CustomEncoder(p[2], 90), CustomEncoder(p[3], 90)
+        };
+        vex::inertial imu(vex::PORT1);
+        OdometryNWheel<4> odom(encs, cfgs, use_imu ? &imu : nullptr, false);
+        double d[4] = {0, 0, 0, 0};
+        result_t r = run(odom, use_imu ? &imu : nullptr, traj, noise, [&](double fwd, double left, double dth) {
+            for (int i = 0; i < 4; i++) {
+                // How far the wheel rolls for this motion of the robot, by the row of the transfer matrix the class
+                // builds for it
+                double th = cfgs[i].theta_rad;
+                double s = cos(th) * fwd - sin(th) * left - (cfgs[i].x * sin(th) + cfgs[i].y * cos(th)) * dth;
+                d[i] += slipped(noise, s) / cfgs[i].radius * 180 / M_PI;
+                p[i].sim_deg = quantized(noise, d[i]);
+            }
+        });
+        report(traj.name, use_imu ? "nwheel4+imu" : "nwheel4", noise, r);
+    }
+}
+
+/**
+ * Encoders that weren't zeroed before the odometry started must not show up as motion
+ */
+void check_unzeroed_encoders() {
+    sim::set_time_us(1000000);
+    {
+        vex::triport::port lp, rp;
+        lp.sim_deg = 1234;
+        rp.sim_deg = -567;
+        CustomEncoder le(lp, 90), re(rp, 90);
+        robot_specs_t specs{};
+        specs.odom_wheel_diam = 2.75;
+        specs.odom_gear_ratio = 1;
+        specs.dist_between_wheels = 12;
+        OdometryTank odom(le, re, specs, nullptr, false);
+        odom.set_position(Pose2d(10, 20, 0));
+        odom.update();
+        lp.sim_deg += 1;
+        sim::advance_us(10000);
+        odom.update();
+        CHECK(odom.get_position().translation().distance(Translation2d(10, 20)) < 0.1);
+    }
+    {
+        vex::triport::port lp, rp, op;
+        lp.sim_deg = 1234;
+        rp.sim_deg = -567;
+        op.sim_deg = 89;
+        CustomEncoder le(lp, 90), re(rp, 90), oe(op, 90);
+        Odometry3Wheel::odometry3wheel_cfg_t cfg{10, 3, 2.75};
+        Odometry3Wheel odom(le, re, oe, cfg, false);
+        odom.set_position(Pose2d(10, 20, 0));
+        odom.update();
+        lp.sim_deg += 1;
+        sim::advance_us(10000);
+        odom.update();
+        CHECK(odom.get_position().translation().distance(Translation2d(10, 20)) < 0.1);
+    }
+}
+
+} // namespace
+
+int main() {
+    sim::use_fake_clock(true);
+
+    std::vector<trajectory_t> trajectories = {
+      {"arc", false,
+       [](double, double &v, double &l, double &w) {
+           v = 40;
+           l = 0;
+           w = 1.0;
+       }},
+      {"s-curve", false,
+       [](double t, double &v, double &l, double &w) {
+           v = 40;
+           l = 0;
+           w = 2.0 * sin(t);
+       }},
+      {"turn-in-place", false,
+       [](double, double &v, double &l, double &w) {
+           v = 0;
+           l = 0;
+           w = 4.0;
+       }},
+      {"strafe-arc", true,
+       [](double t, double &v, double &l, double &w) {
+           v = 20;
+           l = 20 * cos(t);
+           w = 0.8;
+       }},
+    };
+
+    noise_t exact = {false, 0, 0, 0};
+    noise_t noisy = {true, 0.02, 0.25, 0.05};
+    for (const noise_t &noise : {exact, noisy}) {
+        for (const trajectory_t &traj : trajectories) {
+            run_all(traj, noise);
+        }
+    }
+    check_unzeroed_encoders();
+
+    sim::finish(host_test::failures);
+}
@@ -0,0 +1,132 @@
+// Feeds OdometrySerial the packets a coprocessor sends, through the SerialService task, and checks what it decodes:
+// both packet versions, sequence gaps, corrupt and malformed packets, and what decoding costs.
+
+#include <functional>
+#include <thread>
+
+#include "coprocessor_packets.h"
+#include "host_test.h"
+
+namespace {
+
+constexpr int32_t PORT = vex::PORT1;
+
+/**
+ * Wait for the SerialService task to get something done
+ * @return false if it didn't within a second
+ */
+bool wait_for(const std::function<bool()> &done) {
+    for (int i = 0; i < 1000; i++) {
+        if (done()) {
+            return true;
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    return done();
+}
+
+void feed(OdometrySerial &odom, const std::vector<uint8_t> &raw) {
+    std::vector<uint8_t> w = coprocessor_packets::wire(odom, raw);
+    sim::serial_feed(PORT, w.data(), w.size());
+}
+
+bool at_x(OdometrySerial &odom, double x) { return std::fabs(odom.get_position().x() - x) < 1e-4; }
+
+} // namespace
+
+int main() {
+    using namespace coprocessor_packets;
+    OdometrySerial odom(false, false, Pose2d(1, 2, from_degrees(30)), Pose2d(0, 0, 0), PORT, 115200);
+
+    // The configuration goes out first: starting pose, sensor offset, who finds velocity, and the packet version
+    std::vector<uint8_t> sent;
+    CHECK(wait_for([&] {
+        std::vector<uint8_t> more = sim::serial_take_sent(PORT);
+        sent.insert(sent.end(), more.begin(), more.end());
+        return !sent.empty() && sent.back() == 0;
+    }));
+    uint8_t config[OdometrySerial::CONFIG_SIZE + 8];
+    CHECK(odom.cobs_decode(sent.data(), sent.size(), config) == OdometrySerial::CONFIG_SIZE);
+    float start_x, start_rot;
+    memcpy(&start_x, &config[0], sizeof(float));
+    memcpy(&start_rot, &config[8], sizeof(float));
+    CHECK_NEAR(start_x, 1, 1e-6);
+    CHECK_NEAR(start_rot, 30, 1e-4);
+    CHECK(config[25] == OdometrySerial::PROTOCOL_V2);
+
+    // Version 1: the pose alone
+    float pose[7] = {10, 20, 90, 3, 4, 5, 6};
+    feed(odom, v1(pose));
+    CHECK(wait_for([&] { return at_x(odom, 10); }));
+    CHECK_NEAR(odom.get_position().y(), 20, 1e-4);
+    CHECK_NEAR(odom.get_position().rotation().degrees(), 90, 1e-4);
+    CHECK(odom.get_stats().protocol_version == OdometrySerial::PROTOCOL_V1);
+
+    // Version 2, sequence 0 to 9 with 4 lost on the way and 7 corrupted. The last one carries a covariance
+    const float cov[6] = {1, 0.1f, 0.2f, 2, 0.3f, 3};
+    for (uint16_t seq = 0; seq < 10; seq++) {
+        if (seq == 4) {
+            continue;
+        }
+        pose[0] = seq;
+        std::vector<uint8_t> raw = v2(seq, 1000 + seq * 10000, pose, seq == 9 ? cov : nullptr);
+        if (seq == 7) {
+            raw[10] ^= 1;
+        }
+        feed(odom, raw);
+    }
+    CHECK(wait_for([&] { return at_x(odom, 9); }));
+    OdometrySerial::serial_stats_t stats = odom.get_stats();
+    CHECK(stats.protocol_version == OdometrySerial::PROTOCOL_V2);
+    CHECK(stats.packets_corrupt == 1);
+    CHECK(stats.packets_dropped == 2); // 4, and 7 which never arrived intact
+    CHECK(stats.packets_rejected == 0);
+    Eigen::Matrix3d c;
+    CHECK(odom.get_covariance(c));
+    CHECK_NEAR(c(2, 1), 0.3, 1e-6);
+    CHECK_NEAR(c(1, 2), 0.3, 1e-6);
+
+    // Malformed packets are counted and don't move the pose: a repeat, a bad length, a NaN and plain garbage
+    feed(odom, v2(9, 91000, pose, cov));
+    std::vector<uint8_t> short_v2 = v2(10, 101000, pose, nullptr);
+    short_v2.resize(short_v2.size() - 3);
+    feed(odom, short_v2);
+    float nan_pose[7] = {NAN, 0, 0, 0, 0, 0, 0};
+    feed(odom, v1(nan_pose));
+    std::vector<uint8_t> garbage(40);
+    for (size_t i = 0; i < garbage.size(); i++) {
+        garbage[i] = (uint8_t)(i * 37 + 1);
+    }
+    feed(odom, garbage);
+    CHECK(wait_for([&] { return odom.get_stats().packets_rejected == 4; }));
+    CHECK(at_x(odom, 9));
+
+    // Cost: a burst of packets, decoded as fast as the service task can take them. update() publishes the counts
+    // since the last update(), so start counting from here
+    odom.update();
+    const int BURST = 2000;
+    std::vector<uint8_t> burst;
+    for (int i = 0; i < BURST; i++) {
+        pose[0] = 100 + i;
+        std::vector<uint8_t> w = wire(odom, v2(10 + i, 200000 + i * 10000, pose, nullptr));
+        burst.insert(burst.end(), w.begin(), w.end());
+    }
+    auto start = std::chrono::steady_clock::now();
+    sim::serial_feed(PORT, burst.data(), burst.size());
+    CHECK(wait_for([&] { return at_x(odom, 100 + BURST - 1); }));
+    double wall_us = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count();
+    odom.update();
+    stats = odom.get_stats();
+    CHECK(stats.packets_decoded == BURST);
+    CHECK(stats.packets_dropped == 2);
+    printf("decoded %u packets: %.2f us each in the handler, %.2f us each through the service task\n",
+           stats.packets_decoded, (double)stats.parse_time_us / stats.packets_decoded, wall_us / BURST);
+
+    std::vector<uint8_t> w = wire(odom, v2(1, 1, pose, cov));
+    uint8_t out[OdometrySerial::MAX_PACKET_SIZE + 8];
+    volatile size_t sink = 0;
+    double cobs_ns = host_test::time_ns(200000, [&] { sink += odom.cobs_decode(w.data(), w.size(), out); });
+    printf("cobs_decode of a %zu byte packet: %.0f ns\n", w.size(), cobs_ns);
+
+    sim::finish(host_test::failures);
+}
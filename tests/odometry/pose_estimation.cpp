@@ -0,0 +1,188 @@
+// Drives PoseEstimator for 15 s over wheel odometry that reads 3% long and turns 2% fast, with an IMU, a pose from a
+// coprocessor that arrives 60 ms late every 100 ms, and a distance sensor to the field wall that sometimes sees a
+// robot instead. Checks the fused estimate beats odometry alone and that the bad ranges are thrown out, and prints
+// what an update() costs with and without measurements to apply. Also polls, every 2 ms, wheel odometry that only has
+// a new sample every 10 ms, which has to give a steady speed rather than empty polls followed by bursts.
+
+#include <deque>
+#include <random>
+
+#include "core/subsystems/odometry/pose_estimator.h"
+#include "host_test.h"
+#include "scripted_odometry.h"
+
+namespace {
+
+constexpr double DT = 0.005;     // odometry tick (s)
+constexpr int TICKS = 3000;      // 15 s
+constexpr int POSE_LAG = 12;     // ticks between a coprocessor pose being measured and arriving
+constexpr int POSE_EVERY = 20;   // ticks between coprocessor poses
+constexpr int RANGE_EVERY = 10;  // ticks between ranges
+constexpr int GARBAGE_EVERY = 7; // every this many ranges, the sensor sees a robot 10 in away instead of the wall
+
+/**
+ * Wheel odometry driving straight at a constant speed, whose sensors only have a new sample every 10 ms. Reports its
+ * samples through update_kinematics() like the real implementations
+ */
+class SampledOdometry : public OdometryBase {
+  public:
+    SampledOdometry(double speed) : OdometryBase(false), vel(speed) {}
+
+    Pose2d update() override {
+        double now = vexSystemHighResTimeGet() / 1e6;
+        if (now - last_sample < 0.01 - 1e-9) {
+            return current_pos;
+        }
+        last_sample = now;
+        current_pos = Pose2d(vel * now, 0, 0.0);
+        update_kinematics(now);
+        return current_pos;
+    }
+
+  private:
+    double vel;
+    double last_sample = -1;
+};
+
+typedef struct {
+    double rms_odom, rms_est, worst_est, heading_err_deg;
+    uint32_t garbage_ranges;
+    double update_us;
+} run_result_t;
+
+run_result_t run(bool with_pose, bool with_ranges) {
+    std::mt19937 rng(1);
+    std::normal_distribution<double> n(0, 1);
+    sim::set_time_us(1000000);
+
+    ScriptedOdometry odom;
+    vex::inertial imu(vex::PORT1);
+    PoseEstimator::pose_estimator_config_t cfg{0.5, 2.0, 0.5, 6.0, 0.5, 144.0};
+    PoseEstimator pe(odom, &imu, cfg, false);
+
+    const Pose2d start(72, 72, 0.0);
+    Pose2d truth = start;
+    pe.set_position(truth);
+    Pose2d odo(0, 0, 0.0);
+    odom.pose = odo;
+    pe.update();
+
+    std::deque<std::pair<double, Pose2d>> history;
+    run_result_t res{};
+    double se_odom = 0, se_est = 0, total_us = 0;
+    for (int k = 0; k < TICKS; k++) {
+        sim::advance_us((uint64_t)(DT * 1e6));
+        double t = vexSystemHighResTimeGet() / 1e6;
+        double v = 30, w = 1.0 + 0.3 * sin(t * 0.7);
+        truth = truth.exp(Twist2d(v * DT, 0, w * DT));
+        odo = odo.exp(Twist2d(v * DT * 1.03 + 0.01 * n(rng), 0.005 * n(rng), w * DT * 1.02 + 0.0005 * n(rng)));
+        odom.pose = odo;
+
+        // The IMU updates every 10 ms, counting clockwise
+        if (k % 2 == 0) {
+            imu.sim_timestamp += 10;
+            imu.sim_deg = -truth.rotation().degrees() + 0.3 * n(rng);
+        }
+
+        history.push_back({t, truth});
+        if (history.size() > POSE_LAG + 1) {
+            history.pop_front();
+        }
+        if (with_pose && k % POSE_EVERY == 0 && history.size() > POSE_LAG) {
+            const std::pair<double, Pose2d> &m = history.front();
+            Pose2d noisy(
+              m.second.x() + 1.0 * n(rng), m.second.y() + 1.0 * n(rng), m.second.rotation().radians() + 0.03 * n(rng)
+            );
+            pe.add_pose_measurement(noisy, m.first, 1.0, 2.0);
+        }
+
+        if (with_ranges && k % RANGE_EVERY == 5) {
+            // Pointing out the left side, 5 in from the center
+            Pose2d offset(0, 5, M_PI / 2);
+            double range = PoseEstimator::range_to_walls(truth + Transform2d(offset.translation(), offset.rotation()),
+                                                         144) +
+                           0.3 * n(rng);
+            if ((k / RANGE_EVERY) % GARBAGE_EVERY == 0) {
+                range = 10;
+                res.garbage_ranges++;
+            }
+            pe.add_range_measurement(range, t, offset, 0.5);
+        }
+
+        auto before = std::chrono::steady_clock::now();
+        Pose2d est = pe.update();
+        total_us += std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - before).count();
+
+        Pose2d odom_field = start + (odo - Pose2d(0, 0, 0.0));
+        double e_odom = odom_field.translation().distance(truth.translation());
+        double e_est = est.translation().distance(truth.translation());
+        se_odom += e_odom * e_odom;
+        se_est += e_est * e_est;
+        res.worst_est = std::max(res.worst_est, e_est);
+    }
+    res.rms_odom = sqrt(se_odom / TICKS);
+    res.rms_est = sqrt(se_est / TICKS);
+    res.heading_err_deg = (pe.get_position().rotation() - truth.rotation()).wrapped_degrees_180();
+    res.update_us = total_us / TICKS;
+
+    PoseEstimator::estimator_stats_t stats = pe.get_estimator_stats();
+    printf("poses %-3s ranges %-3s  rms error %5.2f in (odometry alone %5.2f), worst %5.2f in, heading %6.2f deg  "
+           "applied %4u rejected %3u dropped %u  update %5.2f us\n",
+           with_pose ? "on" : "off", with_ranges ? "on" : "off", res.rms_est, res.rms_odom, res.worst_est,
+           res.heading_err_deg, stats.applied, stats.rejected, stats.dropped, res.update_us);
+    if (with_ranges) {
+        // Every range that saw a robot is thrown out, and nothing else is
+        CHECK(stats.rejected == res.garbage_ranges);
+    }
+    return res;
+}
+
+void check_sampled_odometry() {
+    sim::set_time_us(1000000);
+    SampledOdometry odom(30);
+    PoseEstimator::pose_estimator_config_t cfg{0.5, 2.0, 0.5, 6.0, 0.5, 144.0};
+    PoseEstimator pe(odom, nullptr, cfg, false);
+    pe.set_position(Pose2d(30, 0, 0.0));
+
+    double worst_speed = 0, worst_accel = 0;
+    int samples = 0;
+    for (int k = 0; k < 1000; k++) {
+        double before = pe.get_sample_time();
+        pe.update();
+        if (pe.get_sample_time() != before) {
+            samples++;
+        }
+        if (k > 250) {
+            worst_speed = std::max(worst_speed, std::fabs(pe.speed - 30));
+            worst_accel = std::max(worst_accel, std::fabs(pe.accel));
+        }
+        sim::advance_us(2000);
+    }
+    printf("2 ms polls of 10 ms samples: %d of 1000 updates were samples, worst speed error %.3f in/s, worst accel "
+           "%.3f in/s^2\n",
+           samples, worst_speed, worst_accel);
+    CHECK(samples == 200);
+    CHECK(worst_speed < 0.5);
+    CHECK(worst_accel < 5);
+}
+
+} // namespace
+
+int main() {
+    sim::use_fake_clock(true);
+
+    run_result_t imu_only = run(false, false);
+    CHECK(std::fabs(imu_only.heading_err_deg) < 1);
+
+    run_result_t ranges = run(false, true);
+    CHECK(ranges.rms_est < ranges.rms_odom);
+
+    run_result_t all = run(true, true);
+    CHECK(all.rms_est < 1.0);
+    CHECK(all.rms_est < all.rms_odom / 4);
+    CHECK(std::fabs(all.heading_err_deg) < 1);
+
+    check_sampled_odometry();
+
+    sim::finish(host_test::failures);
+}
@@ -0,0 +1,18 @@
+#pragma once
+
+#include "core/subsystems/odometry/odometry_base.h"
+
+/**
+ * Wheel odometry that reports whatever pose the test sets, for driving the estimators that wrap an OdometryBase
+ */
+class ScriptedOdometry : public OdometryBase {
+  public:
+    ScriptedOdometry() : OdometryBase(false) {}
+
+    Pose2d update() override {
+        current_pos = pose;
+        return pose;
+    }
+
+    Pose2d pose; ///< what the next update() reports
+};
@@ -0,0 +1,93 @@
+// The compile time paths and profiles in baked_path.h against the runtime functions they copy: a five knot route
+// through Baked::hermite and Baked::inject, and trapezoidal and triangular Baked::trapezoid profiles, all baked into
+// constexpr variables here. Also checks the constexpr sqrt, sin and cos against <cmath>, and prints what building the
+// same route costs at runtime.
+
+#include <algorithm>
+
+#include "core/utils/baked_path.h"
+#include "host_test.h"
+
+using namespace PurePursuit;
+
+namespace {
+
+constexpr std::array<hermite_point, 5> KNOTS = {
+  {{12, 12, 0, 40}, {48, 24, 0.5, 40}, {72, 60, M_PI / 2, 40}, {60, 96, 2.5, 40}, {24, 108, M_PI, 40}}};
+constexpr auto CURVE = Baked::hermite<20>(KNOTS);
+constexpr auto ROUTE = Baked::inject<400>(CURVE, 1.0);
+constexpr auto TRAPEZOID = Baked::trapezoid<200>(0, 48, 60, 80, 100, 0.01);
+// Too short to reach v_max, and backwards
+constexpr auto TRIANGLE = Baked::trapezoid<100>(10, -2, 60, 80, 100, 0.01);
+
+static_assert(CURVE.size == 81, "the curve is baked while compiling");
+static_assert(ROUTE.size > CURVE.size, "the route is baked while compiling");
+
+void check_math() {
+    double worst_trig = 0, worst_sqrt = 0;
+    for (double x = -20; x < 20; x += 0.001) {
+        worst_trig = std::max({worst_trig, std::fabs(Baked::sin(x) - ::sin(x)), std::fabs(Baked::cos(x) - ::cos(x))});
+    }
+    for (double x = 1e-6; x < 1e6; x *= 1.01) {
+        worst_sqrt = std::max(worst_sqrt, std::fabs(Baked::sqrt(x) - ::sqrt(x)) / ::sqrt(x));
+    }
+    printf("constexpr math vs <cmath>: sin and cos %.1e, sqrt %.1e relative\n", worst_trig, worst_sqrt);
+    CHECK(worst_trig < 1e-14);
+    CHECK(worst_sqrt < 1e-15);
+    CHECK(Baked::ceil(2.0) == 2 && Baked::ceil(2.1) == 3 && Baked::ceil(-2.5) == -2);
+}
+
+template <size_t N> double worst_difference(const Baked::path_t<N> &baked, const std::vector<Translation2d> &runtime) {
+    double worst = 0;
+    for (size_t i = 0; i < baked.size && i < runtime.size(); i++) {
+        worst = std::max(worst, runtime[i].distance(Translation2d(baked.points[i].x, baked.points[i].y)));
+    }
+    return worst;
+}
+
+void check_paths() {
+    std::vector<hermite_point> knots(KNOTS.begin(), KNOTS.end());
+    std::vector<Translation2d> curve = smooth_path_hermite(knots, 20);
+    std::vector<Translation2d> route = inject_path(curve, 1.0);
+    double curve_diff = worst_difference(CURVE, curve), route_diff = worst_difference(ROUTE, route);
+    printf("hermite: %zu points, worst difference %.1e in  |  inject: %zu points, worst difference %.1e in\n",
+           CURVE.size, curve_diff, ROUTE.size, route_diff);
+    CHECK(CURVE.size == curve.size());
+    CHECK(ROUTE.size == route.size());
+    CHECK(curve_diff < 1e-12);
+    CHECK(route_diff < 1e-12);
+    CHECK(ROUTE.to_vector().size() == route.size());
+
+    std::vector<Translation2d> built;
+    double runtime_us = host_test::time_ns(1000, [&] { built = inject_path(smooth_path_hermite(knots, 20), 1.0); });
+    printf("building the route at runtime: %.1f us; baked, it's %zu bytes of constant data\n", runtime_us / 1000,
+           sizeof(ROUTE));
+}
+
+template <size_t N> int count_differences(const std::array<motion_t, N> &baked, TrapezoidProfile profile) {
+    int differ = 0;
+    for (size_t i = 0; i < N; i++) {
+        motion_t m = profile.calculate(i * 0.01);
+        differ += m.pos != baked[i].pos || m.vel != baked[i].vel || m.acc != baked[i].acc;
+    }
+    return differ;
+}
+
+void check_profiles() {
+    int trapezoid = count_differences(TRAPEZOID, TrapezoidProfile(0, 48, 60, 80, 100));
+    int triangle = count_differences(TRIANGLE, TrapezoidProfile(10, -2, 60, 80, 100));
+    printf("trapezoid: %d of %zu samples differ; triangle: %d of %zu\n", trapezoid, TRAPEZOID.size(), triangle,
+           TRIANGLE.size());
+    CHECK(trapezoid == 0);
+    CHECK(triangle == 0);
+}
+
+} // namespace
+
+int main() {
+    check_math();
+    check_paths();
+    check_profiles();
+
+    sim::finish(host_test::failures);
+}
@@ -0,0 +1,191 @@
+// DriveRecordingCodec on a minute of synthetic joystick driving: every sample has to come back to within its rounding,
+// bytes that stop partway through a sample must not decode, and the size and cost per sample are printed. Then a
+// scripted 6 s drive is recorded in real time onto the stand-in SD card, with every append taking 15 ms like a slow
+// card, and replayed on motors at 85% strength with and without the correction toward the recorded pose.
+
+#include <algorithm>
+#include <mutex>
+#include <random>
+#include <thread>
+
+#include "core/utils/drive_recording.h"
+#include "host_test.h"
+
+namespace {
+
+const char *const FILENAME = "rec.bin";
+constexpr double TRACK_WIDTH = 12;
+constexpr double TOP_SPEED = 60; // at 12V (inch/s)
+
+/**
+ * A tank drive that moves as fast as its motor voltages say, times a strength, with perfect odometry
+ */
+class SimulatedDrive : public OdometryBase {
+  public:
+    SimulatedDrive(vex::motor_group &left, vex::motor_group &right) : OdometryBase(false), left(left), right(right) {}
+
+    Pose2d update() override { return get_position(); }
+
+    Pose2d get_position() override {
+        std::lock_guard<std::mutex> lock(mut);
+        return pose;
+    }
+
+    void set_position(const Pose2d &newpos) override {
+        std::lock_guard<std::mutex> lock(mut);
+        pose = newpos;
+    }
+
+    void step(double dt) {
+        std::lock_guard<std::mutex> lock(mut);
+        double vl = left.sim_voltage / 12 * TOP_SPEED * strength, vr = right.sim_voltage / 12 * TOP_SPEED * strength;
+        pose = pose.exp(Twist2d((vl + vr) / 2 * dt, 0, (vr - vl) / TRACK_WIDTH * dt));
+    }
+
+    std::atomic<double> strength{1.0};
+
+  private:
+    vex::motor_group &left, &right;
+    std::mutex mut;
+    Pose2d pose{24, 24, 0.0};
+};
+
+void check_codec() {
+    const int SAMPLES = 6000; // a minute at 10 ms
+    std::mt19937 rng(1);
+    std::normal_distribution<double> n(0, 1);
+    DriveRecordingCodec encoder;
+    std::vector<uint8_t> stream;
+    std::vector<drive_sample_t> truth;
+    double l = 0, r = 0;
+    Pose2d pose(24, 24, 0.0);
+    for (int k = 0; k < SAMPLES; k++) {
+        // The joystick moves at 50 Hz, in 1/127 steps, and sits still a fifth of the time
+        if (k % 5 == 0) {
+            l = std::clamp(l + round(n(rng) * 3) / 127, -1.0, 1.0);
+            r = std::clamp(r + round(n(rng) * 3) / 127, -1.0, 1.0);
+            if (k % 1500 < 300) {
+                l = r = 0;
+            }
+        }
+        double vl = l * TOP_SPEED, vr = r * TOP_SPEED;
+        pose = pose.exp(Twist2d((vl + vr) / 2 * 0.01, 0, (vr - vl) / TRACK_WIDTH * 0.01));
+        truth.push_back({l, r, pose});
+        uint8_t bytes[DriveRecordingCodec::MAX_SAMPLE_BYTES];
+        size_t len = encoder.encode(truth.back(), bytes);
+        stream.insert(stream.end(), bytes, bytes + len);
+    }
+
+    DriveRecordingCodec decoder;
+    size_t pos = 0;
+    int decoded = 0;
+    double worst_pos = 0, worst_deg = 0, worst_cmd = 0;
+    drive_sample_t s;
+    while (size_t len = decoder.decode(&stream[pos], stream.size() - pos, s)) {
+        pos += len;
+        const drive_sample_t &t = truth[decoded++];
+        worst_pos = std::max(worst_pos, t.pose.translation().distance(s.pose.translation()));
+        worst_deg = std::max(worst_deg, std::fabs((t.pose.rotation() - s.pose.rotation()).wrapped_degrees_180()));
+        worst_cmd = std::max({worst_cmd, std::fabs(t.left - s.left), std::fabs(t.right - s.right)});
+    }
+
+    // Given one byte more at a time, a sample only decodes once all of it is there
+    DriveRecordingCodec partial;
+    bool partial_ok = true;
+    pos = 0;
+    for (int k = 0; k < 200; k++) {
+        size_t len = 0;
+        for (size_t have = 0; have <= DriveRecordingCodec::MAX_SAMPLE_BYTES && len == 0; have++) {
+            len = partial.decode(&stream[pos], std::min(have, stream.size() - pos), s);
+        }
+        partial_ok &= len > 0 && s.pose.translation().distance(truth[k].pose.translation()) < 1;
+        pos += len;
+    }
+
+    DriveRecordingCodec timed;
+    volatile size_t sink = 0;
+    int i = 0;
+    double encode_ns = host_test::time_ns(50 * SAMPLES, [&] {
+        uint8_t bytes[DriveRecordingCodec::MAX_SAMPLE_BYTES];
+        sink = sink + timed.encode(truth[i++ % SAMPLES], bytes);
+    });
+
+    printf("codec: %d of %d decoded, %zu bytes a minute (%.2f a sample), encode %.0f ns  |  worst position %.4f in, "
+           "heading %.3f deg, command %.4f\n",
+           decoded, SAMPLES, stream.size(), (double)stream.size() / SAMPLES, encode_ns, worst_pos, worst_deg,
+           worst_cmd);
+    CHECK(decoded == SAMPLES);
+    CHECK(worst_pos <= 0.5 / DriveRecordingCodec::POSITION_UNITS * sqrt(2) + 1e-9);
+    CHECK(worst_deg <= 0.5 / DriveRecordingCodec::HEADING_UNITS + 1e-9);
+    CHECK(worst_cmd <= 0.5 / DriveRecordingCodec::COMMAND_UNITS + 1e-9);
+    CHECK(partial_ok);
+    CHECK(stream.size() < SAMPLES * 4);
+}
+
+void check_record_and_replay() {
+    vex::motor_group left, right;
+    robot_specs_t specs{};
+    SimulatedDrive sim_drive(left, right);
+    TankDrive drive(left, right, specs, &sim_drive);
+
+    std::atomic<bool> running{true};
+    std::thread physics([&] {
+        while (running) {
+            sim_drive.step(0.002);
+            std::this_thread::sleep_for(std::chrono::milliseconds(2));
+        }
+    });
+
+    sim::set_sd_write_delay_ms(15);
+    size_t appends_before = sim::sd_appends();
+    DriveRecorder recorder(drive, FILENAME);
+    CHECK(recorder.start());
+    auto start = std::chrono::steady_clock::now();
+    for (double t = 0; t < 6; t = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count()) {
+        // The driver's hand is never quite still, which fills a chunk before the end
+        double forward = (t < 1.5 ? 0.6 : t < 3 ? 0.4 : t < 4.5 ? 0.7 : 0.0) + 0.1 * sin(t * 11);
+        double turn = (t > 1.5 && t < 3 ? 0.3 : 0) + 0.1 * sin(t * 13);
+        recorder.drive_arcade(forward, turn);
+        std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    }
+    recorder.stop();
+    Pose2d recorded_end = sim_drive.get_position();
+    printf("recorded %zu samples in %zu bytes with %zu appends; a sample took %.1f us on average, %u us at worst\n",
+           recorder.num_samples(), recorder.num_bytes(), sim::sd_appends() - appends_before, recorder.mean_sample_us(),
+           recorder.max_sample_us());
+    CHECK(recorder.num_samples() > 550 && recorder.num_samples() < 650);
+    CHECK(sim::sd_appends() - appends_before >= 2);
+    CHECK((size_t)vex::brain::sdcard().size(FILENAME) >= recorder.num_bytes());
+    // The 15 ms appends, one of them while recording, happen on the writer task and never hold up a sample
+    CHECK(recorder.max_sample_us() < 5000);
+
+    double blind_in = 0, corrected_in = 0;
+    for (double gain : {0.0, 1.0}) {
+        sim_drive.set_position(Pose2d(24, 24, 0.0));
+        sim_drive.strength = 0.85;
+        ReplayCommand replay(drive, FILENAME, {0.05 * gain, 0.05 * gain, 1.0 * gain});
+        while (!replay.run()) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(5));
+        }
+        Pose2d end = sim_drive.get_position();
+        double off_in = end.translation().distance(recorded_end.translation());
+        double off_deg = std::fabs((end.rotation() - recorded_end.rotation()).wrapped_degrees_180());
+        printf("replayed on 85%% motors %s correction: ends %.2f in and %.1f deg off\n", gain > 0 ? "with" : "without",
+               off_in, off_deg);
+        (gain > 0 ? corrected_in : blind_in) = off_in;
+    }
+    CHECK(blind_in > 5);
+    CHECK(corrected_in < 1);
+
+    running = false;
+    physics.join();
+}
+
+} // namespace
+
+int main() {
+    check_codec();
+    check_record_and_replay();
+
+    sim::finish(host_test::failures);
+}
@@ -0,0 +1,167 @@
+// FieldMap on a field with a goal, a triangle, a hexagon and two thin barriers, one of them half a cell off the
+// distance field grid. Checks the blended distance stays within half a cell diagonal of the exact one, that is_clear()
+// for points and straight moves agrees with a brute force check against every edge, most of all across the barriers
+// where the blend reads half an inch of room on top of them, that cast() agrees with RangeTable::cast, and that a map
+// survives a blob round trip. What each query costs is printed.
+
+#include <algorithm>
+#include <random>
+
+#include "core/subsystems/odometry/monte_carlo_localizer.h"
+#include "core/utils/field_map.h"
+#include "host_test.h"
+#include "scalar_geometry.h"
+
+namespace {
+
+// Closer than this to the radius, the brute force check and FieldMap can round either way
+constexpr double ROUNDING = 1e-9;
+
+const std::vector<FieldMap::element_t> ELEMENTS = {
+  {{66, 66}, {78, 66}, {78, 78}, {66, 78}},
+  {{20, 100}, {40, 100}, {30, 120}},
+  {{110, 30}, {120, 24}, {130, 30}, {130, 42}, {120, 48}, {110, 42}},
+  {{30, 72.5}, {54, 72.5}},
+  {{100, 90}, {100, 130}},
+};
+
+/**
+ * How far a circle moving from a to b gets from every edge, by checking each one. Negative if a is inside an element
+ * or off the field
+ */
+double brute_force_room(const FieldMap &map, const std::vector<map_segment_t> &segments, const Translation2d &a,
+                        const Translation2d &b) {
+    double room = std::min(map.exact_distance(a), map.exact_distance(b));
+    for (const map_segment_t &s : segments) {
+        room = std::min(room, ScalarGeometry::segment_segment_dist(a, b, s.start, s.end));
+    }
+    return room;
+}
+
+void check_barrier() {
+    FieldMap map(ELEMENTS);
+    // On the barrier, which runs between the rows of the distance field
+    Translation2d on(40.5, 72.5);
+    printf("on the barrier: distance() %.3f in, exact %.3f in\n", map.distance(on), map.exact_distance(on));
+    CHECK(!map.is_clear(on, 0.3));
+    CHECK(!map.is_clear(Translation2d(40.5, 60), Translation2d(40.5, 85), 0.3));
+    CHECK(!map.is_clear(Translation2d(40.5, 60), Translation2d(40.5, 85), 0));
+    // Right past its end, or alongside it, there is room
+    CHECK(map.is_clear(Translation2d(54.5, 60), Translation2d(54.5, 85), 0.3));
+    CHECK(map.is_clear(Translation2d(25, 73), Translation2d(60, 73), 0.3));
+}
+
+void check_random(double resolution) {
+    FieldMap map(ELEMENTS, 144, resolution);
+    std::vector<map_segment_t> segments = map.get_segments();
+    std::mt19937 rng(3);
+    std::uniform_real_distribution<double> u(-2, 146), unit(0, 1);
+
+    double worst_blend = 0, sum_blend = 0;
+    int point_differ = 0;
+    const int POINTS = 100000;
+    for (int i = 0; i < POINTS; i++) {
+        Translation2d p(u(rng), u(rng));
+        double exact = map.exact_distance(p);
+        double blend = std::fabs(map.distance(p) - exact);
+        worst_blend = std::max(worst_blend, blend);
+        sum_blend += blend;
+        double r = unit(rng) * 3;
+        point_differ += std::fabs(exact - r) > ROUNDING && map.is_clear(p, r) != (exact >= r);
+    }
+
+    // Short moves anywhere on the field and a little past it, so about half of them are clear
+    const int MOVES = 20000;
+    int move_differ = 0, clear = 0;
+    for (int i = 0; i < MOVES; i++) {
+        Translation2d a(u(rng), u(rng));
+        Translation2d b = a + Translation2d(unit(rng) * 40 - 20, unit(rng) * 40 - 20);
+        double r = unit(rng) * 9;
+        double room = brute_force_room(map, segments, a, b);
+        if (std::fabs(room - r) > ROUNDING) {
+            move_differ += map.is_clear(a, b, r) != (room >= r);
+            clear += room >= r;
+        }
+    }
+
+    printf("%.0f in cells: blend error mean %.4f in, worst %.3f in (half a diagonal %.3f)  |  is_clear differs from "
+           "brute force on %d of %d points, %d of %d moves (%d clear)\n",
+           resolution, sum_blend / POINTS, worst_blend, resolution * M_SQRT1_2, point_differ, POINTS, move_differ,
+           MOVES, clear);
+    CHECK(worst_blend <= resolution * M_SQRT1_2);
+    CHECK(point_differ == 0);
+    CHECK(move_differ == 0);
+}
+
+void check_cast() {
+    FieldMap map(ELEMENTS);
+    std::vector<map_segment_t> segments = map.get_segments();
+    std::mt19937 rng(5);
+    std::uniform_real_distribution<double> u(0, 144), angle(-M_PI, M_PI);
+
+    const int RAYS = 50000;
+    std::vector<Pose2d> rays;
+    int differ = 0;
+    for (int i = 0; i < RAYS; i++) {
+        rays.push_back(Pose2d(u(rng), u(rng), angle(rng)));
+        differ += std::fabs(map.cast(rays.back(), 200) - RangeTable::cast(segments, rays.back(), 200)) > 1e-9;
+    }
+
+    volatile double sink = 0;
+    int k = 0;
+    double cast_ns = host_test::time_ns(RAYS, [&] { sink = sink + map.cast(rays[k++ % RAYS], 200); });
+    double brute_ns = host_test::time_ns(RAYS, [&] {
+        sink = sink + RangeTable::cast(segments, rays[k++ % RAYS], 200);
+    });
+    Translation2d p(40, 40);
+    double distance_ns = host_test::time_ns(1000000, [&] { sink = sink + map.distance(p); });
+    double exact_ns = host_test::time_ns(100000, [&] { sink = sink + map.exact_distance(p); });
+    double move_ns = host_test::time_ns(100000, [&] {
+        sink = sink + map.is_clear(Translation2d(10, 10), Translation2d(130, 60), 9);
+    });
+    double tight_ns = host_test::time_ns(100000, [&] {
+        sink = sink + map.is_clear(Translation2d(25, 73), Translation2d(60, 73), 0.3);
+    });
+
+    printf("cast() differs from RangeTable::cast on %d of %d rays  |  cast %.0f ns, brute force %.0f ns, distance %.0f "
+           "ns, exact %.0f ns, is_clear across the field %.0f ns, along the barrier %.0f ns\n",
+           differ, RAYS, cast_ns, brute_ns, distance_ns, exact_ns, move_ns, tight_ns);
+    CHECK(differ == 0);
+}
+
+void check_blob() {
+    std::vector<uint8_t> blob = FieldMap::encode(ELEMENTS);
+    std::vector<FieldMap::element_t> decoded;
+    double field_size = 0;
+    CHECK(FieldMap::decode(blob.data(), blob.size(), decoded, field_size));
+    CHECK(field_size == 144);
+    CHECK(decoded.size() == ELEMENTS.size());
+    double worst = 0;
+    for (size_t i = 0; i < decoded.size() && i < ELEMENTS.size(); i++) {
+        CHECK(decoded[i].size() == ELEMENTS[i].size());
+        for (size_t j = 0; j < decoded[i].size() && j < ELEMENTS[i].size(); j++) {
+            worst = std::max(worst, decoded[i][j].distance(ELEMENTS[i][j]));
+        }
+    }
+    printf("blob: %zu bytes, worst vertex moved %.4f in\n", blob.size(), worst);
+    CHECK(worst <= 0.005 * M_SQRT2);
+
+    // One bad byte, or one missing, and it's rejected without touching the outputs
+    blob[10] ^= 0x40;
+    CHECK(!FieldMap::decode(blob.data(), blob.size(), decoded, field_size));
+    blob[10] ^= 0x40;
+    CHECK(!FieldMap::decode(blob.data(), blob.size() - 1, decoded, field_size));
+    CHECK(decoded.size() == ELEMENTS.size());
+}
+
+} // namespace
+
+int main() {
+    check_barrier();
+    check_random(1);
+    check_random(2);
+    check_cast();
+    check_blob();
+
+    sim::finish(host_test::failures);
+}
@@ -0,0 +1,123 @@
+// GridPlanner on 300 random fields (12 game objects, 2 robots and a center goal) planning corner to corner with 1 and
+// 2 in cells: every path has to keep the robot clear of everything, and what building the grid and planning cost is
+// printed. Also the starts inside the inflation band that used to fail or jog, and a field with no way through.
+
+#include <algorithm>
+#include <random>
+
+#include "core/utils/grid_planner.h"
+#include "host_test.h"
+
+namespace {
+
+constexpr double ROBOT_RADIUS = 9;
+
+typedef struct {
+    Translation2d center;
+    double radius;
+} circle_t;
+
+/**
+ * Whether a robot at q touches a wall, a circle or the center goal (66, 66) to (78, 78)
+ */
+bool collides(const Translation2d &q, const std::vector<circle_t> &circles) {
+    const double R = ROBOT_RADIUS - 1e-9;
+    bool hit = q.x() < R || q.y() < R || q.x() > 144 - R || q.y() > 144 - R;
+    for (const circle_t &c : circles) {
+        hit |= q.distance(c.center) < c.radius + R;
+    }
+    double dx = std::max({66 - q.x(), 0.0, q.x() - 78}), dy = std::max({66 - q.y(), 0.0, q.y() - 78});
+    hit |= dx * dx + dy * dy < R * R;
+    return hit;
+}
+
+void random_fields(double resolution) {
+    std::mt19937 rng(11);
+    std::uniform_real_distribution<double> u(24, 120);
+    GridPlanner planner(ROBOT_RADIUS, resolution);
+    const int FIELDS = 300;
+    int found = 0, tried = 0, violations = 0;
+    double total_ms = 0, worst_ms = 0, build_ms = 0;
+    for (int k = 0; k < FIELDS; k++) {
+        std::vector<circle_t> circles;
+        for (int i = 0; i < 12; i++) {
+            circles.push_back({Translation2d(u(rng), u(rng)), 3.5});
+        }
+        for (int i = 0; i < 2; i++) {
+            circles.push_back({Translation2d(u(rng), u(rng)), 9});
+        }
+        build_ms += host_test::time_ns(1, [&] {
+            planner.clear();
+            for (const circle_t &c : circles) {
+                planner.add_circle(c.center, c.radius);
+            }
+            planner.add_rect(Translation2d(66, 66), Translation2d(78, 78));
+        }) / 1e6;
+
+        Translation2d start(16, 16), goal(128, 128);
+        if (!planner.is_free(goal)) {
+            continue;
+        }
+        tried++;
+        std::vector<Translation2d> pts;
+        double ms = host_test::time_ns(1, [&] { pts = planner.plan_points(start, goal); }) / 1e6;
+        total_ms += ms;
+        worst_ms = std::max(worst_ms, ms);
+        if (pts.empty()) {
+            continue;
+        }
+        found++;
+        // The first leg may leave an inflated obstacle the start is in
+        for (size_t i = 1; i + 1 < pts.size(); i++) {
+            for (int j = 0; j <= 200; j++) {
+                if (collides(pts[i] + (pts[i + 1] - pts[i]) * (j / 200.0), circles)) {
+                    violations++;
+                    break;
+                }
+            }
+        }
+    }
+    printf("%.0f in cells: %d of %d fields found a path, %d clearance violations  |  grid build %.2f ms, plan %.2f ms "
+           "mean %.2f ms worst\n",
+           resolution, found, tried, violations, build_ms / FIELDS, total_ms / tried, worst_ms);
+    // Some fields really are closed off, more of them when the grid is coarse
+    CHECK(found > tried * 8 / 10);
+    CHECK(violations == 0);
+}
+
+void check_inflation_starts() {
+    // Against the wall with a robot radius that puts the start inside the grown wall: used to find nothing
+    GridPlanner big(12.7, 2);
+    std::vector<Translation2d> pts = big.plan_points(Translation2d(9, 72), Translation2d(120, 72));
+    CHECK(pts.size() == 2);
+
+    // Less deep in: used to add a jog corner
+    GridPlanner small(ROBOT_RADIUS, 2);
+    pts = small.plan_points(Translation2d(9, 72), Translation2d(120, 72));
+    CHECK(pts.size() == 2);
+
+    // Started against the side of a box, the path first backs away from it and goes around
+    GridPlanner box(ROBOT_RADIUS, 2);
+    box.add_rect(Translation2d(30, 40), Translation2d(34, 100));
+    pts = box.plan_points(Translation2d(25, 72), Translation2d(120, 72));
+    printf("start against a box: %zu points\n", pts.size());
+    CHECK(pts.size() > 2);
+    CHECK(!pts.empty() && pts.front().distance(Translation2d(25, 72)) < 1e-9);
+    CHECK(!pts.empty() && pts.back().distance(Translation2d(120, 72)) < 1e-9);
+
+    // No way through
+    GridPlanner wall(ROBOT_RADIUS, 2);
+    wall.add_segment(Translation2d(72, 0), Translation2d(72, 144));
+    CHECK(wall.plan_points(Translation2d(20, 72), Translation2d(120, 72)).empty());
+    CHECK(!wall.plan(Translation2d(20, 72), Translation2d(120, 72), 8).is_valid());
+}
+
+} // namespace
+
+int main() {
+    random_fields(1);
+    random_fields(2);
+    check_inflation_starts();
+
+    sim::finish(host_test::failures);
+}
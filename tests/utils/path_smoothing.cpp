@@ -0,0 +1,114 @@
+// smooth_path_direct against the iterative smooth_path it solves for in one pass: on noisy 200 point paths with nine
+// pairs of weights, and with pinned points against the same iteration that skips them. Then what each costs on 100,
+// 1000 and 10000 points as the weights get harder for the iteration.
+
+#include <algorithm>
+#include <random>
+
+#include "core/utils/pure_pursuit.h"
+#include "host_test.h"
+
+using namespace PurePursuit;
+
+namespace {
+
+/**
+ * smooth_path(), leaving the fixed points where they are
+ */
+std::vector<Translation2d> smooth_path_pinned(
+  const std::vector<Translation2d> &path, double weight_data, double weight_smooth, double tolerance,
+  const std::vector<bool> &fixed
+) {
+    std::vector<Translation2d> y = path;
+    double change = tolerance;
+    while (change >= tolerance) {
+        change = 0;
+        for (size_t i = 1; i + 1 < path.size(); i++) {
+            if (fixed[i]) {
+                continue;
+            }
+            Translation2d before = y[i];
+            y[i] = y[i] + (path[i] - y[i]) * weight_data + (y[i + 1] + y[i - 1] - y[i] * 2) * weight_smooth;
+            change += y[i].distance(before);
+        }
+    }
+    return y;
+}
+
+// A wave with up to 3 in of noise on every point
+std::vector<Translation2d> noisy_path(std::mt19937 &rng, int n) {
+    std::uniform_real_distribution<double> noise(-3, 3);
+    std::vector<Translation2d> p;
+    for (int i = 0; i < n; i++) {
+        p.push_back(Translation2d(i + noise(rng), 20 * sin(i * 0.05) + noise(rng)));
+    }
+    return p;
+}
+
+double worst_difference(const std::vector<Translation2d> &a, const std::vector<Translation2d> &b) {
+    double worst = 0;
+    for (size_t i = 0; i < a.size(); i++) {
+        worst = std::max(worst, a[i].distance(b[i]));
+    }
+    return worst;
+}
+
+void check_equivalence() {
+    std::mt19937 rng(5);
+    double worst = 0;
+    for (double alpha : {0.1, 0.3, 0.5}) {
+        for (double beta : {0.1, 0.3, 0.45}) {
+            std::vector<Translation2d> p = noisy_path(rng, 200);
+            std::vector<Translation2d> iterated = smooth_path(p, alpha, beta, 1e-10);
+            worst = std::max(worst, worst_difference(iterated, smooth_path_direct(p, alpha, beta)));
+        }
+    }
+
+    std::vector<Translation2d> p = noisy_path(rng, 200);
+    std::vector<size_t> pins = {50, 120, 121};
+    std::vector<bool> fixed(p.size(), false);
+    for (size_t i : pins) {
+        fixed[i] = true;
+    }
+    std::vector<Translation2d> direct = smooth_path_direct(p, 0.2, 0.4, pins);
+    double worst_pinned = worst_difference(smooth_path_pinned(p, 0.2, 0.4, 1e-10, fixed), direct);
+    double pins_moved = 0;
+    for (size_t i : {(size_t)0, (size_t)50, (size_t)120, (size_t)121, p.size() - 1}) {
+        pins_moved = std::max(pins_moved, direct[i].distance(p[i]));
+    }
+
+    printf("direct vs iterating to 1e-10: 9 weight pairs %.1e in, pinned %.1e in, pinned points moved %.1e in\n", worst,
+           worst_pinned, pins_moved);
+    CHECK(worst < 1e-9);
+    CHECK(worst_pinned < 1e-9);
+    CHECK(pins_moved == 0);
+
+    // Too short to smooth
+    std::vector<Translation2d> two = {Translation2d(0, 0), Translation2d(5, 5)};
+    CHECK(smooth_path_direct(two, 0.3, 0.3) == two);
+}
+
+void benchmark() {
+    std::mt19937 rng(6);
+    // Harder for the iteration down the list: less pull back to the data, more toward the neighbors
+    const std::vector<std::pair<double, double>> weights = {{0.5, 0.1}, {0.1, 0.3}, {0.02, 0.45}};
+    for (int n : {100, 1000, 10000}) {
+        for (const std::pair<double, double> &w : weights) {
+            std::vector<Translation2d> p = noisy_path(rng, n);
+            int reps = n >= 10000 ? 1 : 5;
+            double iter_us = host_test::time_ns(reps, [&] { smooth_path(p, w.first, w.second, 0.001); }) / 1000;
+            double direct_us = host_test::time_ns(reps * 20, [&] { smooth_path_direct(p, w.first, w.second); }) / 1000;
+            printf("%5d points, alpha %.2f beta %.2f: smooth_path (tol 0.001) %9.1f us, smooth_path_direct %6.1f us\n",
+                   n, w.first, w.second, iter_us, direct_us);
+        }
+    }
+}
+
+} // namespace
+
+int main() {
+    check_equivalence();
+    benchmark();
+
+    sim::finish(host_test::failures);
+}
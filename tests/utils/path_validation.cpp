@@ -0,0 +1,192 @@
+// The Path constructor's grid-accelerated check for segments that come within a radius of each other, against
+// measuring every pair of segments, on 3000 random walks with repeated points. Then what building a path costs on a
+// 1 in spaced spiral, next to the sampled pairwise loop it replaced, and the cases the old loop got wrong.
+
+#include <algorithm>
+#include <random>
+#include <set>
+
+#include "core/utils/pure_pursuit.h"
+#include "host_test.h"
+#include "scalar_geometry.h"
+
+using namespace PurePursuit;
+
+namespace {
+
+/**
+ * The validity check as it was before the grid: every segment against every segment two or more after it, sampled a
+ * radius apart
+ */
+bool sampled_pairwise_valid(const std::vector<Translation2d> &points, double radius) {
+    bool valid = points.size() >= 2;
+    for (int i = 0; valid && i < (int)points.size() - 1; i++) {
+        for (int j = i + 2; valid && j < (int)points.size() - 1; j++) {
+            double segment_i_dist = points[i].distance(points[i + 1]);
+            if (segment_i_dist == 0) {
+                segment_i_dist = 0.1;
+            }
+            double segment_j_dist = points[j].distance(points[j + 1]);
+            if (segment_j_dist == 0) {
+                segment_j_dist = 0.1;
+            }
+            for (double t1 = 0; valid && t1 <= 1; t1 += radius / segment_i_dist) {
+                Translation2d p1 = points[i] + (points[i + 1] - points[i]) * t1;
+                for (double t2 = 0; t2 <= 1; t2 += radius / segment_j_dist) {
+                    Translation2d p2 = points[j] + (points[j + 1] - points[j]) * t2;
+                    if (p1.distance(p2) < radius) {
+                        valid = false;
+                        break;
+                    }
+                }
+            }
+        }
+    }
+    return valid;
+}
+
+/**
+ * Every pair of segments that are too close under the current rule: within a radius of each other, and more than a
+ * radius apart along the path. Pairs within rounding of either limit could go either way, so they go in edge instead
+ */
+std::set<Path::conflict_t>
+all_conflicts(const std::vector<Translation2d> &pts, double radius, std::set<Path::conflict_t> &edge) {
+    const double ROUNDING = 1e-9;
+    std::vector<double> arc = {0};
+    for (size_t i = 1; i < pts.size(); i++) {
+        arc.push_back(arc.back() + pts[i - 1].distance(pts[i]));
+    }
+    std::set<Path::conflict_t> out;
+    for (size_t i = 0; i + 1 < pts.size(); i++) {
+        for (size_t j = i + 2; j + 1 < pts.size(); j++) {
+            double gap = arc[j] - arc[i + 1];
+            double dist = ScalarGeometry::segment_segment_dist(pts[i], pts[i + 1], pts[j], pts[j + 1]);
+            if (gap > radius + ROUNDING && dist < radius - ROUNDING) {
+                out.insert({i, j});
+            } else if (gap >= radius - ROUNDING && dist <= radius + ROUNDING) {
+                edge.insert({i, j});
+            }
+        }
+    }
+    return out;
+}
+
+std::vector<Translation2d> random_walk(std::mt19937 &rng, int n, double step) {
+    std::uniform_real_distribution<double> turn(-0.6, 0.6);
+    std::vector<Translation2d> p;
+    double x = 0, y = 0, h = 0;
+    for (int i = 0; i < n; i++) {
+        p.push_back(Translation2d(x, y));
+        h += turn(rng);
+        x += step * cos(h);
+        y += step * sin(h);
+    }
+    return p;
+}
+
+// An Archimedean spiral with 40 in between turns and points spacing apart
+std::vector<Translation2d> spiral(int n, double spacing) {
+    std::vector<Translation2d> p;
+    double th = 0;
+    for (int i = 0; i < n; i++) {
+        double r = 5 + 40 * th / (2 * M_PI);
+        p.push_back(Translation2d(r * cos(th), r * sin(th)));
+        th += spacing / r;
+    }
+    return p;
+}
+
+void check_against_all_pairs() {
+    std::mt19937 rng(3);
+    int differ = 0, invalid = 0, capped = 0;
+    const int CASES = 3000;
+    for (int k = 0; k < CASES; k++) {
+        std::vector<Translation2d> pts = random_walk(rng, 5 + rng() % 120, 0.5 + (rng() % 100) / 10.0);
+        // Repeated points, so some segments have no length
+        if (k % 7 == 0) {
+            pts[rng() % pts.size()] = pts[rng() % pts.size()];
+        }
+        double radius = 1 + rng() % 20;
+        Path path(pts, radius);
+        std::set<Path::conflict_t> edge;
+        std::set<Path::conflict_t> expected = all_conflicts(pts, radius, edge);
+        const std::vector<Path::conflict_t> &found = path.get_conflicts();
+
+        invalid += !expected.empty();
+        capped += expected.size() + edge.size() > Path::MAX_CONFLICTS;
+        // Everything found is too close, and if the check didn't stop at MAX_CONFLICTS, everything too close is found
+        bool all_real = std::all_of(found.begin(), found.end(), [&](const Path::conflict_t &c) {
+            return expected.count(c) || edge.count(c);
+        });
+        bool all_found = found.size() == Path::MAX_CONFLICTS ||
+                         std::all_of(expected.begin(), expected.end(), [&](const Path::conflict_t &c) {
+                             return std::find(found.begin(), found.end(), c) != found.end();
+                         });
+        differ += !all_real || !all_found || path.is_valid() != found.empty();
+    }
+    printf("random walks: %d of %d differ from measuring every pair (%d invalid, %d past MAX_CONFLICTS)\n", differ,
+           CASES, invalid, capped);
+    CHECK(differ == 0);
+}
+
+void benchmark() {
+    // 1 in apart with a 0.9 in radius, so the sampled check passes them too
+    for (int n : {100, 300, 1000, 3000, 10000}) {
+        std::vector<Translation2d> pts = spiral(n, 1.0);
+        const double radius = 0.9;
+        bool old_valid = true, new_valid = false;
+        double old_ms = -1;
+        // The old loop takes seconds past this
+        if (n <= 3000) {
+            old_ms = host_test::time_ns(1, [&] { old_valid = sampled_pairwise_valid(pts, radius); }) / 1e6;
+        }
+        double new_ms = host_test::time_ns(20, [&] { new_valid = Path(pts, radius).is_valid(); }) / 1e6;
+        if (old_ms < 0) {
+            printf("%5d point spiral: sampled pairwise    (skipped), grid %7.3f ms\n", n, new_ms);
+        } else {
+            printf("%5d point spiral: sampled pairwise %9.3f ms, grid %7.3f ms\n", n, old_ms, new_ms);
+        }
+        CHECK(old_valid);
+        CHECK(new_valid);
+    }
+}
+
+void check_old_mistakes() {
+    // Points a quarter inch apart with a 12 in lookahead, like an injected path. Neighbors a few segments apart are
+    // always within a radius, which the old check counted against the path
+    std::vector<Translation2d> dense;
+    for (int i = 0; i < 10000; i++) {
+        dense.push_back(Translation2d(i * 0.25, 30 * sin(i * 0.001)));
+    }
+    CHECK(!sampled_pairwise_valid(std::vector<Translation2d>(dense.begin(), dense.begin() + 50), 12));
+    CHECK(Path(dense, 12).is_valid());
+
+    // A path that loops back onto itself says where
+    std::vector<Translation2d> loop = {Translation2d(0, 0),  Translation2d(48, 0), Translation2d(48, 48),
+                                       Translation2d(0, 48), Translation2d(0, 2),  Translation2d(10, 2)};
+    Path looped(loop, 6);
+    CHECK(!looped.is_valid());
+    CHECK(!looped.get_conflicts().empty() && looped.get_conflicts()[0] == Path::conflict_t(0, 3));
+
+    // A radius that isn't positive used to step the sampler by nothing, forever
+    Path zero(std::vector<Translation2d>{Translation2d(0, 0), Translation2d(10, 0), Translation2d(20, 0)}, 0);
+    CHECK(zero.get_conflicts().empty());
+
+    // One segment across thousands of tiny ones doesn't blow up the grid
+    std::mt19937 rng(8);
+    std::vector<Translation2d> tiny = random_walk(rng, 5000, 0.1);
+    tiny.push_back(Translation2d(5000, 5000));
+    double ms = host_test::time_ns(1, [&] { Path huge(tiny, 1); }) / 1e6;
+    printf("5000 tiny segments and one 7000 in one: %.2f ms\n", ms);
+    CHECK(ms < 1000);
+}
+
+} // namespace
+
+int main() {
+    check_against_all_pairs();
+    benchmark();
+    check_old_mistakes();
+
+    sim::finish(host_test::failures);
+}
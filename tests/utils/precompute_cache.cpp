@@ -0,0 +1,180 @@
+// PrecomputeCache over the stand-in SD card, with three routines (two match routes and a skills route), each a
+// quintic spline trajectory plus an injected and smoothed pure pursuit path. A cold start has to compute everything
+// and write the file, a warm one has to load the same artifacts back, and changing a limit, corrupting the file or
+// going back to old inputs has to recompute exactly what changed. What a cold and a warm start cost is printed.
+
+#include <fstream>
+
+#include "core/utils/precompute_cache.h"
+#include "core/utils/quintic_spline.h"
+#include "core/utils/trajectory.h"
+#include "host_test.h"
+
+using namespace PurePursuit;
+
+namespace {
+
+const char *const FILENAME = "auto.bin";
+
+struct routine_t {
+    const char *name;
+    std::vector<hermite_point> knots;
+};
+
+const std::vector<routine_t> ROUTINES = {
+  {"match left",
+   {{12, 12, 0, 40}, {48, 24, 0.5, 40}, {72, 60, M_PI / 2, 40}, {60, 96, 2.5, 40}, {24, 108, M_PI, 40}}},
+  {"match right",
+   {{132, 12, M_PI, 40}, {96, 24, 2.6, 40}, {72, 60, M_PI / 2, 40}, {84, 96, 0.6, 40}, {120, 108, 0, 40}}},
+  {"skills",
+   {{12, 12, 0, 40},
+    {48, 24, 0.5, 40},
+    {72, 60, M_PI / 2, 40},
+    {60, 96, 2.5, 40},
+    {24, 108, M_PI, 40},
+    {12, 84, -M_PI / 2, 40},
+    {36, 60, 0, 40},
+    {108, 60, 0, 60},
+    {132, 96, M_PI / 2, 30},
+    {120, 130, M_PI, 40},
+    {20, 130, M_PI, 40}}},
+};
+
+// The trajectories depend on the limits, the pure pursuit paths only on the knots
+CacheKey trajectory_key(const routine_t &r, const Trajectory::trajectory_config_t &cfg) {
+    CacheKey key("trajectory-v1");
+    key.add(r.knots).add(cfg.max_vel).add(cfg.max_accel).add(cfg.max_centripetal_accel).add(cfg.track_width);
+    key.add(cfg.start_vel).add(cfg.end_vel).add(cfg.reversed);
+    return key;
+}
+
+CacheKey path_key(const routine_t &r) {
+    CacheKey key("pure-pursuit-v1");
+    key.add(r.knots);
+    return key;
+}
+
+typedef struct {
+    size_t hits, misses;
+    double ms;
+    std::vector<std::vector<Trajectory::state_t>> trajectories;
+    std::vector<std::vector<Translation2d>> paths;
+} run_result_t;
+
+/**
+ * What pre-auton would do: load, add every artifact, start, then get them all. Waits for the file to be written
+ * before returning
+ */
+run_result_t run(const Trajectory::trajectory_config_t &cfg, bool use_start = true) {
+    run_result_t res;
+    auto before = std::chrono::steady_clock::now();
+    PrecomputeCache cache(FILENAME);
+    cache.load();
+    for (const routine_t &r : ROUTINES) {
+        cache.add<Trajectory::state_t>(trajectory_key(r, cfg), [r, cfg]() {
+            return Trajectory(QuinticSpline(r.knots).subdivide(0.01, 2), cfg).get_states();
+        });
+        cache.add<Translation2d>(path_key(r), [r]() {
+            return smooth_path(inject_path(smooth_path_hermite(r.knots, 20), 0.5), 0.1, 0.3, 0.0001);
+        });
+    }
+    if (use_start) {
+        cache.start();
+    }
+    for (const routine_t &r : ROUTINES) {
+        res.trajectories.push_back(cache.get<Trajectory::state_t>(trajectory_key(r, cfg)));
+        res.paths.push_back(cache.get<Translation2d>(path_key(r)));
+    }
+    res.ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - before).count();
+    while (!cache.is_ready()) {
+        vexDelay(1);
+    }
+    res.hits = cache.num_hits();
+    res.misses = cache.num_misses();
+    return res;
+}
+
+template <typename T> bool same_bytes(const std::vector<std::vector<T>> &a, const std::vector<std::vector<T>> &b) {
+    if (a.size() != b.size()) {
+        return false;
+    }
+    for (size_t i = 0; i < a.size(); i++) {
+        if (a[i].size() != b[i].size()) {
+            return false;
+        }
+        if (!a[i].empty() && memcmp(a[i].data(), b[i].data(), a[i].size() * sizeof(T)) != 0) {
+            return false;
+        }
+    }
+    return true;
+}
+
+long file_size() { return std::ifstream(sim::sd_path(FILENAME), std::ios::binary | std::ios::ate).tellg(); }
+
+void check_runs() {
+    Trajectory::trajectory_config_t cfg{60, 80, 50, 12, 0, 0, 0, false};
+    remove(sim::sd_path(FILENAME).c_str());
+
+    run_result_t cold = run(cfg);
+    printf("cold: %zu hits %zu misses, %.2f ms, wrote %ld bytes\n", cold.hits, cold.misses, cold.ms, file_size());
+    CHECK(cold.hits == 0 && cold.misses == 6);
+    CHECK(file_size() > 0);
+    for (size_t i = 0; i < ROUTINES.size(); i++) {
+        CHECK(!cold.trajectories[i].empty() && !cold.paths[i].empty());
+    }
+
+    run_result_t warm = run(cfg);
+    printf("warm: %zu hits %zu misses, %.2f ms\n", warm.hits, warm.misses, warm.ms);
+    CHECK(warm.hits == 6 && warm.misses == 0);
+    CHECK(same_bytes(cold.trajectories, warm.trajectories));
+    CHECK(same_bytes(cold.paths, warm.paths));
+
+    // A new limit only changes the trajectories, and the file is rewritten without the old ones
+    Trajectory::trajectory_config_t slower = cfg;
+    slower.max_vel = 55;
+    run_result_t changed = run(slower);
+    run_result_t back = run(cfg);
+    printf("max_vel changed: %zu hits %zu misses; changed back: %zu hits %zu misses\n", changed.hits, changed.misses,
+           back.hits, back.misses);
+    CHECK(changed.hits == 3 && changed.misses == 3);
+    CHECK(back.hits == 3 && back.misses == 3);
+    CHECK(same_bytes(cold.trajectories, back.trajectories));
+
+    // One bad byte and nothing in the file is trusted
+    {
+        std::fstream f(sim::sd_path(FILENAME), std::ios::binary | std::ios::in | std::ios::out);
+        f.seekp(100);
+        f.put(0x55);
+    }
+    run_result_t corrupt = run(cfg);
+    printf("corrupted: %zu hits %zu misses\n", corrupt.hits, corrupt.misses);
+    CHECK(corrupt.hits == 0 && corrupt.misses == 6);
+    CHECK(same_bytes(cold.paths, corrupt.paths));
+
+    // Without start(), get() computes what it needs itself
+    remove(sim::sd_path(FILENAME).c_str());
+    run_result_t unstarted = run(cfg, false);
+    CHECK(same_bytes(cold.trajectories, unstarted.trajectories));
+    CHECK(same_bytes(cold.paths, unstarted.paths));
+}
+
+void benchmark() {
+    Trajectory::trajectory_config_t cfg{60, 80, 50, 12, 0, 0, 0, false};
+    const int RUNS = 10;
+    double cold = 0, warm = 0;
+    for (int i = 0; i < RUNS; i++) {
+        remove(sim::sd_path(FILENAME).c_str());
+        cold += run(cfg).ms;
+        warm += run(cfg).ms;
+    }
+    printf("mean over %d: cold %.2f ms, warm %.2f ms\n", RUNS, cold / RUNS, warm / RUNS);
+}
+
+} // namespace
+
+int main() {
+    check_runs();
+    benchmark();
+
+    sim::finish(host_test::failures);
+}
@@ -0,0 +1,114 @@
+// PurePursuit::Tracker against the stateless get_lookahead() and estimate_remaining_dist() it replaced in TankDrive.
+// A robot 2 in off a wavy 600 in path is followed for 2000 ticks with 50, 500 and 5000 points: the lookahead points
+// have to match, the remaining distance has to be close, and the cost per tick of each is printed. Also covers the
+// fixes that came with it.
+
+#include "core/utils/math_util.h"
+#include "core/utils/pure_pursuit.h"
+#include "host_test.h"
+
+using namespace PurePursuit;
+
+namespace {
+
+constexpr int TICKS = 2000;
+constexpr double LOOKAHEAD = 12;
+
+// n points over a 600 in long, 30 in tall wave
+std::vector<Translation2d> wave(int n) {
+    std::vector<Translation2d> p;
+    for (int i = 0; i < n; i++) {
+        double u = (double)i / (n - 1);
+        p.push_back(Translation2d(600 * u, 30 * sin(u * 12)));
+    }
+    return p;
+}
+
+void compare(int n) {
+    Path path(wave(n), LOOKAHEAD);
+    Tracker tracker(path);
+    double old_us = 0, tracker_us = 0, worst_lookahead = 0, worst_remaining = 0;
+    size_t last_segment = 0;
+    bool went_backwards = false;
+    for (int k = 0; k < TICKS; k++) {
+        double u = (double)k / TICKS;
+        Pose2d robot(600 * u, 30 * sin(u * 12) + 2, 0);
+
+        auto a = std::chrono::steady_clock::now();
+        // What TankDrive::pure_pursuit did every tick, copy included
+        std::vector<Translation2d> copy = path.get_points();
+        Translation2d old_lookahead = get_lookahead(copy, robot, LOOKAHEAD);
+        double old_remaining = estimate_remaining_dist(copy, robot, LOOKAHEAD);
+        auto b = std::chrono::steady_clock::now();
+        tracker.update(robot);
+        auto c = std::chrono::steady_clock::now();
+
+        old_us += std::chrono::duration<double, std::micro>(b - a).count();
+        tracker_us += std::chrono::duration<double, std::micro>(c - b).count();
+        worst_lookahead = std::max(worst_lookahead, old_lookahead.distance(tracker.get_lookahead()));
+        worst_remaining = std::max(worst_remaining, std::fabs(old_remaining - tracker.get_remaining_dist()));
+        went_backwards |= tracker.get_segment() < last_segment;
+        last_segment = tracker.get_segment();
+    }
+    printf("%5d points: get_lookahead + estimate_remaining_dist %8.2f us/tick, Tracker %6.2f us/tick  |  worst "
+           "lookahead difference %.1e in, remaining %.2f in (path %.1f in)\n",
+           n, old_us / TICKS, tracker_us / TICKS, worst_lookahead, worst_remaining, path.get_length());
+    CHECK(worst_lookahead < 1e-9);
+    CHECK(worst_remaining < 0.5);
+    CHECK(!went_backwards);
+}
+
+/**
+ * A hairpin: out along y = 0, back along y = 6. A robot at y = 3.5 is closer to the way back and has both legs inside
+ * its lookahead circle. The tracker only searches one lookahead ahead of its cursor, so it has to stay on the way out
+ * and count the whole way back as still to go
+ */
+void check_hairpin() {
+    std::vector<Translation2d> pts;
+    for (int i = 0; i <= 100; i++) {
+        pts.push_back(Translation2d(i, 0));
+    }
+    for (int i = 100; i >= 40; i--) {
+        pts.push_back(Translation2d(i, 6));
+    }
+    Path path(pts, 4);
+    Tracker tracker(path);
+    double last_remaining = 1e9;
+    for (int x = 0; x <= 30; x++) {
+        Pose2d robot(x, 3.5, 0);
+        tracker.update(robot);
+        CHECK_NEAR(tracker.get_lookahead().y(), 0, 1e-9);
+        CHECK(tracker.get_remaining_dist() < last_remaining);
+        last_remaining = tracker.get_remaining_dist();
+    }
+    CHECK_NEAR(last_remaining, 70 + 60 + 6, 1);
+}
+
+void check_fixes() {
+    // An empty path is invalid rather than looping off the end
+    Path empty(std::vector<Translation2d>{}, LOOKAHEAD);
+    CHECK(!empty.is_valid());
+    CHECK(empty.get_length() == 0);
+
+    // The length of a path doesn't depend on the path measured before it
+    std::vector<Translation2d> a = {Translation2d(0, 0), Translation2d(10, 0)};
+    std::vector<Translation2d> b = {Translation2d(100, 100), Translation2d(100, 110)};
+    CHECK_NEAR(estimate_path_length(a), 10, 1e-9);
+    CHECK_NEAR(estimate_path_length(b), 10, 1e-9);
+    CHECK_NEAR(estimate_path_length(a), 10, 1e-9);
+
+    // Remaining distance from before the first point
+    CHECK(std::isfinite(estimate_remaining_dist(a, Pose2d(-5, 0, 0), 2)));
+}
+
+} // namespace
+
+int main() {
+    for (int n : {50, 500, 5000}) {
+        compare(n);
+    }
+    check_hairpin();
+    check_fixes();
+
+    sim::finish(host_test::failures);
+}
@@ -0,0 +1,168 @@
+// QuinticSpline against the cubic smooth_path_hermite on four routes: how many points each places, what that costs,
+// and how far the polyline strays from the curve it samples. Checks the quintic's curvature is continuous across knots,
+// its analytic heading and curvature agree with finite differences, and subdivide() keeps to its limits. Also checks
+// smooth_path_hermite in Horner form gives the same points as the pow() form it replaced.
+
+#include <algorithm>
+
+#include "core/utils/quintic_spline.h"
+#include "host_test.h"
+
+using namespace PurePursuit;
+
+namespace {
+
+constexpr double TOLERANCE = 0.02;
+
+struct route_t {
+    const char *name;
+    std::vector<hermite_point> knots;
+};
+
+const std::vector<route_t> ROUTES = {
+  {"long straight + turn", {{0, 0, 0, 60}, {96, 0, 0, 60}, {120, 24, M_PI / 2, 30}}},
+  {"s-curve", {{0, 0, 0, 60}, {40, 30, M_PI / 2, 60}, {70, 70, 0, 60}}},
+  {"skills weave",
+   {{12, 12, 0, 40},
+    {48, 24, 0.5, 40},
+    {72, 60, M_PI / 2, 40},
+    {60, 96, 2.5, 40},
+    {24, 108, M_PI, 40},
+    {12, 84, -M_PI / 2, 40},
+    {36, 60, 0, 40},
+    {108, 60, 0, 60},
+    {132, 96, M_PI / 2, 30}}},
+  {"tight U", {{0, 0, 0, 20}, {12, 12, M_PI / 2, 20}, {0, 24, M_PI, 20}}},
+};
+
+/**
+ * smooth_path_hermite() as it was before its blending functions were put in Horner form
+ */
+std::vector<Translation2d> pow_hermite(const std::vector<hermite_point> &path, double steps) {
+    std::vector<Translation2d> new_path;
+    for (size_t i = 0; i < path.size() - 1; i++) {
+        for (int t = 0; t < steps; t++) {
+            double s = (double)t / (double)steps;
+            double h1 = 2 * pow(s, 3) - 3 * pow(s, 2) + 1;
+            double h2 = -2 * pow(s, 3) + 3 * pow(s, 2);
+            double h3 = pow(s, 3) - 2 * pow(s, 2) + s;
+            double h4 = pow(s, 3) - pow(s, 2);
+            new_path.push_back(path[i].getPoint() * h1 + path[i + 1].getPoint() * h2 + path[i].getTangent() * h3 +
+                               path[i + 1].getTangent() * h4);
+        }
+    }
+    new_path.push_back(path.back().getPoint());
+    return new_path;
+}
+
+// The cubic Hermite curve smooth_path_hermite samples, on piece i
+Translation2d cubic_at(const std::vector<hermite_point> &k, size_t i, double s) {
+    double h1 = 2 * s * s * s - 3 * s * s + 1, h2 = -2 * s * s * s + 3 * s * s;
+    double h3 = s * s * s - 2 * s * s + s, h4 = s * s * s - s * s;
+    return k[i].getPoint() * h1 + k[i + 1].getPoint() * h2 + k[i].getTangent() * h3 + k[i + 1].getTangent() * h4;
+}
+
+/**
+ * Furthest a polyline gets from the curve it was sampled from, measured from 400 points on every piece of the curve
+ */
+template <typename Curve> double worst_deviation(const std::vector<Translation2d> &poly, size_t pieces, Curve curve) {
+    SegmentBuffer segs(poly);
+    double worst = 0;
+    for (size_t i = 0; i < pieces; i++) {
+        for (int j = 0; j <= 400; j++) {
+            double t, dist_sq;
+            SegmentKernels::nearest_on_polyline(segs, 0, segs.size(), curve(i, j / 400.0), t, dist_sq);
+            worst = std::max(worst, sqrt(dist_sq));
+        }
+    }
+    return worst;
+}
+
+void compare_routes() {
+    for (const route_t &r : ROUTES) {
+        QuinticSpline spline(r.knots);
+        size_t pieces = r.knots.size() - 1;
+
+        std::vector<Translation2d> cubic, quintic;
+        double cubic_us = host_test::time_ns(2000, [&] { cubic = smooth_path_hermite(r.knots, 20); }) / 1000;
+        double quintic_us =
+          host_test::time_ns(2000, [&] { quintic = QuinticSpline(r.knots).subdivide_points(TOLERANCE); }) / 1000;
+        double cubic_dev = worst_deviation(cubic, pieces, [&](size_t i, double s) { return cubic_at(r.knots, i, s); });
+        double quintic_dev = worst_deviation(quintic, pieces, [&](size_t i, double s) {
+            return spline.evaluate(i + s).pose.translation();
+        });
+        printf("%-20s cubic steps=20 %3zu points %5.1f us, strays %.3f in  |  quintic tol=%.2f %3zu points %5.1f us, "
+               "strays %.3f in\n",
+               r.name, cubic.size(), cubic_us, cubic_dev, TOLERANCE, quintic.size(), quintic_us, quintic_dev);
+
+        // Only the middle of each part is held to the tolerance, so allow a little past it
+        CHECK(quintic_dev < TOLERANCE * 1.5);
+        CHECK(quintic.front().distance(r.knots.front().getPoint()) < 1e-9);
+        CHECK(quintic.back().distance(r.knots.back().getPoint()) < 1e-9);
+    }
+}
+
+void check_spline() {
+    QuinticSpline spline(ROUTES[2].knots);
+
+    double worst_jump = 0;
+    for (size_t i = 1; i < spline.num_pieces(); i++) {
+        worst_jump =
+          std::max(worst_jump, std::fabs(spline.evaluate(i - 1e-9).curvature - spline.evaluate(i + 1e-9).curvature));
+    }
+
+    // Heading and curvature from three close points, against what evaluate() works out
+    double worst_heading = 0, worst_curvature = 0;
+    const double H = 1e-4;
+    for (double u = 0.05; u < spline.num_pieces() - 0.05; u += 0.01) {
+        Translation2d a = spline.evaluate(u - H).pose.translation(), b = spline.evaluate(u).pose.translation();
+        Translation2d c = spline.evaluate(u + H).pose.translation();
+        Trajectory::path_point_t p = spline.evaluate(u);
+        Translation2d d1 = (c - a) / (2 * H), d2 = (c - b * 2 + a) / (H * H);
+        double k = (d1.x() * d2.y() - d1.y() * d2.x()) / pow(d1.norm(), 3);
+        worst_heading = std::max(worst_heading, std::fabs((p.pose.rotation() - d1.theta()).radians()));
+        worst_curvature = std::max(worst_curvature, std::fabs(p.curvature - k));
+    }
+
+    // Every point from subdivide() turns at most MAX_TURN from the last, and is at most max_spacing from it
+    std::vector<Trajectory::path_point_t> pts = spline.subdivide(0.05, 6);
+    double worst_turn = 0, worst_spacing = 0;
+    for (size_t i = 1; i < pts.size(); i++) {
+        worst_turn = std::max(worst_turn, std::fabs((pts[i].pose.rotation() - pts[i - 1].pose.rotation()).radians()));
+        worst_spacing = std::max(worst_spacing, pts[i].pose.translation().distance(pts[i - 1].pose.translation()));
+    }
+
+    printf("skills weave: curvature jump at knots %.1e, vs finite differences heading %.1e rad curvature %.1e 1/in, "
+           "subdivide(0.05, 6) worst turn %.3f rad spacing %.2f in\n",
+           worst_jump, worst_heading, worst_curvature, worst_turn, worst_spacing);
+    CHECK(worst_jump < 1e-6);
+    CHECK(worst_heading < 1e-6);
+    CHECK(worst_curvature < 1e-4);
+    CHECK(worst_turn <= QuinticSpline::MAX_TURN);
+    CHECK(worst_spacing <= 6);
+}
+
+void check_horner() {
+    const std::vector<hermite_point> &knots = ROUTES[2].knots;
+    std::vector<Translation2d> horner, powed;
+    double horner_us = host_test::time_ns(2000, [&] { horner = smooth_path_hermite(knots, 20); }) / 1000;
+    double pow_us = host_test::time_ns(2000, [&] { powed = pow_hermite(knots, 20); }) / 1000;
+    double worst = 0;
+    for (size_t i = 0; i < horner.size(); i++) {
+        worst = std::max(worst, horner[i].distance(powed[i]));
+    }
+    printf("smooth_path_hermite on 9 knots: pow() %.1f us, Horner %.1f us, worst difference %.1e in\n", pow_us,
+           horner_us, worst);
+    CHECK(horner.size() == powed.size());
+    CHECK(worst < 1e-9);
+}
+
+} // namespace
+
+int main() {
+    compare_routes();
+    check_spline();
+    check_horner();
+
+    sim::finish(host_test::failures);
+}
@@ -0,0 +1,206 @@
+// Checks ReplayFilter against processing the same measurements in order: measurements that arrive late, or out of
+// order, have to leave a KalmanFilter and an UnscentedKalmanFilter where applying them on time would have. Also checks
+// what it rejects, and prints what a 20 step replay (a 100 ms delay at 200 Hz) costs.
+
+#include <algorithm>
+#include <random>
+
+#include "core/utils/math/estimator/kalman_filter.h"
+#include "core/utils/math/estimator/replay_filter.h"
+#include "core/utils/math/estimator/unscented_kalman_filter.h"
+#include "host_test.h"
+
+namespace {
+
+constexpr double DT = 0.005;
+constexpr int STEPS = 400;
+
+using AxisKF = KalmanFilter<3, 1, 1>;
+using PoseUKF = UnscentedKalmanFilter<3, 3, 1>;
+
+// Constant acceleration along one axis, position measured
+AxisKF make_kf() {
+    EMat<3, 3> A;
+    A << 0, 1, 0, 0, 0, 1, 0, 0, 0;
+    EMat<1, 3> C;
+    C << 1, 0, 0;
+    AxisKF f(A, EMat<3, 1>::Zero(), C, EMat<1, 1>::Zero(), EVec<3>(0, 0, 300), EVec<1>(0.1));
+    f.set_P(EMat<3, 3>::Identity());
+    return f;
+}
+
+// A pose driven by a body velocity, heading measured. Shaped like PoseEstimator's filter
+PoseUKF make_ukf() {
+    PoseUKF f(
+      [](const EVec<3> &x, const EVec<3> &u) {
+          return EVec<3>(u(0) * cos(x(2)) - u(1) * sin(x(2)), u(0) * sin(x(2)) + u(1) * cos(x(2)), u(2));
+      },
+      [](const EVec<3> &x, const EVec<3> &) {
+          EVec<1> y;
+          y << x(2);
+          return y;
+      },
+      RK4_with_input<3, 3>, EVec<3>(0.5, 0.5, 0.03), EVec<1>(0.01)
+    );
+    f.set_P(EMat<3, 3>::Identity() * 0.1);
+    return f;
+}
+
+/**
+ * Measure every 4th step, and deliver each one some number of steps late
+ *
+ * @param delay_of how many steps late the measurement from a step arrives
+ * @param apply_in_order applies the measurement from step k to the reference filter
+ * @param apply_late applies the measurement from step k to the replay filter, measured at time k * DT
+ * @return how far the replay filter's state ended up from the reference's
+ */
+template <typename Ref, typename Replay, typename U>
+double compare(
+  Ref &ref, Replay &rf, const U &u, const std::function<int(int)> &delay_of,
+  const std::function<void(Ref &, int)> &apply_in_order, const std::function<bool(Replay &, int)> &apply_late
+) {
+    std::vector<std::vector<int>> arrivals(STEPS * 2);
+    for (int k = 0; k < STEPS; k += 4) {
+        arrivals[k + delay_of(k)].push_back(k);
+    }
+    for (int k = 0; k < STEPS; k++) {
+        if (k > 0) {
+            ref.predict(u, DT);
+        }
+        if (k % 4 == 0) {
+            apply_in_order(ref, k);
+        }
+        rf.predict(u, k * DT);
+        for (int j : arrivals[k]) {
+            CHECK(apply_late(rf, j));
+        }
+    }
+    // What's still in flight arrives after the last step
+    for (size_t k = STEPS; k < arrivals.size(); k++) {
+        for (int j : arrivals[k]) {
+            CHECK(apply_late(rf, j));
+        }
+    }
+    return (ref.xhat() - rf.xhat()).norm();
+}
+
+void check_kf_equivalence() {
+    std::mt19937 rng(3);
+    std::normal_distribution<double> n(0, 1);
+    std::vector<double> y(STEPS);
+    for (int k = 0; k < STEPS; k++) {
+        y[k] = sin(k * DT * 3) * 10 + 0.1 * n(rng);
+    }
+    EVec<1> u = EVec<1>::Zero();
+    auto in_order = [&](AxisKF &f, int k) { f.correct(EVec<1>(y[k]), u); };
+    auto late = [&](ReplayFilter<AxisKF, 40> &f, int k) {
+        EVec<1> yk(y[k]);
+        return f.correct(k * DT, [yk, u](AxisKF &kf) { kf.correct(yk, u); });
+    };
+
+    {
+        AxisKF ref = make_kf();
+        ReplayFilter<AxisKF, 40> rf(make_kf(), 1000);
+        double diff = compare<AxisKF, ReplayFilter<AxisKF, 40>>(ref, rf, u, [](int) { return 20; }, in_order, late);
+        printf("KF<3,1,1>, every measurement 20 steps late: %g from in order\n", diff);
+        CHECK(diff < 1e-9);
+        CHECK((ref.P() - rf.filter().P()).norm() < 1e-9);
+        CHECK(rf.stats().replays > 0);
+    }
+    {
+        // 0 to 15 steps late, so they overtake each other
+        std::mt19937 delays(5);
+        std::uniform_int_distribution<int> d(0, 15);
+        AxisKF ref = make_kf();
+        ReplayFilter<AxisKF, 40> rf(make_kf(), 1000);
+        double diff =
+          compare<AxisKF, ReplayFilter<AxisKF, 40>>(ref, rf, u, [&](int) { return d(delays); }, in_order, late);
+        printf("KF<3,1,1>, measurements 0 to 15 steps late, out of order: %g from in order\n", diff);
+        CHECK(diff < 1e-9);
+    }
+}
+
+void check_ukf_equivalence() {
+    std::mt19937 rng(4);
+    std::normal_distribution<double> n(0, 1);
+    std::vector<double> y(STEPS);
+    for (int k = 0; k < STEPS; k++) {
+        y[k] = k * DT + 0.01 * n(rng);
+    }
+    EVec<3> u(30, 0, 1);
+    auto in_order = [&](PoseUKF &f, int k) { f.correct(EVec<3>::Zero(), EVec<1>(y[k])); };
+    auto late = [&](ReplayFilter<PoseUKF, 40> &f, int k) {
+        EVec<1> yk(y[k]);
+        return f.correct(k * DT, [yk](PoseUKF &ukf) { ukf.correct(EVec<3>::Zero(), yk); });
+    };
+    std::mt19937 delays(6);
+    std::uniform_int_distribution<int> d(0, 20);
+    PoseUKF ref = make_ukf();
+    ReplayFilter<PoseUKF, 40> rf(make_ukf(), 1000);
+    double diff =
+      compare<PoseUKF, ReplayFilter<PoseUKF, 40>>(ref, rf, u, [&](int) { return d(delays); }, in_order, late);
+    printf("UKF<3,3,1>, measurements 0 to 20 steps late, out of order: %g from in order\n", diff);
+    // A replay steps by the difference of recorded times, which is only DT to the last bit or so, and the UKF's
+    // nonlinear predict carries that a little further than the KF's
+    CHECK(diff < 1e-6);
+}
+
+void check_rejections() {
+    EVec<1> u = EVec<1>::Zero();
+    auto noop = [](AxisKF &) {};
+    ReplayFilter<AxisKF, 10, 2> rf(make_kf(), 12);
+    for (int k = 0; k < 20; k++) {
+        rf.predict(u, k * DT);
+    }
+    // Older than the 10 steps kept
+    CHECK(!rf.correct(5 * DT, noop));
+    CHECK(rf.stats().too_old == 1);
+    // 2 per step, then the step is full
+    CHECK(rf.correct(15 * DT, noop));
+    CHECK(rf.correct(15 * DT, noop));
+    CHECK(!rf.correct(15 * DT, noop));
+    CHECK(rf.stats().step_full == 1);
+    // Those two replays used 8 of the 12 steps allowed until the next predict
+    CHECK(!rf.correct(14 * DT, noop));
+    CHECK(rf.stats().over_budget == 1);
+    rf.predict(u, 20 * DT);
+    CHECK(rf.correct(14 * DT, noop));
+    CHECK(rf.stats().applied == 3);
+}
+
+/**
+ * 200 Hz with a measurement every 50 ms, each 100 ms late
+ */
+template <typename F, typename U, typename C> void time_replay(const char *name, F make, const U &u, C correction) {
+    ReplayFilter<decltype(make()), 40> rf(make(), 40);
+    double worst = 0, total = 0;
+    int count = 0;
+    for (int k = 0; k < 2000; k++) {
+        double t = k * DT;
+        rf.predict(u, t);
+        if (k >= 20 && k % 10 == 0) {
+            auto before = std::chrono::steady_clock::now();
+            CHECK(rf.correct(t - 0.1, correction));
+            double us = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - before).count();
+            total += us;
+            worst = std::max(worst, us);
+            count++;
+        }
+    }
+    printf("%s: 20 step replay %.1f us average, %.1f us worst\n", name, total / count, worst);
+}
+
+} // namespace
+
+int main() {
+    check_kf_equivalence();
+    check_ukf_equivalence();
+    check_rejections();
+
+    time_replay("KF<3,1,1>", make_kf, EVec<1>(0.0), [](AxisKF &f) { f.correct(EVec<1>(1.0), EVec<1>(0.0)); });
+    time_replay("UKF<3,3,1>", make_ukf, EVec<3>(30, 0, 1), [](PoseUKF &f) {
+        f.correct(EVec<3>::Zero(), EVec<1>(0.1));
+    });
+
+    sim::finish(host_test::failures);
+}
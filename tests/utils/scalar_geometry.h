@@ -0,0 +1,35 @@
+#pragma once
+
+#include <algorithm>
+
+#include "core/utils/math/geometry/translation2d.h"
+
+/**
+ * Point and segment distances done the plain way, one segment at a time, as the reference the path tests compare the
+ * batch kernels and the grid search against
+ */
+namespace ScalarGeometry {
+
+inline double point_segment_dist(const Translation2d &p, const Translation2d &a, const Translation2d &b) {
+    Translation2d ab = b - a;
+    double len_sq = ab * ab;
+    double t = len_sq > 0 ? std::clamp(((p - a) * ab) / len_sq, 0.0, 1.0) : 0;
+    return p.distance(a + ab * t);
+}
+
+inline double cross(const Translation2d &a, const Translation2d &b) { return a.x() * b.y() - a.y() * b.x(); }
+
+// Two segments cross when each one's ends are on opposite sides of the other
+inline double segment_segment_dist(
+  const Translation2d &a, const Translation2d &b, const Translation2d &c, const Translation2d &d
+) {
+    double d1 = cross(b - a, c - a), d2 = cross(b - a, d - a);
+    double d3 = cross(d - c, a - c), d4 = cross(d - c, b - c);
+    if (((d1 > 0) != (d2 > 0)) && ((d3 > 0) != (d4 > 0))) {
+        return 0;
+    }
+    return std::min({point_segment_dist(a, c, d), point_segment_dist(b, c, d), point_segment_dist(c, a, b),
+                     point_segment_dist(d, a, b)});
+}
+
+} // namespace ScalarGeometry
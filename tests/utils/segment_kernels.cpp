@@ -0,0 +1,213 @@
+// The batch segment kernels against the one-segment-at-a-time geometry they replaced: line_circle_intersections()
+// against the slope-intercept version it used to be, and every kernel against a plain scalar answer on random
+// polylines. Then the cost per segment of each, next to the old line_circle_intersections().
+
+#include <algorithm>
+#include <random>
+
+#include "core/utils/math/geometry/segment_kernels.h"
+#include "core/utils/pure_pursuit.h"
+#include "host_test.h"
+#include "scalar_geometry.h"
+
+using namespace PurePursuit;
+using namespace ScalarGeometry;
+
+namespace {
+
+/**
+ * line_circle_intersections() as it was before it shared the parametric solver: slope-intercept form, with vertical
+ * lines as their own case
+ */
+std::vector<Translation2d>
+slope_intercept_intersections(Translation2d center, double r, Translation2d point1, Translation2d point2) {
+    std::vector<Translation2d> intersections = {};
+    point1 = point1 - center;
+    point2 = point2 - center;
+
+    double x1, x2, y1, y2;
+    if (point1.x() - point2.x() == 0) {
+        x1 = point1.x();
+        y1 = sqrt(pow(r, 2) - pow(x1, 2));
+        x2 = point1.x();
+        y2 = -sqrt(pow(r, 2) - pow(x2, 2));
+    } else {
+        double m = (point1.y() - point2.y()) / (point1.x() - point2.x());
+        double b = point1.y() - (m * point1.x());
+        x1 = ((-m * b) + sqrt(pow(r, 2) + (pow(m, 2) * pow(r, 2)) - pow(b, 2))) / (1 + pow(m, 2));
+        y1 = m * x1 + b;
+        x2 = ((-m * b) - sqrt(pow(r, 2) + (pow(m, 2) * pow(r, 2)) - pow(b, 2))) / (1 + pow(m, 2));
+        y2 = m * x2 + b;
+    }
+
+    if (x1 >= fmin(point1.x(), point2.x()) && x1 <= fmax(point1.x(), point2.x()) &&
+        y1 >= fmin(point1.y(), point2.y()) && y1 <= fmax(point1.y(), point2.y())) {
+        intersections.push_back(Translation2d(x1 + center.x(), y1 + center.y()));
+    }
+    if (x2 >= fmin(point1.x(), point2.x()) && x2 <= fmax(point1.x(), point2.x()) &&
+        y2 >= fmin(point1.y(), point2.y()) && y2 <= fmax(point1.y(), point2.y())) {
+        intersections.push_back(Translation2d(x2 + center.x(), y2 + center.y()));
+    }
+    return intersections;
+}
+
+// Every point of a is within 1e-6 of a point of b
+bool covers(const std::vector<Translation2d> &a, const std::vector<Translation2d> &b) {
+    return std::all_of(a.begin(), a.end(), [&](const Translation2d &p) {
+        return std::any_of(b.begin(), b.end(), [&](const Translation2d &q) { return p.distance(q) < 1e-6; });
+    });
+}
+
+void check_line_circle_intersections() {
+    std::mt19937 rng(3);
+    std::uniform_real_distribution<double> u(-20, 20);
+    int differ = 0, vertical = 0;
+    const int CASES = 200000;
+    for (int k = 0; k < CASES; k++) {
+        Translation2d c(u(rng), u(rng)), a(u(rng), u(rng)), b(u(rng), u(rng));
+        if (k % 10 == 0) {
+            b = Translation2d(a.x(), b.y());
+            vertical++;
+        }
+        double r = std::fabs(u(rng)) + 0.5;
+        std::vector<Translation2d> before = slope_intercept_intersections(c, r, a, b);
+        std::vector<Translation2d> now = line_circle_intersections(c, r, a, b);
+        differ += !covers(before, now) || !covers(now, before);
+    }
+    printf("line_circle_intersections: %d of %d random cases (%d vertical) differ from slope-intercept\n", differ,
+           CASES, vertical);
+    CHECK(differ == 0);
+}
+
+void check_kernels() {
+    std::mt19937 rng(4);
+    std::uniform_real_distribution<double> u(-100, 100);
+    std::vector<Translation2d> pts;
+    for (int i = 0; i < 1000; i++) {
+        pts.push_back(Translation2d(u(rng), u(rng)));
+    }
+    // A segment with no length
+    pts[500] = pts[499];
+    SegmentBuffer segs(pts);
+    size_t n = segs.size();
+    std::vector<double> t(n), dist_sq(n), t_near(n), t_far(n), approach_sq(n);
+
+    double worst_closest = 0, worst_approach = 0, worst_circle = 0, worst_nearest = 0;
+    int circle_count_differs = 0;
+    for (int k = 0; k < 200; k++) {
+        Translation2d p(u(rng), u(rng)), q(u(rng), u(rng));
+        double r = std::fabs(u(rng)) * 0.5 + 1;
+        SegmentKernels::closest_points(segs, 0, n, p, t.data(), dist_sq.data());
+        SegmentKernels::closest_approaches(segs, 0, n, p, q, approach_sq.data());
+        SegmentKernels::circle_intersections(segs, 0, n, p, r, t_near.data(), t_far.data());
+
+        double best = 1e18;
+        for (size_t i = 0; i < n; i++) {
+            const Translation2d &a = pts[i], &b = pts[i + 1];
+            double expected = point_segment_dist(p, a, b);
+            best = std::min(best, expected);
+            worst_closest = std::max(worst_closest, std::fabs(sqrt(dist_sq[i]) - expected));
+            worst_approach =
+              std::max(worst_approach, std::fabs(sqrt(approach_sq[i]) - segment_segment_dist(p, q, a, b)));
+
+            std::vector<Translation2d> hits;
+            for (double tt : {t_near[i], t_far[i]}) {
+                if (tt != SegmentKernels::NO_INTERSECTION) {
+                    Translation2d hit = a + (b - a) * tt;
+                    hits.push_back(hit);
+                    worst_circle = std::max(worst_circle, std::fabs(hit.distance(p) - r));
+                }
+            }
+            // Tangent touches can come out as one solution or two equal ones
+            if (a.distance(b) > 0 && (!covers(hits, line_circle_intersections(p, r, a, b)) ||
+                                      !covers(line_circle_intersections(p, r, a, b), hits))) {
+                circle_count_differs++;
+            }
+        }
+
+        double nearest_t, nearest_sq;
+        SegmentKernels::nearest_on_polyline(segs, 0, n, p, nearest_t, nearest_sq);
+        worst_nearest = std::max(worst_nearest, std::fabs(sqrt(nearest_sq) - best));
+    }
+    printf("kernels vs scalar geometry: closest_points %.1e, closest_approaches %.1e, circle_intersections %.1e, "
+           "nearest_on_polyline %.1e in; %d circle cases differ from line_circle_intersections\n",
+           worst_closest, worst_approach, worst_circle, worst_nearest, circle_count_differs);
+    CHECK(worst_closest < 1e-9);
+    CHECK(worst_approach < 1e-9);
+    CHECK(worst_circle < 1e-9);
+    CHECK(worst_nearest < 1e-9);
+    CHECK(circle_count_differs == 0);
+
+    // The furthest intersection along a path that crosses a circle several times is on the last segment in
+    std::vector<Translation2d> zigzag;
+    for (int i = 0; i < 20; i++) {
+        zigzag.push_back(Translation2d(i, i % 2 == 0 ? -10 : 10));
+    }
+    SegmentBuffer zsegs(zigzag);
+    double ft;
+    size_t seg = SegmentKernels::furthest_circle_intersection(zsegs, 0, zsegs.size(), Translation2d(5, 0), 4, ft);
+    CHECK(seg == 8);
+    CHECK(SegmentKernels::furthest_circle_intersection(zsegs, 0, zsegs.size(), Translation2d(100, 0), 4, ft) ==
+          zsegs.size());
+}
+
+void benchmark() {
+    std::mt19937 rng(5);
+    std::uniform_real_distribution<double> u(-100, 100);
+    std::vector<Translation2d> pts;
+    for (int i = 0; i < 1001; i++) {
+        pts.push_back(Translation2d(u(rng), u(rng)));
+    }
+    SegmentBuffer segs(pts);
+    size_t n = segs.size();
+    std::vector<double> a(n), b(n);
+    Translation2d c(3, 4);
+    volatile double sink = 0;
+    const int REPS = 2000;
+
+    double old_ns = host_test::time_ns(REPS, [&] {
+        for (size_t i = 0; i < n; i++) {
+            sink = sink + slope_intercept_intersections(c, 20, pts[i], pts[i + 1]).size();
+        }
+    });
+    double circle_ns = host_test::time_ns(REPS, [&] {
+        SegmentKernels::circle_intersections(segs, 0, n, c, 20, a.data(), b.data());
+        sink = sink + a[7];
+    });
+    double closest_ns = host_test::time_ns(REPS, [&] {
+        SegmentKernels::closest_points(segs, 0, n, c, a.data(), b.data());
+        sink = sink + b[7];
+    });
+    double approach_ns = host_test::time_ns(REPS, [&] {
+        SegmentKernels::closest_approaches(segs, 0, n, c, Translation2d(9, 9), a.data());
+        sink = sink + a[7];
+    });
+    printf("per segment: slope-intercept line_circle_intersections %.1f ns, circle_intersections %.1f ns, "
+           "closest_points %.1f ns, closest_approaches %.1f ns\n",
+           old_ns / n, circle_ns / n, closest_ns / n, approach_ns / n);
+
+    // What the tracker built on them costs on a long path
+    std::vector<Translation2d> wave;
+    for (int i = 0; i < 5000; i++) {
+        double s = i / 4999.0;
+        wave.push_back(Translation2d(600 * s, 30 * sin(s * 12)));
+    }
+    Path path(wave, 12);
+    Tracker tracker(path);
+    int k = 0;
+    double tracker_ns = host_test::time_ns(2000, [&] {
+        double s = k++ / 2000.0;
+        tracker.update(Pose2d(600 * s, 30 * sin(s * 12) + 2, 0));
+    });
+    printf("Tracker update on a 5000 point path: %.2f us\n", tracker_ns / 1000);
+}
+
+} // namespace
+
+int main() {
+    check_line_circle_intersections();
+    check_kernels();
+    benchmark();
+
+    sim::finish(host_test::failures);
+}
@@ -0,0 +1,151 @@
+// Readers polling state a 1 kHz background task owns, published through a SeqLock versus copied out under the mutex
+// the task holds while it updates, the way the odometry getters used to. Checks the SeqLock never hands out a torn
+// value, and prints how long a read takes either way.
+
+#include <algorithm>
+#include <atomic>
+#include <thread>
+
+#include "core/utils/snapshot.h"
+#include "host_test.h"
+
+namespace {
+
+// About the size of the odometry state
+typedef struct {
+    double v[12];
+} state_t;
+
+constexpr int WRITE_PERIOD_US = 1000;
+constexpr int UPDATE_WORK_US = 200; // how long each update takes before it has a new value
+constexpr size_t READS = 10000000;  // about a second of polling
+
+state_t make_state(uint64_t i) {
+    state_t s;
+    for (double &d : s.v) {
+        d = (double)i;
+    }
+    return s;
+}
+
+bool consistent(const state_t &s) {
+    return std::all_of(std::begin(s.v), std::end(s.v), [&](double d) { return d == s.v[0]; });
+}
+
+void busy_us(int us) {
+    auto until = std::chrono::steady_clock::now() + std::chrono::microseconds(us);
+    while (std::chrono::steady_clock::now() < until) {
+    }
+}
+
+/**
+ * A writer as fast as it can go against a reader as fast as it can go: every value read has to be one that was
+ * written, whole, and never older than the one before
+ */
+void check_consistency() {
+    SeqLock<state_t> lock(make_state(0));
+    std::atomic<bool> done{false};
+    std::thread writer([&] {
+        for (uint64_t i = 1; i < 3000000; i++) {
+            lock.write(make_state(i));
+        }
+        done = true;
+    });
+    long reads = 0, torn = 0, backwards = 0;
+    double last = 0;
+    while (!done) {
+        state_t s = lock.read();
+        torn += !consistent(s);
+        backwards += s.v[0] < last;
+        last = s.v[0];
+        reads++;
+    }
+    writer.join();
+    printf("consistency: %ld reads against 3M writes, %ld torn, %ld out of order\n", reads, torn, backwards);
+    CHECK(torn == 0);
+    CHECK(backwards == 0);
+}
+
+typedef struct {
+    long reads;
+    double p50_ns, p99_ns, p999_ns, max_ns;
+} latency_t;
+
+/**
+ * Time every read a reader makes while a writer updates at 1 kHz
+ */
+template <typename Write, typename Read> latency_t measure(Write write, Read read) {
+    std::atomic<bool> done{false};
+    std::thread writer([&] {
+        auto next = std::chrono::steady_clock::now();
+        for (uint64_t i = 1; !done; i++) {
+            next += std::chrono::microseconds(WRITE_PERIOD_US);
+            write(i);
+            std::this_thread::sleep_until(next);
+        }
+    });
+
+    std::vector<double> ns;
+    ns.reserve(READS);
+    long torn = 0;
+    for (auto now = std::chrono::steady_clock::now(); ns.size() < READS;) {
+        state_t s = read();
+        auto after = std::chrono::steady_clock::now();
+        ns.push_back(std::chrono::duration<double, std::nano>(after - now).count());
+        torn += !consistent(s);
+        now = after;
+    }
+    done = true;
+    writer.join();
+    CHECK(torn == 0);
+
+    std::sort(ns.begin(), ns.end());
+    auto pct = [&](double p) { return ns[std::min(ns.size() - 1, (size_t)(p * ns.size()))]; };
+    return {(long)ns.size(), pct(0.5), pct(0.99), pct(0.999), ns.back()};
+}
+
+void report(const char *name, const latency_t &l) {
+    printf("%-8s %9ld reads  p50 %6.0f ns  p99 %8.0f ns  p99.9 %8.0f ns  max %8.0f ns\n", name, l.reads, l.p50_ns,
+           l.p99_ns, l.p999_ns, l.max_ns);
+}
+
+} // namespace
+
+int main() {
+    check_consistency();
+
+    printf("reader latency, writer at %d Hz spending %d us per update, %u cores:\n", 1000000 / WRITE_PERIOD_US,
+           UPDATE_WORK_US, std::thread::hardware_concurrency());
+
+    // The task holds the mutex for the whole update, so a reader arriving mid-update waits for the rest of it
+    vex::mutex mut;
+    state_t shared = make_state(0);
+    latency_t with_mutex = measure(
+      [&](uint64_t i) {
+          mut.lock();
+          busy_us(UPDATE_WORK_US);
+          shared = make_state(i);
+          mut.unlock();
+      },
+      [&] {
+          mut.lock();
+          state_t s = shared;
+          mut.unlock();
+          return s;
+      }
+    );
+    report("mutex", with_mutex);
+
+    // The task does the same work, then publishes. A reader only ever waits out the copy
+    SeqLock<state_t> snapshot(make_state(0));
+    latency_t with_seqlock = measure(
+      [&](uint64_t i) {
+          busy_us(UPDATE_WORK_US);
+          snapshot.write(make_state(i));
+      },
+      [&] { return snapshot.read(); }
+    );
+    report("seqlock", with_seqlock);
+
+    sim::finish(host_test::failures);
+}
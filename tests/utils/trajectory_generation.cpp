@@ -0,0 +1,139 @@
+// Trajectory generated along a hermite S-curve about 2.8 m long: every state has to respect the wheel speed,
+// acceleration and centripetal limits, and driving the sampled speeds has to cover the path. A straight line has to
+// take the time a trapezoid profile says it does, forwards and reversed, and a sharp corner has to nearly stop the
+// robot. A path shorter than the spacing, starting and ending at rest, has to move through its one piece instead of
+// sitting at the start. What generating and sampling cost is printed.
+
+#include <algorithm>
+
+#include "core/utils/pure_pursuit.h"
+#include "core/utils/trajectory.h"
+#include "host_test.h"
+
+namespace {
+
+const Trajectory::trajectory_config_t CONFIG{60, 80, 50, 12, 0, 0, 0.5, false};
+
+// Enough for the rounding in the constant acceleration pieces
+constexpr double SLACK = 1e-6;
+
+void check_s_curve() {
+    std::vector<PurePursuit::hermite_point> waypoints = {{0, 0, 0, 60}, {40, 30, M_PI / 2, 60}, {70, 70, 0, 60}};
+    std::vector<Translation2d> pts = PurePursuit::smooth_path_hermite(waypoints, 40);
+
+    Trajectory traj;
+    double generate_us = host_test::time_ns(200, [&] { traj = Trajectory(pts, CONFIG); }) / 1000;
+    const std::vector<Trajectory::state_t> &states = traj.get_states();
+
+    double worst_wheel = 0, worst_accel = 0, worst_centripetal = 0;
+    bool time_increases = true;
+    for (size_t i = 0; i < states.size(); i++) {
+        const Trajectory::state_t &s = states[i];
+        worst_wheel = std::max(worst_wheel, std::fabs(s.vel) * (1 + std::fabs(s.curvature) * CONFIG.track_width / 2));
+        worst_accel = std::max(worst_accel, std::fabs(s.accel));
+        worst_centripetal = std::max(worst_centripetal, s.vel * s.vel * std::fabs(s.curvature));
+        if (i > 0) {
+            time_increases &= s.time > states[i - 1].time;
+        }
+    }
+
+    // Drive the sampled speed for the whole trajectory, 1 ms at a time
+    const double DT = 0.001;
+    double driven = 0, worst_sampled_speed = 0;
+    Trajectory::state_t prev = traj.sample(0);
+    for (double t = DT; t <= traj.total_time() + DT / 2; t += DT) {
+        Trajectory::state_t s = traj.sample(t);
+        driven += (prev.vel + s.vel) / 2 * DT;
+        worst_sampled_speed =
+          std::max(worst_sampled_speed, s.pose.translation().distance(prev.pose.translation()) / DT);
+        prev = s;
+    }
+    Trajectory::state_t end = traj.sample(1e9);
+
+    int samples = 1000000, k = 0;
+    volatile double sink = 0;
+    double sample_ns = host_test::time_ns(samples, [&] {
+        sink = sink + traj.sample(k++ * traj.total_time() / samples).vel;
+    });
+
+    printf("S-curve: %zu states, %.1f in, %.3f s, generated in %.1f us, sampled in %.0f ns\n", states.size(),
+           traj.total_dist(), traj.total_time(), generate_us, sample_ns);
+    printf("  worst: wheel %.2f of %.0f in/s, accel %.2f of %.0f in/s^2, centripetal %.2f of %.0f in/s^2, sampled "
+           "speed %.2f in/s  |  driven %.2f of %.2f in\n",
+           worst_wheel, CONFIG.max_vel, worst_accel, CONFIG.max_accel, worst_centripetal, CONFIG.max_centripetal_accel,
+           worst_sampled_speed, driven, traj.total_dist());
+
+    CHECK(time_increases);
+    CHECK(worst_wheel <= CONFIG.max_vel + SLACK);
+    CHECK(worst_accel <= CONFIG.max_accel + SLACK);
+    CHECK(worst_centripetal <= CONFIG.max_centripetal_accel + SLACK);
+    CHECK(worst_sampled_speed <= CONFIG.max_vel + 0.1);
+    CHECK_NEAR(driven, traj.total_dist(), traj.total_dist() * 0.001);
+    CHECK(end.pose.translation().distance(pts.back()) < 1e-6);
+    CHECK_NEAR(end.vel, 0, 1e-9);
+}
+
+void check_straight() {
+    // Speeds up at max_accel to max_vel, cruises, and slows down the same way
+    const double TRAPEZOID = 48 / CONFIG.max_vel + CONFIG.max_vel / CONFIG.max_accel;
+    Trajectory forward({Translation2d(0, 0), Translation2d(48, 0)}, CONFIG);
+    printf("48 in straight: %.4f s, trapezoid profile %.4f s\n", forward.total_time(), TRAPEZOID);
+    CHECK_NEAR(forward.total_time(), TRAPEZOID, 1e-6);
+    CHECK_NEAR(forward.sample(forward.total_time() / 2).vel, CONFIG.max_vel, 1e-6);
+
+    // Backwards, the robot faces away from where it's going and its speed is negative
+    Trajectory::trajectory_config_t reversed_config = CONFIG;
+    reversed_config.reversed = true;
+    Trajectory reversed({Translation2d(0, 0), Translation2d(-48, 0)}, reversed_config);
+    Trajectory::state_t middle = reversed.sample(reversed.total_time() / 2);
+    CHECK_NEAR(reversed.total_time(), TRAPEZOID, 1e-6);
+    CHECK_NEAR(middle.pose.x(), -24, 1e-6);
+    CHECK_NEAR(middle.pose.rotation().radians(), 0, 1e-9);
+    CHECK_NEAR(middle.vel, -CONFIG.max_vel, 1e-6);
+
+    // Times past either end get the end states
+    CHECK(forward.sample(-1).dist == 0);
+    CHECK_NEAR(forward.sample(100).dist, 48, 1e-9);
+}
+
+void check_corner() {
+    Trajectory corner({Translation2d(0, 0), Translation2d(24, 0), Translation2d(24, 24)}, CONFIG);
+    double slowest = 1e9;
+    for (const Trajectory::state_t &s : corner.get_states()) {
+        if (s.dist > 1 && s.dist < 47) {
+            slowest = std::min(slowest, s.vel);
+        }
+    }
+    printf("90 degree corner: slowest %.3f in/s\n", slowest);
+    CHECK(slowest < 5);
+    CHECK(slowest > 0);
+}
+
+void check_short() {
+    // Speeds up at max_accel to the middle and slows back down
+    const double LENGTH = 0.3;
+    const double T = 2 * sqrt(LENGTH / CONFIG.max_accel);
+    Trajectory hop({Translation2d(0, 0), Translation2d(LENGTH, 0)}, CONFIG);
+    Trajectory::state_t quarter = hop.sample(T / 4), middle = hop.sample(T / 2), three_quarters = hop.sample(T * 3 / 4);
+    printf("%.1f in hop: %.4f s, at a quarter %.4f in, halfway %.4f in at %.2f in/s, at three quarters %.4f in\n",
+           LENGTH, hop.total_time(), quarter.pose.x(), middle.pose.x(), middle.vel, three_quarters.pose.x());
+    CHECK_NEAR(hop.total_time(), T, 1e-9);
+    CHECK_NEAR(quarter.pose.x(), LENGTH / 8, 1e-9);
+    CHECK_NEAR(quarter.accel, CONFIG.max_accel, 1e-9);
+    CHECK_NEAR(middle.pose.x(), LENGTH / 2, 1e-9);
+    CHECK_NEAR(middle.vel, sqrt(CONFIG.max_accel * LENGTH), 1e-9);
+    CHECK_NEAR(three_quarters.pose.x(), LENGTH * 7 / 8, 1e-9);
+    CHECK_NEAR(three_quarters.accel, -CONFIG.max_accel, 1e-9);
+    CHECK_NEAR(hop.sample(T).vel, 0, 1e-9);
+}
+
+} // namespace
+
+int main() {
+    check_s_curve();
+    check_straight();
+    check_corner();
+    check_short();
+
+    sim::finish(host_test::failures);
+}
@@ -0,0 +1,86 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+/**
+ * Controls for the host stand-in of the VEX SDK (vex.h), for tests to drive the simulated brain
+ */
+namespace sim {
+
+/**
+ * Switch between the computer's clock and a fake one. While the fake clock is on, time only moves when a test moves
+ * it or something calls vexDelay(), which moves it instead of sleeping. Only use the fake clock when no task is
+ * sleeping on it
+ *
+ * @param fake true for the fake clock
+ */
+void use_fake_clock(bool fake);
+
+/**
+ * Set the fake clock
+ * @param us the new time (us)
+ */
+void set_time_us(uint64_t us);
+
+/**
+ * Move the fake clock forward
+ * @param us how far to move it (us)
+ */
+void advance_us(uint64_t us);
+
+/**
+ * Put the SD card in a directory, created if needed. Defaults to "sd" in the working directory
+ * @param dir the directory
+ */
+void set_sd_dir(const std::string &dir);
+
+/**
+ * Get the path on the computer of a file on the SD card
+ * @param name the file's name on the SD card
+ */
+std::string sd_path(const char *name);
+
+/**
+ * Make every sdcard::appendfile() call take at least this long, like a real card
+ * @param ms how long (ms)
+ */
+void set_sd_write_delay_ms(uint32_t ms);
+
+/**
+ * Get the number of sdcard::appendfile() calls so far
+ */
+size_t sd_appends();
+
+/**
+ * Queue bytes for a smart port to receive
+ * @param port the port (0 for PORT1)
+ * @param data the bytes
+ * @param len the number of bytes
+ */
+void serial_feed(uint32_t port, const uint8_t *data, size_t len);
+
+/**
+ * Take every byte a smart port has transmitted since the last call
+ * @param port the port (0 for PORT1)
+ */
+std::vector<uint8_t> serial_take_sent(uint32_t port);
+
+/**
+ * Connect a smart port to a file descriptor, like one end of a pty: the port receives what can be read from it, and
+ * transmits by writing to it. The descriptor is made non-blocking
+ *
+ * @param port the port (0 for PORT1)
+ * @param fd the file descriptor, or -1 to go back to the byte queues
+ */
+void serial_attach(uint32_t port, int fd);
+
+/**
+ * Print the test's result and exit, without running destructors: tasks may still be running on objects a test owns
+ * @param failures the number of failed checks
+ */
+[[noreturn]] void finish(int failures);
+
+} // namespace sim
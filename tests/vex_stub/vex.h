@@ -0,0 +1,389 @@
+#pragma once
+
+/**
+ * Host stand-in for the parts of the VEX V5 SDK the core library uses, so it can be built and tested on a computer.
+ *
+ * Only what the host tests need is here. Sensors read back whatever a test put in their sim_ fields, motors remember
+ * what they were last told to do, tasks are real threads, the SD card is a directory, and smart port serial is a
+ * queue of bytes or a file descriptor (see sim.h for the controls).
+ */
+
+#include <cmath>
+#include <cstdarg>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <mutex>
+#include <vector>
+
+#ifndef M_TWOPI
+#define M_TWOPI (M_PI * 2.0)
+#endif
+
+#define vex_vsnprintf vsnprintf
+
+typedef FILE FIL;
+
+extern "C" {
+void vexDelay(uint32_t ms);
+uint32_t vexSystemTimeGet();
+uint64_t vexSystemHighResTimeGet();
+
+void vexGenericSerialEnable(uint32_t index, uint32_t options);
+void vexGenericSerialBaudrate(uint32_t index, uint32_t baudrate);
+int32_t vexGenericSerialReadChar(uint32_t index);
+int32_t vexGenericSerialReceiveAvail(uint32_t index);
+int32_t vexGenericSerialReceive(uint32_t index, uint8_t *buffer, int32_t length);
+int32_t vexGenericSerialTransmit(uint32_t index, uint8_t *buffer, int32_t length);
+int32_t vexGenericSerialWriteFree(uint32_t index);
+void vexGenericSerialFlush(uint32_t index);
+
+FIL *vexFileOpen(const char *filename, const char *mode);
+FIL *vexFileOpenWrite(const char *filename);
+FIL *vexFileOpenCreate(const char *filename);
+void vexFileClose(FIL *fdp);
+int32_t vexFileRead(char *buf, uint32_t size, uint32_t nItems, FIL *fdp);
+int32_t vexFileWrite(char *buf, uint32_t size, uint32_t nItems, FIL *fdp);
+int32_t vexFileSize(FIL *fdp);
+int32_t vexFileSeek(FIL *fdp, uint32_t offset, int32_t whence);
+int32_t vexFileTell(FIL *fdp);
+void vexFileSync(FIL *fdp);
+}
+
+namespace vex {
+
+enum class rotationUnits { deg, rev, raw };
+enum class distanceUnits { mm, in, cm };
+enum class velocityUnits { pct, rpm, dps };
+enum class voltageUnits { volt, mV };
+enum class percentUnits { pct };
+enum class currentUnits { amp };
+enum class temperatureUnits { celsius, fahrenheit };
+enum class timeUnits { sec, msec };
+enum class directionType { fwd, rev, undefined };
+enum class brakeType { coast, brake, hold, undefined };
+enum class fontType { mono12, mono15, mono20, mono30, mono40, mono60, prop20, prop30, prop40, prop60, mono, prop };
+
+constexpr rotationUnits deg = rotationUnits::deg, degrees = rotationUnits::deg, rev = rotationUnits::rev,
+                        turns = rotationUnits::rev;
+constexpr distanceUnits inches = distanceUnits::in, mm = distanceUnits::mm;
+constexpr directionType fwd = directionType::fwd, forward = directionType::fwd, reverse = directionType::rev;
+constexpr timeUnits sec = timeUnits::sec, seconds = timeUnits::sec, msec = timeUnits::msec;
+constexpr voltageUnits volt = voltageUnits::volt, voltage = voltageUnits::volt;
+constexpr velocityUnits rpm = velocityUnits::rpm, dps = velocityUnits::dps;
+constexpr percentUnits percent = percentUnits::pct, pct = percentUnits::pct;
+constexpr temperatureUnits celsius = temperatureUnits::celsius;
+constexpr brakeType coast = brakeType::coast, brake = brakeType::brake, hold = brakeType::hold;
+
+enum PORTS {
+    PORT1 = 0, PORT2, PORT3, PORT4, PORT5, PORT6, PORT7, PORT8, PORT9, PORT10, PORT11,
+    PORT12, PORT13, PORT14, PORT15, PORT16, PORT17, PORT18, PORT19, PORT20, PORT21
+};
+
+class color {
+  public:
+    color() = default;
+    color(int, int, int) {}
+    color(uint32_t) {}
+};
+extern const color white, black, red, green, blue, yellow, orange, purple, cyan, transparent;
+
+class mutex {
+  public:
+    void lock() { m.lock(); }
+    void unlock() { m.unlock(); }
+    bool try_lock() { return m.try_lock(); }
+
+  private:
+    std::mutex m;
+};
+
+class thread {
+  public:
+    static const int32_t threadPriorityLow = 1;
+    static const int32_t threadPriorityNormal = 7;
+    static const int32_t threadPriorityHigh = 15;
+};
+
+namespace this_thread {
+void yield();
+void sleep_for(uint32_t ms);
+} // namespace this_thread
+
+/**
+ * A task runs on its own detached thread from the moment it's created. stop() and suspend() do nothing, so objects
+ * that own a running task must outlive it: tests end with sim::finish(), which exits without running destructors
+ */
+class task {
+  public:
+    task() = default;
+    task(int (*callback)(void));
+    task(int (*callback)(void *), void *arg);
+    task(int (*callback)(void *), void *arg, int32_t priority);
+    void stop() {}
+    void suspend() {}
+    void resume() {}
+    static void sleep(uint32_t ms) { vexDelay(ms); }
+};
+
+class timer {
+  public:
+    timer();
+    double time();
+    double time(timeUnits units);
+    double value();
+    void reset();
+    void clear() { reset(); }
+    static uint32_t system();
+    static uint64_t systemHighResolution();
+
+  private:
+    uint64_t start_us;
+};
+
+class device {
+  public:
+    bool installed() { return sim_installed; }
+    int32_t timestamp() { return sim_timestamp; }
+
+    bool sim_installed = true; ///< what installed() returns
+    int32_t sim_timestamp = 0; ///< what timestamp() returns (ms), when the last reading was taken
+};
+
+class triport {
+  public:
+    /**
+     * A 3 wire port. An encoder plugged into it reads sim_deg
+     */
+    class port {
+      public:
+        double sim_deg = 0; ///< encoder position (deg)
+        double sim_dps = 0; ///< encoder velocity (deg/s)
+    };
+    triport(int32_t) {}
+    port A, B, C, D, E, F, G, H;
+};
+
+class encoder {
+  public:
+    encoder(triport::port &port) : sim_port(&port) {}
+    double position(rotationUnits units);
+    double rotation(rotationUnits units) { return position(units); }
+    double velocity(velocityUnits units);
+    void setPosition(double value, rotationUnits units);
+    void setRotation(double value, rotationUnits units) { setPosition(value, units); }
+    void resetRotation() { setPosition(0, rotationUnits::deg); }
+
+  private:
+    triport::port *sim_port;
+    double offset_deg = 0;
+};
+
+class motor : public device {
+  public:
+    motor(int32_t index, bool reversed = false) : reversed(reversed) { (void)index; }
+    motor(int32_t index, int32_t gears, bool reversed = false) : reversed(reversed) { (void)index, (void)gears; }
+    void spin(directionType dir, double value, voltageUnits units);
+    void spin(directionType dir, double value, velocityUnits units);
+    void spin(directionType dir) { (void)dir; }
+    void stop() { sim_voltage = 0; }
+    void stop(brakeType mode) { (void)mode, sim_voltage = 0; }
+    void setBrake(brakeType mode) { (void)mode; }
+    void setVelocity(double value, velocityUnits units) { (void)value, (void)units; }
+    double position(rotationUnits units) { return units == rotationUnits::rev ? sim_deg / 360.0 : sim_deg; }
+    double velocity(velocityUnits units) { return units == velocityUnits::dps ? sim_rpm * 6 : sim_rpm; }
+    double voltage(voltageUnits units = voltageUnits::volt) {
+        return units == voltageUnits::mV ? sim_voltage * 1000 : sim_voltage;
+    }
+    double current(currentUnits units = currentUnits::amp) { return (void)units, 0; }
+    double temperature(temperatureUnits units = temperatureUnits::celsius) { return (void)units, 25; }
+    void setPosition(double value, rotationUnits units) { sim_deg = units == rotationUnits::rev ? value * 360 : value; }
+    void resetPosition() { sim_deg = 0; }
+
+    bool reversed;
+    double sim_deg = 0;     ///< what position() returns (deg)
+    double sim_rpm = 0;     ///< what velocity() returns (rpm)
+    double sim_voltage = 0; ///< the last voltage the motor was told to spin at, or the velocity as a fraction of 12V
+};
+
+class motor_group {
+  public:
+    motor_group() = default;
+    template <typename... Motors> motor_group(Motors &...motors) : motors{&motors...} {}
+    void spin(directionType dir, double value, voltageUnits units);
+    void spin(directionType dir, double value, velocityUnits units);
+    void spin(directionType dir) { (void)dir; }
+    void stop();
+    void stop(brakeType mode) { (void)mode, stop(); }
+    void setStopping(brakeType mode) { (void)mode; }
+    void setVelocity(double value, velocityUnits units) { (void)value, (void)units; }
+    double position(rotationUnits units) { return units == rotationUnits::rev ? sim_deg / 360.0 : sim_deg; }
+    double velocity(velocityUnits units) { return units == velocityUnits::dps ? sim_rpm * 6 : sim_rpm; }
+    double voltage(voltageUnits units = voltageUnits::volt) {
+        return units == voltageUnits::mV ? sim_voltage * 1000 : sim_voltage;
+    }
+    double current(currentUnits units = currentUnits::amp) { return (void)units, 0; }
+    double temperature(temperatureUnits units = temperatureUnits::celsius) { return (void)units, 25; }
+    void setPosition(double value, rotationUnits units) { sim_deg = units == rotationUnits::rev ? value * 360 : value; }
+    void resetPosition() { sim_deg = 0; }
+    int32_t count() { return (int32_t)motors.size(); }
+
+    std::vector<motor *> motors;
+    double sim_deg = 0;     ///< what position() returns (deg)
+    double sim_rpm = 0;     ///< what velocity() returns (rpm)
+    double sim_voltage = 0; ///< the last voltage the group was told to spin at, or the velocity as a fraction of 12V
+};
+
+class inertial : public device {
+  public:
+    inertial(int32_t index) { (void)index; }
+    double rotation(rotationUnits units = rotationUnits::deg) {
+        return units == rotationUnits::rev ? sim_deg / 360 : sim_deg;
+    }
+    double heading(rotationUnits units = rotationUnits::deg);
+    double gyroRate(int axis, velocityUnits units) { return (void)axis, (void)units, sim_dps; }
+    void setRotation(double value, rotationUnits units) { sim_deg = units == rotationUnits::rev ? value * 360 : value; }
+    void setHeading(double value, rotationUnits units) { setRotation(value, units); }
+    void resetRotation() { sim_deg = 0; }
+    void calibrate() {}
+    bool isCalibrating() { return false; }
+
+    double sim_deg = 0; ///< what rotation() returns, clockwise positive like the real sensor (deg)
+    double sim_dps = 0; ///< what gyroRate() returns (deg/s)
+};
+
+class rotation : public device {
+  public:
+    rotation(int32_t index, bool reversed = false) { (void)index, (void)reversed; }
+    double position(rotationUnits units) { return units == rotationUnits::rev ? sim_deg / 360 : sim_deg; }
+    double angle(rotationUnits units = rotationUnits::deg) { return (void)units, fmod(sim_deg, 360); }
+    double velocity(velocityUnits units) { return units == velocityUnits::dps ? sim_dps : sim_dps / 6; }
+    void setPosition(double value, rotationUnits units) { sim_deg = units == rotationUnits::rev ? value * 360 : value; }
+    void resetPosition() { sim_deg = 0; }
+
+    double sim_deg = 0; ///< what position() returns (deg)
+    double sim_dps = 0; ///< what velocity() returns (deg/s)
+};
+
+class distance : public device {
+  public:
+    distance(int32_t index) { (void)index; }
+    double objectDistance(distanceUnits units) {
+        return units == distanceUnits::mm ? sim_in * 25.4 : units == distanceUnits::cm ? sim_in * 2.54 : sim_in;
+    }
+    bool isObjectDetected() { return sim_detected; }
+
+    double sim_in = 0;        ///< what objectDistance() returns (inch)
+    bool sim_detected = true; ///< what isObjectDetected() returns
+};
+
+class pneumatics {
+  public:
+    pneumatics(triport::port &port) { (void)port; }
+    void open() { sim_open = true; }
+    void close() { sim_open = false; }
+    void set(bool value) { sim_open = value; }
+    bool value() { return sim_open; }
+
+    bool sim_open = false;
+};
+
+class controller {
+  public:
+    class axis {
+      public:
+        int32_t position() { return (int32_t)sim_pct; }
+        int32_t position(percentUnits units) { return (void)units, (int32_t)sim_pct; }
+        double sim_pct = 0;
+    };
+    class button {
+      public:
+        bool pressing() { return sim_pressing; }
+        void pressed(void (*callback)(void)) { (void)callback; }
+        void released(void (*callback)(void)) { (void)callback; }
+        bool sim_pressing = false;
+    };
+    class lcd {
+      public:
+        template <typename... Args> void print(Args...) {}
+        void clearScreen() {}
+        void clearLine() {}
+        void clearLine(int32_t) {}
+        void newLine() {}
+        void setCursor(int32_t, int32_t) {}
+    };
+    controller() = default;
+    void rumble(const char *) {}
+
+    axis Axis1, Axis2, Axis3, Axis4;
+    button ButtonA, ButtonB, ButtonX, ButtonY, ButtonUp, ButtonDown, ButtonLeft, ButtonRight, ButtonL1, ButtonL2,
+      ButtonR1, ButtonR2;
+    lcd Screen;
+};
+
+class brain {
+  public:
+    class lcd {
+      public:
+        template <typename... Args> void print(Args...) {}
+        template <typename... Args> void printAt(int32_t, int32_t, Args...) {}
+        template <typename... Args> void printAt(int32_t, int32_t, bool, Args...) {}
+        void setCursor(int32_t, int32_t) {}
+        void newLine() {}
+        void clearScreen() {}
+        void clearScreen(const color &) {}
+        void setPenColor(const color &) {}
+        void setPenWidth(uint32_t) {}
+        void setFillColor(const color &) {}
+        void setFont(fontType) {}
+        void drawLine(int32_t, int32_t, int32_t, int32_t) {}
+        void drawCircle(int32_t, int32_t, int32_t) {}
+        void drawCircle(int32_t, int32_t, int32_t, const color &) {}
+        void drawRectangle(int32_t, int32_t, int32_t, int32_t) {}
+        void drawRectangle(int32_t, int32_t, int32_t, int32_t, const color &) {}
+        bool drawImageFromBuffer(uint8_t *, int32_t, int32_t, int32_t) { return false; }
+        int32_t getStringWidth(const char *s) { return 10 * (int32_t)strlen(s); }
+        int32_t getStringHeight(const char *) { return 20; }
+        bool pressing() { return false; }
+        int32_t xPosition() { return 0; }
+        int32_t yPosition() { return 0; }
+        bool render() { return true; }
+    };
+
+    /**
+     * The SD card, as a directory on the computer (see sim::set_sd_dir)
+     */
+    class sdcard {
+      public:
+        bool isInserted();
+        bool exists(const char *name);
+        int32_t size(const char *name);
+        int32_t loadfile(const char *name, uint8_t *buffer, int32_t len);
+        int32_t savefile(const char *name, uint8_t *buffer, int32_t len);
+        int32_t appendfile(const char *name, uint8_t *buffer, int32_t len);
+    };
+
+    class battery {
+      public:
+        double voltage() { return 12.6; }
+        double temperature(temperatureUnits) { return 25; }
+        uint32_t capacity() { return 100; }
+    };
+
+    lcd Screen;
+    sdcard SDcard;
+    battery Battery;
+    timer Timer;
+};
+
+class competition {
+  public:
+    bool isAutonomous() { return false; }
+    bool isDriverControl() { return true; }
+    bool isEnabled() { return true; }
+};
+
+} // namespace vex
+
+using namespace vex;
@@ -0,0 +1,349 @@
+#include "vex.h"
+
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <deque>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <thread>
+#include <unistd.h>
+
+#include "sim.h"
+
+namespace {
+
+const auto clock_start = std::chrono::steady_clock::now();
+std::atomic<bool> fake_clock{false};
+std::atomic<uint64_t> fake_us{0};
+
+std::string sd_dir = "sd";
+bool sd_dir_made = false;
+uint32_t sd_write_delay_ms = 0;
+std::atomic<size_t> sd_append_count{0};
+
+const char *sd_dir_path() {
+    if (!sd_dir_made) {
+        mkdir(sd_dir.c_str(), 0755);
+        sd_dir_made = true;
+    }
+    return sd_dir.c_str();
+}
+
+struct serial_port_t {
+    std::mutex mut;
+    std::deque<uint8_t> rx;
+    std::vector<uint8_t> tx;
+    int fd = -1;
+};
+serial_port_t serial_ports[vex::PORT21 + 1];
+
+serial_port_t *serial_port(uint32_t index) { return index <= vex::PORT21 ? &serial_ports[index] : nullptr; }
+
+// Move whatever the descriptor has into the receive queue. Called with the port's mutex held
+void serial_poll(serial_port_t &p) {
+    if (p.fd < 0) {
+        return;
+    }
+    uint8_t buf[256];
+    ssize_t n;
+    while ((n = read(p.fd, buf, sizeof(buf))) > 0) {
+        p.rx.insert(p.rx.end(), buf, buf + n);
+    }
+}
+
+} // namespace
+
+namespace sim {
+
+void use_fake_clock(bool fake) {
+    if (fake) {
+        fake_us = std::chrono::duration_cast<std::chrono::microseconds>(
+                    std::chrono::steady_clock::now() - clock_start
+        )
+                    .count();
+    }
+    fake_clock = fake;
+}
+
+void set_time_us(uint64_t us) { fake_us = us; }
+
+void advance_us(uint64_t us) { fake_us += us; }
+
+void set_sd_dir(const std::string &dir) {
+    sd_dir = dir;
+    sd_dir_made = false;
+}
+
+std::string sd_path(const char *name) { return std::string(sd_dir_path()) + "/" + name; }
+
+void set_sd_write_delay_ms(uint32_t ms) { sd_write_delay_ms = ms; }
+
+size_t sd_appends() { return sd_append_count; }
+
+void serial_feed(uint32_t port, const uint8_t *data, size_t len) {
+    serial_port_t *p = serial_port(port);
+    std::lock_guard<std::mutex> lock(p->mut);
+    p->rx.insert(p->rx.end(), data, data + len);
+}
+
+std::vector<uint8_t> serial_take_sent(uint32_t port) {
+    serial_port_t *p = serial_port(port);
+    std::lock_guard<std::mutex> lock(p->mut);
+    std::vector<uint8_t> out;
+    out.swap(p->tx);
+    return out;
+}
+
+void serial_attach(uint32_t port, int fd) {
+    serial_port_t *p = serial_port(port);
+    std::lock_guard<std::mutex> lock(p->mut);
+    if (fd >= 0) {
+        fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) | O_NONBLOCK);
+    }
+    p->fd = fd;
+}
+
+void finish(int failures) {
+    printf("%s (%d failed checks)\n", failures == 0 ? "PASS" : "FAIL", failures);
+    fflush(stdout);
+    _Exit(failures == 0 ? 0 : 1);
+}
+
+} // namespace sim
+
+extern "C" {
+
+void vexDelay(uint32_t ms) {
+    if (fake_clock) {
+        fake_us += (uint64_t)ms * 1000;
+    } else {
+        std::this_thread::sleep_for(std::chrono::milliseconds(ms));
+    }
+}
+
+uint64_t vexSystemHighResTimeGet() {
+    if (fake_clock) {
+        return fake_us;
+    }
+    return std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - clock_start)
+      .count();
+}
+
+uint32_t vexSystemTimeGet() { return (uint32_t)(vexSystemHighResTimeGet() / 1000); }
+
+void vexGenericSerialEnable(uint32_t, uint32_t) {}
+
+void vexGenericSerialBaudrate(uint32_t, uint32_t) {}
+
+int32_t vexGenericSerialReadChar(uint32_t index) {
+    serial_port_t *p = serial_port(index);
+    std::lock_guard<std::mutex> lock(p->mut);
+    serial_poll(*p);
+    if (p->rx.empty()) {
+        return -1;
+    }
+    int32_t c = p->rx.front();
+    p->rx.pop_front();
+    return c;
+}
+
+int32_t vexGenericSerialReceiveAvail(uint32_t index) {
+    serial_port_t *p = serial_port(index);
+    std::lock_guard<std::mutex> lock(p->mut);
+    serial_poll(*p);
+    return (int32_t)p->rx.size();
+}
+
+int32_t vexGenericSerialReceive(uint32_t index, uint8_t *buffer, int32_t length) {
+    serial_port_t *p = serial_port(index);
+    std::lock_guard<std::mutex> lock(p->mut);
+    serial_poll(*p);
+    int32_t n = 0;
+    for (; n < length && !p->rx.empty(); n++) {
+        buffer[n] = p->rx.front();
+        p->rx.pop_front();
+    }
+    return n;
+}
+
+int32_t vexGenericSerialTransmit(uint32_t index, uint8_t *buffer, int32_t length) {
+    serial_port_t *p = serial_port(index);
+    std::lock_guard<std::mutex> lock(p->mut);
+    if (p->fd >= 0) {
+        ssize_t n = write(p->fd, buffer, length);
+        return n < 0 ? 0 : (int32_t)n;
+    }
+    p->tx.insert(p->tx.end(), buffer, buffer + length);
+    return length;
+}
+
+int32_t vexGenericSerialWriteFree(uint32_t) { return 1024; }
+
+void vexGenericSerialFlush(uint32_t index) {
+    serial_port_t *p = serial_port(index);
+    std::lock_guard<std::mutex> lock(p->mut);
+    p->rx.clear();
+}
+
+FIL *vexFileOpen(const char *filename, const char *) { return fopen(sim::sd_path(filename).c_str(), "rb"); }
+
+FIL *vexFileOpenWrite(const char *filename) { return fopen(sim::sd_path(filename).c_str(), "wb"); }
+
+FIL *vexFileOpenCreate(const char *filename) { return fopen(sim::sd_path(filename).c_str(), "wb"); }
+
+void vexFileClose(FIL *fdp) { fclose(fdp); }
+
+int32_t vexFileRead(char *buf, uint32_t size, uint32_t nItems, FIL *fdp) {
+    return (int32_t)fread(buf, size, nItems, fdp);
+}
+
+int32_t vexFileWrite(char *buf, uint32_t size, uint32_t nItems, FIL *fdp) {
+    return (int32_t)fwrite(buf, size, nItems, fdp);
+}
+
+int32_t vexFileSize(FIL *fdp) {
+    long here = ftell(fdp);
+    fseek(fdp, 0, SEEK_END);
+    long size = ftell(fdp);
+    fseek(fdp, here, SEEK_SET);
+    return (int32_t)size;
+}
+
+int32_t vexFileSeek(FIL *fdp, uint32_t offset, int32_t whence) { return fseek(fdp, offset, whence); }
+
+int32_t vexFileTell(FIL *fdp) { return (int32_t)ftell(fdp); }
+
+void vexFileSync(FIL *fdp) { fflush(fdp); }
+}
+
+namespace vex {
+
+const color white, black, red, green, blue, yellow, orange, purple, cyan, transparent;
+
+namespace this_thread {
+void yield() { std::this_thread::yield(); }
+void sleep_for(uint32_t ms) { vexDelay(ms); }
+} // namespace this_thread
+
+task::task(int (*callback)(void)) { std::thread(callback).detach(); }
+
+task::task(int (*callback)(void *), void *arg) { std::thread(callback, arg).detach(); }
+
+task::task(int (*callback)(void *), void *arg, int32_t) { std::thread(callback, arg).detach(); }
+
+timer::timer() { reset(); }
+
+double timer::time() { return (vexSystemHighResTimeGet() - start_us) / 1000.0; }
+
+double timer::time(timeUnits units) { return units == timeUnits::sec ? time() / 1000.0 : time(); }
+
+double timer::value() { return time(timeUnits::sec); }
+
+void timer::reset() { start_us = vexSystemHighResTimeGet(); }
+
+uint32_t timer::system() { return vexSystemTimeGet(); }
+
+uint64_t timer::systemHighResolution() { return vexSystemHighResTimeGet(); }
+
+double encoder::position(rotationUnits units) {
+    double deg = sim_port->sim_deg - offset_deg;
+    return units == rotationUnits::rev ? deg / 360.0 : deg;
+}
+
+double encoder::velocity(velocityUnits units) {
+    return units == velocityUnits::dps ? sim_port->sim_dps : sim_port->sim_dps / 6.0;
+}
+
+void encoder::setPosition(double value, rotationUnits units) {
+    offset_deg = sim_port->sim_deg - (units == rotationUnits::rev ? value * 360 : value);
+}
+
+void motor::spin(directionType dir, double value, voltageUnits units) {
+    double volts = units == voltageUnits::mV ? value / 1000 : value;
+    sim_voltage = dir == directionType::rev ? -volts : volts;
+}
+
+void motor::spin(directionType dir, double value, velocityUnits units) {
+    double frac = units == velocityUnits::pct ? value / 100 : value / 200;
+    sim_voltage = 12 * (dir == directionType::rev ? -frac : frac);
+}
+
+void motor_group::spin(directionType dir, double value, voltageUnits units) {
+    double volts = units == voltageUnits::mV ? value / 1000 : value;
+    sim_voltage = dir == directionType::rev ? -volts : volts;
+    for (motor *m : motors) {
+        m->sim_voltage = sim_voltage;
+    }
+}
+
+void motor_group::spin(directionType dir, double value, velocityUnits units) {
+    double frac = units == velocityUnits::pct ? value / 100 : value / 200;
+    sim_voltage = 12 * (dir == directionType::rev ? -frac : frac);
+    for (motor *m : motors) {
+        m->sim_voltage = sim_voltage;
+    }
+}
+
+void motor_group::stop() {
+    sim_voltage = 0;
+    for (motor *m : motors) {
+        m->sim_voltage = 0;
+    }
+}
+
+double inertial::heading(rotationUnits units) {
+    double deg = fmod(sim_deg, 360);
+    if (deg < 0) {
+        deg += 360;
+    }
+    return units == rotationUnits::rev ? deg / 360 : deg;
+}
+
+bool brain::sdcard::isInserted() { return true; }
+
+bool brain::sdcard::exists(const char *name) {
+    struct stat st;
+    return stat(sim::sd_path(name).c_str(), &st) == 0;
+}
+
+int32_t brain::sdcard::size(const char *name) {
+    struct stat st;
+    return stat(sim::sd_path(name).c_str(), &st) == 0 ? (int32_t)st.st_size : 0;
+}
+
+int32_t brain::sdcard::loadfile(const char *name, uint8_t *buffer, int32_t len) {
+    FILE *f = fopen(sim::sd_path(name).c_str(), "rb");
+    if (f == nullptr) {
+        return 0;
+    }
+    int32_t n = (int32_t)fread(buffer, 1, len, f);
+    fclose(f);
+    return n;
+}
+
+int32_t brain::sdcard::savefile(const char *name, uint8_t *buffer, int32_t len) {
+    FILE *f = fopen(sim::sd_path(name).c_str(), "wb");
+    if (f == nullptr) {
+        return 0;
+    }
+    int32_t n = len > 0 ? (int32_t)fwrite(buffer, 1, len, f) : 0;
+    fclose(f);
+    return n;
+}
+
+int32_t brain::sdcard::appendfile(const char *name, uint8_t *buffer, int32_t len) {
+    sd_append_count++;
+    FILE *f = fopen(sim::sd_path(name).c_str(), "ab");
+    if (f == nullptr) {
+        return 0;
+    }
+    int32_t n = (int32_t)fwrite(buffer, 1, len, f);
+    fclose(f);
+    if (sd_write_delay_ms > 0) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(sd_write_delay_ms));
+    }
+    return n;
+}
+
+} // namespace vex